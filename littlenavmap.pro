@@ -235,6 +235,7 @@ SOURCES += \
   src/common/elevationprovider.cpp \
   src/common/formatter.cpp \
   src/common/fueltool.cpp \
+  src/common/globetiles.cpp \
   src/common/htmlinfobuilder.cpp \
   src/common/jsoninfobuilder.cpp \
   src/common/jumpback.cpp \
@@ -244,6 +245,7 @@ SOURCES += \
   src/common/maptools.cpp \
   src/common/maptypes.cpp \
   src/common/maptypesfactory.cpp \
+  src/common/paintprofiler.cpp \
   src/common/proctypes.cpp \
   src/common/settingsmigrate.cpp \
   src/common/symbolpainter.cpp \
@@ -290,6 +292,7 @@ SOURCES += \
   src/mapgui/maptooltip.cpp \
   src/mapgui/mapvisible.cpp \
   src/mapgui/mapwidget.cpp \
+  src/mapgui/screengrid.cpp \
   src/mappainter/mappainter.cpp \
   src/mappainter/mappainteraircraft.cpp \
   src/mappainter/mappainterairport.cpp \
@@ -308,7 +311,9 @@ SOURCES += \
   src/mappainter/mappainterwind.cpp \
   src/mappainter/mappaintlayer.cpp \
   src/navapp.cpp \
+  src/online/onlineclientstore.cpp \
   src/online/onlinedatacontroller.cpp \
+  src/online/onlinedataworker.cpp \
   src/options/optiondata.cpp \
   src/options/optionsdialog.cpp \
   src/perf/aircraftperfcontroller.cpp \
@@ -325,6 +330,7 @@ SOURCES += \
   src/query/airwaytrackquery.cpp \
   src/query/infoquery.cpp \
   src/query/mapquery.cpp \
+  src/query/mapqueryprefetcher.cpp \
   src/query/procedurequery.cpp \
   src/query/querytypes.cpp \
   src/query/waypointquery.cpp \
@@ -333,9 +339,11 @@ SOURCES += \
   src/route/flightplanentrybuilder.cpp \
   src/route/parkingdialog.cpp \
   src/route/route.cpp \
+  src/route/routealternativesdialog.cpp \
   src/route/routealtitude.cpp \
   src/route/routealtitudeleg.cpp \
   src/route/routecalcwindow.cpp \
+  src/route/routecalculator.cpp \
   src/route/routecommand.cpp \
   src/route/routecontroller.cpp \
   src/route/routeextractor.cpp \
@@ -371,7 +379,7 @@ SOURCES += \
   src/search/searchcontroller.cpp \
   src/search/sqlcontroller.cpp \
   src/search/sqlmodel.cpp \
-  src/search/sqlproxymodel.cpp \
+  src/search/sqlmodelworker.cpp \
   src/search/userdatasearch.cpp \
   src/search/usericondelegate.cpp \
   src/track/trackcontroller.cpp \
@@ -386,6 +394,7 @@ SOURCES += \
   src/web/webcontroller.cpp \
   src/web/webflags.cpp \
   src/web/webmapcontroller.cpp \
+  src/web/webtilecache.cpp \
   src/web/webtools.cpp \
   src/webapi/abstractactionscontroller.cpp \
   src/webapi/abstractlnmactionscontroller.cpp \
@@ -393,7 +402,8 @@ SOURCES += \
   src/webapi/airportactionscontroller.cpp \
   src/webapi/simactionscontroller.cpp \
   src/webapi/uiactionscontroller.cpp \
-  src/webapi/webapicontroller.cpp
+  src/webapi/webapicontroller.cpp \
+  src/webapi/webapistream.cpp
 
 HEADERS  += \
   src/airspace/airspacecontroller.h \
@@ -408,6 +418,7 @@ HEADERS  += \
   src/common/elevationprovider.h \
   src/common/formatter.h \
   src/common/fueltool.h \
+  src/common/globetiles.h \
   src/common/htmlinfobuilder.h \
   src/common/infobuildertypes.h \
   src/common/jsoninfobuilder.h \
@@ -418,6 +429,7 @@ HEADERS  += \
   src/common/maptools.h \
   src/common/maptypes.h \
   src/common/maptypesfactory.h \
+  src/common/paintprofiler.h \
   src/common/proctypes.h \
   src/common/settingsmigrate.h \
   src/common/symbolpainter.h \
@@ -463,6 +475,7 @@ HEADERS  += \
   src/mapgui/maptooltip.h \
   src/mapgui/mapvisible.h \
   src/mapgui/mapwidget.h \
+  src/mapgui/screengrid.h \
   src/mappainter/mappainter.h \
   src/mappainter/mappainteraircraft.h \
   src/mappainter/mappainterairport.h \
@@ -481,7 +494,9 @@ HEADERS  += \
   src/mappainter/mappainterwind.h \
   src/mappainter/mappaintlayer.h \
   src/navapp.h \
+  src/online/onlineclientstore.h \
   src/online/onlinedatacontroller.h \
+  src/online/onlinedataworker.h \
   src/options/optiondata.h \
   src/options/optionsdialog.h \
   src/perf/aircraftperfcontroller.h \
@@ -498,6 +513,7 @@ HEADERS  += \
   src/query/airwaytrackquery.h \
   src/query/infoquery.h \
   src/query/mapquery.h \
+  src/query/mapqueryprefetcher.h \
   src/query/procedurequery.h \
   src/query/querytypes.h \
   src/query/waypointquery.h \
@@ -506,9 +522,11 @@ HEADERS  += \
   src/route/flightplanentrybuilder.h \
   src/route/parkingdialog.h \
   src/route/route.h \
+  src/route/routealternativesdialog.h \
   src/route/routealtitude.h \
   src/route/routealtitudeleg.h \
   src/route/routecalcwindow.h \
+  src/route/routecalculator.h \
   src/route/routecommand.h \
   src/route/routecontroller.h \
   src/route/routeextractor.h \
@@ -544,7 +562,7 @@ HEADERS  += \
   src/search/searchcontroller.h \
   src/search/sqlcontroller.h \
   src/search/sqlmodel.h \
-  src/search/sqlproxymodel.h \
+  src/search/sqlmodelworker.h \
   src/search/userdatasearch.h \
   src/search/usericondelegate.h \
   src/track/trackcontroller.h \
@@ -559,6 +577,7 @@ HEADERS  += \
   src/web/webcontroller.h \
   src/web/webflags.h \
   src/web/webmapcontroller.h \
+  src/web/webtilecache.h \
   src/web/webtools.h \
   src/webapi/abstractactionscontroller.h \
   src/webapi/abstractlnmactionscontroller.h \
@@ -568,7 +587,8 @@ HEADERS  += \
   src/webapi/uiactionscontroller.h \
   src/webapi/webapicontroller.h \
   src/webapi/webapirequest.h \
-  src/webapi/webapiresponse.h
+  src/webapi/webapiresponse.h \
+  src/webapi/webapistream.h
 
 FORMS += \
   src/connect/connectdialog.ui \
@@ -590,6 +610,7 @@ FORMS += \
   src/print/printdialog.ui \
   src/route/customproceduredialog.ui \
   src/route/parkingdialog.ui \
+  src/route/routealternativesdialog.ui \
   src/route/userwaypointdialog.ui \
   src/routeexport/routeexportdialog.ui \
   src/routeexport/routemultiexportdialog.ui \
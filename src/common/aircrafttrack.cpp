@@ -23,9 +23,21 @@
 #include "geo/linestring.h"
 #include "fs/sc/simconnectuseraircraft.h"
 
+#include <cstring>
+
 #include <QDataStream>
 #include <QDateTime>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QMap>
+
+/* Number of levels of detail and tolerance for the first level. Tolerance is multiplied by four for each level. */
+const static int LOD_LEVELS = 6;
+const static float LOD_TOLERANCE_DEG = 0.00005f;
+
+/* Number of positions simplified at once */
+const static int LOD_CHUNK_SIZE = 256;
 
 namespace at {
 
@@ -43,6 +55,16 @@ QDataStream& operator<<(QDataStream& dataStream, const at::AircraftTrackPos& tra
 
 }
 
+AircraftTrack::RingStorage::~RingStorage()
+{
+  if(file != nullptr)
+  {
+    file->unmap(data);
+    file->close();
+    delete file;
+  }
+}
+
 AircraftTrack::AircraftTrack()
 {
   lastUserAircraft = new atools::fs::sc::SimConnectUserAircraft;
@@ -50,11 +72,11 @@ AircraftTrack::AircraftTrack()
 
 AircraftTrack::~AircraftTrack()
 {
+  release();
   delete lastUserAircraft;
 }
 
 AircraftTrack::AircraftTrack(const AircraftTrack& other)
-  : QList<at::AircraftTrackPos>(other)
 {
   lastUserAircraft = new atools::fs::sc::SimConnectUserAircraft;
   this->operator=(other);
@@ -62,15 +84,44 @@ AircraftTrack::AircraftTrack(const AircraftTrack& other)
 
 AircraftTrack& AircraftTrack::operator=(const AircraftTrack& other)
 {
-  clear();
-  append(other);
+  if(this == &other)
+    return *this;
+
   maxTrackEntries = other.maxTrackEntries;
   *lastUserAircraft = *other.lastUserAircraft;
+
+  release();
+  if(other.header != nullptr)
+  {
+    // Share buffer read-only instead of copying all positions
+    storage = other.storage;
+    setColumns(storage->data);
+    readOnly = true;
+    snapshotHead = other.readOnly ? other.snapshotHead : other.header->head;
+    snapshotCount = static_cast<quint32>(other.size());
+  }
+  overwritten = 0;
+
+  // Geometry is implicitly shared
+  segments = other.segments;
+  maxAltitude = other.maxAltitude;
   return *this;
 }
 
+void AircraftTrack::setMaxTrackEntries(int value)
+{
+  maxTrackEntries = std::max(value, 2);
+
+  if(header != nullptr && static_cast<int>(header->capacity) != maxTrackEntries)
+    resizeRing(maxTrackEntries);
+}
+
 void AircraftTrack::saveState(const QString& suffix)
 {
+  if(storage != nullptr && storage->file != nullptr && !readOnly)
+    // All positions are already written to the mapped file
+    return;
+
   QFile trackFile(atools::settings::Settings::getConfigFilename(suffix));
 
   if(trackFile.open(QIODevice::WriteOnly))
@@ -85,38 +136,75 @@ void AircraftTrack::saveState(const QString& suffix)
 
 void AircraftTrack::restoreState(const QString& suffix)
 {
-  clear();
+  release();
+  ringFilename = atools::settings::Settings::getConfigFilename(suffix + "ring");
 
+  // The old format is written only if the ring file could not be mapped which makes it newer than any ring file
   QFile trackFile(atools::settings::Settings::getConfigFilename(suffix));
+  if(!trackFile.exists() && attachRing())
+  {
+    if(static_cast<int>(header->capacity) != maxTrackEntries)
+      resizeRing(maxTrackEntries);
+    rebuildGeometry();
+    return;
+  }
+
+  allocate(maxTrackEntries);
+
+  // Convert track file from older versions =====================
   if(trackFile.exists())
   {
     if(trackFile.open(QIODevice::ReadOnly))
     {
       QDataStream in(&trackFile);
-      readFromStream(in);
+      bool converted = readFromStream(in);
       trackFile.close();
+
+      // Remove old file only if positions are stored in the mapped file now
+      if(converted && storage->file != nullptr)
+      {
+        qInfo() << Q_FUNC_INFO << "Converted" << trackFile.fileName() << "to" << storage->file->fileName();
+        trackFile.remove();
+      }
     }
     else
       qWarning() << "Cannot read track" << trackFile.fileName() << ":" << trackFile.errorString();
   }
+  rebuildGeometry();
 }
 
 void AircraftTrack::clearTrack()
 {
-  clear();
+  if(readOnly)
+    // Do not touch the buffer of the source
+    release();
+  else if(header != nullptr)
+  {
+    header->count = 0;
+    header->head = 0;
+  }
+  overwritten = 0;
+  removedPositions = 0;
+  segments.clear();
+  maxAltitude = 0.f;
 }
 
 void AircraftTrack::saveToStream(QDataStream& out)
 {
+  QList<at::AircraftTrackPos> positions;
+  positions.reserve(size());
+  for(int i = 0; i < size(); i++)
+    positions.append(entry(i));
+
   out.setVersion(QDataStream::Qt_5_5);
   out.setFloatingPointPrecision(QDataStream::SinglePrecision);
-  out << FILE_MAGIC_NUMBER << FILE_VERSION << *this;
+  out << FILE_MAGIC_NUMBER << FILE_VERSION << positions;
 }
 
 bool AircraftTrack::readFromStream(QDataStream& in)
 {
   bool retval = false;
-  clear();
+  clearTrack();
 
   quint32 magic;
   quint16 version;
@@ -129,7 +217,12 @@ bool AircraftTrack::readFromStream(QDataStream& in)
     in >> version;
     if(version == FILE_VERSION)
     {
-      in >> *this;
+      QList<at::AircraftTrackPos> positions;
+      in >> positions;
+      for(const at::AircraftTrackPos& trackPos : positions)
+        appendEntry(trackPos);
+      overwritten = 0;
+      rebuildGeometry();
       retval = true;
     }
     else
@@ -141,6 +234,253 @@ bool AircraftTrack::readFromStream(QDataStream& in)
   return retval;
 }
 
+at::AircraftTrackPos AircraftTrack::entry(int index) const
+{
+  int idx = slot(index);
+  bool onGround = flags[idx] & FLAG_ON_GROUND;
+
+  if(flags[idx] & FLAG_BREAK)
+    return at::AircraftTrackPos(timestamps[idx], onGround);
+  else
+    return at::AircraftTrackPos(atools::geo::Pos(lonX[idx], latY[idx], altitude[idx]), timestamps[idx], onGround);
+}
+
+bool AircraftTrack::appendEntry(const at::AircraftTrackPos& trackPos)
+{
+  if(readOnly)
+    // Get own buffer before writing
+    resizeRing(maxTrackEntries);
+  else if(header == nullptr)
+    allocate(maxTrackEntries);
+
+  bool full = header->count == header->capacity;
+  quint32 idx = full ? header->head : (header->head + header->count) % header->capacity;
+
+  if(full && !(flags[idx] & FLAG_BREAK))
+    // Oldest position is overwritten
+    removedPositions++;
+
+  // Write columns first and update header afterwards to keep the file consistent
+  lonX[idx] = trackPos.pos.getLonX();
+  latY[idx] = trackPos.pos.getLatY();
+  altitude[idx] = trackPos.pos.getAltitude();
+  timestamps[idx] = trackPos.timestamp;
+  flags[idx] = static_cast<quint8>((trackPos.onGround ? FLAG_ON_GROUND : 0) | (trackPos.isValid() ? 0 : FLAG_BREAK));
+
+  if(full)
+  {
+    // Oldest entry was overwritten - new one is last now
+    header->head = (header->head + 1) % header->capacity;
+
+    // Remove invalid segments at the start
+    while(header->count > 0 && flags[header->head] & FLAG_BREAK)
+    {
+      header->head = (header->head + 1) % header->capacity;
+      header->count--;
+    }
+
+    overwritten++;
+    if(overwritten >= PRUNE_TRACK_ENTRIES)
+    {
+      overwritten = 0;
+      return true;
+    }
+  }
+  else
+    header->count++;
+
+  return false;
+}
+
+void AircraftTrack::allocate(int capacity)
+{
+  release();
+
+  storage.reset(new RingStorage);
+  uchar *data = nullptr;
+  qint64 bytes = ringSize(capacity);
+
+  if(!ringFilename.isEmpty())
+  {
+    // Remove instead of truncating since copies of the track might still map the old file.
+    // Removing a mapped file fails on Windows. Use a new file with a higher number in this case
+    // which is preferred by attachRing() on the next start.
+    QString filename = ringFilename;
+    const QStringList remaining = removeRingFiles();
+    if(!remaining.isEmpty())
+      filename = ringFilename + "." + QString::number(ringFileNumber(remaining.last()) + 1);
+
+    QFile *file = new QFile(filename);
+    if(file->open(QIODevice::ReadWrite) && file->resize(bytes))
+      data = file->map(0, bytes);
+
+    if(data != nullptr)
+      storage->file = file;
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot map track" << filename << ":" << file->errorString()
+                 << "- keeping track in memory";
+      delete file;
+      if(QFile::exists(filename) && !QFile::remove(filename))
+        qWarning() << Q_FUNC_INFO << "Cannot remove track" << filename;
+    }
+  }
+
+  if(data == nullptr)
+  {
+    // Pages are only touched when used
+    storage->memory = QByteArray(static_cast<int>(bytes), Qt::Uninitialized);
+    data = reinterpret_cast<uchar *>(storage->memory.data());
+  }
+  storage->data = data;
+
+  RingHeader *hdr = reinterpret_cast<RingHeader *>(data);
+  memset(hdr, 0, sizeof(RingHeader));
+  hdr->magic = RING_MAGIC_NUMBER;
+  hdr->version = RING_VERSION;
+  hdr->capacity = static_cast<quint32>(capacity);
+  setColumns(data);
+}
+
+bool AircraftTrack::attach(const QString& filename)
+{
+  release();
+
+  QFile *file = new QFile(filename);
+  if(file->open(QIODevice::ReadWrite) && file->size() >= static_cast<qint64>(sizeof(RingHeader)))
+  {
+    RingHeader hdr;
+    if(file->read(reinterpret_cast<char *>(&hdr), sizeof(RingHeader)) == sizeof(RingHeader) &&
+       hdr.magic == RING_MAGIC_NUMBER && hdr.version == RING_VERSION && hdr.capacity > 0 &&
+       hdr.head < hdr.capacity && hdr.count <= hdr.capacity &&
+       file->size() == ringSize(static_cast<int>(hdr.capacity)))
+    {
+      uchar *data = file->map(0, file->size());
+      if(data != nullptr)
+      {
+        storage.reset(new RingStorage);
+        storage->file = file;
+        storage->data = data;
+        setColumns(data);
+        qDebug() << Q_FUNC_INFO << filename << "entries" << header->count << "capacity" << header->capacity;
+        return true;
+      }
+    }
+  }
+
+  qWarning() << Q_FUNC_INFO << "Invalid track file" << filename << ":" << file->errorString();
+  delete file;
+  return false;
+}
+
+bool AircraftTrack::attachRing()
+{
+  // Try the most recent file first
+  const QStringList files = ringFiles();
+  for(int i = files.size() - 1; i >= 0; i--)
+  {
+    if(attach(files.at(i)))
+    {
+      // Remove files left over from reallocations while copies mapped the old file
+      for(const QString& filename : files)
+      {
+        if(filename != files.at(i) && !QFile::remove(filename))
+          qWarning() << Q_FUNC_INFO << "Cannot remove track" << filename;
+      }
+      return true;
+    }
+    else
+      qWarning() << "Cannot read track" << files.at(i);
+  }
+  return false;
+}
+
+QStringList AircraftTrack::ringFiles() const
+{
+  QFileInfo fileinfo(ringFilename);
+  QMap<int, QString> files;
+
+  if(fileinfo.exists())
+    files.insert(0, ringFilename);
+
+  // Add numbered files like "little_navmap.trackring.1"
+  const QStringList names = fileinfo.dir().entryList({fileinfo.fileName() + ".*"}, QDir::Files);
+  for(const QString& name : names)
+  {
+    QString filename = fileinfo.dir().filePath(name);
+    int number = ringFileNumber(filename);
+    if(number > 0)
+      files.insert(number, filename);
+  }
+  return files.values();
+}
+
+int AircraftTrack::ringFileNumber(const QString& filename) const
+{
+  QString name = QFileInfo(filename).fileName(), ringName = QFileInfo(ringFilename).fileName();
+  if(name == ringName)
+    return 0;
+  else if(!name.startsWith(ringName + "."))
+    return -1;
+
+  bool ok;
+  int number = name.mid(ringName.size() + 1).toInt(&ok);
+  return ok ? number : -1;
+}
+
+QStringList AircraftTrack::removeRingFiles() const
+{
+  QStringList remaining;
+  for(const QString& filename : ringFiles())
+  {
+    if(!QFile::remove(filename))
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot remove track" << filename << "- probably still mapped by a copy";
+      remaining.append(filename);
+    }
+  }
+  return remaining;
+}
+
+void AircraftTrack::resizeRing(int capacity)
+{
+  // Keep the most recent positions
+  QVector<at::AircraftTrackPos> positions;
+  for(int i = std::max(size() - capacity, 0); i < size(); i++)
+    positions.append(entry(i));
+
+  allocate(capacity);
+  for(const at::AircraftTrackPos& trackPos : positions)
+    appendEntry(trackPos);
+  overwritten = 0;
+  rebuildGeometry();
+}
+
+void AircraftTrack::release()
+{
+  // Buffer is freed when the last copy releases it
+  storage.reset();
+  readOnly = false;
+  snapshotHead = snapshotCount = 0;
+
+  header = nullptr;
+  lonX = latY = altitude = nullptr;
+  timestamps = nullptr;
+  flags = nullptr;
+}
+
+void AircraftTrack::setColumns(uchar *data)
+{
+  header = reinterpret_cast<RingHeader *>(data);
+  int capacity = static_cast<int>(header->capacity);
+
+  lonX = reinterpret_cast<float *>(data + sizeof(RingHeader));
+  latY = lonX + capacity;
+  altitude = latY + capacity;
+  timestamps = reinterpret_cast<quint32 *>(altitude + capacity);
+  flags = reinterpret_cast<quint8 *>(timestamps + capacity);
+}
+
 bool AircraftTrack::appendTrackPos(const atools::fs::sc::SimConnectUserAircraft& userAircraft, bool allowSplit)
 {
   if(!userAircraft.isValid())
@@ -162,60 +502,305 @@ bool AircraftTrack::appendTrackPos(const atools::fs::sc::SimConnectUserAircraft&
   bool onGround = userAircraft.isOnGround();
 
   if(isEmpty() && userAircraft.isValid())
-    append(at::AircraftTrackPos(pos, timestamp.toTime_t(), onGround));
+    pruned |= appendPosition(at::AircraftTrackPos(pos, timestamp.toTime_t(), onGround));
   else
   {
     // Use a smaller distance on ground before storing position
     float epsilonPos = onGround ? atools::geo::Pos::POS_EPSILON_5M : atools::geo::Pos::POS_EPSILON_100M;
     long epsilonTime = onGround ? MIN_POSITION_TIME_DIFF_GROUND_MS : MIN_POSITION_TIME_DIFF_MS;
 
+    const at::AircraftTrackPos lastPos = last();
     long time = timestamp.toMSecsSinceEpoch();
-    long lastTime = last().timestamp * 1000L;
+    long lastTime = lastPos.timestamp * 1000L;
 
-    if(!pos.almostEqual(last().pos, epsilonPos) && !atools::almostEqual(lastTime, time, epsilonTime))
+    if(!pos.almostEqual(lastPos.pos, epsilonPos) && !atools::almostEqual(lastTime, time, epsilonTime))
     {
       bool lastValid = lastUserAircraft->isValid();
       bool aircraftChanged = lastValid && lastUserAircraft->hasAircraftChanged(userAircraft);
-      bool jumped = !isEmpty() && pos.distanceMeterTo(last().pos) > atools::geo::nmToMeter(MAX_POINT_DISTANCE_NM);
+      bool jumped = pos.distanceMeterTo(lastPos.pos) > atools::geo::nmToMeter(MAX_POINT_DISTANCE_NM);
 
-      if(allowSplit && jumped && (last().onGround || onGround || aircraftChanged))
+      if(allowSplit && jumped && (lastPos.onGround || onGround || aircraftChanged))
       {
         qDebug() << Q_FUNC_INFO << "Splitting trail" << "allowSplit" << allowSplit << "jumped" << jumped
-                 << "last().onGround" << last().onGround << "onGround" << onGround
+                 << "last().onGround" << lastPos.onGround << "onGround" << onGround
                  << "aircraftChanged" << aircraftChanged;
 
         // Add an invalid position before indicating a break
-        append(at::AircraftTrackPos(timestamp.toTime_t(), onGround));
-        append(at::AircraftTrackPos(pos, timestamp.toTime_t(), onGround));
+        pruned |= appendPosition(at::AircraftTrackPos(timestamp.toTime_t(), onGround));
+        pruned |= appendPosition(at::AircraftTrackPos(pos, timestamp.toTime_t(), onGround));
       }
       else
-      {
-        if(size() > maxTrackEntries)
-        {
-          for(int i = 0; i < PRUNE_TRACK_ENTRIES; i++)
-            removeFirst();
-
-          // Remove invalid segments
-          while(!isEmpty() && !first().isValid())
-            removeFirst();
-
-          pruned = true;
-        }
-        append(at::AircraftTrackPos(pos, timestamp.toTime_t(), onGround));
-      }
+        // Overwrites the oldest entry if full
+        pruned |= appendPosition(at::AircraftTrackPos(pos, timestamp.toTime_t(), onGround));
 
       *lastUserAircraft = userAircraft;
     }
   }
+
   return pruned;
 }
 
+bool AircraftTrack::appendPosition(const at::AircraftTrackPos& trackPos)
+{
+  bool pruned = appendEntry(trackPos);
+
+  if(pruned)
+    // Remove overwritten positions from geometry
+    pruneGeometry();
+
+  appendGeometry(trackPos);
+  return pruned;
+}
+
+void AircraftTrack::appendGeometry(const at::AircraftTrackPos& trackPos)
+{
+  if(!trackPos.isValid())
+  {
+    // Break - start a new segment with the next position
+    if(!segments.isEmpty() && !segments.last().line.isEmpty())
+      segments.append(at::AircraftTrackSegment());
+    return;
+  }
+
+  if(segments.isEmpty())
+    segments.append(at::AircraftTrackSegment());
+
+  at::AircraftTrackSegment& segment = segments.last();
+  extendBounding(segment, trackPos.pos);
+  segment.line.append(trackPos.pos);
+
+  maxAltitude = std::max(maxAltitude, trackPos.pos.getAltitude());
+
+  // Simplify chunk if complete
+  if(segment.line.size() > std::max(segment.simplifiedSize - 1, 0) + LOD_CHUNK_SIZE)
+    simplifyChunk(segment);
+}
+
+void AircraftTrack::extendBounding(at::AircraftTrackSegment& segment, const atools::geo::Pos& pos)
+{
+  if(segment.line.isEmpty())
+  {
+    segment.bounding = atools::geo::Rect(pos);
+    segment.crossesAntiMeridian = false;
+  }
+  else
+  {
+    // Rect::extend() does not consider the anti-meridian and would result in a rectangle covering the wrong side
+    if(std::abs(pos.getLonX() - segment.line.last().getLonX()) > 180.f)
+      segment.crossesAntiMeridian = true;
+    segment.bounding.extend(pos);
+  }
+}
+
+void AircraftTrack::rebuildGeometry()
+{
+  segments.clear();
+  maxAltitude = 0.f;
+  removedPositions = 0;
+
+  for(int i = 0; i < size(); i++)
+    appendGeometry(entry(i));
+
+  // Remove empty segment after a trailing break
+  if(!segments.isEmpty() && segments.last().line.isEmpty())
+    segments.removeLast();
+}
+
+void AircraftTrack::pruneGeometry()
+{
+  // Overwritten positions are always the oldest ones
+  while(removedPositions > 0 && !segments.isEmpty() && !segments.first().line.isEmpty())
+  {
+    at::AircraftTrackSegment& segment = segments.first();
+    if(removedPositions >= segment.line.size())
+    {
+      removedPositions -= segment.line.size();
+      segments.removeFirst();
+    }
+    else
+    {
+      removeFromSegment(segment, removedPositions);
+      removedPositions = 0;
+    }
+  }
+  removedPositions = 0;
+
+  maxAltitude = 0.f;
+  for(const at::AircraftTrackSegment& segment : segments)
+  {
+    for(const atools::geo::Pos& pos : segment.line)
+      maxAltitude = std::max(maxAltitude, pos.getAltitude());
+  }
+}
+
+void AircraftTrack::removeFromSegment(at::AircraftTrackSegment& segment, int numPositions)
+{
+  // Number of chunks which do not contain positions after the removed ones
+  int numChunks = 0;
+  while(numChunks < segment.chunkEnds.size() && segment.chunkEnds.at(numChunks) <= numPositions)
+    numChunks++;
+
+  if(numChunks == segment.chunkEnds.size())
+  {
+    // All simplified positions removed - remaining positions will be simplified again when a chunk is complete
+    segment.levels.clear();
+    segment.chunkStarts.clear();
+    segment.chunkEnds.clear();
+    segment.simplifiedSize = 0;
+  }
+  else
+  {
+    // Chunk containing the new first position
+    int chunkStart = numChunks > 0 ? segment.chunkEnds.at(numChunks - 1) : 0;
+    int chunkEnd = segment.chunkEnds.at(numChunks);
+
+    float tolerance = LOD_TOLERANCE_DEG;
+    for(int i = 0; i < segment.levels.size(); i++)
+    {
+      atools::geo::LineString& level = segment.levels[i];
+      QVector<int>& starts = segment.chunkStarts[i];
+
+      // Number of level positions to remove from the start and start of the next chunk
+      int removeLevel = starts.at(numChunks);
+      int nextStart = numChunks + 1 < starts.size() ? starts.at(numChunks + 1) : level.size() - 1;
+
+      atools::geo::LineString simplified;
+      if(chunkStart < numPositions)
+      {
+        // Simplify the remaining part of the cut chunk again
+        douglasPeucker(simplified, segment.line, numPositions, chunkEnd, tolerance);
+
+        // Remove the old cut chunk without the shared last position
+        removeLevel = nextStart;
+      }
+      // Offset change for the remaining chunks
+      int shift = removeLevel;
+
+      level.remove(0, removeLevel);
+      if(!simplified.isEmpty())
+      {
+        // Replace shared last position by the simplified part
+        shift -= simplified.size() - 1;
+        for(int j = 1; j < level.size(); j++)
+          simplified.append(level.at(j));
+        level.swap(simplified);
+      }
+
+      starts.remove(0, numChunks);
+      starts[0] = 0;
+      for(int j = 1; j < starts.size(); j++)
+        starts[j] -= shift;
+      tolerance *= 4.f;
+    }
+
+    segment.chunkEnds.remove(0, numChunks);
+    for(int& end : segment.chunkEnds)
+      end -= numPositions;
+    segment.simplifiedSize -= numPositions;
+  }
+
+  segment.line.remove(0, numPositions);
+
+  // Update rectangle from remaining positions
+  segment.bounding = atools::geo::Rect(segment.line.first());
+  segment.crossesAntiMeridian = false;
+  for(int i = 1; i < segment.line.size(); i++)
+  {
+    if(std::abs(segment.line.at(i).getLonX() - segment.line.at(i - 1).getLonX()) > 180.f)
+      segment.crossesAntiMeridian = true;
+    segment.bounding.extend(segment.line.at(i));
+  }
+}
+
+void AircraftTrack::simplifyChunk(at::AircraftTrackSegment& segment)
+{
+  int start = std::max(segment.simplifiedSize - 1, 0);
+  int end = start + LOD_CHUNK_SIZE;
+
+  if(segment.levels.isEmpty())
+  {
+    segment.levels.resize(LOD_LEVELS);
+    segment.chunkStarts.resize(LOD_LEVELS);
+  }
+
+  float tolerance = LOD_TOLERANCE_DEG;
+  for(int i = 0; i < segment.levels.size(); i++)
+  {
+    atools::geo::LineString& level = segment.levels[i];
+
+    // Chunks share the first and last position
+    if(!level.isEmpty())
+      level.removeLast();
+
+    segment.chunkStarts[i].append(level.size());
+    douglasPeucker(level, segment.line, start, end, tolerance);
+    tolerance *= 4.f;
+  }
+  segment.chunkEnds.append(end);
+  segment.simplifiedSize = end + 1;
+}
+
+void AircraftTrack::douglasPeucker(atools::geo::LineString& result, const atools::geo::LineString& line,
+                                   int start, int end, float toleranceDeg)
+{
+  // Use planar coordinates with longitude scaled for the latitude of the chunk
+  float lonFactor = std::cos(atools::geo::toRadians(line.at(start).getLatY()));
+  QVector<bool> keep(end - start + 1, false);
+  keep[0] = keep[end - start] = true;
+
+  // Avoid recursion by using a stack of ranges
+  QVector<std::pair<int, int> > ranges({std::make_pair(start, end)});
+  while(!ranges.isEmpty())
+  {
+    std::pair<int, int> range = ranges.takeLast();
+    const atools::geo::Pos& first = line.at(range.first), & last = line.at(range.second);
+    float dx = (last.getLonX() - first.getLonX()) * lonFactor, dy = last.getLatY() - first.getLatY();
+    float length = std::sqrt(dx * dx + dy * dy);
+
+    // Find position with largest distance to line between first and last
+    float maxDist = 0.f;
+    int maxIndex = -1;
+    for(int i = range.first + 1; i < range.second; i++)
+    {
+      float px = (line.at(i).getLonX() - first.getLonX()) * lonFactor, py = line.at(i).getLatY() - first.getLatY();
+      float dist = length > 0.f ? std::abs(dx * py - dy * px) / length : std::sqrt(px * px + py * py);
+      if(dist > maxDist)
+      {
+        maxDist = dist;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1 && maxDist > toleranceDeg)
+    {
+      keep[maxIndex - start] = true;
+      ranges.append(std::make_pair(range.first, maxIndex));
+      ranges.append(std::make_pair(maxIndex, range.second));
+    }
+  }
+
+  for(int i = start; i <= end; i++)
+  {
+    if(keep.at(i - start))
+      result.append(line.at(i));
+  }
+}
+
+int AircraftTrack::getLevelOfDetail(float toleranceDeg)
+{
+  int level = -1;
+  float tolerance = LOD_TOLERANCE_DEG;
+  for(int i = 0; i < LOD_LEVELS && tolerance <= toleranceDeg; i++)
+  {
+    level = i;
+    tolerance *= 4.f;
+  }
+  return level;
+}
+
 float AircraftTrack::getMaxAltitude() const
 {
-  float maxAlt = 0.f;
-  for(const at::AircraftTrackPos& trackPos : *this)
-    maxAlt = std::max(maxAlt, trackPos.pos.getAltitude());
-  return maxAlt;
+  return maxAltitude;
 }
 
 QVector<atools::geo::LineString> AircraftTrack::getLineStrings() const
@@ -227,16 +812,17 @@ QVector<atools::geo::LineString> AircraftTrack::getLineStrings() const
     atools::geo::LineString line;
     linestrings.reserve(size());
 
-    for(const at::AircraftTrackPos& trackPos : *this)
+    for(int i = 0; i < size(); i++)
     {
-      if(!trackPos.isValid())
+      int idx = slot(i);
+      if(flags[idx] & FLAG_BREAK)
       {
         // An invalid position shows a break in the lines - add line and start a new one
         linestrings.append(line);
         line.clear();
       }
       else
-        line.append(trackPos.pos);
+        line.append(atools::geo::Pos(lonX[idx], latY[idx], altitude[idx]));
     }
 
     // Add rest
@@ -248,28 +834,29 @@ QVector<atools::geo::LineString> AircraftTrack::getLineStrings() const
 
 QVector<QVector<quint32> > AircraftTrack::getTimestamps() const
 {
-  QVector<QVector<quint32> > timestamps;
+  QVector<QVector<quint32> > timestampList;
 
   if(!isEmpty())
   {
     QVector<quint32> times;
-    timestamps.reserve(size());
+    timestampList.reserve(size());
 
-    for(const at::AircraftTrackPos& trackPos : *this)
+    for(int i = 0; i < size(); i++)
     {
-      if(!trackPos.isValid())
+      int idx = slot(i);
+      if(flags[idx] & FLAG_BREAK)
       {
         // An invalid position shows a break in the lines - start a new list
-        timestamps.append(times);
+        timestampList.append(times);
         times.clear();
       }
       else
-        times.append(trackPos.timestamp);
+        times.append(timestamps[idx]);
     }
 
     // Add rest
     if(!times.isEmpty())
-      timestamps.append(times);
+      timestampList.append(times);
   }
-  return timestamps;
+  return timestampList;
 }
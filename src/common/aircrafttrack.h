@@ -18,7 +18,14 @@
 #ifndef LITTLENAVMAP_AIRCRAFTTRACK_H
 #define LITTLENAVMAP_AIRCRAFTTRACK_H
 
-#include "geo/pos.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QStringList>
+
+class QFile;
 
 namespace atools {
 namespace fs {
@@ -26,9 +33,6 @@ namespace sc {
 class SimConnectUserAircraft;
 }
 }
-namespace geo {
-class LineString;
-}
 }
 
 namespace at {
@@ -64,6 +68,37 @@ struct AircraftTrackPos
   bool onGround;
 };
 
+/* Trail part between two breaks. Geometry is updated for each new position and used by the map painter. */
+struct AircraftTrackSegment
+{
+  /* Positions at full resolution */
+  atools::geo::LineString line;
+
+  /* Positions simplified by Douglas-Peucker for each level of detail. Covers all positions of line up to
+   * simplifiedSize - 1. Simplification is done for chunks of fixed size when they are complete.
+   * Neighbor chunks share the first and last position. */
+  QVector<atools::geo::LineString> levels;
+  int simplifiedSize = 0;
+
+  /* Index into line of the last position for each chunk */
+  QVector<int> chunkEnds;
+
+  /* Index into each level of the first position for each chunk */
+  QVector<QVector<int> > chunkStarts;
+
+  /* Not valid if segment crosses the anti-meridian */
+  atools::geo::Rect bounding;
+  bool crossesAntiMeridian = false;
+
+  /* Index into line of the first position which is not covered by levels yet. This is the last simplified
+   * position or 0. */
+  int getTailStart() const
+  {
+    return std::max(simplifiedSize - 1, 0);
+  }
+
+};
+
 QDataStream& operator>>(QDataStream& dataStream, at::AircraftTrackPos& obj);
 QDataStream& operator<<(QDataStream& dataStream, const at::AircraftTrackPos& obj);
 
@@ -77,19 +112,32 @@ Q_DECLARE_METATYPE(at::AircraftTrackPos);
  *
  * Points where the track is interrupted (new flight) are indicated by invalid coordinates.
  * Warping at altitude does not interrupt a track.
+ *
+ * Positions are kept in a ring buffer of fixed size with separate columns for longitude, latitude, altitude,
+ * timestamp and flags. The oldest entry is overwritten once the buffer is full which makes pruning O(1).
+ *
+ * After restoreState() the buffer is a memory mapped file. Each new position is written directly into the
+ * mapped file which means that the track survives a crash and does not need to be rewritten on save.
+ * The whole buffer is kept in memory if the file cannot be mapped.
+ *
+ * Copies share the buffer read-only and keep head and size of the source at the time of copying.
+ * The source might overwrite the oldest positions of a copy later. Therefore, copies have to be refreshed
+ * before use like done by MapPaintWidget::copySettings(). A copy gets its own buffer when it is modified.
  */
-class AircraftTrack :
-  private QList<at::AircraftTrackPos>
+class AircraftTrack
 {
 public:
   AircraftTrack();
   ~AircraftTrack();
 
+  /* Copies share the buffer of other read-only */
   AircraftTrack(const AircraftTrack& other);
 
   AircraftTrack& operator=(const AircraftTrack& other);
 
-  /* Saves and restores track into a separate file (little_navmap.track) */
+  /* Opens the track file (little_navmap.trackring) and maps it into memory. A track file in the
+   * old format (little_navmap.track) is converted and deleted.
+   * saveState() writes the old format only if the file could not be mapped. */
   void saveState(const QString& suffix);
   void restoreState(const QString& suffix);
 
@@ -111,30 +159,145 @@ public:
   /* Same as getLineStrings() but returns the timestamps for each position */
   QVector<QVector<quint32> > getTimestamps() const;
 
-  /* Convert to linestring and timestamp values for export functions like GPX */
-  // void convert(atools::geo::LineString *track) const;
+  /* Geometry for painting which is maintained on each new position. Can contain up to PRUNE_TRACK_ENTRIES
+   * positions which were already overwritten since these are removed on prune only. */
+  const QVector<at::AircraftTrackSegment>& getSegments() const
+  {
+    return segments;
+  }
 
-  /* Pull only needed methods of the base class into public space */
-  using QList::isEmpty;
+  /* Get index into AircraftTrackSegment::levels where removed positions deviate not more than
+   * the given value. -1 means full resolution is needed. */
+  static int getLevelOfDetail(float toleranceDeg);
 
-  /* Track will be pruned if it contains more track entries than this value. Default is 20000. */
-  void setMaxTrackEntries(int value)
+  bool isEmpty() const
   {
-    maxTrackEntries = value;
+    return size() == 0;
   }
 
+  /* Track will be pruned if it contains more track entries than this value. Default is 20000.
+   * Call before restoreState() to avoid resizing the file. */
+  void setMaxTrackEntries(int value);
+
   /* Write and read the whole track to and from a binary stream */
   void saveToStream(QDataStream& out);
 
   bool readFromStream(QDataStream & in);
 
 private:
+  friend class AircraftTrackTest;
+
+  /* Header at the start of file or memory buffer. Followed by the columns, each one with capacity entries. */
+  struct RingHeader
+  {
+    quint32 magic;
+    quint16 version;
+    quint16 reserved;
+    quint32 capacity, head, count;
+    quint32 reserved2[3];
+  };
+
+  /* Values for the flags column */
+  static const quint8 FLAG_ON_GROUND = 0x01;
+  static const quint8 FLAG_BREAK = 0x02;
+
+  /* Size of all columns for one entry: longitude, latitude, altitude, timestamp and flags */
+  static const int BYTES_PER_ENTRY = 3 * sizeof(float) + sizeof(quint32) + sizeof(quint8);
+
+  int size() const
+  {
+    if(header == nullptr)
+      return 0;
+    else
+      return static_cast<int>(readOnly ? snapshotCount : header->count);
+  }
+
+  /* Get buffer slot for logical entry with index 0 being the oldest one */
+  int slot(int index) const
+  {
+    return static_cast<int>(((readOnly ? snapshotHead : header->head) + static_cast<quint32>(index)) %
+                            header->capacity);
+  }
+
+  /* Get logical entry with index 0 being the oldest one */
+  at::AircraftTrackPos entry(int index) const;
+  at::AircraftTrackPos last() const
+  {
+    return entry(size() - 1);
+  }
+
+  /* Append to buffer and segments */
+  bool appendPosition(const at::AircraftTrackPos& trackPos);
+
+  /* Add position to the last segment or start a new one for a break */
+  void appendGeometry(const at::AircraftTrackPos& trackPos);
+
+  /* Build segments from the buffer after loading */
+  void rebuildGeometry();
+
+  /* Remove positions from the start of the segments which were overwritten in the buffer */
+  void pruneGeometry();
+
+  /* Remove positions from the start of the segment. Drops whole chunks and simplifies only the chunk
+   * containing the new first position again. */
+  static void removeFromSegment(at::AircraftTrackSegment& segment, int numPositions);
+
+  /* Extend bounding rectangle and detect anti-meridian crossing */
+  static void extendBounding(at::AircraftTrackSegment& segment, const atools::geo::Pos& pos);
+
+  /* Simplify the next complete chunk of the segment for all levels */
+  static void simplifyChunk(at::AircraftTrackSegment& segment);
+
+  /* Append Douglas-Peucker simplified positions of line from start to end (inclusive) */
+  static void douglasPeucker(atools::geo::LineString& result, const atools::geo::LineString& line, int start, int end,
+                             float toleranceDeg);
+
+  /* Append to the buffer and overwrite the oldest entry if full. Allocates the buffer if needed.
+   * @return true if a number of PRUNE_TRACK_ENTRIES entries were overwritten since the last report */
+  bool appendEntry(const at::AircraftTrackPos& trackPos);
+
+  /* Create a new empty buffer in the file if ringFilename is set or in memory otherwise.
+   * The file gets a new number if the old one cannot be removed. */
+  void allocate(int capacity);
+
+  /* Map an existing file. Returns false if the file is not valid. */
+  bool attach(const QString& filename);
+
+  /* Map the most recent valid ring file and remove all others. Returns false if no file is valid. */
+  bool attachRing();
+
+  /* Existing ring files sorted by number with ringFilename being the oldest one. Numbered files are created if
+   * the previous file could not be removed since copies still mapped it (Windows). */
+  QStringList ringFiles() const;
+
+  /* Number of a ring file from ringFiles(). 0 for ringFilename and -1 if not a ring file. */
+  int ringFileNumber(const QString& filename) const;
+
+  /* Try to remove all ring files and return the ones which could not be removed */
+  QStringList removeRingFiles() const;
+
+  /* Copy the most recent entries into a buffer with the new capacity */
+  void resizeRing(int capacity);
+
+  /* Unmap file or free memory if not used by copies anymore */
+  void release();
+
+  /* Set column pointers for a buffer starting with the header */
+  void setColumns(uchar *data);
+
+  static qint64 ringSize(int capacity)
+  {
+    return static_cast<qint64>(sizeof(RingHeader)) + static_cast<qint64>(capacity) * BYTES_PER_ENTRY;
+  }
+
   /* Insert an invalid position as an break indicator if aircraft jumps too far on ground. */
   static const int MAX_POINT_DISTANCE_NM = 5;
 
-  /* Maximum number of track points. If exceeded entries will be removed from beginning of the list */
+  /* Maximum number of track points. If exceeded the oldest entries will be overwritten */
   int maxTrackEntries = 20000;
-  /* Number of entries to remove at once */
+
+  /* Number of overwritten entries before appendTrackPos() reports a prune.
+   * Avoids updating the profile on each new position once the buffer is full. */
   static const int PRUNE_TRACK_ENTRIES = 200;
 
   /* Minimum time difference between recordings */
@@ -146,7 +309,46 @@ private:
   /* Version 2 to adds timstamp and single floating point precision */
   static const quint16 FILE_VERSION = 2;
 
+  /* Ring buffer file using native byte order */
+  static const quint32 RING_MAGIC_NUMBER = 0x5B6C1A2C;
+  static const quint16 RING_VERSION = 1;
+
   atools::fs::sc::SimConnectUserAircraft *lastUserAircraft;
+
+  /* Owns the mapped file or the memory buffer */
+  struct RingStorage
+  {
+    ~RingStorage();
+
+    QFile *file = nullptr;
+    QByteArray memory;
+    uchar *data = nullptr;
+  };
+
+  /* Set by restoreState(). Buffer is kept in memory if empty or file cannot be mapped.
+   * The mapped file can have a number appended. See ringFiles(). */
+  QString ringFilename;
+  QSharedPointer<RingStorage> storage;
+
+  /* Buffer is shared with the source of a copy. Head and count of the header are not used. */
+  bool readOnly = false;
+  quint32 snapshotHead = 0, snapshotCount = 0;
+
+  /* Point into the mapped file or into ringMemory. All null if not allocated yet. */
+  RingHeader *header = nullptr;
+  float *lonX = nullptr, *latY = nullptr, *altitude = nullptr;
+  quint32 *timestamps = nullptr;
+  quint8 *flags = nullptr;
+
+  /* Number of overwritten entries since last prune report */
+  int overwritten = 0;
+
+  /* Number of valid positions overwritten since geometry was updated */
+  int removedPositions = 0;
+
+  /* Geometry for painting */
+  QVector<at::AircraftTrackSegment> segments;
+  float maxAltitude = 0.f;
 };
 
 #endif // LITTLENAVMAP_AIRCRAFTTRACK_H
@@ -211,6 +211,7 @@ const QLatin1String AIRSPACE_CONTROLLER_WIDGETS("AirspaceController/Widget");
 const QLatin1String SETTINGS_INFOQUERY("Settings/InfoQuery");
 const QLatin1String SETTINGS_MAPQUERY("Settings/MapQuery");
 const QLatin1String SETTINGS_DATABASE("Settings/Database");
+const QLatin1String SETTINGS_PROFILE("Settings/Profile");
 
 const QLatin1String APPROACHTREE_WIDGET("ApproachTree/Widget");
 const QLatin1String APPROACHTREE_SELECTED_WIDGET("ApproachTree/WidgetSelected");
@@ -280,10 +281,13 @@ const QLatin1String OPTIONS_WHAZZUP_PARSER_DEBUG("Options/WhazzupParserDebug");
 const QLatin1String OPTIONS_DATAREADER_DEBUG("Options/DataReaderDebug");
 const QLatin1String OPTIONS_WEATHER_DEBUG("Options/WeatherDebug");
 const QLatin1String OPTIONS_ONLINE_NETWORK_DEBUG("Options/OnlineNetworkDebug");
+const QLatin1String OPTIONS_ONLINE_EXTRAPOLATION_UPDATE("Options/OnlineExtrapolationUpdateSeconds");
 const QLatin1String OPTIONS_TRACK_DEBUG("Options/TrackDebug");
 const QLatin1String OPTIONS_WEATHER_LEVELS("Options/WeatherLevels");
 const QLatin1String OPTIONS_WIND_DEBUG("Options/WindDebug");
 const QLatin1String OPTIONS_WEBSERVER_DEBUG("Options/WebserverDebug");
+const QLatin1String OPTIONS_WEBSERVER_TILE_IDLE_SECONDS("Options/WebserverTileIdleSeconds");
+const QLatin1String OPTIONS_WEBSERVER_STREAM_INTERVAL("Options/WebserverStreamIntervalMs");
 const QLatin1String OPTIONS_VERSION("Options/Version");
 const QLatin1String OPTIONS_NO_USER_AGENT("Options/NoUserAgent");
 const QLatin1String OPTIONS_WEATHER_UPDATE("Options/WeatherUpdate");
@@ -18,6 +18,7 @@
 #include "common/elevationprovider.h"
 
 #include "navapp.h"
+#include "common/globetiles.h"
 #include "fs/common/globereader.h"
 #include "options/optiondata.h"
 #include "geo/line.h"
@@ -29,6 +30,9 @@
 #include <marble/GeoDataCoordinates.h>
 #include <marble/ElevationModel.h>
 
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
 /* Limt altitude to this value */
 static Q_DECL_CONSTEXPR float ALTITUDE_LIMIT_METER = 8800.f;
 /* Point removal equality tolerance in meter */
@@ -41,6 +45,15 @@ using atools::fs::common::GlobeReader;
 
 using namespace Marble;
 
+/* Reset all invalid and ocean indicators to 0 */
+inline static float validElevation(float elevation)
+{
+  if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
+    return 0.f;
+  else
+    return elevation;
+}
+
 ElevationProvider::ElevationProvider(QObject *parent, const Marble::ElevationModel *model)
   : QObject(parent), marbleModel(model)
 {
@@ -51,7 +64,7 @@ ElevationProvider::ElevationProvider(QObject *parent, const Marble::ElevationMod
 
 ElevationProvider::~ElevationProvider()
 {
-  delete globeReader;
+  std::atomic_store(&globeTiles, std::shared_ptr<const GlobeTiles>());
 }
 
 void ElevationProvider::marbleUpdateAvailable()
@@ -62,16 +75,11 @@ void ElevationProvider::marbleUpdateAvailable()
 
 float ElevationProvider::getElevationMeter(const atools::geo::Pos& pos)
 {
-  QMutexLocker locker(&mutex);
+  // Keep a reference so that the reader stays alive even if replaced meanwhile
+  std::shared_ptr<const GlobeTiles> tiles = std::atomic_load(&globeTiles);
 
-  if(isGlobeOfflineProvider())
-  {
-    float elevation = globeReader->getElevation(pos);
-    if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
-      return 0.f;
-    else
-      return elevation;
-  }
+  if(tiles != nullptr)
+    return validElevation(tiles->getElevation(pos));
   else
     return 0.f;
 }
@@ -81,66 +89,118 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
   if(!line.isValid())
     return;
 
-  QMutexLocker locker(&mutex);
+  std::shared_ptr<const GlobeTiles> tiles = std::atomic_load(&globeTiles);
+  if(tiles != nullptr)
+    getElevationsGlobe(*tiles, elevations, line);
+  else
+    getElevationsMarble(elevations, line);
+}
+
+void ElevationProvider::getElevations(QVector<LineString>& elevations, const QVector<Line>& lines)
+{
+  elevations.clear();
+  elevations.resize(lines.size());
 
-  if(isGlobeOfflineProvider())
+  std::shared_ptr<const GlobeTiles> tiles = std::atomic_load(&globeTiles);
+  if(tiles == nullptr)
   {
-    globeReader->getElevations(elevations, LineString(line.getPos1(), line.getPos2()));
-    for(Pos& pos : elevations)
+    // Marble is not thread safe - fetch one by one
+    for(int i = 0; i < lines.size(); i++)
     {
-      float alt = pos.getAltitude();
-      if(!(alt > atools::fs::common::OCEAN && alt < atools::fs::common::INVALID))
-        // Reset all invalid and ocean indicators to 0
-        pos.setAltitude(0.f);
+      if(lines.at(i).isValid())
+        getElevationsMarble(elevations[i], lines.at(i));
     }
+    return;
   }
-  else
+
+  // Split lines into chunks - one for each core including this thread
+  int numChunks = std::max(1, std::min(QThread::idealThreadCount(), lines.size()));
+  int chunkSize = (lines.size() + numChunks - 1) / numChunks;
+
+  // Each chunk writes only into its own slots of the pre-sized vector
+  LineString *result = elevations.data();
+  auto fetchChunk = [this, tiles, result, &lines](int from, int to) -> void
+                    {
+                      for(int i = from; i < to; i++)
+                      {
+                        if(lines.at(i).isValid())
+                          getElevationsGlobe(*tiles, result[i], lines.at(i));
+                      }
+                    };
+
+  QVector<QFuture<void> > futures;
+  for(int from = chunkSize; from < lines.size(); from += chunkSize)
+    futures.append(QtConcurrent::run(fetchChunk, from, std::min(from + chunkSize, lines.size())));
+
+  // Do the first chunk in this thread
+  fetchChunk(0, std::min(chunkSize, lines.size()));
+
+  for(QFuture<void>& future : futures)
+    future.waitForFinished();
+}
+
+void ElevationProvider::getElevationsGlobe(const GlobeTiles& tiles, atools::geo::LineString& elevations,
+                                           const atools::geo::Line& line) const
+{
+  int start = elevations.size();
+  tiles.getElevations(elevations, line.getPos1(), line.getPos2());
+
+  for(int i = start; i < elevations.size(); i++)
   {
-    // Get altitude points for the line segment
-    // The might not be complete and will be more complete on further iterations when we get a signal
-    // from the elevation model
-    QVector<GeoDataCoordinates> temp = marbleModel->heightProfile(line.getPos1().getLonX(), line.getPos1().getLatY(),
-                                                                  line.getPos2().getLonX(), line.getPos2().getLatY());
-
-    // Limit long legs to a maximum of 2000 points - minimum of 1000 points
-    int divisor = 1;
-    while(temp.size() / divisor > 2000)
-      divisor++;
-
-    int i = 0;
-    Pos lastDropped;
-    for(const GeoDataCoordinates& c : temp)
-    {
-      if((i++ % divisor) != 0)
-        continue;
+    Pos& pos = elevations[i];
+    // Limit ground altitude
+    pos.setAltitude(std::min(validElevation(pos.getAltitude()), ALTITUDE_LIMIT_METER));
+  }
+}
+
+void ElevationProvider::getElevationsMarble(atools::geo::LineString& elevations, const atools::geo::Line& line)
+{
+  QMutexLocker locker(&marbleMutex);
+
+  // Get altitude points for the line segment
+  // The might not be complete and will be more complete on further iterations when we get a signal
+  // from the elevation model
+  QVector<GeoDataCoordinates> temp = marbleModel->heightProfile(line.getPos1().getLonX(), line.getPos1().getLatY(),
+                                                                line.getPos2().getLonX(), line.getPos2().getLatY());
 
-      Pos pos(c.longitude(), c.latitude(), c.altitude());
-      pos.toDeg();
+  // Limit long legs to a maximum of 2000 points - minimum of 1000 points
+  int divisor = 1;
+  while(temp.size() / divisor > 2000)
+    divisor++;
 
-      if(!elevations.isEmpty())
+  int i = 0;
+  Pos lastDropped;
+  for(const GeoDataCoordinates& c : temp)
+  {
+    if((i++ % divisor) != 0)
+      continue;
+
+    Pos pos(c.longitude(), c.latitude(), c.altitude());
+    pos.toDeg();
+
+    if(!elevations.isEmpty())
+    {
+      if(atools::almostEqual(elevations.last().getAltitude(), pos.getAltitude(), SAME_ONLINE_ELEVATION_EPSILON))
       {
-        if(atools::almostEqual(elevations.last().getAltitude(), pos.getAltitude(), SAME_ONLINE_ELEVATION_EPSILON))
-        {
-          // Drop points with similar altitude
-          lastDropped = pos;
-          continue;
-        }
-        else if(lastDropped.isValid())
-        {
-          // Add last point of a stretch with similar altitude
-          elevations.append(lastDropped);
-          lastDropped = Pos();
-        }
+        // Drop points with similar altitude
+        lastDropped = pos;
+        continue;
+      }
+      else if(lastDropped.isValid())
+      {
+        // Add last point of a stretch with similar altitude
+        elevations.append(lastDropped);
+        lastDropped = Pos();
       }
-      elevations.append(pos);
     }
+    elevations.append(pos);
+  }
 
-    if(elevations.isEmpty())
-    {
-      // Workaround for invalid geometry data - add void
-      elevations.append(line.getPos1());
-      elevations.append(line.getPos2());
-    }
+  if(elevations.isEmpty())
+  {
+    // Workaround for invalid geometry data - add void
+    elevations.append(line.getPos1());
+    elevations.append(line.getPos2());
   }
 
   for(Pos& pos : elevations)
@@ -156,13 +216,14 @@ bool ElevationProvider::isGlobeDirectoryValid(const QString& path) const
 
 void ElevationProvider::optionsChanged()
 {
-  // Make sure to wait for other methods to finish before changing the reader
-  QMutexLocker locker(&mutex);
+  // No need to wait for readers - they keep their reference to the old tiles
   updateReader();
 }
 
 void ElevationProvider::updateReader()
 {
+  QMutexLocker locker(&updateMutex);
+
   if(OptionData::instance().getFlags() & opts::CACHE_USE_OFFLINE_ELEVATION)
   {
     const QString& path = OptionData::instance().getOfflineElevationPath();
@@ -178,26 +239,29 @@ void ElevationProvider::updateReader()
     }
     else
     {
-      delete globeReader;
-      globeReader = new GlobeReader(path);
+      std::shared_ptr<const GlobeTiles> current = std::atomic_load(&globeTiles);
+      if(current == nullptr || current->getDirectory() != path)
       {
         qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
 
-        if(!globeReader->openFiles())
+        // Open new tiles completely before publishing them to readers
+        std::shared_ptr<GlobeTiles> tiles = std::make_shared<GlobeTiles>(path);
+        if(tiles->openFiles())
+          std::atomic_store(&globeTiles, std::shared_ptr<const GlobeTiles>(tiles));
+        else
         {
+          std::atomic_store(&globeTiles, std::shared_ptr<const GlobeTiles>());
           NavApp::deleteSplashScreen();
           atools::gui::Dialog::warning(NavApp::getQMainWidget(),
                                        tr("Cannot open GLOBE data in directory<br/>\"%1\"").arg(path));
-          qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
         }
+        qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
       }
     }
   }
   else
-  {
-    delete globeReader;
-    globeReader = nullptr;
-  }
+    // Old tiles are unmapped when the last reader releases its reference
+    std::atomic_store(&globeTiles, std::shared_ptr<const GlobeTiles>());
 
   emit updateAvailable();
 }
@@ -20,18 +20,17 @@
 
 #include <QMutex>
 #include <QObject>
+#include <QVector>
+
+#include <memory>
 
 namespace Marble {
 class ElevationModel;
 }
 
-namespace atools {
-namespace fs {
-namespace common {
-class GlobeReader;
-}
-}
+class GlobeTiles;
 
+namespace atools {
 namespace geo {
 class Pos;
 class LineString;
@@ -43,7 +42,9 @@ class Line;
  * Wraps the slow Marble online elevation provider and the fast offline GLOBE data provider.
  * Use GLOBE data if all paramters are set properly in settings.
  *
- * Class is thread safe.
+ * Class is thread safe. Offline GLOBE data is read from memory mapped files without locking. The
+ * reader is replaced atomically when options change while readers in other threads keep their copy
+ * until they are done. Only the online Marble provider is serialized by a mutex.
  */
 class ElevationProvider :
   public QObject
@@ -64,10 +65,14 @@ public:
    * consecutive ones with same elevation. Elevation given in meter */
   void getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line);
 
+  /* Batch version of the method above. Resizes elevations to the size of lines and fills one line string
+   * for each line. Lines are processed in parallel using the global thread pool if offline data is used. */
+  void getElevations(QVector<atools::geo::LineString>& elevations, const QVector<atools::geo::Line>& lines);
+
   /* true if the data is provided from the fast offline source */
   bool isGlobeOfflineProvider() const
   {
-    return globeReader != nullptr;
+    return std::atomic_load(&globeTiles) != nullptr;
   }
 
   /* True if directory is valid and contains at least one valid GLOBE file */
@@ -84,11 +89,20 @@ private:
   void marbleUpdateAvailable();
   void updateReader();
 
+  void getElevationsGlobe(const GlobeTiles& tiles, atools::geo::LineString& elevations,
+                          const atools::geo::Line& line) const;
+  void getElevationsMarble(atools::geo::LineString& elevations, const atools::geo::Line& line);
+
   const Marble::ElevationModel *marbleModel = nullptr;
-  atools::fs::common::GlobeReader *globeReader = nullptr;
 
-  /* Need to synchronize here since it is called from profile widget thread */
-  mutable QMutex mutex;
+  /* Immutable once opened. Always accessed using std::atomic_load and std::atomic_store. */
+  std::shared_ptr<const GlobeTiles> globeTiles;
+
+  /* Need to synchronize Marble access since it is called from profile widget thread */
+  mutable QMutex marbleMutex;
+
+  /* Serializes calls to updateReader */
+  QMutex updateMutex;
 
 };
 
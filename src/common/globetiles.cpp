@@ -0,0 +1,158 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "common/globetiles.h"
+
+#include "geo/pos.h"
+#include "geo/linestring.h"
+#include "fs/common/globereader.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QtEndian>
+
+#include <cmath>
+
+using atools::geo::Pos;
+using atools::geo::LineString;
+
+/* Tiles are arranged in four rows from north to south and four columns from west to east.
+ * Each tile covers 90 degree longitude. Northern and southern rows cover 40 degree latitude
+ * and the rows at the equator 50 degree. Data is signed 16 bit little endian, row major from north west. */
+static const int NUM_TILE_COLUMNS = 4;
+static const int TILE_COLUMNS = 10800;
+static const int TILE_ROWS_POLAR = 4800;
+static const int TILE_ROWS_EQUATOR = 6000;
+
+/* 30 arc seconds */
+static const double CELLS_PER_DEGREE = 120.;
+
+/* Latitude of the northern border for each tile row */
+static const double TILE_ROW_TOP_LAT[] = {90., 50., 0., -50.};
+
+/* Distance between sample points when getting elevations for lines */
+static const float SAMPLE_DISTANCE_METER = 500.f;
+
+GlobeTiles::GlobeTiles(const QString& directoryParam)
+  : directory(directoryParam)
+{
+}
+
+GlobeTiles::~GlobeTiles()
+{
+  for(Tile& tile : tiles)
+  {
+    // Unmaps memory
+    delete tile.file;
+    tile.file = nullptr;
+    tile.data = nullptr;
+  }
+}
+
+bool GlobeTiles::openFiles()
+{
+  QDir dir(directory);
+  tiles.resize(16);
+
+  for(int i = 0; i < 16; i++)
+  {
+    Tile& tile = tiles[i];
+    int tileRow = i / NUM_TILE_COLUMNS;
+    tile.rows = tileRow == 0 || tileRow == 3 ? TILE_ROWS_POLAR : TILE_ROWS_EQUATOR;
+
+    QString name = QString(QChar('a' + i)) + "10g";
+    QString filename = dir.filePath(name);
+    if(!QFile::exists(filename))
+      filename = dir.filePath(name.toUpper());
+
+    tile.file = new QFile(filename);
+    if(!tile.file->open(QIODevice::ReadOnly))
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot open" << filename << tile.file->errorString();
+      return false;
+    }
+
+    qint64 size = static_cast<qint64>(tile.rows) * TILE_COLUMNS * 2;
+    if(tile.file->size() < size)
+    {
+      qWarning() << Q_FUNC_INFO << "File too small" << filename << tile.file->size();
+      return false;
+    }
+
+    // Pages are loaded by the operating system on demand and shared between all threads
+    tile.data = reinterpret_cast<const qint16 *>(tile.file->map(0, size));
+    if(tile.data == nullptr)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot map" << filename << tile.file->errorString();
+      return false;
+    }
+  }
+  return true;
+}
+
+float GlobeTiles::getElevation(const Pos& pos) const
+{
+  if(!pos.isValid() || tiles.size() != 16)
+    return atools::fs::common::INVALID;
+
+  double lon = std::max(-180., std::min(static_cast<double>(pos.getLonX()), 180.));
+  double lat = std::max(-90., std::min(static_cast<double>(pos.getLatY()), 90.));
+
+  int tileCol = std::min(static_cast<int>((lon + 180.) / 90.), NUM_TILE_COLUMNS - 1);
+  int tileRow = lat > 50. ? 0 : (lat > 0. ? 1 : (lat > -50. ? 2 : 3));
+  const Tile& tile = tiles.at(tileRow * NUM_TILE_COLUMNS + tileCol);
+
+  int col = static_cast<int>((lon - (tileCol * 90. - 180.)) * CELLS_PER_DEGREE);
+  int row = static_cast<int>((TILE_ROW_TOP_LAT[tileRow] - lat) * CELLS_PER_DEGREE);
+  col = std::max(0, std::min(col, TILE_COLUMNS - 1));
+  row = std::max(0, std::min(row, tile.rows - 1));
+
+  return qFromLittleEndian<qint16>(tile.data[row * TILE_COLUMNS + col]);
+}
+
+void GlobeTiles::getElevations(LineString& elevations, const Pos& pos1, const Pos& pos2) const
+{
+  float distanceMeter = pos1.distanceMeterTo(pos2);
+  int numPoints = std::max(2, static_cast<int>(std::ceil(distanceMeter / SAMPLE_DISTANCE_METER)) + 1);
+
+  Pos lastDropped;
+  float lastElevation = atools::fs::common::INVALID;
+  for(int i = 0; i < numPoints; i++)
+  {
+    Pos pos = i == 0 ? pos1 : (i == numPoints - 1 ? pos2 :
+                               pos1.interpolate(pos2, distanceMeter, static_cast<float>(i) / (numPoints - 1)));
+    float elevation = getElevation(pos);
+    pos.setAltitude(elevation);
+
+    if(i > 0 && i < numPoints - 1 && elevation == lastElevation)
+    {
+      // Drop points with same elevation but remember the last one of this stretch
+      lastDropped = pos;
+      continue;
+    }
+
+    if(lastDropped.isValid())
+    {
+      elevations.append(lastDropped);
+      lastDropped = Pos();
+    }
+
+    elevations.append(pos);
+    lastElevation = elevation;
+  }
+}
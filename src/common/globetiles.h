@@ -0,0 +1,76 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_GLOBETILES_H
+#define LITTLENAVMAP_GLOBETILES_H
+
+#include <QString>
+#include <QVector>
+
+class QFile;
+
+namespace atools {
+namespace geo {
+class Pos;
+class LineString;
+}
+}
+
+/*
+ * Read only access to the 16 GLOBE elevation tiles a10g to p10g which are mapped into memory.
+ *
+ * The object is immutable once opened. All const methods can be called from any number of
+ * threads concurrently without locking.
+ */
+class GlobeTiles
+{
+public:
+  explicit GlobeTiles(const QString& directoryParam);
+  ~GlobeTiles();
+
+  GlobeTiles(const GlobeTiles& other) = delete;
+  GlobeTiles& operator=(const GlobeTiles& other) = delete;
+
+  /* Map all files into memory. Returns false if any file is missing or cannot be mapped. */
+  bool openFiles();
+
+  /* Raw elevation in meter or ocean and invalid indicators as defined by the GLOBE data set */
+  float getElevation(const atools::geo::Pos& pos) const;
+
+  /* Appends elevations along the great circle line with a point every 500 meters.
+   * Consecutive points with same elevation are removed. Altitude is raw elevation in meter. */
+  void getElevations(atools::geo::LineString& elevations, const atools::geo::Pos& pos1,
+                     const atools::geo::Pos& pos2) const;
+
+  const QString& getDirectory() const
+  {
+    return directory;
+  }
+
+private:
+  struct Tile
+  {
+    QFile *file = nullptr;
+    const qint16 *data = nullptr;
+    int rows = 0;
+  };
+
+  QString directory;
+  QVector<Tile> tiles;
+};
+
+#endif // LITTLENAVMAP_GLOBETILES_H
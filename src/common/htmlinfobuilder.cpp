@@ -53,6 +53,7 @@
 #include "userdata/userdatacontroller.h"
 #include "userdata/userdataicons.h"
 #include "util/htmlbuilder.h"
+#include "weather/weatherreporter.h"
 #include "weather/windreporter.h"
 #include "route/routealtitude.h"
 
@@ -366,41 +367,47 @@ void HtmlInfoBuilder::airportText(const MapAirport& airport, const map::WeatherC
     {
       // Simulator weather =====================================================
       QString sim = tr("%1 ").arg(NavApp::getCurrentSimulatorShortName());
-      addMetarLine(html, tr("%1Station").arg(sim), airport, fsMetar.metarForStation,
+      addMetarLine(html, tr("%1Station").arg(sim), airport, WEATHER_SOURCE_SIMULATOR, fsMetar.metarForStation,
                    fsMetar.requestIdent, fsMetar.timestamp, true /* fs */, src == WEATHER_SOURCE_SIMULATOR);
-      addMetarLine(html, tr("%1Nearest").arg(sim), airport,
+      addMetarLine(html, tr("%1Nearest").arg(sim), airport, WEATHER_SOURCE_SIMULATOR,
                    fsMetar.metarForNearest, fsMetar.requestIdent, fsMetar.timestamp,
                    true /* fs */, src == WEATHER_SOURCE_SIMULATOR);
-      addMetarLine(html, tr("%1Interpolated").arg(sim), airport,
+      addMetarLine(html, tr("%1Interpolated").arg(sim), airport, WEATHER_SOURCE_SIMULATOR,
                    fsMetar.metarForInterpolated, fsMetar.requestIdent, fsMetar.timestamp,
                    true /* fs */, src == WEATHER_SOURCE_SIMULATOR);
     }
 
     // Active Sky weather =====================================================
-    addMetarLine(html, weatherContext.asType, airport, weatherContext.asMetar, QString(), QDateTime(),
-                 false /* fs */, src == WEATHER_SOURCE_ACTIVE_SKY);
+    addMetarLine(html, weatherContext.asType, airport, WEATHER_SOURCE_ACTIVE_SKY, weatherContext.asMetar,
+                 QString(), QDateTime(), false /* fs */, src == WEATHER_SOURCE_ACTIVE_SKY);
 
     // NOAA weather =====================================================
-    addMetarLine(html, tr("NOAA Station"), airport, weatherContext.noaaMetar.metarForStation,
+    addMetarLine(html, tr("NOAA Station"), airport, WEATHER_SOURCE_NOAA,
+                 weatherContext.noaaMetar.metarForStation,
                  weatherContext.noaaMetar.requestIdent, weatherContext.noaaMetar.timestamp,
                  false /* fs */, src == WEATHER_SOURCE_NOAA);
-    addMetarLine(html, tr("NOAA Nearest"), airport, weatherContext.noaaMetar.metarForNearest,
+    addMetarLine(html, tr("NOAA Nearest"), airport, WEATHER_SOURCE_NOAA,
+                 weatherContext.noaaMetar.metarForNearest,
                  weatherContext.noaaMetar.requestIdent, weatherContext.noaaMetar.timestamp,
                  false /* fs */, src == WEATHER_SOURCE_NOAA);
 
     // VATSIM weather =====================================================
-    addMetarLine(html, tr("VATSIM Station"), airport, weatherContext.vatsimMetar.metarForStation,
+    addMetarLine(html, tr("VATSIM Station"), airport, WEATHER_SOURCE_VATSIM,
+                 weatherContext.vatsimMetar.metarForStation,
                  weatherContext.vatsimMetar.requestIdent, weatherContext.vatsimMetar.timestamp,
                  false /* fs */, src == WEATHER_SOURCE_VATSIM);
-    addMetarLine(html, tr("VATSIM Nearest"), airport, weatherContext.vatsimMetar.metarForNearest,
+    addMetarLine(html, tr("VATSIM Nearest"), airport, WEATHER_SOURCE_VATSIM,
+                 weatherContext.vatsimMetar.metarForNearest,
                  weatherContext.vatsimMetar.requestIdent, weatherContext.vatsimMetar.timestamp,
                  false /* fs */, src == WEATHER_SOURCE_VATSIM);
 
     // IVAO weather =====================================================
-    addMetarLine(html, tr("IVAO Station"), airport, weatherContext.ivaoMetar.metarForStation,
+    addMetarLine(html, tr("IVAO Station"), airport, WEATHER_SOURCE_IVAO,
+                 weatherContext.ivaoMetar.metarForStation,
                  weatherContext.ivaoMetar.requestIdent, weatherContext.ivaoMetar.timestamp,
                  false /* fs */, src == WEATHER_SOURCE_IVAO);
-    addMetarLine(html, tr("IVAO Nearest"), airport, weatherContext.ivaoMetar.metarForNearest,
+    addMetarLine(html, tr("IVAO Nearest"), airport, WEATHER_SOURCE_IVAO,
+                 weatherContext.ivaoMetar.metarForNearest,
                  weatherContext.ivaoMetar.requestIdent, weatherContext.ivaoMetar.timestamp,
                  false /* fs */, src == WEATHER_SOURCE_IVAO);
     html.tableEnd();
@@ -1602,6 +1609,7 @@ void HtmlInfoBuilder::weatherText(const map::WeatherContext& context, const MapA
       // Source for map icon display
       MapWeatherSource src = NavApp::getMapWeatherSource();
       bool weatherShown = NavApp::isMapWeatherShown();
+      WeatherReporter *reporter = NavApp::getWeatherReporter();
 
       // Simconnect or X-Plane weather file metar ===========================
       if(context.fsMetar.isValid())
@@ -1614,7 +1622,8 @@ void HtmlInfoBuilder::weatherText(const map::WeatherContext& context, const MapA
 
         if(!metar.metarForStation.isEmpty())
         {
-          Metar met(metar.metarForStation, metar.requestIdent, metar.timestamp, true);
+          Metar met = reporter->getParsedMetar(WEATHER_SOURCE_SIMULATOR, metar.metarForStation, metar.requestIdent,
+                                               metar.timestamp, true);
 
           html.p(tr("%1Station Weather").arg(sim), WEATHER_TITLE_FLAGS);
           decodedMetar(html, airport, map::MapAirport(), met, false /* interpolated */, fsxP3d,
@@ -1623,7 +1632,8 @@ void HtmlInfoBuilder::weatherText(const map::WeatherContext& context, const MapA
 
         if(!metar.metarForNearest.isEmpty())
         {
-          Metar met(metar.metarForNearest, metar.requestIdent, metar.timestamp, true);
+          Metar met = reporter->getParsedMetar(WEATHER_SOURCE_SIMULATOR, metar.metarForNearest, metar.requestIdent,
+                                               metar.timestamp, true);
           QString reportIcao = met.getParsedMetar().isValid() ? met.getParsedMetar().getId() : met.getStation();
 
           html.p(tr("%2Nearest Weather - %1").arg(reportIcao).arg(sim), WEATHER_TITLE_FLAGS);
@@ -1645,7 +1655,8 @@ void HtmlInfoBuilder::weatherText(const map::WeatherContext& context, const MapA
 
         if(!metar.metarForInterpolated.isEmpty())
         {
-          Metar met(metar.metarForInterpolated, metar.requestIdent, metar.timestamp, fsxP3d);
+          Metar met = reporter->getParsedMetar(WEATHER_SOURCE_SIMULATOR, metar.metarForInterpolated,
+                                               metar.requestIdent, metar.timestamp, fsxP3d);
           html.p(tr("%2Interpolated Weather - %1").arg(met.getStation()).arg(sim), WEATHER_TITLE_FLAGS);
           decodedMetar(html, airport, map::MapAirport(), met, true /* interpolated */, fsxP3d, false /* map src */);
         }
@@ -1665,18 +1676,22 @@ void HtmlInfoBuilder::weatherText(const map::WeatherContext& context, const MapA
         else
           html.p(context.asType, WEATHER_TITLE_FLAGS);
 
-        decodedMetar(html, airport, map::MapAirport(), Metar(context.asMetar), false /* interpolated */,
+        decodedMetar(html, airport, map::MapAirport(),
+                     reporter->getParsedMetar(WEATHER_SOURCE_ACTIVE_SKY, context.asMetar), false /* interpolated */,
                      false /* FSX/P3D */, src == WEATHER_SOURCE_ACTIVE_SKY && weatherShown);
       }
 
       // NOAA or nearest ===========================
-      decodedMetars(html, context.noaaMetar, airport, tr("NOAA"), src == WEATHER_SOURCE_NOAA && weatherShown);
+      decodedMetars(html, context.noaaMetar, airport, tr("NOAA"), WEATHER_SOURCE_NOAA,
+                    src == WEATHER_SOURCE_NOAA && weatherShown);
 
       // Vatsim metar ===========================
-      decodedMetars(html, context.vatsimMetar, airport, tr("VATSIM"), src == WEATHER_SOURCE_VATSIM && weatherShown);
+      decodedMetars(html, context.vatsimMetar, airport, tr("VATSIM"), WEATHER_SOURCE_VATSIM,
+                    src == WEATHER_SOURCE_VATSIM && weatherShown);
 
       // IVAO or nearest ===========================
-      decodedMetars(html, context.ivaoMetar, airport, tr("IVAO"), src == WEATHER_SOURCE_IVAO && weatherShown);
+      decodedMetars(html, context.ivaoMetar, airport, tr("IVAO"), WEATHER_SOURCE_IVAO,
+                    src == WEATHER_SOURCE_IVAO && weatherShown);
     } // if(flags & optsw::WEATHER_INFO_ALL)
     else
       html.p().warning(tr("No weather display selected in options dialog in page \"Weather\"."));
@@ -1684,20 +1699,23 @@ void HtmlInfoBuilder::weatherText(const map::WeatherContext& context, const MapA
 }
 
 void HtmlInfoBuilder::decodedMetars(HtmlBuilder& html, const atools::fs::weather::MetarResult& metar,
-                                    const map::MapAirport& airport, const QString& name, bool mapDisplay) const
+                                    const map::MapAirport& airport, const QString& name,
+                                    map::MapWeatherSource source, bool mapDisplay) const
 {
   if(metar.isValid())
   {
+    WeatherReporter *reporter = NavApp::getWeatherReporter();
     if(!metar.metarForStation.isEmpty())
     {
       html.p(tr("%1 Station Weather").arg(name), WEATHER_TITLE_FLAGS);
       decodedMetar(html, airport, map::MapAirport(),
-                   Metar(metar.metarForStation, metar.requestIdent, metar.timestamp, true), false, false, mapDisplay);
+                   reporter->getParsedMetar(source, metar.metarForStation, metar.requestIdent, metar.timestamp, true),
+                   false, false, mapDisplay);
     }
 
     if(!metar.metarForNearest.isEmpty())
     {
-      Metar met(metar.metarForNearest, metar.requestIdent, metar.timestamp, true);
+      Metar met = reporter->getParsedMetar(source, metar.metarForNearest, metar.requestIdent, metar.timestamp, true);
       QString reportIcao = met.getParsedMetar().isValid() ? met.getParsedMetar().getId() : met.getStation();
 
       html.p(tr("%1 Nearest Weather - %2").arg(name).arg(reportIcao), WEATHER_TITLE_FLAGS);
@@ -4403,12 +4421,13 @@ void HtmlInfoBuilder::rowForStrCap(HtmlBuilder& html, const SqlRecord *rec, cons
 }
 
 void HtmlInfoBuilder::addMetarLine(atools::util::HtmlBuilder& html, const QString& header,
-                                   const map::MapAirport& airport, const QString& metar, const QString& station,
+                                   const map::MapAirport& airport, map::MapWeatherSource source,
+                                   const QString& metar, const QString& station,
                                    const QDateTime& timestamp, bool fsMetar, bool mapDisplay) const
 {
   if(!metar.isEmpty())
   {
-    Metar m(metar, station, timestamp, fsMetar);
+    Metar m = NavApp::getWeatherReporter()->getParsedMetar(source, metar, station, timestamp, fsMetar);
     const atools::fs::weather::MetarParser& parsed = m.getParsedMetar();
 
     if(!parsed.isValid())
@@ -281,6 +281,11 @@ QByteArray JsonInfoBuilder::airport(AirportInfoData airportInfoData) const
 
 
 QByteArray JsonInfoBuilder::siminfo(SimConnectInfoData simconnectInfoData) const
+{
+    return siminfoJson(simconnectInfoData).dump().data();
+}
+
+JSON JsonInfoBuilder::siminfoJson(SimConnectInfoData simconnectInfoData) const
 {
 
     SimConnectData data = *simconnectInfoData.data;
@@ -310,11 +315,16 @@ QByteArray JsonInfoBuilder::siminfo(SimConnectInfoData simconnectInfoData) const
         };
     }
 
-  return json.dump().data();
+  return json;
 }
 
 
 QByteArray JsonInfoBuilder::uiinfo(UiInfoData uiInfoData) const
+{
+    return uiinfoJson(uiInfoData).dump().data();
+}
+
+JSON JsonInfoBuilder::uiinfoJson(UiInfoData uiInfoData) const
 {
 
     UiInfoData data = uiInfoData;
@@ -328,6 +338,6 @@ QByteArray JsonInfoBuilder::uiinfo(UiInfoData uiInfoData) const
            { "distance_web", data.distanceWeb},
        };
 
-    return json.dump().data();
+    return json;
 }
 
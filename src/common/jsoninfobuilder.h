@@ -42,6 +42,13 @@ public:
   QByteArray siminfo(SimConnectInfoData simConnectInfoData) const override;
   QByteArray uiinfo(UiInfoData uiInfoData) const override;
 
+  /**
+   * @brief simulator and ui info as JSON objects. Used by the live
+   * data stream to avoid parsing serialized data again.
+   */
+  JSON siminfoJson(SimConnectInfoData simConnectInfoData) const;
+  JSON uiinfoJson(UiInfoData uiInfoData) const;
+
 private:
   JSON coordinatesToJSON(QMap<QString,float> map) const;
 };
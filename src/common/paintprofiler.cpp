@@ -0,0 +1,224 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "common/paintprofiler.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstring>
+
+/* Number of frames kept for export */
+static const int MAX_HISTORY_FRAMES = 600;
+
+/* Number of painters shown in the overlay sorted by time */
+static const int MAX_OVERLAY_PAINTERS = 16;
+
+thread_local PaintProfiler *PaintProfiler::activeProfiler = nullptr;
+
+inline static double nsToMs(qint64 nanoseconds)
+{
+  return nanoseconds / 1000000.;
+}
+
+PaintProfiler::PaintProfiler()
+{
+  history.reserve(MAX_HISTORY_FRAMES);
+}
+
+void PaintProfiler::beginFrame(float distanceNm)
+{
+  currentFrame = paintprof::Frame();
+  currentFrame.timestampMs = QDateTime::currentMSecsSinceEpoch();
+  currentFrame.distanceNm = distanceNm;
+  frameTimer.start();
+  activeProfiler = this;
+}
+
+void PaintProfiler::endFrame(int objectCount, bool staticLayersCached)
+{
+  if(activeProfiler == this)
+    activeProfiler = nullptr;
+
+  currentFrame.nanoseconds = frameTimer.nsecsElapsed();
+  currentFrame.objectCount = objectCount;
+  currentFrame.staticLayersCached = staticLayersCached;
+  lastFrame = currentFrame;
+
+  if(history.size() < MAX_HISTORY_FRAMES)
+    history.append(currentFrame);
+  else
+    // Overwrite oldest frame
+    history[historyIndex] = currentFrame;
+  historyIndex = (historyIndex + 1) % MAX_HISTORY_FRAMES;
+}
+
+void PaintProfiler::addPainter(const char *name, qint64 nanoseconds, int objects)
+{
+  currentFrame.painters.append({name, nanoseconds, objects});
+}
+
+void PaintProfiler::query(const char *name, bool hit, int rows)
+{
+  if(activeProfiler == nullptr)
+    return;
+
+  QVector<paintprof::QueryStat>& queries = activeProfiler->currentFrame.queries;
+  for(paintprof::QueryStat& stat : queries)
+  {
+    if(std::strcmp(stat.name, name) == 0)
+    {
+      // Query type called more than once in this frame
+      stat.hits += hit;
+      stat.misses += !hit;
+      stat.rows += rows;
+      return;
+    }
+  }
+  queries.append({name, hit, !hit, rows});
+}
+
+QVector<paintprof::Frame> PaintProfiler::getFrames() const
+{
+  if(history.size() < MAX_HISTORY_FRAMES)
+    return history;
+  else
+    // Ring buffer is full - oldest frame is at the write index
+    return history.mid(historyIndex) + history.mid(0, historyIndex);
+}
+
+void PaintProfiler::clear()
+{
+  history.clear();
+  historyIndex = 0;
+  lastFrame = paintprof::Frame();
+}
+
+QString PaintProfiler::toCsv() const
+{
+  QString csv;
+  QTextStream stream(&csv);
+  stream << "frame,timestamp_ms,distance_nm,frame_ms,frame_objects,static_cached,"
+            "type,name,time_ms,objects,hits,misses,rows" << endl;
+
+  int frameNum = 0;
+  for(const paintprof::Frame& frame : getFrames())
+  {
+    QString prefix = QString("%1,%2,%3,%4,%5,%6,").
+                     arg(frameNum++).arg(frame.timestampMs).arg(frame.distanceNm, 0, 'f', 2).
+                     arg(nsToMs(frame.nanoseconds), 0, 'f', 3).arg(frame.objectCount).
+                     arg(frame.staticLayersCached ? 1 : 0);
+
+    for(const paintprof::PainterStat& painter : frame.painters)
+      stream << prefix << "painter," << painter.name << ","
+             << QString::number(nsToMs(painter.nanoseconds), 'f', 3) << "," << painter.objects << ",,," << endl;
+
+    for(const paintprof::QueryStat& query : frame.queries)
+      stream << prefix << "query," << query.name << ",,," << query.hits << "," << query.misses << ","
+             << query.rows << endl;
+  }
+  stream.flush();
+  return csv;
+}
+
+QByteArray PaintProfiler::toJson() const
+{
+  QJsonArray framesArr;
+  for(const paintprof::Frame& frame : getFrames())
+  {
+    QJsonArray paintersArr;
+    for(const paintprof::PainterStat& painter : frame.painters)
+      paintersArr.append(QJsonObject({
+        {"name", QString(painter.name)},
+        {"time_ms", nsToMs(painter.nanoseconds)},
+        {"objects", painter.objects}
+      }));
+
+    QJsonArray queriesArr;
+    for(const paintprof::QueryStat& query : frame.queries)
+      queriesArr.append(QJsonObject({
+        {"name", QString(query.name)},
+        {"hits", query.hits},
+        {"misses", query.misses},
+        {"rows", query.rows}
+      }));
+
+    framesArr.append(QJsonObject({
+      {"timestamp_ms", frame.timestampMs},
+      {"distance_nm", static_cast<double>(frame.distanceNm)},
+      {"time_ms", nsToMs(frame.nanoseconds)},
+      {"objects", frame.objectCount},
+      {"static_cached", frame.staticLayersCached},
+      {"painters", paintersArr},
+      {"queries", queriesArr}
+    }));
+  }
+
+  return QJsonDocument(QJsonObject({{"frames", framesArr}})).toJson();
+}
+
+void PaintProfiler::paintOverlay(QPainter *painter, const QRect& rect) const
+{
+  QStringList lines;
+  lines.append(QString("Frame %1 ms, %2 objects, %3 NM%4").
+               arg(nsToMs(lastFrame.nanoseconds), 0, 'f', 2).arg(lastFrame.objectCount).
+               arg(lastFrame.distanceNm, 0, 'f', 0).arg(lastFrame.staticLayersCached ? ", cached" : QString()));
+
+  // Show slowest painters first
+  QVector<paintprof::PainterStat> painters(lastFrame.painters);
+  std::sort(painters.begin(), painters.end(),
+            [](const paintprof::PainterStat& p1, const paintprof::PainterStat& p2) -> bool
+  {
+    return p1.nanoseconds > p2.nanoseconds;
+  });
+
+  for(int i = 0; i < std::min(painters.size(), MAX_OVERLAY_PAINTERS); i++)
+  {
+    const paintprof::PainterStat& p = painters.at(i);
+    lines.append(QString("%1: %2 ms, %3 objects").arg(p.name).arg(nsToMs(p.nanoseconds), 0, 'f', 2).arg(p.objects));
+  }
+
+  for(const paintprof::QueryStat& q : lastFrame.queries)
+    lines.append(QString("Query %1: %2 hit, %3 miss, %4 rows").arg(q.name).arg(q.hits).arg(q.misses).arg(q.rows));
+
+  painter->save();
+  QFontMetrics metrics(painter->font());
+  int width = 0;
+  for(const QString& line : lines)
+    width = std::max(width, metrics.width(line));
+
+  int height = metrics.height() * lines.size();
+  QRect box(rect.left() + 10, rect.bottom() - height - 30, width + 10, height + 10);
+
+  painter->setPen(Qt::NoPen);
+  painter->setBrush(QColor(255, 255, 255, 200));
+  painter->drawRect(box);
+
+  painter->setPen(Qt::black);
+  int y = box.top() + 5 + metrics.ascent();
+  for(const QString& line : lines)
+  {
+    painter->drawText(box.left() + 5, y, line);
+    y += metrics.height();
+  }
+  painter->restore();
+}
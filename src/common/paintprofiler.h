@@ -0,0 +1,139 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_PAINTPROFILER_H
+#define LITTLENAVMAP_PAINTPROFILER_H
+
+#include <QElapsedTimer>
+#include <QVector>
+
+class QPainter;
+class QRect;
+
+namespace paintprof {
+
+/* Time and number of drawn objects for one painter in one frame */
+struct PainterStat
+{
+  const char *name; /* Static string */
+  qint64 nanoseconds;
+  int objects;
+};
+
+/* Cache usage of one query type in one frame. A hit means that the cached result was used without rebuilding. */
+struct QueryStat
+{
+  const char *name; /* Static string */
+  int hits, misses, rows;
+};
+
+/* Statistics for one call of MapPaintLayer::render() */
+struct Frame
+{
+  qint64 timestampMs = 0L, nanoseconds = 0L;
+  float distanceNm = 0.f;
+  int objectCount = 0;
+  bool staticLayersCached = false;
+
+  QVector<PainterStat> painters;
+  QVector<QueryStat> queries;
+};
+
+}
+
+/*
+ * Collects render times per painter and cache statistics per query for each map paint event.
+ * Keeps a history of the last frames which can be exported as CSV or JSON and draws an overlay.
+ *
+ * Overhead is one elapsed timer call per painter. Not thread safe. Queries are only recorded if
+ * called in the thread which started the frame.
+ */
+class PaintProfiler
+{
+public:
+  PaintProfiler();
+
+  PaintProfiler(const PaintProfiler& other) = delete;
+  PaintProfiler& operator=(const PaintProfiler& other) = delete;
+
+  /* Measures time and object count difference for the lifetime of the object */
+  class Timer
+  {
+public:
+    Timer(PaintProfiler& profilerParam, const char *nameParam, const int& objectCountParam)
+      : profiler(profilerParam), name(nameParam), objectCount(objectCountParam), objectCountStart(objectCountParam)
+    {
+      timer.start();
+    }
+
+    ~Timer()
+    {
+      profiler.addPainter(name, timer.nsecsElapsed(), objectCount - objectCountStart);
+    }
+
+private:
+    PaintProfiler& profiler;
+    const char *name;
+    const int& objectCount;
+    int objectCountStart;
+    QElapsedTimer timer;
+  };
+
+  /* Start a new frame and make this the active profiler for query statistics in the calling thread */
+  void beginFrame(float distanceNm);
+
+  /* Finish frame and add it to the history */
+  void endFrame(int objectCount, bool staticLayersCached);
+
+  void addPainter(const char *name, qint64 nanoseconds, int objects);
+
+  /* Record a cache lookup in the frame of the active profiler. Does nothing if no frame is being recorded
+   * in the calling thread. name has to be a static string. */
+  static void query(const char *name, bool hit, int rows);
+
+  /* Last finished frame */
+  const paintprof::Frame& getLastFrame() const
+  {
+    return lastFrame;
+  }
+
+  /* All frames in the history oldest first */
+  QVector<paintprof::Frame> getFrames() const;
+
+  void clear();
+
+  /* One line per painter and query of each frame in history */
+  QString toCsv() const;
+  QByteArray toJson() const;
+
+  /* Draw statistics of the last frame into the lower left corner of rect */
+  void paintOverlay(QPainter *painter, const QRect& rect) const;
+
+private:
+  paintprof::Frame currentFrame, lastFrame;
+
+  /* Ring buffer of finished frames */
+  QVector<paintprof::Frame> history;
+  int historyIndex = 0;
+
+  QElapsedTimer frameTimer;
+
+  /* Profiler currently recording a frame in this thread */
+  static thread_local PaintProfiler *activeProfiler;
+};
+
+#endif // LITTLENAVMAP_PAINTPROFILER_H
@@ -89,6 +89,9 @@ ConnectClient::ConnectClient(MainWindow *parent)
   flushQueuedRequestsTimer.setInterval(FLUSH_QUEUE_MS);
   connect(&flushQueuedRequestsTimer, &QTimer::timeout, this, &ConnectClient::flushQueuedRequests);
   flushQueuedRequestsTimer.start();
+
+  weatherBatchTimer.setSingleShot(true);
+  connect(&weatherBatchTimer, &QTimer::timeout, this, &ConnectClient::weatherBatchTimeout);
 }
 
 ConnectClient::~ConnectClient()
@@ -96,6 +99,7 @@ ConnectClient::~ConnectClient()
   qDebug() << Q_FUNC_INFO;
 
   flushQueuedRequestsTimer.stop();
+  weatherBatchTimer.stop();
   reconnectNetworkTimer.stop();
 
   disconnectClicked();
@@ -126,6 +130,19 @@ void ConnectClient::flushQueuedRequests()
   }
 }
 
+void ConnectClient::weatherBatchTimeout()
+{
+  if(!weatherBatchIdents.isEmpty())
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Missing replies" << weatherBatchIdents;
+
+    // Show what arrived so far - missing stations will be requested again on next call
+    weatherBatchIdents.clear();
+    emit weatherUpdated();
+  }
+}
+
 void ConnectClient::connectToServerDialog()
 {
   dialog->setConnected(isConnected());
@@ -289,6 +306,8 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
       if(verbose)
         qDebug() << "Metars number" << dataPacket.getMetars().size();
 
+      // Replies for stations requested outside of a batch like tooltips or information window
+      bool otherReplies = false;
       for(atools::fs::weather::MetarResult metar : dataPacket.getMetars())
       {
         QString ident = metar.requestIdent;
@@ -315,10 +334,26 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
 
         metar.simulator = true;
         metarIdentCache.insert(ident, metar);
+        if(!weatherBatchIdents.remove(ident))
+          otherReplies = true;
       }
 
-      if(!dataPacket.getMetars().isEmpty())
+      if(weatherBatchIdents.isEmpty())
+      {
+        // Not part of a batch or batch complete - update once
+        weatherBatchTimer.stop();
         emit weatherUpdated();
+      }
+      else if(otherReplies || weatherBatchProgress.hasExpired(WEATHER_BATCH_PROGRESS_MS))
+      {
+        // Do not delay unrelated replies and show progress of large batches now and then
+        weatherBatchProgress.start();
+        emit weatherUpdated();
+      }
+
+      if(!isConnectedNetwork() && !queuedRequests.isEmpty())
+        // Send next request of queue to simulator without waiting for the timer
+        QTimer::singleShot(0, this, &ConnectClient::flushQueuedRequests);
     }
   } // if(dataPacket.getStatus() == atools::fs::sc::OK)
   else
@@ -501,6 +536,66 @@ atools::fs::weather::MetarResult ConnectClient::requestWeather(const QString& st
   return retval;
 }
 
+QVector<atools::fs::weather::MetarResult> ConnectClient::requestWeatherBatch(
+  const QVector<atools::fs::sc::WeatherRequest>& requests, bool onlyStation)
+{
+  QVector<atools::fs::weather::MetarResult> retval(requests.size());
+
+  if(!isConnected())
+    // Ignore cache if not connected
+    return retval;
+
+  if(isSimConnect() && !dataReader->canFetchWeather())
+    // MSFS cannot fetch weather - disable to avoid stutters
+    return retval;
+
+  bool canRequest = (socket != nullptr && socket->isOpen()) ||
+                    (dataReader->isFsxHandler() && dataReader->isConnected());
+  QVector<atools::fs::sc::WeatherRequest> batch;
+
+  for(int i = 0; i < requests.size(); i++)
+  {
+    const atools::fs::sc::WeatherRequest& request = requests.at(i);
+    const QString& station = request.getStation();
+
+    if(onlyStation && notAvailableStations.contains(station))
+      // No nearest or interpolated and airport is in blacklist
+      continue;
+
+    // Get the old value without triggering the timeout dependent delete
+    atools::fs::weather::MetarResult *result = metarIdentCache.valueNoTimeout(station);
+    if(result != nullptr)
+      retval[i] = *result;
+
+    if(canRequest && !queuedRequestIdents.contains(station) && !outstandingReplies.contains(station) &&
+       (!metarIdentCache.containsNoTimeout(station) || metarIdentCache.isTimedOut(station)))
+    {
+      batch.append(request);
+      queuedRequestIdents.insert(station);
+      weatherBatchIdents.insert(station);
+    }
+  }
+
+  if(!batch.isEmpty())
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "batch size" << batch.size() << "pending" << weatherBatchIdents.size();
+
+    if(!weatherBatchTimer.isActive())
+      weatherBatchProgress.start();
+
+    // Queue is taken from the end - add in reverse order to send the most important stations first
+    for(auto it = batch.crbegin(); it != batch.crend(); ++it)
+      queuedRequests.append(*it);
+
+    // Allow time for sending all remaining requests one by one before giving up on the batch
+    weatherBatchTimer.start(WEATHER_BATCH_TIMEOUT_MS + FLUSH_QUEUE_MS * weatherBatchIdents.size());
+    QTimer::singleShot(0, this, &ConnectClient::flushQueuedRequests);
+  }
+
+  return retval;
+}
+
 bool ConnectClient::isFetchAiShip() const
 {
   return dialog->isFetchAiShip(dialog->getCurrentSimType());
@@ -570,6 +665,9 @@ void ConnectClient::disconnectClicked()
 
   // Close but do not allow reconnect if auto is on
   closeSocket(false);
+
+  weatherBatchTimer.stop();
+  weatherBatchIdents.clear();
 }
 
 void ConnectClient::connectInternalAuto()
@@ -24,6 +24,7 @@
 
 #include <QAbstractSocket>
 #include <QCache>
+#include <QElapsedTimer>
 #include <QTimer>
 
 class QTcpSocket;
@@ -93,6 +94,13 @@ public:
   atools::fs::weather::MetarResult requestWeather(const QString& station, const atools::geo::Pos& pos,
                                                   bool onlyStation);
 
+  /* Request weather for many stations in one pass. Returns cached results in the order of requests.
+   * All missing or timed out stations are queued at once as a batch and the signal weatherUpdated is
+   * emitted when all replies of the batch have arrived or after a timeout. Large batches also emit it every
+   * WEATHER_BATCH_PROGRESS_MS to show progress. */
+  QVector<atools::fs::weather::MetarResult> requestWeatherBatch(
+    const QVector<atools::fs::sc::WeatherRequest>& requests, bool onlyStation);
+
   bool isFetchAiShip() const;
   bool isFetchAiAircraft() const;
 
@@ -123,6 +131,13 @@ private:
   const int DIRECT_RECONNECT_SEC = 5;
   const int FLUSH_QUEUE_MS = 50;
 
+  /* Send update signal for an incomplete batch after this time. Extended by FLUSH_QUEUE_MS for each station
+   * waiting in the batch since only one request is sent per queue flush. */
+  const int WEATHER_BATCH_TIMEOUT_MS = 2000;
+
+  /* Send update signals not more often than this while a batch is pending */
+  const int WEATHER_BATCH_PROGRESS_MS = 500;
+
   /* Any metar fetched from the Simulator will time out in 15 seconds */
   const int WEATHER_TIMEOUT_FS_SECS = 15;
   const int NOT_AVAILABLE_TIMEOUT_FS_SECS = 300;
@@ -141,6 +156,7 @@ private:
   void autoConnectToggled(bool state);
   void requestWeather(const atools::fs::sc::WeatherRequest& weatherRequest);
   void flushQueuedRequests();
+  void weatherBatchTimeout();
   atools::fs::sc::ConnectHandler *handlerByDialogSettings();
   QString simShortName() const;
   QString simName() const;
@@ -167,7 +183,7 @@ private:
 
   QTcpSocket *socket = nullptr;
   /* Used to trigger reconnects on socket base connections */
-  QTimer reconnectNetworkTimer, flushQueuedRequestsTimer;
+  QTimer reconnectNetworkTimer, flushQueuedRequestsTimer, weatherBatchTimer;
   MainWindow *mainWindow;
   bool verbose = false;
   atools::util::TimedCache<QString, atools::fs::weather::MetarResult> metarIdentCache;
@@ -179,6 +195,13 @@ private:
   QVector<atools::fs::sc::WeatherRequest> queuedRequests;
   QSet<QString> queuedRequestIdents;
 
+  /* Stations of the current batch still waiting for replies. weatherUpdated is throttled until empty
+   * except for replies of stations not in the batch. */
+  QSet<QString> weatherBatchIdents;
+
+  /* Time since last weatherUpdated while a batch is pending */
+  QElapsedTimer weatherBatchProgress;
+
   /* Cache holding all weather stations that do not allow a direct report but rather interpolated or nearest */
   atools::util::TimedCache<QString, QString> notAvailableStations;
 
@@ -49,9 +49,11 @@
 #include "fs/navdatabaseerrors.h"
 #include "options/optionsdialog.h"
 #include "fs/scenery/languagejson.h"
+#include "query/querytypes.h"
 
 #include <QElapsedTimer>
 #include <QDir>
+#include <QProgressDialog>
 #include <QSettings>
 
 using atools::gui::ErrorHandler;
@@ -69,6 +71,14 @@ const int MAX_ERROR_BGL_MESSAGES = 400;
 const int MAX_ERROR_SCENERY_MESSAGES = 400;
 const int MAX_TEXT_LENGTH = 120;
 
+/* Point tables which are included in the spatial index benchmark */
+static const QVector<std::pair<QString, QString> > SPATIAL_INDEX_BENCHMARK_TABLES(
+{
+  {"airport", "airport_id"}, {"airport_medium", "airport_id"}, {"airport_large", "airport_id"},
+  {"vor", "vor_id"}, {"ndb", "ndb_id"}, {"waypoint", "waypoint_id"}, {"marker", "marker_id"},
+  {"ils", "ils_id"}, {"holding", "holding_id"}
+});
+
 DatabaseManager::DatabaseManager(MainWindow *parent)
   : QObject(parent), mainWindow(parent)
 {
@@ -984,11 +994,162 @@ void DatabaseManager::openAllDatabases()
     navDbFile = simDbFile;
   // else if(usingNavDatabase == MIXED)
 
+  // Create index files before opening so that all connections including the ones in worker threads can attach
+  QStringList files({simDbFile, navDbFile, simAirspaceDbFile, navAirspaceDbFile});
+  files.removeDuplicates();
+  updateSpatialIndexFiles(files);
+
   openDatabaseFile(databaseSim, simDbFile, true /* readonly */, true /* createSchema */);
   openDatabaseFile(databaseNav, navDbFile, true /* readonly */, true /* createSchema */);
 
   openDatabaseFile(databaseSimAirspace, simAirspaceDbFile, true /* readonly */, true /* createSchema */);
   openDatabaseFile(databaseNavAirspace, navAirspaceDbFile, true /* readonly */, true /* createSchema */);
+
+  // Index files are removed if disabled
+  for(SqlDatabase *db : {databaseSim, databaseNav, databaseSimAirspace, databaseNavAirspace})
+    query::attachSpatialIndex(db);
+
+  if(Settings::instance().getAndStoreValue(lnm::SETTINGS_DATABASE + "SpatialIndexBenchmark", false).toBool())
+  {
+    for(SqlDatabase *db : {databaseSim, databaseNav})
+    {
+      for(const std::pair<QString, QString>& table : SPATIAL_INDEX_BENCHMARK_TABLES)
+      {
+        if(query::hasSpatialIndex(db, table.first))
+          spatialIndexBenchmark(db, table.first, table.second);
+      }
+    }
+  }
+}
+
+void DatabaseManager::updateSpatialIndexFiles(const QStringList& files)
+{
+  if(!Settings::instance().getAndStoreValue(lnm::SETTINGS_DATABASE + "SpatialIndex", true).toBool())
+  {
+    // Remove files to avoid using outdated indexes when enabling again
+    for(const QString& file : files)
+      QFile::remove(query::spatialIndexFile(file));
+    return;
+  }
+
+  QStringList outdated;
+  for(const QString& file : files)
+  {
+    if(QFile::exists(file) && query::isSpatialIndexFileOutdated(file))
+      outdated.append(file);
+  }
+
+  if(outdated.isEmpty())
+    return;
+
+  // Indexes are created only once after loading or compiling a database - can take a few seconds
+  QProgressDialog progress(tr("Creating spatial index ..."), QString(), 0, outdated.size() * 100, mainWindow);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(0);
+  progress.show();
+
+  for(int i = 0; i < outdated.size(); i++)
+  {
+    query::createSpatialIndexFile(outdated.at(i), [&progress, i](int done, int total)
+    {
+      progress.setValue(i * 100 + done * 100 / total);
+      QApplication::processEvents();
+    });
+  }
+  progress.setValue(progress.maximum());
+}
+
+void DatabaseManager::spatialIndexBenchmark(atools::sql::SqlDatabase *db, const QString& table,
+                                            const QString& idColumn)
+{
+  const int NUM_SAMPLES = 50;
+  const double SAMPLE_SIZE_DEG = 2.;
+
+  // Plain queries can use only one of the coordinate indexes - rows visited are the objects in the band of the
+  // index chosen by SQLite or all rows for a table scan
+  SqlQuery planQuery(db);
+  planQuery.exec("explain query plan select * from " + table +
+                 " where lonx between 0 and 1 and laty between 0 and 1");
+  QString plan;
+  while(planQuery.next())
+    plan += planQuery.valueStr("detail");
+
+  QString bandWhere;
+  if(plan.contains("USING INDEX") && plan.contains("(lonx"))
+    bandWhere = " where lonx between :leftx and :rightx";
+  else if(plan.contains("USING INDEX") && plan.contains("(laty"))
+    bandWhere = " where laty between :bottomy and :topy";
+  qDebug() << Q_FUNC_INFO << table << "plan" << plan;
+
+  SqlQuery bandQuery(db);
+  bandQuery.prepare("select count(1) from " + table + bandWhere);
+
+  // Rows visited using the spatial index are the candidates returned by the R*Tree
+  SqlQuery indexQuery(db);
+  indexQuery.prepare("select count(1) from spatial." + query::spatialIndexTable(table) +
+                     " where max_x >= :leftx and min_x <= :rightx and max_y >= :bottomy and min_y <= :topy");
+
+  SqlQuery plainQuery(db);
+  plainQuery.prepare("select * from " + table +
+                     " where lonx between :leftx and :rightx and laty between :bottomy and :topy");
+  SqlQuery spatialQuery(db);
+  spatialQuery.prepare("select * from " + table + " where " + query::whereRectPoint(db, table, idColumn));
+
+  SqlQuery sampleQuery(db);
+  sampleQuery.exec("select lonx, laty from " + table + " order by random() limit " + QString::number(NUM_SAMPLES));
+
+  qint64 rowsPlain = 0, rowsIndex = 0, rowsResult = 0, timePlainNs = 0, timeIndexNs = 0;
+  QElapsedTimer timer;
+  while(sampleQuery.next())
+  {
+    double lonx = sampleQuery.valueFloat("lonx"), laty = sampleQuery.valueFloat("laty");
+
+    for(SqlQuery *q : {&indexQuery, &plainQuery, &spatialQuery})
+    {
+      q->bindValue(":leftx", lonx - SAMPLE_SIZE_DEG / 2.);
+      q->bindValue(":rightx", lonx + SAMPLE_SIZE_DEG / 2.);
+      q->bindValue(":bottomy", laty - SAMPLE_SIZE_DEG / 2.);
+      q->bindValue(":topy", laty + SAMPLE_SIZE_DEG / 2.);
+    }
+
+    if(bandWhere.contains(":leftx"))
+    {
+      bandQuery.bindValue(":leftx", lonx - SAMPLE_SIZE_DEG / 2.);
+      bandQuery.bindValue(":rightx", lonx + SAMPLE_SIZE_DEG / 2.);
+    }
+    else if(bandWhere.contains(":bottomy"))
+    {
+      bandQuery.bindValue(":bottomy", laty - SAMPLE_SIZE_DEG / 2.);
+      bandQuery.bindValue(":topy", laty + SAMPLE_SIZE_DEG / 2.);
+    }
+
+    bandQuery.exec();
+    if(bandQuery.next())
+      rowsPlain += bandQuery.valueInt(0);
+
+    indexQuery.exec();
+    if(indexQuery.next())
+      rowsIndex += indexQuery.valueInt(0);
+
+    timer.restart();
+    plainQuery.exec();
+    while(plainQuery.next())
+      rowsResult++;
+    timePlainNs += timer.nsecsElapsed();
+
+    timer.restart();
+    spatialQuery.exec();
+    while(spatialQuery.next())
+    {
+    }
+    timeIndexNs += timer.nsecsElapsed();
+  }
+
+  qInfo().nospace() << "Spatial index benchmark " << db->databaseName() << " table " << table
+                    << ": " << NUM_SAMPLES << " rectangles " << SAMPLE_SIZE_DEG << " deg"
+                    << ", result rows " << rowsResult
+                    << ", rows visited plain " << rowsPlain << " index " << rowsIndex
+                    << ", time plain " << timePlainNs / 1000 << " us index " << timeIndexNs / 1000 << " us";
 }
 
 void DatabaseManager::openDatabaseFile(atools::sql::SqlDatabase *db, const QString& file, bool readonly,
@@ -1008,42 +1169,50 @@ void DatabaseManager::openDatabaseFile(atools::sql::SqlDatabase *db, const QStri
   }
 }
 
-void DatabaseManager::openDatabaseFileInternal(atools::sql::SqlDatabase *db, const QString& file, bool readonly,
-                                               bool createSchema, bool exclusive, bool autoTransactions)
+QStringList DatabaseManager::databasePragmas(bool readonly, bool exclusive)
 {
   atools::settings::Settings& settings = atools::settings::Settings::instance();
   int databaseCacheKb = settings.getAndStoreValue(lnm::SETTINGS_DATABASE + "CacheKb", 50000).toInt();
   bool foreignKeys = settings.getAndStoreValue(lnm::SETTINGS_DATABASE + "ForeignKeys", false).toBool();
 
   // cache_size * 1024 bytes if value is negative
-  QStringList databasePragmas({QString("PRAGMA cache_size=-%1").arg(databaseCacheKb), "PRAGMA page_size=8196"});
+  QStringList pragmas({QString("PRAGMA cache_size=-%1").arg(databaseCacheKb), "PRAGMA page_size=8196"});
 
   if(exclusive)
   {
     // Best settings for loading databases accessed write only - unsafe
-    databasePragmas.append("PRAGMA locking_mode=EXCLUSIVE");
-    databasePragmas.append("PRAGMA journal_mode=TRUNCATE");
-    databasePragmas.append("PRAGMA synchronous=OFF");
+    pragmas.append("PRAGMA locking_mode=EXCLUSIVE");
+    pragmas.append("PRAGMA journal_mode=TRUNCATE");
+    pragmas.append("PRAGMA synchronous=OFF");
   }
   else
   {
     // Best settings for online and user databases which are updated often - read/write
-    databasePragmas.append("PRAGMA locking_mode=NORMAL");
-    databasePragmas.append("PRAGMA journal_mode=DELETE");
-    databasePragmas.append("PRAGMA synchronous=NORMAL");
+    pragmas.append("PRAGMA locking_mode=NORMAL");
+    pragmas.append("PRAGMA journal_mode=DELETE");
+    pragmas.append("PRAGMA synchronous=NORMAL");
   }
 
-  if(!readonly)
-    databasePragmas.append("PRAGMA busy_timeout=2000");
-
-  qDebug() << "Opening database" << file;
-  db->setDatabaseName(file);
+  // Readers of shared files have to wait for the commit of a writer too
+  if(!readonly || !exclusive)
+    pragmas.append("PRAGMA busy_timeout=2000");
 
   // Set foreign keys only on demand because they can decrease loading performance
   if(foreignKeys)
-    databasePragmas.append("PRAGMA foreign_keys = ON");
+    pragmas.append("PRAGMA foreign_keys = ON");
   else
-    databasePragmas.append("PRAGMA foreign_keys = OFF");
+    pragmas.append("PRAGMA foreign_keys = OFF");
+
+  return pragmas;
+}
+
+void DatabaseManager::openDatabaseFileInternal(atools::sql::SqlDatabase *db, const QString& file, bool readonly,
+                                               bool createSchema, bool exclusive, bool autoTransactions)
+{
+  QStringList databasePragmas = DatabaseManager::databasePragmas(readonly, exclusive);
+
+  qDebug() << "Opening database" << file;
+  db->setDatabaseName(file);
 
   bool autocommit = db->isAutocommit();
   db->setAutocommit(false);
@@ -109,6 +109,10 @@ public:
   /* Load MSFS translations for current language */
   void loadLanguageIndex();
 
+  /* Pragmas used to open database files. Non exclusive settings are needed for files accessed by several
+   * connections like in worker threads. These wait for locks of other connections using a busy timeout. */
+  static QStringList databasePragmas(bool readonly, bool exclusive);
+
   /* Open a writeable database for userpoints or online network data. Automatic transactions are off.  */
   void openWriteableDatabase(atools::sql::SqlDatabase *database, const QString& name, const QString& displayName,
                              bool backup);
@@ -263,6 +267,13 @@ private:
 
   void closeDatabaseFile(atools::sql::SqlDatabase *db);
 
+  /* Create missing or outdated R*Tree spatial index files for the database files showing a progress dialog.
+   * Removes the files if the index is disabled. Queries fall back to coordinate ranges if creation fails. */
+  void updateSpatialIndexFiles(const QStringList& files);
+
+  /* Log rows visited and time for sample rectangle queries with and without spatial index */
+  void spatialIndexBenchmark(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn);
+
   void restoreState();
 
   bool isDatabaseCompatible(atools::sql::SqlDatabase *db);
@@ -62,6 +62,7 @@
 #include "common/unit.h"
 #include "fs/pln/flightplanio.h"
 #include "query/procedurequery.h"
+#include "query/mapqueryprefetcher.h"
 #include "search/proceduresearch.h"
 #include "userdata/userdatacontroller.h"
 #include "online/onlinedatacontroller.h"
@@ -76,6 +77,7 @@
 #include "mapgui/imageexportdialog.h"
 #include "web/webcontroller.h"
 #include "weather/windreporter.h"
+#include "common/paintprofiler.h"
 #include "logbook/logdatacontroller.h"
 #include "search/logdatasearch.h"
 #include "airspace/airspacecontroller.h"
@@ -582,6 +584,7 @@ void MainWindow::debugActionTriggered6()
 
 void MainWindow::updateMap() const
 {
+  mapWidget->invalidateStaticLayers();
   mapWidget->update();
 }
 
@@ -1221,20 +1224,26 @@ void MainWindow::connectAllSlots()
           this, &MainWindow::updateOnlineActionStates);
 
   // Update search
-  connect(onlinedataController, &OnlinedataController::onlineClientAndAtcUpdated,
+  connect(onlinedataController, &OnlinedataController::onlineClientsUpdated,
           clientSearch, &OnlineClientSearch::refreshData);
-  connect(onlinedataController, &OnlinedataController::onlineClientAndAtcUpdated,
+  connect(onlinedataController, &OnlinedataController::onlineAtcUpdated,
           centerSearch, &OnlineCenterSearch::refreshData);
   connect(onlinedataController, &OnlinedataController::onlineServersUpdated,
           serverSearch, &OnlineServerSearch::refreshData);
 
   // Clear cache and update map widget
-  connect(onlinedataController, &OnlinedataController::onlineClientAndAtcUpdated,
+  connect(onlinedataController, &OnlinedataController::onlineAtcUpdated,
           NavApp::getAirspaceController(), &AirspaceController::onlineClientAndAtcUpdated);
   connect(onlinedataController, &OnlinedataController::onlineClientAndAtcUpdated,
           mapWidget, &MapPaintWidget::onlineClientAndAtcUpdated);
   connect(onlinedataController, &OnlinedataController::onlineNetworkChanged,
           mapWidget, &MapPaintWidget::onlineNetworkChanged);
+  connect(onlinedataController, &OnlinedataController::onlineClientPositionsUpdated,
+          mapWidget, &MapPaintWidget::onlineClientPositionsUpdated);
+
+  // Redraw map once objects left out while painting are loaded
+  connect(NavApp::getMapQueryPrefetcher(), &MapQueryPrefetcher::tilesLoaded,
+          mapWidget, &MapPaintWidget::mapQueryTilesLoaded);
 
   // Update info
   connect(onlinedataController, &OnlinedataController::onlineClientAndAtcUpdated,
@@ -1280,6 +1289,8 @@ void MainWindow::connectAllSlots()
   connect(ui->actionOptions, &QAction::triggered, this, &MainWindow::openOptionsDialog);
   connect(ui->actionResetMessages, &QAction::triggered, this, &MainWindow::resetMessages);
   connect(ui->actionSaveAllNow, &QAction::triggered, this, &MainWindow::saveStateNow);
+  connect(ui->actionMapShowPaintProfiler, &QAction::toggled, mapWidget, &MapPaintWidget::setShowPaintProfiler);
+  connect(ui->actionMapExportPaintProfile, &QAction::triggered, this, &MainWindow::mapSavePaintStatistics);
 
   // Windows menu ============================================================
   connect(ui->actionShowFloatingWindows, &QAction::triggered, this, &MainWindow::raiseFloatingWindows);
@@ -1503,7 +1514,6 @@ void MainWindow::connectAllSlots()
 
   // Airway/tracks =======================================================
   TrackController *trackController = NavApp::getTrackController();
-  connect(trackController, &TrackController::postTrackLoad, routeController, &RouteController::clearAirwayNetworkCache);
   connect(trackController, &TrackController::postTrackLoad, infoController, &InfoController::tracksChanged);
   connect(trackController, &TrackController::postTrackLoad, this, &MainWindow::updateMapObjectsShown);
   connect(trackController, &TrackController::postTrackLoad, routeController, &RouteController::tracksChanged);
@@ -2293,6 +2303,7 @@ void MainWindow::routeNew()
   if(routeCheckForChanges())
   {
     routeController->newFlightplan();
+    mapWidget->invalidateStaticLayers();
     mapWidget->update();
     showFlightPlan();
     setStatusMessage(tr("Created new empty flight plan."));
@@ -2307,6 +2318,7 @@ void MainWindow::routeNewFromAirports(map::MapAirport departure, map::MapAirport
     routeController->newFlightplan();
     routeController->routeSetDeparture(departure);
     routeController->routeSetDestination(destination);
+    mapWidget->invalidateStaticLayers();
     mapWidget->update();
     showFlightPlan();
     routeCenter();
@@ -3129,6 +3141,7 @@ void MainWindow::resetMapObjectsShown()
 
   mapWidget->updateMapObjectsShown();
 
+  mapWidget->invalidateStaticLayers();
   mapWidget->update();
   profileWidget->update();
 
@@ -3167,6 +3180,37 @@ void MainWindow::openOptionsDialog()
   optionsDialog->open();
 }
 
+/* Save paint statistics history as CSV or JSON depending on selected filter or file extension */
+void MainWindow::mapSavePaintStatistics()
+{
+  int filterIndex = -1;
+  QString file = dialog->saveFileDialog(
+    tr("Save Map Paint Statistics"),
+    tr("CSV Files (*.csv);;JSON Files (*.json);;All Files (*)"),
+    "csv", "MainWindow/PaintStatistics", atools::documentsDir(),
+    tr("LittleNavmap_PaintStatistics_%1.csv").arg(QDateTime::currentDateTime().toString("yyyyMMddHHmm")),
+    false /* confirm overwrite */, false /* autoNumber */, &filterIndex);
+
+  if(!file.isEmpty())
+  {
+    const PaintProfiler& profiler = mapWidget->getPaintProfiler();
+    bool json = file.endsWith(".json", Qt::CaseInsensitive) || filterIndex == 1;
+
+    QFile outFile(file);
+    if(outFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+      if(json)
+        outFile.write(profiler.toJson());
+      else
+        outFile.write(profiler.toCsv().toUtf8());
+      outFile.close();
+      setStatusMessage(tr("Map paint statistics saved."));
+    }
+    else
+      atools::gui::ErrorHandler(this).handleIOError(outFile, tr("Error saving map paint statistics."));
+  }
+}
+
 /* Reset all "do not show this again" message box status values */
 void MainWindow::resetMessages()
 {
@@ -310,6 +310,9 @@ private:
   void resetAllSettings();
   void showDatabaseFiles();
 
+  /* Save drawing times and query statistics of the map as CSV or JSON */
+  void mapSavePaintStatistics();
+
   /* Save map as images */
   void mapSaveImage();
   void mapSaveImageAviTab();
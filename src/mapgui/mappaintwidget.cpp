@@ -29,6 +29,7 @@
 #include "common/unit.h"
 #include "common/aircrafttrack.h"
 #include "mapgui/aprongeometrycache.h"
+#include "query/mapqueryprefetcher.h"
 
 #include <QPainter>
 #include <QJsonDocument>
@@ -159,6 +160,8 @@ void MapPaintWidget::copySettings(const MapPaintWidget& other)
 
   // Copy own/internal settings
   currentThemeIndex = other.currentThemeIndex;
+
+  // Shares the buffer of the tracks read-only and does not copy positions
   *aircraftTrack = *other.aircraftTrack;
   *aircraftTrackLogbook = *other.aircraftTrackLogbook;
   searchMarkPos = other.searchMarkPos;
@@ -183,6 +186,34 @@ void MapPaintWidget::copyView(const MapPaintWidget& other)
   currentViewBoundingBox = other.viewport()->viewLatLonAltBox();
 }
 
+void MapPaintWidget::invalidateStaticLayers()
+{
+  paintLayer->invalidateStaticLayers();
+  emit staticLayersInvalidated();
+}
+
+void MapPaintWidget::updateDynamic()
+{
+  paintLayer->reuseStaticLayers();
+  update();
+}
+
+const PaintProfiler& MapPaintWidget::getPaintProfiler() const
+{
+  return paintLayer->getPaintProfiler();
+}
+
+void MapPaintWidget::setShowPaintProfiler(bool show)
+{
+  paintLayer->setShowPaintProfiler(show);
+  update();
+}
+
+void MapPaintWidget::setStaticLayersOnly(bool value)
+{
+  paintLayer->setStaticLayersOnly(value);
+}
+
 void MapPaintWidget::setTheme(const QString& theme, int index)
 {
   qDebug() << "setting map theme to index" << index << theme;
@@ -190,6 +221,7 @@ void MapPaintWidget::setTheme(const QString& theme, int index)
   currentThemeIndex = map::MapThemeComboIndex(index);
 
   setThemeInternal(theme);
+  invalidateStaticLayers();
 }
 
 bool MapPaintWidget::isDarkMap() const
@@ -294,11 +326,13 @@ void MapPaintWidget::optionsChanged()
 
   // reloadMap();
   updateCacheSizes();
+  invalidateStaticLayers();
   update();
 }
 
 void MapPaintWidget::styleChanged()
 {
+  invalidateStaticLayers();
   update();
 }
 
@@ -327,14 +361,20 @@ void MapPaintWidget::setShowMapSunShading(bool show)
 void MapPaintWidget::weatherUpdated()
 {
   if(paintLayer->getShownMapObjectDisplayTypes().testFlag(map::AIRPORT_WEATHER))
+  {
+    invalidateStaticLayers();
     update();
+  }
 }
 
 void MapPaintWidget::windUpdated()
 {
   if(paintLayer->getShownMapObjectDisplayTypes().testFlag(map::WIND_BARBS) ||
      paintLayer->getShownMapObjectDisplayTypes().testFlag(map::WIND_BARBS_ROUTE))
+  {
+    invalidateStaticLayers();
     update();
+  }
 }
 
 map::MapWeatherSource MapPaintWidget::getMapWeatherSource() const
@@ -489,6 +529,7 @@ void MapPaintWidget::postDatabaseLoad()
   databaseLoadStatus = false;
   paintLayer->postDatabaseLoad();
   screenIndex->updateAllGeometry(getCurrentViewBoundingBox());
+  invalidateStaticLayers();
   update();
   updateMapVisibleUi();
 }
@@ -864,6 +905,7 @@ void MapPaintWidget::showAircraft(bool centerAircraftChecked)
 void MapPaintWidget::changeRouteHighlights(const QList<int>& routeHighlight)
 {
   screenIndex->setRouteHighlights(routeHighlight);
+  invalidateStaticLayers();
   update();
 }
 
@@ -877,6 +919,7 @@ void MapPaintWidget::routeChanged(bool geometryChanged)
     screenIndex->updateRouteScreenGeometry(getCurrentViewBoundingBox());
   }
   screenIndex->updateIlsScreenGeometry(getCurrentViewBoundingBox());
+  invalidateStaticLayers();
   update();
 }
 
@@ -887,6 +930,7 @@ void MapPaintWidget::routeAltitudeChanged(float)
 
   qDebug() << Q_FUNC_INFO;
   screenIndex->updateAirspaceScreenGeometry(getCurrentViewBoundingBox());
+  invalidateStaticLayers();
   update();
 }
 
@@ -1001,6 +1045,7 @@ void MapPaintWidget::changeApproachHighlight(const proc::MapProcedureLegs& appro
   cancelDragAll();
   screenIndex->getProcedureHighlight() = approach;
   screenIndex->updateRouteScreenGeometry(getCurrentViewBoundingBox());
+  invalidateStaticLayers();
   update();
 }
 
@@ -1023,6 +1068,7 @@ void MapPaintWidget::changeAirwayHighlights(const QList<QList<map::MapAirway> >&
 void MapPaintWidget::updateLogEntryScreenGeometry()
 {
   screenIndex->updateLogEntryScreenGeometry(getCurrentViewBoundingBox());
+  invalidateStaticLayers();
 }
 
 void MapPaintWidget::changeSearchHighlights(const map::MapResult& newHighlights, bool updateAirspace,
@@ -1235,6 +1281,11 @@ void MapPaintWidget::paintEvent(QPaintEvent *paintEvent)
     screenIndex->updateAllGeometry(currentViewBoundingBox);
   }
 
+  // Load objects left out while painting and ahead of the map movement in background - only for the main map
+  if(visibleWidget && !printing && NavApp::getMapQueryPrefetcher() != nullptr)
+    NavApp::getMapQueryPrefetcher()->viewChanged(currentViewBoundingBox, paintLayer->getMapLayer(),
+                                                 paintLayer->getShownMapObjects());
+
   if(paintLayer->isObjectOverflow() || paintLayer->isQueryOverflow())
   {
 #ifdef DEBUG_INFORMATION
@@ -1264,6 +1315,20 @@ bool MapPaintWidget::loadKml(const QString& filename, bool center)
 void MapPaintWidget::onlineClientAndAtcUpdated()
 {
   screenIndex->updateAirspaceScreenGeometry(currentViewBoundingBox);
+  invalidateStaticLayers();
+  update();
+}
+
+void MapPaintWidget::onlineClientPositionsUpdated()
+{
+  if(getShownMapFeatures() & map::AIRCRAFT_ONLINE)
+    updateDynamic();
+}
+
+void MapPaintWidget::mapQueryTilesLoaded()
+{
+  screenIndex->updateAllGeometry(currentViewBoundingBox);
+  invalidateStaticLayers();
   update();
 }
 
@@ -1271,5 +1336,6 @@ void MapPaintWidget::onlineNetworkChanged()
 {
   screenIndex->resetAirspaceOnlineScreenGeometry();
   screenIndex->updateAirspaceScreenGeometry(currentViewBoundingBox);
+  invalidateStaticLayers();
   update();
 }
@@ -34,6 +34,7 @@ class MainWindow;
 class MapPaintLayer;
 class MapScreenIndex;
 class ApronGeometryCache;
+class PaintProfiler;
 
 namespace proc {
 struct MapProcedureLeg;
@@ -71,6 +72,23 @@ public:
   /* Copies the bounding rectangle to this one which will be centered on next resize. */
   void copyView(const MapPaintWidget& other);
 
+  /* Redraw the cached static layers like airports, navaids, airspaces and flight plan on next paint event. */
+  void invalidateStaticLayers();
+
+  /* Schedules a repaint which draws only the dynamic layers like user aircraft, AI and trail on top of the
+   * cached static layers if view and settings did not change. Any other repaint redraws all layers. */
+  void updateDynamic();
+
+  /* Render times and query statistics of the last paint events */
+  const PaintProfiler& getPaintProfiler() const;
+
+  /* Show paint statistics as overlay on the map and update */
+  void setShowPaintProfiler(bool show);
+
+  /* Draw only airports, navaids, airspaces, flight plan and other static layers but no aircraft, tracks,
+   * marks or copyright. Used for web map tiles which are cached. */
+  void setStaticLayersOnly(bool value);
+
   /* streamlined for webmapcontroller from showPosInternal(pos, distanceKm, doubleClick, false) */
   void showPosNotAdjusted(const atools::geo::Pos& pos, float distanceKm);
 
@@ -219,6 +237,12 @@ public:
   /* Whole online network has changed */
   void onlineNetworkChanged();
 
+  /* Redraw map for extrapolated online aircraft positions if these are shown */
+  void onlineClientPositionsUpdated();
+
+  /* Map objects which were left out while painting were loaded in background. Update index and redraw. */
+  void mapQueryTilesLoaded();
+
   /* Redraw map to reflect weather changes */
   void weatherUpdated();
 
@@ -326,6 +350,11 @@ public:
     return currentThemeIndex;
   }
 
+  int getMapDetailLevel() const
+  {
+    return mapDetailLevel;
+  }
+
   /* Logbook display options have changed or new or edited logbook entry */
   void updateLogEntryScreenGeometry();
 
@@ -342,6 +371,9 @@ signals:
   /* Emitted whenever the result exceeds the limit clause in the queries */
   void resultTruncated();
 
+  /* Emitted by invalidateStaticLayers() on data or settings changes which alter the static map content */
+  void staticLayersInvalidated();
+
   /* Update action state in main window (disabled/enabled) */
   void updateActionStates();
 
@@ -31,11 +31,13 @@
 #include "query/mapquery.h"
 #include "query/airwaytrackquery.h"
 #include "query/airportquery.h"
+#include "query/waypointtrackquery.h"
 #include "common/constants.h"
 #include "settings/settings.h"
 #include "airspace/airspacecontroller.h"
 
 #include <marble/GeoDataLineString.h>
+#include <marble/ViewportParams.h>
 
 using atools::geo::Pos;
 using atools::geo::Line;
@@ -45,6 +47,54 @@ using map::MapAirway;
 using Marble::GeoDataLineString;
 using Marble::GeoDataCoordinates;
 
+/* Margin in pixel around the screen for cached map objects which are added to the grid */
+const static int SCREEN_OBJECT_MARGIN = 100;
+
+/* true if both hashes contain the same implicitly shared lists, i.e. the cache was not changed */
+template<typename TYPE>
+static bool isSharedWith(const QHash<int, QList<TYPE> >& hash1, const QHash<int, QList<TYPE> >& hash2)
+{
+  if(hash1.size() != hash2.size())
+    return false;
+
+  for(auto it = hash1.constBegin(); it != hash1.constEnd(); ++it)
+  {
+    auto it2 = hash2.constFind(it.key());
+    if(it2 == hash2.constEnd() || !it2->isSharedWith(it.value()))
+      return false;
+  }
+  return true;
+}
+
+struct MapScreenIndex::ObjectScreenIndex
+{
+  /* Object in snapshot list given by type with screen position. Tower is an airport type. */
+  struct Entry
+  {
+    map::MapTypes type;
+    int index;
+    QPoint point;
+    bool tower;
+  };
+
+  /* Implicitly shared copies of the query caches. Flattened parking and helipads are in objects too.
+   * Parking and helipad hashes are copied from the airport query caches and contain shared lists. */
+  map::MapResult objects;
+  QHash<int, QList<map::MapParking> > parkingCache;
+  QHash<int, QList<map::MapHelipad> > helipadCache;
+
+  /* View used to calculate screen coordinates */
+  qreal centerLonX = 0., centerLatY = 0.;
+  int radius = 0, projection = -1;
+  QSize size;
+  bool valid = false;
+
+  QVector<Entry> entries;
+
+  /* Values are indexes into entries */
+  ScreenGrid grid;
+};
+
 MapScreenIndex::MapScreenIndex(MapPaintWidget *mapPaintWidgetParam, MapPaintLayer *mapPaintLayer)
   : mapPaintWidget(mapPaintWidgetParam), paintLayer(mapPaintLayer)
 {
@@ -55,6 +105,7 @@ MapScreenIndex::MapScreenIndex(MapPaintWidget *mapPaintWidgetParam, MapPaintLaye
   searchHighlights = new map::MapResult;
   approachLegHighlights = new proc::MapProcedureLeg;
   approachHighlight = new proc::MapProcedureLegs;
+  objectIndex = new ObjectScreenIndex;
 }
 
 MapScreenIndex::~MapScreenIndex()
@@ -62,6 +113,7 @@ MapScreenIndex::~MapScreenIndex()
   delete searchHighlights;
   delete approachLegHighlights;
   delete approachHighlight;
+  delete objectIndex;
 }
 
 void MapScreenIndex::copy(const MapScreenIndex& other)
@@ -86,6 +138,16 @@ void MapScreenIndex::copy(const MapScreenIndex& other)
   ilsLines = other.ilsLines;
   routePointsEditable = other.routePointsEditable;
   routePointsAll = other.routePointsAll;
+
+  routeLineGrid = other.routeLineGrid;
+  airwayLineGrid = other.airwayLineGrid;
+  logEntryLineGrid = other.logEntryLineGrid;
+  airspacePolygonGrid = other.airspacePolygonGrid;
+  ilsPolygonGrid = other.ilsPolygonGrid;
+  ilsLineGrid = other.ilsLineGrid;
+
+  // Viewport might differ - rebuild on next query
+  objectIndex->valid = false;
 }
 
 void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceId>& ids, map::MapAirspaceSources source,
@@ -162,33 +224,31 @@ void MapScreenIndex::resetIlsScreenGeometry()
 {
   ilsPolygons.clear();
   ilsLines.clear();
+  ilsPolygonGrid.clear();
+  ilsLineGrid.clear();
 }
 
 void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
   airspacePolygons.clear();
-  if(paintLayer == nullptr || paintLayer->getMapLayer() == nullptr)
-    return;
-
-  // Use ID set to check for duplicates between calls
-  QSet<map::MapAirspaceId> ids;
-
-  // First get geometry from highlights
-  updateAirspaceScreenGeometryInternal(ids, NavApp::getAirspaceController()->getAirspaceSources(), curBox, true);
-
-  if(paintLayer->getMapLayerEffective()->isAirportDiagram())
-    // Airspace appearance is independent of detail settings
-    return;
+  if(paintLayer != nullptr && paintLayer->getMapLayer() != nullptr)
+  {
+    // Use ID set to check for duplicates between calls
+    QSet<map::MapAirspaceId> ids;
 
-  if(!paintLayer->getMapLayer()->isAirspace() || !paintLayer->getShownMapObjects().testFlag(map::AIRSPACE))
-    return;
+    // First get geometry from highlights
+    updateAirspaceScreenGeometryInternal(ids, NavApp::getAirspaceController()->getAirspaceSources(), curBox, true);
 
-  // Do not put into index if nothing is drawn
-  if(mapPaintWidget->distance() >= layer::DISTANCE_CUT_OFF_LIMIT)
-    return;
+    // Airspace appearance is independent of detail settings in airport diagram
+    // Do not put into index if nothing is drawn
+    if(!paintLayer->getMapLayerEffective()->isAirportDiagram() &&
+       paintLayer->getMapLayer()->isAirspace() && paintLayer->getShownMapObjects().testFlag(map::AIRSPACE) &&
+       mapPaintWidget->distance() < layer::DISTANCE_CUT_OFF_LIMIT)
+      // Get geometry from visible airspaces
+      updateAirspaceScreenGeometryInternal(ids, NavApp::getAirspaceController()->getAirspaceSources(), curBox, false);
+  }
 
-  // Get geometry from visible airspaces
-  updateAirspaceScreenGeometryInternal(ids, NavApp::getAirspaceController()->getAirspaceSources(), curBox, false);
+  updatePolygonGrid(airspacePolygonGrid, airspacePolygons);
 }
 
 void MapScreenIndex::updateIlsScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
@@ -272,6 +332,9 @@ void MapScreenIndex::updateIlsScreenGeometry(const Marble::GeoDataLatLonBox& cur
         ilsPolygons.append(std::make_pair(ils.id, polygon));
     }
   }
+
+  updateLineGrid(ilsLineGrid, ilsLines);
+  updatePolygonGrid(ilsPolygonGrid, ilsPolygons);
 }
 
 void MapScreenIndex::updateLogEntryScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
@@ -308,6 +371,8 @@ void MapScreenIndex::updateLogEntryScreenGeometry(const Marble::GeoDataLatLonBox
       }
     }
   }
+
+  updateLineGrid(logEntryLineGrid, logEntryLines);
 }
 
 void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
@@ -325,6 +390,8 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonBox&
 
   // Get geometry from visible airways
   updateAirwayScreenGeometryInternal(ids, curBox, false /* highlight */);
+
+  updateLineGrid(airwayLineGrid, airwayLines);
 }
 
 void MapScreenIndex::updateAirwayScreenGeometryInternal(QSet<int>& ids, const Marble::GeoDataLatLonBox& curBox,
@@ -530,6 +597,187 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonBox& c
     routePointsAll.append(otherPointsEditable);
     routePointsAll.append(otherPointsNotEditable);
   }
+
+  updateLineGrid(routeLineGrid, routeLines);
+}
+
+void MapScreenIndex::updateLineGrid(ScreenGrid& grid, const QList<std::pair<int, QLine> >& lineList) const
+{
+  grid.reset(mapPaintWidget->rect());
+  for(int i = 0; i < lineList.size(); i++)
+    grid.insert(i, lineList.at(i).second);
+}
+
+template<typename ID>
+void MapScreenIndex::updatePolygonGrid(ScreenGrid& grid, const QList<std::pair<ID, QPolygon> >& polygonList) const
+{
+  grid.reset(mapPaintWidget->rect());
+  for(int i = 0; i < polygonList.size(); i++)
+    grid.insert(i, polygonList.at(i).second.boundingRect());
+}
+
+void MapScreenIndex::updateObjectScreenGeometry() const
+{
+  const Marble::ViewportParams *viewport = mapPaintWidget->viewport();
+  ObjectScreenIndex& index = *objectIndex;
+
+  // Get current cache lists - cheap since all are implicitly shared
+  map::MapResult objects;
+  mapQuery->getCachedObjects(objects);
+  QHash<int, QList<map::MapParking> > parkingCache = airportQuery->getParkingCache();
+  QHash<int, QList<map::MapHelipad> > helipadCache = airportQuery->getHelipadCache();
+
+  if(index.valid &&
+     atools::almostEqual(index.centerLonX, viewport->centerLongitude()) &&
+     atools::almostEqual(index.centerLatY, viewport->centerLatitude()) &&
+     index.radius == viewport->radius() && index.size == viewport->size() &&
+     index.projection == viewport->projection() &&
+     // Lists are shared as long as the query caches were not changed
+     index.objects.airports.isSharedWith(objects.airports) && index.objects.vors.isSharedWith(objects.vors) &&
+     index.objects.ndbs.isSharedWith(objects.ndbs) && index.objects.holdings.isSharedWith(objects.holdings) &&
+     index.objects.userpoints.isSharedWith(objects.userpoints) &&
+     index.objects.markers.isSharedWith(objects.markers) && index.objects.ils.isSharedWith(objects.ils) &&
+     isSharedWith(index.parkingCache, parkingCache) && isSharedWith(index.helipadCache, helipadCache))
+    return;
+
+  index.objects = objects;
+  index.parkingCache = parkingCache;
+  index.helipadCache = helipadCache;
+  index.centerLonX = viewport->centerLongitude();
+  index.centerLatY = viewport->centerLatitude();
+  index.radius = viewport->radius();
+  index.size = viewport->size();
+  index.projection = viewport->projection();
+  index.valid = true;
+
+  for(const QList<map::MapParking>& parkings : parkingCache)
+    index.objects.parkings.append(parkings);
+  for(const QList<map::MapHelipad>& helipads : helipadCache)
+    index.objects.helipads.append(helipads);
+
+  // Calculate screen coordinates once ===================================
+  CoordinateConverter conv(viewport);
+  QRect rect = mapPaintWidget->rect().adjusted(-SCREEN_OBJECT_MARGIN, -SCREEN_OBJECT_MARGIN,
+                                               SCREEN_OBJECT_MARGIN, SCREEN_OBJECT_MARGIN);
+  index.entries.clear();
+  index.grid.reset(rect);
+
+  auto addEntry = [&index, &conv, &rect](map::MapTypes type, int i, const Pos& pos, bool tower) -> void
+                  {
+                    int x, y;
+                    if(conv.wToS(pos, x, y) && rect.contains(x, y))
+                    {
+                      index.grid.insert(index.entries.size(), QPoint(x, y));
+                      index.entries.append({type, i, QPoint(x, y), tower});
+                    }
+                  };
+
+  for(int i = 0; i < index.objects.airports.size(); i++)
+  {
+    const map::MapAirport& airport = index.objects.airports.at(i);
+    addEntry(map::AIRPORT, i, airport.position, false);
+    if(airport.towerCoords.isValid())
+      addEntry(map::AIRPORT, i, airport.towerCoords, true);
+  }
+  for(int i = 0; i < index.objects.vors.size(); i++)
+    addEntry(map::VOR, i, index.objects.vors.at(i).position, false);
+  for(int i = 0; i < index.objects.ndbs.size(); i++)
+    addEntry(map::NDB, i, index.objects.ndbs.at(i).position, false);
+  for(int i = 0; i < index.objects.holdings.size(); i++)
+    addEntry(map::HOLDING, i, index.objects.holdings.at(i).position, false);
+  for(int i = 0; i < index.objects.userpoints.size(); i++)
+    addEntry(map::USERPOINT, i, index.objects.userpoints.at(i).position, false);
+  for(int i = 0; i < index.objects.markers.size(); i++)
+    addEntry(map::MARKER, i, index.objects.markers.at(i).position, false);
+  for(int i = 0; i < index.objects.ils.size(); i++)
+    addEntry(map::ILS, i, index.objects.ils.at(i).position, false);
+  for(int i = 0; i < index.objects.parkings.size(); i++)
+    addEntry(map::PARKING, i, index.objects.parkings.at(i).position, false);
+  for(int i = 0; i < index.objects.helipads.size(); i++)
+    addEntry(map::HELIPAD, i, index.objects.helipads.at(i).position, false);
+}
+
+void MapScreenIndex::getNearestScreenObjects(const CoordinateConverter& conv, const MapLayer *mapLayer,
+                                             bool airportDiagram, map::MapTypes types, int xs, int ys,
+                                             int maxDistance, map::MapResult& result) const
+{
+  using maptools::insertSortedByDistance;
+  using maptools::insertSortedByTowerDistance;
+
+  updateObjectScreenGeometry();
+
+  const map::MapResult& objects = objectIndex->objects;
+  bool airports = mapLayer->isAirport() && types.testFlag(map::AIRPORT);
+
+  // Check only objects in cells near the cursor
+  for(int value : objectIndex->grid.query(QPoint(xs, ys), maxDistance))
+  {
+    const ObjectScreenIndex::Entry& entry = objectIndex->entries.at(value);
+    if(atools::geo::manhattanDistance(entry.point.x(), entry.point.y(), xs, ys) >= maxDistance)
+      continue;
+
+    if(entry.type == map::AIRPORT)
+    {
+      const map::MapAirport& airport = objects.airports.at(entry.index);
+      if(airports && airport.isVisible(types))
+      {
+        if(!entry.tower)
+          insertSortedByDistance(conv, result.airports, &result.airportIds, xs, ys, airport);
+        else if(airportDiagram)
+          // Include tower for airport diagrams
+          insertSortedByTowerDistance(conv, result.towers, xs, ys, airport);
+      }
+    }
+    else if(entry.type == map::VOR)
+    {
+      if(mapLayer->isVor() && types.testFlag(map::VOR))
+        insertSortedByDistance(conv, result.vors, &result.vorIds, xs, ys, objects.vors.at(entry.index));
+    }
+    else if(entry.type == map::NDB)
+    {
+      if(mapLayer->isNdb() && types.testFlag(map::NDB))
+        insertSortedByDistance(conv, result.ndbs, &result.ndbIds, xs, ys, objects.ndbs.at(entry.index));
+    }
+    else if(entry.type == map::HOLDING)
+    {
+      if(mapLayer->isHolding() && types.testFlag(map::HOLDING))
+        insertSortedByDistance(conv, result.holdings, &result.holdingIds, xs, ys, objects.holdings.at(entry.index));
+    }
+    else if(entry.type == map::USERPOINT)
+    {
+      // No flag since visibility is defined by type
+      if(mapLayer->isUserpoint())
+        insertSortedByDistance(conv, result.userpoints, &result.userpointIds, xs, ys,
+                               objects.userpoints.at(entry.index));
+    }
+    else if(entry.type == map::MARKER)
+    {
+      if(mapLayer->isMarker() && types.testFlag(map::MARKER))
+        insertSortedByDistance(conv, result.markers, nullptr, xs, ys, objects.markers.at(entry.index));
+    }
+    else if(entry.type == map::ILS)
+    {
+      if(mapLayer->isIls() && types.testFlag(map::ILS))
+        insertSortedByDistance(conv, result.ils, nullptr, xs, ys, objects.ils.at(entry.index));
+    }
+    else if(entry.type == map::PARKING)
+    {
+      // Check parking and helipads in airport diagrams
+      if(airports && airportDiagram)
+        insertSortedByDistance(conv, result.parkings, nullptr, xs, ys, objects.parkings.at(entry.index));
+    }
+    else if(entry.type == map::HELIPAD)
+    {
+      if(airports && airportDiagram)
+        insertSortedByDistance(conv, result.helipads, nullptr, xs, ys, objects.helipads.at(entry.index));
+    }
+  }
+
+  // Add waypoints that displayed together with airways =================================
+  if((mapLayer->isAirwayWaypoint() && (types.testFlag(map::AIRWAYV) || types.testFlag(map::AIRWAYJ))) ||
+     (mapLayer->isTrackWaypoint() && types.testFlag(map::TRACK)) ||
+     (mapLayer->isWaypoint() && types.testFlag(map::WAYPOINT)))
+    NavApp::getWaypointTrackQuery()->getNearestScreenObjects(conv, mapLayer, types, xs, ys, maxDistance, result);
 }
 
 void MapScreenIndex::getAllNearest(int xs, int ys, int maxDistance, map::MapResult& result,
@@ -645,14 +893,14 @@ void MapScreenIndex::getAllNearest(int xs, int ys, int maxDistance, map::MapResu
 
   // Get objects from cache - already present objects will be skipped
   // Airway included to fetch waypoints
-  mapQuery->getNearestScreenObjects(conv, mapLayer, mapLayer->isAirportDiagram() &&
-                                    OptionData::instance().getDisplayOptionsAirport().
-                                    testFlag(optsd::ITEM_AIRPORT_DETAIL_PARKING),
-                                    shown &
-                                    (map::AIRPORT_ALL_ADDON | map::VOR | map::NDB | map::WAYPOINT | map::MARKER |
-                                     map::HOLDING | map::AIRWAYJ | map::TRACK | map::AIRWAYV | map::USERPOINT |
-                                     map::LOGBOOK),
-                                    xs, ys, maxDistance, result);
+  getNearestScreenObjects(conv, mapLayer, mapLayer->isAirportDiagram() &&
+                          OptionData::instance().getDisplayOptionsAirport().
+                          testFlag(optsd::ITEM_AIRPORT_DETAIL_PARKING),
+                          shown &
+                          (map::AIRPORT_ALL_ADDON | map::VOR | map::NDB | map::WAYPOINT | map::MARKER |
+                           map::HOLDING | map::AIRWAYJ | map::TRACK | map::AIRWAYV | map::USERPOINT |
+                           map::LOGBOOK),
+                          xs, ys, maxDistance, result);
 
   // Update all incomplete objects, especially from search
   for(map::MapAirport& obj : result.airports)
@@ -824,12 +1072,13 @@ void MapScreenIndex::updateAllGeometry(const Marble::GeoDataLatLonBox& curBox)
   updateLogEntryScreenGeometry(curBox);
   updateAirspaceScreenGeometry(curBox);
   updateIlsScreenGeometry(curBox);
+  updateObjectScreenGeometry();
 }
 
 /* Get all airways near cursor position */
 void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapResult& result) const
 {
-  for(int i = 0; i < airspacePolygons.size(); i++)
+  for(int i : airspacePolygonGrid.query(QPoint(xs, ys), 0))
   {
     const std::pair<map::MapAirspaceId, QPolygon>& polyPair = airspacePolygons.at(i);
 
@@ -842,11 +1091,13 @@ void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapResult& result)
   }
 }
 
-QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys,
-                                         int maxDistance, bool lineDistanceOnly) const
+QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, const ScreenGrid& grid,
+                                         int xs, int ys, int maxDistance, bool lineDistanceOnly) const
 {
   QSet<int> ids;
-  for(int i = 0; i < lineList.size(); i++)
+
+  // Lines are added to all cells they cross - no margin needed
+  for(int i : grid.query(QPoint(xs, ys), maxDistance))
   {
     const std::pair<int, QLine>& linePair = lineList.at(i);
     const QLine& line = linePair.second;
@@ -877,7 +1128,8 @@ void MapScreenIndex::getNearestLogEntries(int xs, int ys, int maxDistance, map::
   if(paintLayer->getShownMapObjectDisplayTypes().testFlag(map::LOGBOOK_DIRECT) ||
      paintLayer->getShownMapObjectDisplayTypes().testFlag(map::LOGBOOK_ROUTE))
   {
-    for(int id : nearestLineIds(logEntryLines, xs, ys, maxDistance, false /* also distance to points */))
+    for(int id : nearestLineIds(logEntryLines, logEntryLineGrid, xs, ys, maxDistance,
+                                false /* also distance to points */))
       maptools::insertSortedByDistance(conv, result.logbookEntries, &ids, xs, ys,
                                        NavApp::getLogdataController()->getLogEntryById(id));
   }
@@ -890,10 +1142,10 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
     return;
 
   // Get nearest center lines (also considering buffer)
-  QSet<int> ilsIds = nearestLineIds(ilsLines, xs, ys, maxDistance, false /* lineDistanceOnly */);
+  QSet<int> ilsIds = nearestLineIds(ilsLines, ilsLineGrid, xs, ys, maxDistance, false /* lineDistanceOnly */);
 
   // Get nearest ILS by geometry - duplicates are removed in set
-  for(int i = 0; i < ilsPolygons.size(); i++)
+  for(int i : ilsPolygonGrid.query(QPoint(xs, ys), 0))
   {
     const std::pair<int, QPolygon>& polyPair = ilsPolygons.at(i);
     if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
@@ -911,7 +1163,7 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
 /* Get all airways near cursor position */
 void MapScreenIndex::getNearestAirways(int xs, int ys, int maxDistance, map::MapResult& result) const
 {
-  for(int id : nearestLineIds(airwayLines, xs, ys, maxDistance, true /* lineDistanceOnly */))
+  for(int id : nearestLineIds(airwayLines, airwayLineGrid, xs, ys, maxDistance, true /* lineDistanceOnly */))
     result.airways.append(airwayQuery->getAirwayById(id));
 }
 
@@ -923,7 +1175,7 @@ int MapScreenIndex::getNearestRouteLegIndex(int xs, int ys, int maxDistance) con
   int minIndex = -1;
   float minDist = std::numeric_limits<float>::max();
 
-  for(int i = 0; i < routeLines.size(); i++)
+  for(int i : routeLineGrid.query(QPoint(xs, ys), maxDistance))
   {
     const std::pair<int, QLine>& line = routeLines.at(i);
 
@@ -20,6 +20,7 @@
 
 #include "fs/sc/simconnectdata.h"
 #include "common/mapflags.h"
+#include "mapgui/screengrid.h"
 
 namespace atools {
 namespace geo {
@@ -62,12 +63,16 @@ class AirportQuery;
 class MapPaintLayer;
 class MapQuery;
 class CoordinateConverter;
+class MapLayer;
 
 /*
  * Keeps an indes of certain map objects like flight plan lines, airway lines in screen coordinates
  * to allow mouse over reaction.
  * Also maintains distance measurement lines and range rings.
  * All get nearest methods return objects sorted by distance
+ *
+ * Lines, polygons and cached map objects like airports or navaids are added to screen grids when the view
+ * changes. Get nearest methods check only objects in grid cells near the cursor.
  */
 class MapScreenIndex
 {
@@ -277,6 +282,13 @@ public:
 
 private:
   void getNearestAirways(int xs, int ys, int maxDistance, map::MapResult& result) const;
+
+  /* Get airports, navaids, parking and more from the screen grid of cached objects */
+  void getNearestScreenObjects(const CoordinateConverter& conv, const MapLayer *mapLayer, bool airportDiagram,
+                               map::MapTypes types, int xs, int ys, int maxDistance, map::MapResult& result) const;
+
+  /* Update snapshot of cached map objects and the screen grid if view or caches changed since last call */
+  void updateObjectScreenGeometry() const;
   void getNearestLogEntries(int xs, int ys, int maxDistance, map::MapResult& result) const;
 
   void getNearestIls(int xs, int ys, int maxDistance, map::MapResult& result) const;
@@ -294,8 +306,14 @@ private:
                                 const Marble::GeoDataLatLonBox& curBox,
                                 const CoordinateConverter& conv);
 
-  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys, int maxDistance,
-                           bool lineDistanceOnly) const;
+  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, const ScreenGrid& grid,
+                           int xs, int ys, int maxDistance, bool lineDistanceOnly) const;
+
+  /* Rebuild grid for lines or polygons. Values are the indexes in the list. */
+  void updateLineGrid(ScreenGrid& grid, const QList<std::pair<int, QLine> >& lineList) const;
+
+  template<typename ID>
+  void updatePolygonGrid(ScreenGrid& grid, const QList<std::pair<ID, QPolygon> >& polygonList) const;
 
   template<typename TYPE>
   int getNearestIndex(int xs, int ys, int maxDistance, const QList<TYPE>& typeList) const;
@@ -345,6 +363,13 @@ private:
   QList<std::pair<int, QLine> > ilsLines; /* Index ILS center lines separately to allow
                                            * tooltips when getting the cursor near a line */
 
+  /* Grids with indexes into the lists above */
+  ScreenGrid routeLineGrid, airwayLineGrid, logEntryLineGrid, airspacePolygonGrid, ilsPolygonGrid, ilsLineGrid;
+
+  /* Snapshot of map objects from the query caches with screen grid. Updated lazily in const methods. */
+  struct ObjectScreenIndex;
+  ObjectScreenIndex *objectIndex;
+
 };
 
 #endif // LITTLENAVMAP_MAPSCREENINDEX_H
@@ -2434,8 +2434,8 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
       setUpdatesEnabled(true);
 
     if((dataHasChanged || aiVisible) && !contextMenuActive)
-      // Not scrolled or zoomed but needs a redraw
-      update();
+      // Not scrolled or zoomed but needs a redraw - static layers are redrawn only if the view has changed
+      updateDynamic();
   } // if(now - lastSimUpdateMs > deltas.timeDeltaMs)
 }
 
@@ -2719,12 +2719,14 @@ void MapWidget::restoreState()
   // Restore range rings, patterns, holds and more
   getScreenIndex()->restoreState();
 
-  if(OptionData::instance().getFlags() & opts::STARTUP_LOAD_TRAIL)
-    aircraftTrack->restoreState(".track");
+  // Open the track files which are written on each new position
   aircraftTrack->setMaxTrackEntries(OptionData::instance().getAircraftTrackMaxPoints());
+  aircraftTrack->restoreState(".track");
+  if(!(OptionData::instance().getFlags() & opts::STARTUP_LOAD_TRAIL))
+    aircraftTrack->clearTrack();
 
-  aircraftTrackLogbook->restoreState(".logbooktrack");
   aircraftTrackLogbook->setMaxTrackEntries(OptionData::instance().getAircraftTrackMaxPoints());
+  aircraftTrackLogbook->restoreState(".logbooktrack");
 
   atools::gui::WidgetState state(lnm::MAP_OVERLAY_VISIBLE, false /*save visibility*/, true /*block signals*/);
   for(QAction *action : mapOverlays)
@@ -3087,7 +3089,8 @@ void MapWidget::updateMapObjectsShown()
 
   emit shownMapFeaturesChanged(paintLayer->getShownMapObjects());
 
-  // Update widget
+  // Update widget - also called for userpoint and logbook changes
+  invalidateStaticLayers();
   update();
 }
 
@@ -3411,6 +3414,7 @@ void MapWidget::setMapDetail(int factor)
   mapDetailLevel = factor;
   setDetailLevel(mapDetailLevel);
   updateDetailUi(mapDetailLevel);
+  invalidateStaticLayers();
   update();
 
   int det = mapDetailLevel - MapLayerSettings::MAP_DEFAULT_DETAIL_FACTOR;
@@ -0,0 +1,169 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/screengrid.h"
+
+#include <QLine>
+
+#include <cmath>
+#include <limits>
+
+ScreenGrid::ScreenGrid(int cellSizeParam)
+  : cellSize(std::max(cellSizeParam, 1))
+{
+}
+
+void ScreenGrid::reset(const QRect& screenRect)
+{
+  area = screenRect;
+  columns = std::max((area.width() + cellSize - 1) / cellSize, 1);
+  rows = std::max((area.height() + cellSize - 1) / cellSize, 1);
+  numValues = 0;
+
+  cells.clear();
+  cells.resize(columns * rows);
+}
+
+void ScreenGrid::clear()
+{
+  cells.clear();
+  area = QRect();
+  columns = rows = numValues = 0;
+}
+
+void ScreenGrid::insert(int value, const QPoint& point)
+{
+  if(cells.isEmpty())
+    return;
+
+  cells[row(point.y()) * columns + column(point.x())].append(value);
+  numValues++;
+}
+
+/* One boundary test of the Liang-Barsky line clipping. Narrows the parameter range [t0, t1] of the line.
+ * Returns false if the line is completely outside of this boundary. */
+static bool clipBoundary(double p, double q, double& t0, double& t1)
+{
+  if(p == 0.)
+    // Parallel to boundary
+    return q >= 0.;
+
+  double r = q / p;
+  if(p < 0.)
+  {
+    if(r > t1)
+      return false;
+    t0 = std::max(t0, r);
+  }
+  else
+  {
+    if(r < t0)
+      return false;
+    t1 = std::min(t1, r);
+  }
+  return true;
+}
+
+void ScreenGrid::insert(int value, const QLine& line)
+{
+  if(cells.isEmpty())
+    return;
+
+  // Clip line to grid area first - floating point avoids overflows for points far outside of the screen
+  double x1 = line.x1(), y1 = line.y1();
+  double dx = static_cast<double>(line.x2()) - x1, dy = static_cast<double>(line.y2()) - y1;
+  double left = area.left(), top = area.top(), right = left + area.width(), bottom = top + area.height();
+  double t0 = 0., t1 = 1.;
+  if(!clipBoundary(-dx, x1 - left, t0, t1) || !clipBoundary(dx, right - x1, t0, t1) ||
+     !clipBoundary(-dy, y1 - top, t0, t1) || !clipBoundary(dy, bottom - y1, t0, t1))
+    // Completely outside
+    return;
+
+  // Clipped start and end in cell units
+  double startX = (x1 + dx * t0 - left) / cellSize, startY = (y1 + dy * t0 - top) / cellSize;
+  double endX = (x1 + dx * t1 - left) / cellSize, endY = (y1 + dy * t1 - top) / cellSize;
+
+  int col = std::min(std::max(static_cast<int>(startX), 0), columns - 1);
+  int rw = std::min(std::max(static_cast<int>(startY), 0), rows - 1);
+  int endCol = std::min(std::max(static_cast<int>(endX), 0), columns - 1);
+  int endRow = std::min(std::max(static_cast<int>(endY), 0), rows - 1);
+
+  // Walk all crossed cells (DDA) - tMax is the line parameter where the next column or row is entered
+  double cellDx = endX - startX, cellDy = endY - startY;
+  const double INF = std::numeric_limits<double>::infinity();
+  int stepCol = cellDx > 0. ? 1 : -1, stepRow = cellDy > 0. ? 1 : -1;
+  double tDeltaX = cellDx != 0. ? std::abs(1. / cellDx) : INF;
+  double tDeltaY = cellDy != 0. ? std::abs(1. / cellDy) : INF;
+  double tMaxX = cellDx > 0. ? (std::floor(startX) + 1. - startX) * tDeltaX :
+                 (cellDx < 0. ? (startX - std::floor(startX)) * tDeltaX : INF);
+  double tMaxY = cellDy > 0. ? (std::floor(startY) + 1. - startY) * tDeltaY :
+                 (cellDy < 0. ? (startY - std::floor(startY)) * tDeltaY : INF);
+
+  // Number of steps is fixed which guarantees termination at the end cell
+  int steps = std::abs(endCol - col) + std::abs(endRow - rw);
+  cells[rw * columns + col].append(value);
+  for(int i = 0; i < steps; i++)
+  {
+    if(rw == endRow || (col != endCol && tMaxX < tMaxY))
+    {
+      col += stepCol;
+      tMaxX += tDeltaX;
+    }
+    else
+    {
+      rw += stepRow;
+      tMaxY += tDeltaY;
+    }
+    cells[rw * columns + col].append(value);
+  }
+  numValues++;
+}
+
+void ScreenGrid::insert(int value, const QRect& rect)
+{
+  if(cells.isEmpty())
+    return;
+
+  QRect normalized = rect.normalized();
+  int right = column(normalized.right()), bottom = row(normalized.bottom());
+  for(int r = row(normalized.top()); r <= bottom; r++)
+  {
+    for(int c = column(normalized.left()); c <= right; c++)
+      cells[r * columns + c].append(value);
+  }
+  numValues++;
+}
+
+QVector<int> ScreenGrid::query(const QRect& rect) const
+{
+  QVector<int> values;
+  if(numValues == 0)
+    return values;
+
+  QRect normalized = rect.normalized();
+  int right = column(normalized.right()), bottom = row(normalized.bottom());
+  for(int r = row(normalized.top()); r <= bottom; r++)
+  {
+    for(int c = column(normalized.left()); c <= right; c++)
+      values.append(cells.at(r * columns + c));
+  }
+
+  // Values covering more than one cell are returned more than once
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_SCREENGRID_H
+#define LITTLENAVMAP_SCREENGRID_H
+
+#include <algorithm>
+
+#include <QRect>
+#include <QVector>
+
+class QLine;
+
+/*
+ * Uniform grid of cells in screen coordinates which allows to find objects near the cursor without checking all.
+ *
+ * Values are usually indexes into a list of objects which is kept elsewhere.
+ * Points outside of the grid area are added to the nearest border cell.
+ * A query returns all values of cells touching the query rectangle. The caller has to do the exact check.
+ */
+class ScreenGrid
+{
+public:
+  explicit ScreenGrid(int cellSizeParam = 32);
+
+  /* Remove all values and cover the given screen rectangle */
+  void reset(const QRect& screenRect);
+
+  void clear();
+
+  /* Add value to the cell containing the point */
+  void insert(int value, const QPoint& point);
+
+  /* Add value to all cells crossed by the line. The line is clipped to the grid area and nothing is
+   * added if it is completely outside. */
+  void insert(int value, const QLine& line);
+
+  /* Add value to all cells touching the rectangle */
+  void insert(int value, const QRect& rect);
+
+  /* Get values of all cells touching the rectangle. Values are sorted and unique. */
+  QVector<int> query(const QRect& rect) const;
+
+  /* Same as above for a rectangle around the point with the given distance */
+  QVector<int> query(const QPoint& point, int distance) const
+  {
+    return query(QRect(point.x() - distance, point.y() - distance, distance * 2 + 1, distance * 2 + 1));
+  }
+
+  bool isEmpty() const
+  {
+    return numValues == 0;
+  }
+
+private:
+  int column(int x) const
+  {
+    return std::min(std::max((x - area.left()) / cellSize, 0), columns - 1);
+  }
+
+  int row(int y) const
+  {
+    return std::min(std::max((y - area.top()) / cellSize, 0), rows - 1);
+  }
+
+  int cellSize, columns = 0, rows = 0, numValues = 0;
+  QRect area;
+  QVector<QVector<int> > cells;
+};
+
+#endif // LITTLENAVMAP_SCREENGRID_H
@@ -309,11 +309,12 @@ void MapPainter::drawCross(Marble::GeoPainter *painter, int x, int y, int size)
   painter->drawLine(x - size, y, x + size, y);
 }
 
-void MapPainter::drawLineString(Marble::GeoPainter *painter, const atools::geo::LineString& linestring)
+void MapPainter::drawLineString(Marble::GeoPainter *painter, const atools::geo::LineString& linestring,
+                                int startIndex)
 {
   GeoDataLineString ls;
   ls.setTessellate(true);
-  for(int i = 1; i < linestring.size(); i++)
+  for(int i = std::max(startIndex + 1, 1); i < linestring.size(); i++)
   {
     if(linestring.at(i - 1).almostEqual(linestring.at(i)))
       // Do not draw  duplicates
@@ -293,7 +293,8 @@ protected:
   void paintCircle(Marble::GeoPainter *painter, const atools::geo::Pos& centerPos,
                    float radiusNm, bool fast, int& xtext, int& ytext);
 
-  void drawLineString(Marble::GeoPainter *painter, const atools::geo::LineString& linestring);
+  /* Draw positions of linestring from startIndex to the end */
+  void drawLineString(Marble::GeoPainter *painter, const atools::geo::LineString& linestring, int startIndex = 0);
   void drawLine(Marble::GeoPainter *painter, const atools::geo::Line& line);
 
   /* Draw simple text with current settings. Corners are the text corners pointing to the position */
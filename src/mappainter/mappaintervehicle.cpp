@@ -163,8 +163,24 @@ void MapPainterVehicle::paintAircraftTrack()
   {
     context->painter->setPen(mapcolors::aircraftTrailPen(context->sz(context->thicknessTrail, 2)));
 
-    for(const LineString& line : aircraftTrack.getLineStrings())
-      drawLineString(context->painter, line);
+    // Use simplified geometry where removed positions deviate less than a pixel
+    float pixelPerDegree = scale->getPixelForNm(60.f);
+    int level = pixelPerDegree > 0.f ? AircraftTrack::getLevelOfDetail(1.f / pixelPerDegree) : -1;
+
+    for(const at::AircraftTrackSegment& segment : aircraftTrack.getSegments())
+    {
+      if(!segment.crossesAntiMeridian && !context->viewportRect.overlaps(segment.bounding))
+        continue;
+
+      if(level == -1 || segment.levels.isEmpty())
+        drawLineString(context->painter, segment.line);
+      else
+      {
+        // Draw simplified part and positions not simplified yet
+        drawLineString(context->painter, segment.levels.at(level));
+        drawLineString(context->painter, segment.line, segment.getTailStart());
+      }
+    }
   }
 }
 
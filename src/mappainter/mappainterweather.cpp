@@ -125,12 +125,19 @@ void MapPainterWeather::render()
   std::sort(visibleAirportWeather.begin(), visibleAirportWeather.end(),
             std::bind(&MapPainter::sortAirportFunction, this, _1, _2));
 
-  WeatherReporter *reporter = NavApp::getWeatherReporter();
+  // Resolve weather for all airports at once ======================================
+  QVector<const MapAirport *> airports;
+  airports.reserve(visibleAirportWeather.size());
   for(const PaintAirportType& airportWeather: visibleAirportWeather)
+    airports.append(airportWeather.airport);
+
+  QVector<atools::fs::weather::Metar> metars =
+    NavApp::getWeatherReporter()->getAirportWeather(airports, context->weatherSource);
+
+  for(int i = 0; i < visibleAirportWeather.size(); i++)
   {
-    atools::fs::weather::Metar metar =
-      reporter->getAirportWeather(airportWeather.airport->ident,
-                                  airportWeather.airport->position, context->weatherSource);
+    const atools::fs::weather::Metar& metar = metars.at(i);
+    const PaintAirportType& airportWeather = visibleAirportWeather.at(i);
 
     if(metar.isValid())
       drawAirportWeather(metar, static_cast<float>(airportWeather.point.x()),
@@ -41,10 +41,12 @@
 #include "route/route.h"
 #include "geo/calculations.h"
 #include "options/optiondata.h"
+#include "query/mapqueryprefetcher.h"
 
 #include <QElapsedTimer>
 
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -501,6 +503,10 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
   Q_UNUSED(renderPos)
   Q_UNUSED(layer)
 
+  // Reuse is allowed only for the paint event following a call to reuseStaticLayers()
+  bool reuseStatic = staticLayersReuse;
+  staticLayersReuse = false;
+
   if(!databaseLoadStatus && !mapWidget->isNoNavPaint())
   {
     // Update map scale for screen distance approximation
@@ -590,6 +596,10 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
       context.weatherSource = weatherSource;
       context.visibleWidget = mapWidget->isVisibleWidget();
 
+      // Leave out missing tiles and load them in background only for the visible map
+      if(NavApp::getMapQueryPrefetcher() != nullptr)
+        NavApp::getMapQueryPrefetcher()->setPaintingVisibleMap(context.visibleWidget && !mapWidget->isPrinting());
+
       // ====================================
       // Get all waypoints from the route and add them to the map to avoid duplicate drawing
       if(context.objectDisplayTypes.testFlag(map::FLIGHTPLAN))
@@ -663,68 +673,214 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
       // =========================================================================
       // Draw ====================================
 
-      // Altitude below all others
-      mapPainterAltitude->render();
+      profiler.beginFrame(context.distance);
+      bool staticLayersCached = false;
 
-      // Ship below other navaids and airports
-      mapPainterShip->render();
+      // Use cached static layers only for the visible map while it is not moving
+      bool useCache = mapWidget->isVisibleWidget() && !mapWidget->isPrinting() &&
+                      mapWidget->viewContext() == Marble::Still;
+      StaticLayerKey key;
+      if(useCache)
+      {
+        key = staticLayerKey(painter, viewport);
+
+        // Center changes with each update if the map follows the aircraft. Drawing into the images and
+        // copying these would be slower than drawing directly. Fill the cache once the center remains unchanged.
+        useCache = key.hasSameCenter(staticLayersKey);
+        if(!useCache)
+          staticLayersKey = key;
+      }
 
-      if(mapWidget->distance() < layer::DISTANCE_CUT_OFF_LIMIT)
+      if(useCache)
       {
-        if(!context.isObjectOverflow())
-          mapPainterAirspace->render();
+        staticLayersCached = !updateStaticLayerCache(painter, viewport, key, reuseStatic);
+
+        // Static layers were drawn with the same settings and data before
+        context.objectCount = staticLayersObjectCount;
+        context.queryOverflow = staticLayersQueryOverflow;
 
-        if(context.mapLayer->isAirportDiagram())
         {
-          // Put ILS below and navaids on top of airport diagram
-          if(!context.isObjectOverflow())
-            mapPainterIls->render();
+          PaintProfiler::Timer timer(profiler, "Static layer image below ships", context.objectCount);
+          painter->drawPixmap(0, 0, staticLayersBelowShips);
+        }
 
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
+        // Ship below other navaids and airports
+        renderPainter(mapPainterShip, "Ships");
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
-        }
-        else
-        {
-          // Airports on top of all
-          if(!context.isObjectOverflow())
-            mapPainterIls->render();
+        PaintProfiler::Timer timer(profiler, "Static layer image", context.objectCount);
+        painter->drawPixmap(0, 0, staticLayers);
+      }
+      else
+      {
+        // Draw all directly if moving, following the aircraft, printing or for web map
+        staticLayersValid = false;
+        renderStaticLayersBelowShips();
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
+        if(!staticLayersOnly)
+          renderPainter(mapPainterShip, "Ships");
 
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
-        }
+        renderStaticLayers();
       }
 
+      if(!staticLayersOnly)
+        renderDynamicLayers();
+
+      profiler.endFrame(context.objectCount, staticLayersCached);
+    }
+
+    if(!mapWidget->isPrinting() && mapWidget->isVisibleWidget())
+    {
+      // Dim the map by drawing a semi-transparent black rectangle - but not for printing or web services
+      mapcolors::darkenPainterRect(*painter);
+
+      if(showPaintProfiler)
+        profiler.paintOverlay(painter, mapWidget->rect());
+    }
+  }
+  return true;
+}
+
+void MapPaintLayer::renderPainter(MapPainter *painter, const char *name)
+{
+  PaintProfiler::Timer timer(profiler, name, context.objectCount);
+  painter->render();
+}
+
+void MapPaintLayer::renderStaticLayersBelowShips()
+{
+  // Altitude below all others
+  renderPainter(mapPainterAltitude, "MORA");
+}
+
+void MapPaintLayer::renderStaticLayers()
+{
+  if(mapWidget->distance() < layer::DISTANCE_CUT_OFF_LIMIT)
+  {
+    if(!context.isObjectOverflow())
+      renderPainter(mapPainterAirspace, "Airspaces");
+
+    if(context.mapLayer->isAirportDiagram())
+    {
+      // Put ILS below and navaids on top of airport diagram
       if(!context.isObjectOverflow())
-        mapPainterUser->render();
+        renderPainter(mapPainterIls, "ILS");
 
       if(!context.isObjectOverflow())
-        mapPainterWind->render();
+        renderPainter(mapPainterAirport, "Airports");
 
-      // if(!context.isOverflow()) always paint route even if number of objects is too large
-      mapPainterRoute->render();
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterNav, "Navaids");
+    }
+    else
+    {
+      // Airports on top of all
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterIls, "ILS");
 
       if(!context.isObjectOverflow())
-        mapPainterWeather->render();
+        renderPainter(mapPainterNav, "Navaids");
 
       if(!context.isObjectOverflow())
-        mapPainterTrack->render();
+        renderPainter(mapPainterAirport, "Airports");
+    }
+  }
 
-      mapPainterMark->render();
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterUser, "Userpoints");
 
-      mapPainterAircraft->render();
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterWind, "Wind");
 
-      mapPainterTop->render();
-    }
+  // if(!context.isOverflow()) always paint route even if number of objects is too large
+  renderPainter(mapPainterRoute, "Flight plan");
 
-    if(!mapWidget->isPrinting() && mapWidget->isVisibleWidget())
-      // Dim the map by drawing a semi-transparent black rectangle - but not for printing or web services
-      mapcolors::darkenPainterRect(*painter);
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterWeather, "Weather");
+}
+
+void MapPaintLayer::renderDynamicLayers()
+{
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterTrack, "Trail");
+
+  renderPainter(mapPainterMark, "Marks");
+
+  renderPainter(mapPainterAircraft, "Aircraft");
+
+  renderPainter(mapPainterTop, "Top");
+}
+
+MapPaintLayer::StaticLayerKey MapPaintLayer::staticLayerKey(GeoPainter *painter, ViewportParams *viewport) const
+{
+  StaticLayerKey key;
+  key.centerLon = viewport->centerLongitude();
+  key.centerLat = viewport->centerLatitude();
+  key.radius = viewport->radius();
+  key.projection = viewport->projection();
+  key.size = viewport->size();
+  key.devicePixelRatio = painter->device()->devicePixelRatioF();
+  key.objectTypes = objectTypes;
+  key.objectDisplayTypes = objectDisplayTypes;
+  key.airspaceTypes = airspaceTypes.types;
+  key.airspaceFlags = airspaceTypes.flags;
+  key.weatherSource = weatherSource;
+  key.detailFactor = detailFactor;
+  key.activeLegIndex = NavApp::getRouteConst().getActiveLegIndex();
+  key.darkMap = context.darkMap;
+  key.userPointTypes = context.userPointTypes;
+  key.userPointTypeUnknown = context.userPointTypeUnknown;
+  return key;
+}
+
+bool MapPaintLayer::updateStaticLayerCache(GeoPainter *painter, ViewportParams *viewport, const StaticLayerKey& key,
+                                           bool reuse)
+{
+  if(reuse && staticLayersValid && key == staticLayersKey)
+    return false;
+
+#ifdef DEBUG_INFORMATION_PAINT
+  QElapsedTimer timer;
+  timer.start();
+#endif
+
+  // Draw into offscreen pixmaps below and above ships using the same projection and painter settings
+  for(QPixmap *pixmap : {&staticLayersBelowShips, &staticLayers})
+  {
+    if(pixmap->size() != key.size * key.devicePixelRatio)
+      *pixmap = QPixmap(key.size * key.devicePixelRatio);
+    pixmap->setDevicePixelRatio(key.devicePixelRatio);
+    pixmap->fill(Qt::transparent);
+
+    GeoPainter cachePainter(pixmap, viewport, mapWidget->mapQuality(mapWidget->viewContext()));
+    cachePainter.setRenderHints(painter->renderHints());
+    cachePainter.setFont(context.defaultFont);
+
+    context.painter = &cachePainter;
+    if(pixmap == &staticLayersBelowShips)
+      renderStaticLayersBelowShips();
+    else
+      renderStaticLayers();
+    context.painter = painter;
   }
+
+  staticLayersKey = key;
+  staticLayersValid = true;
+  staticLayersObjectCount = context.objectCount;
+  staticLayersQueryOverflow = context.queryOverflow;
+
+#ifdef DEBUG_INFORMATION_PAINT
+  qDebug() << Q_FUNC_INFO << "static layers redrawn in" << timer.elapsed() << "ms";
+#endif
   return true;
 }
+
+bool MapPaintLayer::StaticLayerKey::operator==(const MapPaintLayer::StaticLayerKey& other) const
+{
+  // Cached layers cannot be moved since nothing is drawn outside of the view - center has to match too
+  return hasSameCenter(other) && radius == other.radius && projection == other.projection && size == other.size &&
+         devicePixelRatio == other.devicePixelRatio && objectTypes == other.objectTypes &&
+         objectDisplayTypes == other.objectDisplayTypes && airspaceTypes == other.airspaceTypes &&
+         airspaceFlags == other.airspaceFlags && weatherSource == other.weatherSource &&
+         detailFactor == other.detailFactor && activeLegIndex == other.activeLegIndex && darkMap == other.darkMap &&
+         userPointTypes == other.userPointTypes && userPointTypeUnknown == other.userPointTypeUnknown;
+}
@@ -19,8 +19,10 @@
 #define LITTLENAVMAP_MAPPAINTLAYER_H
 
 #include "mappainter/mappainter.h"
+#include "common/paintprofiler.h"
 
 #include <QPen>
+#include <QPixmap>
 
 #include <marble/LayerInterface.h>
 
@@ -157,10 +159,101 @@ public:
     return context.isQueryOverflow();
   }
 
+  /* Forces a full redraw of the cached static layers like airports, navaids, airspaces and flight plan
+   * on next paint event. */
+  void invalidateStaticLayers()
+  {
+    staticLayersValid = false;
+  }
+
+  /* Allows the next paint event to use the cached static layers if view and settings are unchanged.
+   * Only for updates which change dynamic layers like aircraft and trail. All other paint events redraw. */
+  void reuseStaticLayers()
+  {
+    staticLayersReuse = true;
+  }
+
+  /* Render times and query statistics of the last paint events */
+  const PaintProfiler& getPaintProfiler() const
+  {
+    return profiler;
+  }
+
+  /* Show statistics of the last frame in the lower left corner. Only for the visible widget. */
+  void setShowPaintProfiler(bool show)
+  {
+    showPaintProfiler = show;
+  }
+
+  bool isShowPaintProfiler() const
+  {
+    return showPaintProfiler;
+  }
+
+  /* Skip dynamic layers like aircraft, tracks, marks and copyright if true. Used for web map tiles. */
+  void setStaticLayersOnly(bool value)
+  {
+    staticLayersOnly = value;
+  }
+
+  bool isStaticLayersOnly() const
+  {
+    return staticLayersOnly;
+  }
+
 private:
+  /* Values which require a redraw of the static layers if changed */
+  struct StaticLayerKey
+  {
+    /* Center in radians */
+    double centerLon = 0., centerLat = 0.;
+    int radius = 0, projection = 0;
+    QSize size;
+    qreal devicePixelRatio = 1.;
+    map::MapTypes objectTypes = map::NONE;
+    map::MapObjectDisplayTypes objectDisplayTypes = map::DISPLAY_TYPE_NONE;
+    map::MapAirspaceTypes airspaceTypes;
+    map::MapAirspaceFlags airspaceFlags;
+    map::MapWeatherSource weatherSource = map::WEATHER_SOURCE_SIMULATOR;
+    int detailFactor = 10, activeLegIndex = -1;
+    bool darkMap = false, userPointTypeUnknown = false;
+    QStringList userPointTypes;
+
+    bool operator==(const StaticLayerKey& other) const;
+
+    bool hasSameCenter(const StaticLayerKey& other) const
+    {
+      return centerLon == other.centerLon && centerLat == other.centerLat;
+    }
+
+    bool operator!=(const StaticLayerKey& other) const
+    {
+      return !operator==(other);
+    }
+
+  };
+
   void initMapLayerSettings();
   void updateLayers();
 
+  /* Call render on painter and record time and object count in the profiler */
+  void renderPainter(MapPainter *painter, const char *name);
+
+  /* Painters which depend only on view and loaded data. Split into layers below and above ships. */
+  void renderStaticLayersBelowShips();
+  void renderStaticLayers();
+
+  /* Painters which change with each simulator update. Drawn on top of the static layers. */
+  void renderDynamicLayers();
+
+  /* Get key for the current view and settings */
+  StaticLayerKey staticLayerKey(Marble::GeoPainter *painter, Marble::ViewportParams *viewport) const;
+
+  /* Draw static layers into the offscreen pixmaps unless reuse is requested and the key is unchanged.
+   * Returns true if the layers were redrawn. */
+  bool updateStaticLayerCache(Marble::GeoPainter *painter, Marble::ViewportParams *viewport,
+                              const StaticLayerKey& key, bool reuse);
+
   /* Implemented from LayerInterface: We  draw above all but below user tools */
   virtual QStringList renderPosition() const override
   {
@@ -201,6 +294,20 @@ private:
   MapPainterWeather *mapPainterWeather;
   MapPainterWind *mapPainterWind;
 
+  /* Offscreen images of the static layers below and above ships drawn with a transparent background.
+   * Only used for the visible widget and when the map is still and not following the aircraft. */
+  QPixmap staticLayersBelowShips, staticLayers;
+  StaticLayerKey staticLayersKey;
+  bool staticLayersValid = false, staticLayersReuse = false;
+
+  /* Object count and overflow status of the last static layer drawing */
+  int staticLayersObjectCount = 0;
+  bool staticLayersQueryOverflow = false;
+
+  PaintProfiler profiler;
+  bool showPaintProfiler = false;
+  bool staticLayersOnly = false;
+
   MapScale *mapScale = nullptr;
   MapLayerSettings *layers = nullptr;
   MapPaintWidget *mapWidget = nullptr;
@@ -41,6 +41,7 @@
 #include "query/airportquery.h"
 #include "query/infoquery.h"
 #include "query/mapquery.h"
+#include "query/mapqueryprefetcher.h"
 #include "query/procedurequery.h"
 #include "query/waypointtrackquery.h"
 #include "route/routecontroller.h"
@@ -62,6 +63,7 @@
 AirportQuery *NavApp::airportQuerySim = nullptr;
 AirportQuery *NavApp::airportQueryNav = nullptr;
 MapQuery *NavApp::mapQuery = nullptr;
+MapQueryPrefetcher *NavApp::mapQueryPrefetcher = nullptr;
 InfoQuery *NavApp::infoQuery = nullptr;
 ProcedureQuery *NavApp::procedureQuery = nullptr;
 
@@ -156,9 +158,12 @@ void NavApp::init(MainWindow *mainWindowParam)
   aircraftPerfController = new AircraftPerfController(mainWindow);
 
   mapQuery = new MapQuery(databaseManager->getDatabaseSim(), databaseManager->getDatabaseNav(),
-                          databaseManager->getDatabaseUser());
+                          databaseManager->getDatabaseUser(), query::QuerySettings::read());
   mapQuery->initQueries();
 
+  mapQueryPrefetcher = new MapQueryPrefetcher(mainWindow);
+  mapQueryPrefetcher->postDatabaseLoad();
+
   airspaceController = new AirspaceController(mainWindow,
                                               databaseManager->getDatabaseSimAirspace(),
                                               databaseManager->getDatabaseNavAirspace(),
@@ -253,6 +258,10 @@ void NavApp::deInit()
   delete airportQueryNav;
   airportQueryNav = nullptr;
 
+  qDebug() << Q_FUNC_INFO << "delete mapQueryPrefetcher";
+  delete mapQueryPrefetcher;
+  mapQueryPrefetcher = nullptr;
+
   qDebug() << Q_FUNC_INFO << "delete mapQuery";
   delete mapQuery;
   mapQuery = nullptr;
@@ -349,6 +358,7 @@ void NavApp::preDatabaseLoad()
 
   loadingDatabase = true;
   infoQuery->deInitQueries();
+  mapQueryPrefetcher->preDatabaseLoad();
   mapQuery->deInitQueries();
   airportQuerySim->deInitQueries();
   airportQueryNav->deInitQueries();
@@ -377,6 +387,7 @@ void NavApp::postDatabaseLoad()
   airportQuerySim->initQueries();
   airportQueryNav->initQueries();
   mapQuery->initQueries();
+  mapQueryPrefetcher->postDatabaseLoad();
   infoQuery->initQueries();
   procedureQuery->initQueries();
   moraReader->postDatabaseLoad();
@@ -484,7 +495,10 @@ const atools::geo::Pos& NavApp::getUserAircraftPos()
 void NavApp::updateAllMaps()
 {
   if(mainWindow->getMapWidget() != nullptr)
+  {
+    mainWindow->getMapWidget()->invalidateStaticLayers();
     mainWindow->getMapWidget()->update();
+  }
 
   if(mainWindow->getProfileWidget() != nullptr)
     mainWindow->getProfileWidget()->update();
@@ -510,6 +524,11 @@ MapQuery *NavApp::getMapQuery()
   return mapQuery;
 }
 
+MapQueryPrefetcher *NavApp::getMapQueryPrefetcher()
+{
+  return mapQueryPrefetcher;
+}
+
 AirwayTrackQuery *NavApp::getAirwayTrackQuery()
 {
   return trackController->getAirwayTrackQuery();
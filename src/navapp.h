@@ -41,6 +41,7 @@ class LogdataSearch;
 class MainWindow;
 class MapPaintWidget;
 class MapQuery;
+class MapQueryPrefetcher;
 class MapWidget;
 class OnlinedataController;
 class OptionsDialog;
@@ -190,6 +191,7 @@ public:
   static AirportQuery *getAirportQuerySim();
   static AirportQuery *getAirportQueryNav();
   static MapQuery *getMapQuery();
+  static MapQueryPrefetcher *getMapQueryPrefetcher();
 
   static atools::geo::Pos getAirportPos(const QString& ident);
 
@@ -379,6 +381,7 @@ private:
   /* Database query helpers and caches */
   static AirportQuery *airportQuerySim, *airportQueryNav;
   static MapQuery *mapQuery;
+  static MapQueryPrefetcher *mapQueryPrefetcher;
   static InfoQuery *infoQuery;
   static ProcedureQuery *procedureQuery;
   static ElevationProvider *elevationProvider;
@@ -0,0 +1,146 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "online/onlineclientstore.h"
+
+#include "fs/online/onlinedatamanager.h"
+#include "geo/calculations.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <marble/GeoDataLatLonBox.h>
+
+#include <QDateTime>
+
+#include <cmath>
+
+using atools::fs::sc::SimConnectAircraft;
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+
+/* Two degree cells result in 180 x 90 cells */
+static const double CELL_SIZE_DEG = 2.;
+static const int COLUMNS = static_cast<int>(360. / CELL_SIZE_DEG);
+static const int ROWS = static_cast<int>(180. / CELL_SIZE_DEG);
+
+/* Do not extrapolate slow aircraft which are taxiing or where the reported speed is noise */
+static const float MIN_EXTRAPOLATION_SPEED_KTS = 40.f;
+
+OnlineClientStore::OnlineClientStore()
+{
+  cellStart.fill(0, COLUMNS * ROWS + 1);
+}
+
+int OnlineClientStore::cellColumn(double lonxDeg)
+{
+  return std::min(std::max(static_cast<int>(std::floor((lonxDeg + 180.) / CELL_SIZE_DEG)), 0), COLUMNS - 1);
+}
+
+int OnlineClientStore::cellRow(double latyDeg)
+{
+  return std::min(std::max(static_cast<int>(std::floor((latyDeg + 90.) / CELL_SIZE_DEG)), 0), ROWS - 1);
+}
+
+void OnlineClientStore::build(atools::sql::SqlDatabase *db)
+{
+  timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+  // Read all clients into the parallel arrays ===========================
+  atools::sql::SqlQuery query(db);
+  query.exec("select * from client");
+  while(query.next())
+  {
+    atools::sql::SqlRecord record = query.record();
+
+    SimConnectAircraft ac;
+    atools::fs::online::OnlinedataManager::fillFromClient(ac, record);
+
+    // Keep first for duplicate callsigns
+    QString callsign = record.valueStr("callsign");
+    if(!callsignIndex.contains(callsign))
+      callsignIndex.insert(callsign, aircraft.size());
+
+    lonx.append(ac.getPosition().getLonX());
+    laty.append(ac.getPosition().getLatY());
+
+    float speed = ac.getGroundSpeedKts(), heading = ac.getHeadingDegTrue();
+    if(ac.isOnGround() || speed < MIN_EXTRAPOLATION_SPEED_KTS || speed >= atools::fs::sc::SC_INVALID_FLOAT ||
+       heading >= atools::fs::sc::SC_INVALID_FLOAT)
+      speed = heading = 0.f;
+    groundSpeedKts.append(speed);
+    headingDegTrue.append(heading);
+
+    aircraft.append(ac);
+  }
+
+  // Sort indexes into grid cells (counting sort) ===========================
+  QVector<int> cells(aircraft.size());
+  for(int i = 0; i < aircraft.size(); i++)
+  {
+    cells[i] = cellRow(laty.at(i)) * COLUMNS + cellColumn(lonx.at(i));
+    cellStart[cells.at(i) + 1]++;
+  }
+
+  // Counts to start offsets
+  for(int i = 1; i < cellStart.size(); i++)
+    cellStart[i] += cellStart.at(i - 1);
+
+  QVector<int> fill(cellStart);
+  cellIndexes.resize(aircraft.size());
+  for(int i = 0; i < aircraft.size(); i++)
+    cellIndexes[fill[cells.at(i)]++] = i;
+}
+
+atools::geo::Pos OnlineClientStore::getPosition(int index, qint64 nowMs, int maxSeconds) const
+{
+  atools::geo::Pos pos(lonx.at(index), laty.at(index));
+
+  float speed = groundSpeedKts.at(index);
+  float seconds = std::min((nowMs - timestampMs) / 1000.f, static_cast<float>(maxSeconds));
+  if(speed > 0.f && seconds > 0.f)
+    return pos.endpoint(atools::geo::nmToMeter(speed * seconds / 3600.f), headingDegTrue.at(index));
+  else
+    return pos;
+}
+
+void OnlineClientStore::getIndexes(QVector<int>& indexes, const GeoDataLatLonBox& rect) const
+{
+  if(aircraft.isEmpty())
+    return;
+
+  double west = rect.west(GeoDataCoordinates::Degree), east = rect.east(GeoDataCoordinates::Degree);
+  double south = rect.south(GeoDataCoordinates::Degree), north = rect.north(GeoDataCoordinates::Degree);
+
+  int x1 = cellColumn(west), x2 = cellColumn(east), y1 = cellRow(south), y2 = cellRow(north);
+
+  for(int y = y1; y <= y2; y++)
+  {
+    for(int x = x1; x <= x2; x++)
+    {
+      int cell = y * COLUMNS + x;
+      for(int i = cellStart.at(cell); i < cellStart.at(cell + 1); i++)
+      {
+        // Cells on the border are only partially covered by the rectangle
+        int index = cellIndexes.at(i);
+        float lon = lonx.at(index), lat = laty.at(index);
+        if(lon >= west && lon <= east && lat >= south && lat <= north)
+          indexes.append(index);
+      }
+    }
+  }
+}
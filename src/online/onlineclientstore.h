@@ -0,0 +1,112 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ONLINECLIENTSTORE_H
+#define LNM_ONLINECLIENTSTORE_H
+
+#include "fs/sc/simconnectaircraft.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace Marble {
+class GeoDataLatLonBox;
+}
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/*
+ * In-memory copy of the online client table for map display and shadow aircraft detection.
+ *
+ * Built once per download in the worker thread and never changed afterwards. The controller swaps its shared pointer
+ * to a new store when the worker is done. Therefore the GUI thread can read it without locking and without
+ * accessing the database.
+ *
+ * Positions, speeds and aircraft are kept in parallel arrays. A fixed latitude/longitude grid holds the array indexes
+ * sorted by cell for rectangle queries. A hash allows to look up clients by callsign.
+ * Ground speed and heading allow to extrapolate positions between downloads.
+ */
+class OnlineClientStore
+{
+public:
+  OnlineClientStore();
+
+  /* Read all clients from table "client" in database. Call only once on a new object. */
+  void build(atools::sql::SqlDatabase *db);
+
+  /* Append indexes of all clients inside rect. Uses last known positions. rect must not cross the anti-meridian. */
+  void getIndexes(QVector<int>& indexes, const Marble::GeoDataLatLonBox& rect) const;
+
+  /* Index of first client with the given callsign or -1 if not found */
+  int indexOfCallsign(const QString& callsign) const
+  {
+    return callsignIndex.value(callsign, -1);
+  }
+
+  /* Last known position from the download */
+  atools::geo::Pos getPosition(int index) const
+  {
+    return atools::geo::Pos(lonx.at(index), laty.at(index));
+  }
+
+  /* Position advanced from the last known position along heading using ground speed until nowMs.
+   * Time is counted from building the store and limited to maxSeconds. Aircraft on ground are not moved. */
+  atools::geo::Pos getPosition(int index, qint64 nowMs, int maxSeconds) const;
+
+  const atools::fs::sc::SimConnectAircraft& getAircraft(int index) const
+  {
+    return aircraft.at(index);
+  }
+
+  int size() const
+  {
+    return aircraft.size();
+  }
+
+  bool isEmpty() const
+  {
+    return aircraft.isEmpty();
+  }
+
+private:
+  /* Grid cell for coordinates. Clamps to grid boundaries. */
+  static int cellColumn(double lonxDeg);
+  static int cellRow(double latyDeg);
+
+  /* Parallel arrays indexed by client number */
+  QVector<float> lonx, laty;
+
+  /* Ground speed is zero for aircraft which are not extrapolated */
+  QVector<float> groundSpeedKts, headingDegTrue;
+  QVector<atools::fs::sc::SimConnectAircraft> aircraft;
+
+  /* Time of building in milliseconds since epoch */
+  qint64 timestampMs = 0L;
+
+  /* Client numbers sorted by grid cell. Numbers for cell n are in cellIndexes[cellStart[n]] to
+   * cellIndexes[cellStart[n + 1] - 1]. */
+  QVector<int> cellStart, cellIndexes;
+
+  /* Callsign to client number */
+  QHash<QString, int> callsignIndex;
+};
+
+#endif // LNM_ONLINECLIENTSTORE_H
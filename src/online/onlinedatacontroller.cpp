@@ -18,7 +18,7 @@
 #include "online/onlinedatacontroller.h"
 
 #include "fs/online/onlinedatamanager.h"
-#include "airspace/airspacecontroller.h"
+#include "online/onlineclientstore.h"
 #include "util/httpdownloader.h"
 #include "gui/mainwindow.h"
 #include "common/constants.h"
@@ -27,6 +27,7 @@
 #include "zip/gzip.h"
 #include "gui/dialog.h"
 #include "geo/calculations.h"
+#include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
 #include "mapgui/maplayer.h"
@@ -54,10 +55,16 @@ static const int MIN_DISTANCE_DUPLICATE_M = atools::geo::nmToMeter(30);
 // Minimum reload time for whazzup files (JSON or txt)
 static const int MIN_RELOAD_TIME_SECONDS = 15;
 
+// Stop moving aircraft if no new data arrived for this time
+static const int MAX_EXTRAPOLATION_SECONDS = 180;
+
+static const double QUERY_RECT_INFLATION_FACTOR = 0.2;
+static const double QUERY_RECT_INFLATION_INCREMENT = 0.1;
+static const int QUERY_MAX_ROWS = 5000;
+
 using atools::fs::sc::SimConnectAircraft;
 using atools::fs::online::OnlinedataManager;
 using atools::util::HttpDownloader;
-using atools::geo::LineString;
 using atools::geo::Pos;
 
 atools::fs::online::Format convertFormat(opts::OnlineFormat format)
@@ -80,7 +87,7 @@ atools::fs::online::Format convertFormat(opts::OnlineFormat format)
 }
 
 OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager *onlineManager, MainWindow *parent)
-  : manager(onlineManager), mainWindow(parent), aircraftCache()
+  : manager(onlineManager), mainWindow(parent), clientStore(new OnlineClientStore), aircraftCache()
 {
   // Files use Windows code with embedded UTF-8 for ATIS text
   codec = QTextCodec::codecForName("Windows-1252");
@@ -103,8 +110,38 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
   // Recurring downloads
   connect(&downloadTimer, &QTimer::timeout, this, &OnlinedataController::startDownloadInternal);
 
-  using namespace std::placeholders;
-  manager->setGeometryCallback(std::bind(&OnlinedataController::geometryCallback, this, _1, _2));
+  // Map updates for moving aircraft between downloads
+  extrapolationUpdateSeconds = atools::settings::Settings::instance().
+                               getAndStoreValue(lnm::OPTIONS_ONLINE_EXTRAPOLATION_UPDATE, 5).toInt();
+  if(extrapolationUpdateSeconds > 0)
+  {
+    connect(&extrapolationTimer, &QTimer::timeout, this, &OnlinedataController::extrapolationTimeout);
+    extrapolationTimer.setInterval(extrapolationUpdateSeconds * 1000);
+    extrapolationTimer.start();
+  }
+
+  // Worker thread for parsing and database updates =================================
+  qRegisterMetaType<online::WorkerRequest>();
+  qRegisterMetaType<online::WorkerResult>();
+
+  worker = new OnlinedataWorker(atools::settings::Settings::instance().
+                                getAndStoreValue(lnm::OPTIONS_WHAZZUP_PARSER_DEBUG, false).toBool());
+  worker->moveToThread(&workerThread);
+
+  connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
+  connect(this, &OnlinedataController::workerRequested, worker, &OnlinedataWorker::process, Qt::QueuedConnection);
+  connect(this, &OnlinedataController::workerInitRequested, worker, &OnlinedataWorker::initDatabase,
+          Qt::BlockingQueuedConnection);
+  connect(this, &OnlinedataController::workerDeInitRequested, worker, &OnlinedataWorker::deInitDatabase,
+          Qt::BlockingQueuedConnection);
+  connect(this, &OnlinedataController::workerResetRequested, worker, &OnlinedataWorker::resetData,
+          Qt::BlockingQueuedConnection);
+  connect(worker, &OnlinedataWorker::processed, this, &OnlinedataController::workerProcessed,
+          Qt::QueuedConnection);
+
+  workerThread.setObjectName("OnlinedataWorker");
+  workerThread.start();
+  initWorker();
 
 #ifdef DEBUG_ONLINE_DOWNLOAD
   downloader->enableCache(60);
@@ -113,10 +150,13 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
 
 OnlinedataController::~OnlinedataController()
 {
-  manager->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
-
   deInitQueries();
 
+  // Waits for a running update - worker is deleted in thread when finished
+  emit workerDeInitRequested();
+  workerThread.quit();
+  workerThread.wait();
+
   delete downloader;
 
   // Remove all from the database to avoid confusion on startup
@@ -166,7 +206,32 @@ void OnlinedataController::updateAtcSizes()
 
     sizeMap.insert(type, diameter != -1 ? std::max(1, diameter / 2) : -1);
   }
-  manager->setAtcSize(sizeMap);
+  atcSizes = sizeMap;
+}
+
+void OnlinedataController::initWorker()
+{
+  atools::sql::SqlDatabase *dbUserAirspace = NavApp::getDatabaseUserAirspace();
+  emit workerInitRequested(manager->getDatabase()->databaseName(),
+                           dbUserAirspace != nullptr && dbUserAirspace->isOpen() ?
+                           dbUserAirspace->databaseName() : QString());
+}
+
+void OnlinedataController::postWorkerRequest(online::RequestType type, const QByteArray& data, bool utf8)
+{
+  opts2::Flags2 flags2 = OptionData::instance().getFlags2();
+
+  online::WorkerRequest request;
+  request.requestId = workerRequestId;
+  request.type = type;
+  request.data = data;
+  request.utf8 = utf8;
+  request.format = convertFormat(OptionData::instance().getOnlineFormat());
+  request.atcSizes = atcSizes;
+  request.airspaceByName = flags2 & opts2::ONLINE_AIRSPACE_BY_NAME;
+  request.airspaceByFile = flags2 & opts2::ONLINE_AIRSPACE_BY_FILE;
+
+  emit workerRequested(request);
 }
 
 void OnlinedataController::startProcessing()
@@ -309,7 +374,8 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
   else if(currentState == DOWNLOADING_TRANSCEIVERS)
   {
     // transceivers.json downloaded ============================================
-    manager->readFromTransceivers(uncompress(data, Q_FUNC_INFO, true /* utf8 */));
+    // Worker reads it before the following whazzup
+    postWorkerRequest(online::TRANSCEIVERS, data, true /* utf8 */);
 
     // Next in chain after transceivers is JSON
     currentState = DOWNLOADING_WHAZZUP;
@@ -321,20 +387,43 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
   {
     // whazzup.txt or JSON downloaded ============================================
     atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
+    bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
+
+    // Parse in worker - chain continues in workerProcessed
+    currentState = PROCESSING_WHAZZUP;
+    postWorkerRequest(online::WHAZZUP, data, json /* utf8 */);
+  }
+  else if(currentState == DOWNLOADING_WHAZZUP_SERVERS)
+  {
+    // Parse in worker - chain ends in workerProcessed
+    currentState = PROCESSING_WHAZZUP_SERVERS;
+    postWorkerRequest(online::SERVERS, data, false /* utf8 */);
+  }
+}
+
+void OnlinedataController::workerProcessed(const online::WorkerResult& result)
+{
+  if(result.requestId != workerRequestId)
+  {
+    // Options changed or download chain was stopped in the meantime
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Dropping outdated result" << result.requestId;
+    return;
+  }
 
-    // Contains servers and does not need an extra download
-    bool vatsimJson = format == atools::fs::online::VATSIM_JSON3;
-    bool ivaoJson = format == atools::fs::online::IVAO_JSON2;
+  reloadMinutesFromWhazzup = result.reloadMinutes;
 
-    if(manager->readFromWhazzup(uncompress(data, Q_FUNC_INFO, ivaoJson || vatsimJson /* utf8 */),
-                                format, manager->getLastUpdateTimeFromWhazzup()))
+  const QDateTime now = QDateTime::currentDateTime();
+  if(currentState == PROCESSING_WHAZZUP && result.type == online::WHAZZUP)
+  {
+    if(result.updated)
     {
-      // Get all callsigns and positions from online list to allow deduplication
-      clientCallsignAndPosMap.clear();
-      manager->getClientCallsignAndPosMap(clientCallsignAndPosMap);
+      // Contains servers and does not need an extra download
+      atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
+      bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
 
       QString whazzupVoiceUrlFromStatus = manager->getWhazzupVoiceUrlFromStatus();
-      if(!vatsimJson && !ivaoJson && !whazzupVoiceUrlFromStatus.isEmpty() &&
+      if(!json && !whazzupVoiceUrlFromStatus.isEmpty() &&
          lastServerDownload < now.addSecs(-MIN_SERVER_DOWNLOAD_INTERVAL_MIN * 60))
       {
         // Next in chain is server file
@@ -344,19 +433,13 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
       }
       else
       {
-        // Done after downloading whazzup.txt - start timer for next session
-        startDownloadTimer();
-        currentState = NONE;
-        lastUpdateTime = now;
-
-        aircraftCache.clear();
-        simulatorAiRegistrations.clear();
-
-        // Message for search tabs, map widget and info
-        emit onlineServersUpdated(true /* load all */, true /* keep selection */);
-        emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */);
-        statusBarMessage();
+        // Done after downloading whazzup.txt
+        finishDownloadChain(now);
+        emit onlineServersUpdated(false /* load all */, true /* keep selection */);
       }
+
+      // Message for search tabs, map widget and info
+      applyResult(result);
     }
     else
     {
@@ -364,31 +447,62 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
         qInfo() << Q_FUNC_INFO << "whazzup.txt is not recent";
 
       // Done after old update - try again later
-      startDownloadTimer();
-      currentState = NONE;
-      lastUpdateTime = now;
+      finishDownloadChain(now);
     }
   }
-  else if(currentState == DOWNLOADING_WHAZZUP_SERVERS)
+  else if(currentState == PROCESSING_WHAZZUP_SERVERS && result.type == online::SERVERS)
   {
-    manager->readServersFromWhazzup(uncompress(data, Q_FUNC_INFO, false /* utf8 */),
-                                    convertFormat(OptionData::instance().getOnlineFormat()),
-                                    manager->getLastUpdateTimeFromWhazzup());
+    // Done after downloading server.txt
     lastServerDownload = now;
+    finishDownloadChain(now);
 
-    // Done after downloading server.txt - start timer for next session
-    startDownloadTimer();
-    currentState = NONE;
-    lastUpdateTime = now;
+    applyResult(result);
+    emit onlineServersUpdated(false /* load all */, true /* keep selection */);
+  }
+}
 
-    aircraftCache.clear();
-    simulatorAiRegistrations.clear();
+void OnlinedataController::finishDownloadChain(const QDateTime& now)
+{
+  startDownloadTimer();
+  currentState = NONE;
+  lastUpdateTime = now;
+  statusBarMessage();
+}
 
-    // Message for search tabs, map widget and info
-    emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */);
-    emit onlineServersUpdated(true /* load all */, true /* keep selection */);
-    statusBarMessage();
+void OnlinedataController::applyResult(const online::WorkerResult& result)
+{
+  const online::Delta& delta = result.delta;
+
+  // Replace store with all clients for map and deduplication - old one is deleted when not referenced anymore
+  if(!result.clientStore.isNull())
+    clientStore = result.clientStore;
+
+  bool clients = delta.hasClientChanges(), atc = delta.hasAtcChanges();
+
+  if(clients)
+  {
+    // Reload cached aircraft from the new store for the same rectangle - keeps aircraft visible in lazy updates
+    aircraftCache.list.clear();
+    aircraftCacheIndexes.clear();
+    if(!aircraftCache.curRect.isEmpty())
+      fillAircraftCache(aircraftCache.curRect, simulatorAiRegistrations);
   }
+
+  // Views reload only the first page of rows. Airspace cache has to be cleared before the map is updated.
+  if(atc)
+    emit onlineAtcUpdated(false /* load all */, true /* keep selection */);
+  if(clients)
+    emit onlineClientsUpdated(false /* load all */, true /* keep selection */);
+  if(clients || atc)
+    emit onlineClientAndAtcUpdated(false /* load all */, true /* keep selection */);
+}
+
+void OnlinedataController::emitAllUpdated()
+{
+  emit onlineAtcUpdated(true /* load all */, true /* keep selection */);
+  emit onlineClientsUpdated(true /* load all */, true /* keep selection */);
+  emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */);
+  emit onlineServersUpdated(true /* load all */, true /* keep selection */);
 }
 
 void OnlinedataController::startDownloader()
@@ -446,7 +560,10 @@ void OnlinedataController::stopAllProcesses()
   downloadTimer.stop();
   currentState = NONE;
   simulatorAiRegistrations.clear();
-  // clientCallsignAndPosMap.clear(); // Do not clear these until the download is finished
+
+  // Drop results of updates still running in the worker
+  workerRequestId++;
+  // Client store is kept until the next download is finished
 }
 
 void OnlinedataController::showMessageDialog()
@@ -455,27 +572,6 @@ void OnlinedataController::showMessageDialog()
                            tr("Message from downloaded status file:\n\n%2\n").arg(manager->getMessageFromStatus()));
 }
 
-LineString *OnlinedataController::geometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type)
-{
-  opts2::Flags2 flags2 = OptionData::instance().getFlags2();
-
-  LineString *lineString = nullptr;
-
-  // Try to get airspace boundary by name vs. callsign if set in options
-  if(flags2 & opts2::ONLINE_AIRSPACE_BY_NAME)
-    lineString = NavApp::getAirspaceController()->
-                 getOnlineAirspaceGeoByName(callsign, atools::fs::online::facilityTypeText(type));
-
-  // Try to get airspace boundary by file name vs. callsign if set in options
-  if(flags2 & opts2::ONLINE_AIRSPACE_BY_FILE)
-  {
-    if(lineString == nullptr)
-      lineString = NavApp::getAirspaceController()->getOnlineAirspaceGeoByFile(callsign);
-  }
-
-  return lineString;
-}
-
 void OnlinedataController::optionsChanged()
 {
   qDebug() << Q_FUNC_INFO;
@@ -484,16 +580,16 @@ void OnlinedataController::optionsChanged()
   manager->resetForNewOptions();
   stopAllProcesses();
 
-  // Remove all from the database
-  manager->clearData();
-  aircraftCache.clear();
+  // Remove all from the database - waits for a running update in the worker
+  emit workerResetRequested();
+  clearAircraftCache();
   simulatorAiRegistrations.clear();
-  clientCallsignAndPosMap.clear();
+  clientStore.reset(new OnlineClientStore);
+  reloadMinutesFromWhazzup = 0;
 
   updateAtcSizes();
 
-  emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */);
-  emit onlineServersUpdated(true /* load all */, true /* keep selection */);
+  emitAllUpdated();
   emit onlineNetworkChanged();
   statusBarMessage();
 
@@ -505,6 +601,10 @@ void OnlinedataController::optionsChanged()
 
 void OnlinedataController::userAirspacesUpdated()
 {
+  // Reconnect worker to get new airspace geometry
+  stopAllProcesses();
+  initWorker();
+
   optionsChanged();
 }
 
@@ -575,15 +675,12 @@ const QList<atools::fs::sc::SimConnectAircraft> *OnlinedataController::getAircra
                                                                                    const MapLayer *mapLayer, bool lazy,
                                                                                    bool& overflow)
 {
-  static const double queryRectInflationFactor = 0.2;
-  static const double queryRectInflationIncrement = 0.1;
-  static const int queryMaxRows = 5000;
-
-  aircraftCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  if(aircraftCache.updateCache(rect, mapLayer, QUERY_RECT_INFLATION_FACTOR, QUERY_RECT_INFLATION_INCREMENT, lazy,
+                               [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersWaypoint(newLayer);
-  });
+  }))
+    aircraftCacheIndexes.clear();
 
   // Remember user aircraft registration aircraft for disambiguation
   const atools::fs::sc::SimConnectUserAircraft& userAircraft = NavApp::getUserAircraft();
@@ -600,43 +697,90 @@ const QList<atools::fs::sc::SimConnectAircraft> *OnlinedataController::getAircra
 
   if(simulatorAiRegistrations.keys() != curRegistrations.keys())
     // List of registrations has changed - clear cache and reload
-    aircraftCache.clear();
+    clearAircraftCache();
 
   if((aircraftCache.list.isEmpty() && !lazy))
   {
-    for(const Marble::GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, aircraftByRectQuery);
-      aircraftByRectQuery->exec();
-      while(aircraftByRectQuery->next())
-      {
-        atools::fs::sc::SimConnectAircraft aircraft;
-        fillAircraftFromClient(aircraft, aircraftByRectQuery->record());
-
-        if(!curRegistrations.contains(aircraft.getAirplaneRegistration()) ||
-           aircraft.getPosition().distanceMeterTo(curRegistrations.value(aircraft.getAirplaneRegistration())) >
-           MIN_DISTANCE_DUPLICATE_M)
-          // Avoid duplicates with simulator aircraft that are close by
-          aircraftCache.list.append(aircraft);
-      }
-    }
+    fillAircraftCache(rect, curRegistrations);
     simulatorAiRegistrations = curRegistrations;
   }
-  overflow = aircraftCache.validate(queryMaxRows);
+
+  // Advance positions also for lazy updates
+  extrapolateAircraftCache();
+
+  overflow = aircraftCache.validate(QUERY_MAX_ROWS);
   return &aircraftCache.list;
 }
 
+void OnlinedataController::clearAircraftCache()
+{
+  aircraftCache.clear();
+  aircraftCacheIndexes.clear();
+}
+
+void OnlinedataController::fillAircraftCache(const Marble::GeoDataLatLonBox& rect,
+                                             const QHash<QString, atools::geo::Pos>& registrations)
+{
+  QVector<int> indexes;
+  for(const Marble::GeoDataLatLonBox& r :
+      query::splitAtAntiMeridian(rect, QUERY_RECT_INFLATION_FACTOR, QUERY_RECT_INFLATION_INCREMENT))
+    clientStore->getIndexes(indexes, r);
+
+  for(int index : indexes)
+  {
+    const atools::fs::sc::SimConnectAircraft& aircraft = clientStore->getAircraft(index);
+    if(!registrations.contains(aircraft.getAirplaneRegistration()) ||
+       aircraft.getPosition().distanceMeterTo(registrations.value(aircraft.getAirplaneRegistration())) >
+       MIN_DISTANCE_DUPLICATE_M)
+    {
+      // Avoid duplicates with simulator aircraft that are close by
+      aircraftCache.list.append(aircraft);
+      aircraftCacheIndexes.append(index);
+    }
+  }
+}
+
+void OnlinedataController::extrapolateAircraftCache()
+{
+  if(extrapolationUpdateSeconds <= 0)
+    return;
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  for(int i = 0; i < aircraftCache.list.size(); i++)
+  {
+    // Keep altitude and change only coordinates
+    Pos pos = clientStore->getPosition(aircraftCacheIndexes.at(i), now, MAX_EXTRAPOLATION_SECONDS);
+    Pos& cachedPos = aircraftCache.list[i].getPosition();
+    cachedPos.setLonX(pos.getLonX());
+    cachedPos.setLatY(pos.getLatY());
+  }
+}
+
+atools::geo::Pos OnlinedataController::clientPosition(int index) const
+{
+  if(extrapolationUpdateSeconds > 0)
+    return clientStore->getPosition(index, QDateTime::currentMSecsSinceEpoch(), MAX_EXTRAPOLATION_SECONDS);
+  else
+    return clientStore->getPosition(index);
+}
+
+void OnlinedataController::extrapolationTimeout()
+{
+  // Redraw only if there is anything to move
+  if(!aircraftCache.list.isEmpty())
+    emit onlineClientPositionsUpdated();
+}
+
 bool OnlinedataController::getShadowAircraft(atools::fs::sc::SimConnectAircraft& onlineClient,
                                              const atools::fs::sc::SimConnectAircraft& simAircraft)
 {
   if(isShadowAircraft(simAircraft))
   {
-    atools::sql::SqlRecordVector clients = manager->getClientRecordsByCallsign(simAircraft.getAirplaneRegistration());
+    int index = clientStore->indexOfCallsign(simAircraft.getAirplaneRegistration());
 
-    if(!clients.isEmpty())
+    if(index != -1)
     {
-      fillAircraftFromClient(onlineClient, clients.first());
+      onlineClient = clientStore->getAircraft(index);
 
       // Update to real simulator position including altitude for shadows
       onlineClient.getPosition() = simAircraft.getPosition();
@@ -650,9 +794,11 @@ bool OnlinedataController::getShadowAircraft(atools::fs::sc::SimConnectAircraft&
 
 bool OnlinedataController::isShadowAircraft(const atools::fs::sc::SimConnectAircraft& simAircraft)
 {
-  const atools::geo::Pos pos = clientCallsignAndPosMap.value(simAircraft.getAirplaneRegistration());
-  return simAircraft.isOnlineShadow() ||
-         (pos.isValid() && pos.distanceMeterTo(simAircraft.getPosition()) < MIN_DISTANCE_DUPLICATE_M);
+  if(simAircraft.isOnlineShadow())
+    return true;
+
+  int index = clientStore->indexOfCallsign(simAircraft.getAirplaneRegistration());
+  return index != -1 && clientPosition(index).distanceMeterTo(simAircraft.getPosition()) < MIN_DISTANCE_DUPLICATE_M;
 }
 
 void OnlinedataController::getClientAircraftById(atools::fs::sc::SimConnectAircraft& aircraft, int id)
@@ -701,21 +847,13 @@ void OnlinedataController::initQueries()
   deInitQueries();
 
   manager->initQueries();
-
-  aircraftByRectQuery = new atools::sql::SqlQuery(getDatabase());
-  aircraftByRectQuery->prepare("select * from client "
-                               "where lonx between :leftx and :rightx and "
-                               "laty between :bottomy and :topy");
 }
 
 void OnlinedataController::deInitQueries()
 {
-  aircraftCache.clear();
+  clearAircraftCache();
 
   manager->deInitQueries();
-
-  delete aircraftByRectQuery;
-  aircraftByRectQuery = nullptr;
 }
 
 int OnlinedataController::getNumClients() const
@@ -741,7 +879,7 @@ void OnlinedataController::startDownloadTimer()
     if(intervalSeconds == -1)
     {
       // Use time from whazzup.txt - mode auto
-      intervalSeconds = std::max(manager->getReloadMinutesFromWhazzup() * 60, 60);
+      intervalSeconds = std::max(reloadMinutesFromWhazzup * 60, 60);
       source = "whazzup";
     }
     else
@@ -780,6 +918,12 @@ QString OnlinedataController::stateAsStr(OnlinedataController::State state)
 
     case OnlinedataController::DOWNLOADING_WHAZZUP_SERVERS:
       return "Downloading Servers";
+
+    case OnlinedataController::PROCESSING_WHAZZUP:
+      return "Processing Whazzup";
+
+    case OnlinedataController::PROCESSING_WHAZZUP_SERVERS:
+      return "Processing Servers";
   }
   return QString();
 }
@@ -20,12 +20,15 @@
 
 #include <QDateTime>
 #include <QObject>
+#include <QThread>
 #include <QTimer>
 
 #include "query/querytypes.h"
 #include "fs/online/onlinetypes.h"
+#include "online/onlinedataworker.h"
 
 class MapLayer;
+class OnlineClientStore;
 
 namespace Marble {
 class GeoDataLatLonBox;
@@ -65,6 +68,11 @@ class QTextCodec;
 /*
  * Manages recurring download of online network data from the status.txt and whazzup.txt files.
  * Uses options to determine how to download data.
+ *
+ * Downloaded files are parsed and written to the database by an OnlinedataWorker in an own thread.
+ * The worker sends back a delta of changed clients and centers which is used to update only affected views.
+ * Map display and shadow aircraft detection use the client store built by the worker and do not access the database.
+ * The manager given in the constructor is used for status.txt and all other read queries in the GUI thread.
  */
 class OnlinedataController :
   public QObject
@@ -139,10 +147,23 @@ public:
   bool isShadowAircraft(const atools::fs::sc::SimConnectAircraft& simAircraft);
 
 signals:
-  /* Sent whenever new data was downloaded */
+  /* Sent whenever new data was downloaded and clients or centers have changed */
   void onlineClientAndAtcUpdated(bool loadAll, bool keepSelection);
   void onlineServersUpdated(bool loadAll, bool keepSelection);
 
+  /* Sent before onlineClientAndAtcUpdated only if clients or centers have changed respectively */
+  void onlineClientsUpdated(bool loadAll, bool keepSelection);
+  void onlineAtcUpdated(bool loadAll, bool keepSelection);
+
+  /* Sent periodically to redraw the map with extrapolated aircraft positions if online aircraft are shown */
+  void onlineClientPositionsUpdated();
+
+  /* Internal signals for the worker */
+  void workerRequested(online::WorkerRequest request);
+  void workerInitRequested(const QString& onlineDbFile, const QString& userAirspaceDbFile);
+  void workerDeInitRequested();
+  void workerResetRequested();
+
   /* Sent when network changes via options dialog */
   void onlineNetworkChanged();
 
@@ -163,8 +184,37 @@ private:
   QString uncompress(const QByteArray& data, const QString& func, bool utf8);
   void startDownloader();
 
-  /* Tries to fetch geometry for atc centers from the user geometry database from cache */
-  atools::geo::LineString *geometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type);
+  /* Send downloaded file to the worker thread */
+  void postWorkerRequest(online::RequestType type, const QByteArray& data, bool utf8);
+
+  /* Parsing of file finished in worker. Continues the download chain. */
+  void workerProcessed(const online::WorkerResult& result);
+
+  /* Open worker database connections with the files of the GUI thread connections */
+  void initWorker();
+
+  /* Swap client store, clear caches and send signals for changed data only */
+  void applyResult(const online::WorkerResult& result);
+
+  /* Send all update signals for a full reload */
+  void emitAllUpdated();
+
+  /* Done with the download chain - start timer for next session */
+  void finishDownloadChain(const QDateTime& now);
+
+  /* Clear aircraft list and store indexes */
+  void clearAircraftCache();
+
+  /* Append aircraft from client store in rect which are not duplicates of simulator aircraft in registrations */
+  void fillAircraftCache(const Marble::GeoDataLatLonBox& rect, const QHash<QString, atools::geo::Pos>& registrations);
+
+  /* Move positions of cached aircraft to the current time */
+  void extrapolateAircraftCache();
+
+  /* Last known or extrapolated position of client in store depending on options */
+  atools::geo::Pos clientPosition(int index) const;
+
+  void extrapolationTimeout();
 
   /* Database manager */
   atools::fs::online::OnlinedataManager *manager;
@@ -182,7 +232,9 @@ private:
     DOWNLOADING_STATUS, /* Downloading status.txt */
     DOWNLOADING_WHAZZUP, /* Downloading whazzup.txt or JSON file */
     DOWNLOADING_TRANSCEIVERS, /* Downloading transceivers-data-fmt.json */
-    DOWNLOADING_WHAZZUP_SERVERS /* Downloading servers */
+    DOWNLOADING_WHAZZUP_SERVERS, /* Downloading servers */
+    PROCESSING_WHAZZUP, /* Worker is reading whazzup.txt or JSON file */
+    PROCESSING_WHAZZUP_SERVERS /* Worker is reading servers */
   };
 
   QString stateAsStr(OnlinedataController::State state);
@@ -204,15 +256,33 @@ private:
 
   QTextCodec *codec = nullptr;
 
+  /* Reload interval from last whazzup read by the worker */
+  int reloadMinutesFromWhazzup = 0;
+
+  /* Circle radius for ATC center types - passed to worker */
+  QHash<atools::fs::online::fac::FacilityType, int> atcSizes;
+
+  /* Worker for parsing and database writes */
+  QThread workerThread;
+  OnlinedataWorker *worker = nullptr;
+  int workerRequestId = 0;
+
   bool verbose = false;
 
   /* Simulator aircraft registrations and positions */
   QHash<QString, atools::geo::Pos> simulatorAiRegistrations;
 
-  QHash<QString, atools::geo::Pos> clientCallsignAndPosMap;
+  /* All clients from the last update. Replaced as a whole and never null. */
+  QSharedPointer<const OnlineClientStore> clientStore;
 
   query::SimpleRectCache<atools::fs::sc::SimConnectAircraft> aircraftCache;
-  atools::sql::SqlQuery *aircraftByRectQuery = nullptr;
+
+  /* Index in clientStore for each entry in aircraftCache.list */
+  QVector<int> aircraftCacheIndexes;
+
+  /* Triggers map updates for extrapolated positions. Interval in seconds. Zero disables extrapolation. */
+  QTimer extrapolationTimer;
+  int extrapolationUpdateSeconds = 0;
 };
 
 #endif // LNM_ONLINECONTROLLER_H
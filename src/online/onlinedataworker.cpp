@@ -0,0 +1,292 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "online/onlinedataworker.h"
+
+#include "common/maptypes.h"
+#include "db/databasemanager.h"
+#include "exception.h"
+#include "fs/online/onlinedatamanager.h"
+#include "online/onlineclientstore.h"
+#include "query/airspacequery.h"
+#include "sql/sqldatabase.h"
+#include "zip/gzip.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QTextCodec>
+
+using atools::sql::SqlDatabase;
+using atools::geo::LineString;
+
+static const QString DATABASE_TYPE("QSQLITE");
+static const QString DATABASE_NAME_ONLINE_WORKER("LNMONLINEWORKER");
+static const QString DATABASE_NAME_AIRSPACE_WORKER("LNMONLINEWORKERAIRSPACE");
+
+OnlinedataWorker::OnlinedataWorker(bool verboseParam)
+  : verbose(verboseParam)
+{
+  // Files use Windows code with embedded UTF-8 for ATIS text
+  codec = QTextCodec::codecForName("Windows-1252");
+  if(codec == nullptr)
+    codec = QTextCodec::codecForLocale();
+}
+
+OnlinedataWorker::~OnlinedataWorker()
+{
+  deInitDatabase();
+}
+
+void OnlinedataWorker::initDatabase(const QString& onlineDbFile, const QString& userAirspaceDbFile)
+{
+  deInitDatabase();
+
+  try
+  {
+    SqlDatabase::addDatabase(DATABASE_TYPE, DATABASE_NAME_ONLINE_WORKER);
+    db = new SqlDatabase(DATABASE_NAME_ONLINE_WORKER);
+    db->setDatabaseName(onlineDbFile);
+
+    // Same settings as the connection in the GUI thread - waits for readers instead of failing on commit
+    db->open(DatabaseManager::databasePragmas(false /* readonly */, false /* exclusive */));
+
+    // Schema is created by the manager in the GUI thread
+    manager = new atools::fs::online::OnlinedataManager(db, verbose);
+    manager->initQueries();
+
+    using namespace std::placeholders;
+    manager->setGeometryCallback(std::bind(&OnlinedataWorker::geometryCallback, this, _1, _2));
+
+    if(!userAirspaceDbFile.isEmpty())
+    {
+      SqlDatabase::addDatabase(DATABASE_TYPE, DATABASE_NAME_AIRSPACE_WORKER);
+      dbAirspace = new SqlDatabase(DATABASE_NAME_AIRSPACE_WORKER);
+      dbAirspace->setDatabaseName(userAirspaceDbFile);
+      dbAirspace->setReadonly();
+      dbAirspace->open();
+
+      airspaceQuery = new AirspaceQuery(dbAirspace, map::AIRSPACE_SRC_USER);
+      airspaceQuery->initQueries();
+    }
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open online database" << onlineDbFile << e.what();
+    deInitDatabase();
+  }
+}
+
+void OnlinedataWorker::deInitDatabase()
+{
+  delete airspaceQuery;
+  airspaceQuery = nullptr;
+
+  if(manager != nullptr)
+  {
+    manager->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
+    manager->deInitQueries();
+    delete manager;
+    manager = nullptr;
+  }
+
+  if(dbAirspace != nullptr)
+  {
+    if(dbAirspace->isOpen())
+      dbAirspace->close();
+    delete dbAirspace;
+    dbAirspace = nullptr;
+    SqlDatabase::removeDatabase(DATABASE_NAME_AIRSPACE_WORKER);
+  }
+
+  if(db != nullptr)
+  {
+    if(db->isOpen())
+      db->close();
+    delete db;
+    db = nullptr;
+    SqlDatabase::removeDatabase(DATABASE_NAME_ONLINE_WORKER);
+  }
+
+  clientHashes.clear();
+  atcHashes.clear();
+}
+
+void OnlinedataWorker::resetData()
+{
+  if(manager != nullptr)
+  {
+    manager->resetForNewOptions();
+    manager->clearData();
+  }
+  clientHashes.clear();
+  atcHashes.clear();
+}
+
+void OnlinedataWorker::process(online::WorkerRequest request)
+{
+  online::WorkerResult result;
+  result.requestId = request.requestId;
+  result.type = request.type;
+
+  if(manager == nullptr)
+  {
+    emit processed(result);
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  airspaceByName = request.airspaceByName;
+  airspaceByFile = request.airspaceByFile;
+  manager->setAtcSize(request.atcSizes);
+
+  try
+  {
+    switch(request.type)
+    {
+      case online::TRANSCEIVERS:
+        manager->readFromTransceivers(uncompress(request.data, true /* utf8 */));
+        result.updated = true;
+        break;
+
+      case online::WHAZZUP:
+        result.updated = manager->readFromWhazzup(uncompress(request.data, request.utf8), request.format,
+                                                  manager->getLastUpdateTimeFromWhazzup());
+        break;
+
+      case online::SERVERS:
+        manager->readServersFromWhazzup(uncompress(request.data, request.utf8), request.format,
+                                        manager->getLastUpdateTimeFromWhazzup());
+        result.updated = true;
+        break;
+    }
+
+    if(result.updated && request.type != online::TRANSCEIVERS)
+    {
+      // Build delta for views =========================================
+      online::Delta& delta = result.delta;
+      diffTable("select callsign, lonx, laty, altitude, heading, groundspeed, on_ground, state, "
+                "flightplan_departure_aerodrome, flightplan_destination_aerodrome, flightplan_aircraft, "
+                "transponder_code from client",
+                clientHashes, delta.addedClients, delta.removedClients, delta.changedClients);
+      diffTable("select callsign, lonx, laty, frequency, visual_range, atis, atis_time, facility_type from atc",
+                atcHashes, delta.addedAtc, delta.removedAtc, delta.changedAtc);
+
+      if(delta.hasClientChanges())
+      {
+        // Copy of all clients for map display and shadow aircraft - replaced in the GUI thread as a whole
+        OnlineClientStore *store = new OnlineClientStore;
+        store->build(db);
+        result.clientStore.reset(store);
+      }
+    }
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Error reading online data" << e.what();
+    result.updated = false;
+  }
+
+  result.reloadMinutes = manager->getReloadMinutesFromWhazzup();
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "type" << request.type << "updated" << result.updated
+             << "clients added" << result.delta.addedClients.size()
+             << "removed" << result.delta.removedClients.size()
+             << "changed" << result.delta.changedClients.size()
+             << "atc added" << result.delta.addedAtc.size()
+             << "removed" << result.delta.removedAtc.size()
+             << "changed" << result.delta.changedAtc.size()
+             << "store" << (result.clientStore.isNull() ? -1 : result.clientStore->size())
+             << timer.elapsed() << "ms";
+
+  emit processed(result);
+}
+
+void OnlinedataWorker::diffTable(const QString& queryStr, QHash<QString, uint>& hashes, QSet<QString>& added,
+                                 QSet<QString>& removed, QSet<QString>& changed)
+{
+  QHash<QString, uint> newHashes;
+  newHashes.reserve(hashes.size());
+
+  QSqlQuery query(db->getQSqlDatabase());
+  query.setForwardOnly(true);
+  if(!query.exec(queryStr))
+  {
+    qWarning() << Q_FUNC_INFO << query.lastError().text();
+    return;
+  }
+
+  int columns = query.record().count();
+  while(query.next())
+  {
+    QString callsign = query.value(0).toString();
+
+    uint hash = 0;
+    for(int i = 1; i < columns; i++)
+      hash = 31 * hash ^ qHash(query.value(i).toString());
+    newHashes.insert(callsign, hash);
+
+    auto it = hashes.constFind(callsign);
+    if(it == hashes.constEnd())
+      added.insert(callsign);
+    else if(it.value() != hash)
+      changed.insert(callsign);
+  }
+  query.finish();
+
+  for(auto it = hashes.constBegin(); it != hashes.constEnd(); ++it)
+  {
+    if(!newHashes.contains(it.key()))
+      removed.insert(it.key());
+  }
+
+  hashes.swap(newHashes);
+}
+
+QString OnlinedataWorker::uncompress(const QByteArray& data, bool utf8)
+{
+  QByteArray textData = atools::zip::gzipDecompressIf(data, Q_FUNC_INFO);
+
+  if(utf8)
+    return QString(textData);
+  else
+    // Convert from encoding to UTF-8. Some formats use windows encoding
+    return codec->toUnicode(textData);
+}
+
+LineString *OnlinedataWorker::geometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type)
+{
+  if(airspaceQuery == nullptr)
+    return nullptr;
+
+  LineString *lineString = nullptr;
+
+  // Try to get airspace boundary by name vs. callsign if set in options
+  if(airspaceByName)
+    lineString = airspaceQuery->getAirspaceGeometryByName(callsign, atools::fs::online::facilityTypeText(type));
+
+  // Try to get airspace boundary by file name vs. callsign if set in options
+  if(airspaceByFile && lineString == nullptr)
+    lineString = airspaceQuery->getAirspaceGeometryByFile(callsign);
+
+  return lineString;
+}
@@ -0,0 +1,167 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ONLINEDATAWORKER_H
+#define LNM_ONLINEDATAWORKER_H
+
+#include "fs/online/onlinetypes.h"
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+
+class AirspaceQuery;
+class OnlineClientStore;
+class QTextCodec;
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace sql {
+class SqlDatabase;
+}
+namespace fs {
+namespace online {
+class OnlinedataManager;
+}
+}
+}
+
+namespace online {
+
+/* Type of downloaded file */
+enum RequestType
+{
+  TRANSCEIVERS, /* transceivers-data.json */
+  WHAZZUP, /* whazzup.txt or JSON file */
+  SERVERS /* servers.txt */
+};
+
+/* Downloaded file to be parsed and written to the database in the worker thread */
+struct WorkerRequest
+{
+  /* Results of outdated requests are dropped by the controller */
+  int requestId = -1;
+  RequestType type = WHAZZUP;
+
+  /* Raw download which might be gzip compressed */
+  QByteArray data;
+  bool utf8 = false;
+  atools::fs::online::Format format = atools::fs::online::UNKNOWN;
+
+  /* Options copied in the GUI thread */
+  QHash<atools::fs::online::fac::FacilityType, int> atcSizes;
+  bool airspaceByName = false, airspaceByFile = false;
+};
+
+/* Changes in tables client and atc compared to the last update. All keys are callsigns. */
+struct Delta
+{
+  QSet<QString> addedClients, removedClients, changedClients, addedAtc, removedAtc, changedAtc;
+
+  bool hasClientChanges() const
+  {
+    return !addedClients.isEmpty() || !removedClients.isEmpty() || !changedClients.isEmpty();
+  }
+
+  bool hasAtcChanges() const
+  {
+    return !addedAtc.isEmpty() || !removedAtc.isEmpty() || !changedAtc.isEmpty();
+  }
+
+};
+
+/* Sent back from the worker when a request is done */
+struct WorkerResult
+{
+  int requestId = -1;
+  RequestType type = WHAZZUP;
+
+  /* False if whazzup was not recent and nothing was changed */
+  bool updated = false;
+
+  /* Reload interval from whazzup needed for the download timer */
+  int reloadMinutes = 0;
+
+  Delta delta;
+
+  /* New copy of all clients if clients have changed. Null otherwise. */
+  QSharedPointer<const OnlineClientStore> clientStore;
+};
+
+}
+
+Q_DECLARE_METATYPE(online::WorkerRequest);
+Q_DECLARE_METATYPE(online::WorkerResult);
+
+/*
+ * Lives in an own thread and parses downloaded online network files. Owns a writeable connection to the
+ * online database and a read only connection to the user airspace database for the center geometry.
+ *
+ * Compares the tables client and atc with the state of the last update to build a delta which allows
+ * views to update only if their data has changed. Builds a new in-memory client store if clients have changed.
+ */
+class OnlinedataWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit OnlinedataWorker(bool verboseParam);
+  virtual ~OnlinedataWorker() override;
+
+  /* Open databases. Has to be called in the worker thread. */
+  void initDatabase(const QString& onlineDbFile, const QString& userAirspaceDbFile);
+
+  /* Close databases. Has to be called in the worker thread. */
+  void deInitDatabase();
+
+  /* Parse file and write to database. Sends processed when done. */
+  void process(online::WorkerRequest request);
+
+  /* Remove all data and reset state from whazzup for new network options */
+  void resetData();
+
+signals:
+  void processed(const online::WorkerResult& result);
+
+private:
+  /* Tries to fetch geometry for atc centers from the user airspace database */
+  atools::geo::LineString *geometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type);
+
+  /* Compare the callsigns and a hash of columns for the given query with the last state in hashes.
+   * First column has to be the callsign. */
+  void diffTable(const QString& queryStr, QHash<QString, uint>& hashes, QSet<QString>& added,
+                 QSet<QString>& removed, QSet<QString>& changed);
+
+  QString uncompress(const QByteArray& data, bool utf8);
+
+  atools::sql::SqlDatabase *db = nullptr, *dbAirspace = nullptr;
+  atools::fs::online::OnlinedataManager *manager = nullptr;
+  AirspaceQuery *airspaceQuery = nullptr;
+
+  /* Callsign to hash of values from the last update */
+  QHash<QString, uint> clientHashes, atcHashes;
+
+  bool airspaceByName = false, airspaceByFile = false;
+  QTextCodec *codec = nullptr;
+  bool verbose = false;
+};
+
+#endif // LNM_ONLINEDATAWORKER_H
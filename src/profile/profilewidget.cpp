@@ -34,6 +34,7 @@
 #include "settings/settings.h"
 #include "mapgui/mapwidget.h"
 #include "options/optiondata.h"
+#include "common/constants.h"
 #include "common/elevationprovider.h"
 #include "common/vehicleicons.h"
 #include "util/paintercontextsaver.h"
@@ -85,6 +86,35 @@ struct ElevationLeg
   float maxElevation = 0.f; /* Max ground altitude for this leg */
 };
 
+/* Elevation cache entry for one leg */
+struct ElevationCacheEntry
+{
+  atools::geo::LineString geometry, /* Leg geometry for validation in case of hash collisions */
+                          elevations; /* Elevation points. Altitude is in meter. */
+};
+
+/* Hash over all coordinates of a leg geometry including procedure geometry */
+static uint geometryHash(const LineString& geometry)
+{
+  uint hash = static_cast<uint>(geometry.size());
+  for(const Pos& pos : geometry)
+    hash = hash * 31 + (qHash(pos.getLonX()) ^ (qHash(pos.getLatY()) << 1));
+  return hash;
+}
+
+static bool isSameGeometry(const LineString& geometry1, const LineString& geometry2)
+{
+  if(geometry1.size() != geometry2.size())
+    return false;
+
+  for(int i = 0; i < geometry1.size(); i++)
+  {
+    if(!geometry1.at(i).almostEqual(geometry2.at(i)))
+      return false;
+  }
+  return true;
+}
+
 struct ElevationLegList
 {
   Route route; /* Copy from route controller.
@@ -108,6 +138,9 @@ ProfileWidget::ProfileWidget(QWidget *parent)
 
   legList = new ElevationLegList;
 
+  elevationCache.setMaxCost(atools::settings::Settings::instance().
+                            getAndStoreValue(lnm::SETTINGS_PROFILE + "ElevationCacheMaxPoints", 500000).toInt());
+
   ui->labelProfileError->setVisible(false);
 
   scrollArea = new ProfileScrollArea(this, ui->scrollAreaProfile);
@@ -1357,6 +1390,9 @@ void ProfileWidget::textsAndColorForLeg(QStringList& texts, QColor& color, bool&
 /* Update signal from Marble elevation model */
 void ProfileWidget::elevationUpdateAvailable()
 {
+  // Elevation data changed - all cached legs have to be sampled again
+  clearElevationCache();
+
   if(!widgetVisible || databaseLoadStatus)
     return;
 
@@ -1455,7 +1491,8 @@ void ProfileWidget::updateThreadFinished()
 bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
                                          const atools::geo::LineString& geometry) const
 {
-  ElevationProvider *elevationProvider = NavApp::getElevationProvider();
+  // Collect all segments first to allow the provider to fetch them in one batch
+  QVector<atools::geo::Line> lines;
   for(int i = 0; i < geometry.size() - 1; i++)
   {
     // Create a line string from the two points and split it at the date line if crossing
@@ -1471,9 +1508,6 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
     {
       for(int j = 1; j < ls->size(); j++)
       {
-        if(terminateThreadSignal)
-          return false;
-
         const Marble::GeoDataCoordinates& c1 = ls->at(j - 1);
         const Marble::GeoDataCoordinates& c2 = ls->at(j);
         Pos p1(c1.longitude(), c1.latitude());
@@ -1481,12 +1515,21 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
 
         p1.toDeg();
         p2.toDeg();
-        elevationProvider->getElevations(elevations, atools::geo::Line(p1, p2));
+        lines.append(atools::geo::Line(p1, p2));
       }
     }
     qDeleteAll(coordsCorrected);
   }
 
+  if(terminateThreadSignal)
+    return false;
+
+  QVector<atools::geo::LineString> lineElevations;
+  NavApp::getElevationProvider()->getElevations(lineElevations, lines);
+
+  for(const atools::geo::LineString& lineElevation : lineElevations)
+    elevations.append(lineElevation);
+
   if(!elevations.isEmpty())
   {
     // Add start or end point if heightProfile omitted these - check only lat lon not alt
@@ -1500,6 +1543,42 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
   return true;
 }
 
+void ProfileWidget::clearElevationCache()
+{
+  QMutexLocker locker(&elevationCacheMutex);
+  elevationCache.clear();
+  elevationCacheGeneration++;
+}
+
+/* Called from thread. Reuses elevation points for legs with unchanged geometry.
+ * @return true if not aborted */
+bool ProfileWidget::fetchRouteElevationsCached(atools::geo::LineString& elevations,
+                                               const atools::geo::LineString& geometry) const
+{
+  uint key = geometryHash(geometry);
+  int generation;
+  {
+    QMutexLocker locker(&elevationCacheMutex);
+    ElevationCacheEntry *entry = elevationCache.object(key);
+    if(entry != nullptr && isSameGeometry(entry->geometry, geometry))
+    {
+      elevations = entry->elevations;
+      return true;
+    }
+    generation = elevationCacheGeneration;
+  }
+
+  // Not cached - sample elevation along the leg
+  if(!fetchRouteElevations(elevations, geometry))
+    return false;
+
+  QMutexLocker locker(&elevationCacheMutex);
+  if(generation == elevationCacheGeneration)
+    // Cache was not cleared in the meantime
+    elevationCache.insert(key, new ElevationCacheEntry({geometry, elevations}), std::max(1, elevations.size()));
+  return true;
+}
+
 /* Background thread. Fetches elevation points from Marble elevation model and updates totals. */
 ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs) const
 {
@@ -1551,9 +1630,9 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
       if(geometry.size() == 1)
         geometry.append(geometry.first());
 
-      // Includes first and last point
+      // Includes first and last point - legs with unchanged geometry are taken from the cache
       LineString elevations;
-      if(!fetchRouteElevations(elevations, geometry))
+      if(!fetchRouteElevationsCached(elevations, geometry))
         return ElevationLegList();
 
       leg.geometry = geometry;
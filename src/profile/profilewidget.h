@@ -22,6 +22,8 @@
 
 #include <QFutureWatcher>
 #include <QWidget>
+#include <QCache>
+#include <QMutex>
 
 namespace atools {
 namespace geo {
@@ -47,6 +49,7 @@ class JumpBack;
 class Route;
 class RouteLeg;
 struct ElevationLegList;
+struct ElevationCacheEntry;
 
 /*
  * Loads and displays the flight plan elevation profile. The elevation data is
@@ -172,6 +175,11 @@ private:
   virtual void contextMenuEvent(QContextMenuEvent *event) override;
 
   bool fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const;
+
+  /* Same as above but takes elevations from cache if leg geometry is unchanged */
+  bool fetchRouteElevationsCached(atools::geo::LineString& elevations,
+                                  const atools::geo::LineString& geometry) const;
+  void clearElevationCache();
   ElevationLegList fetchRouteElevationsThread(ElevationLegList legs) const;
   void elevationUpdateAvailable();
   void updateTimeout();
@@ -271,6 +279,14 @@ private:
   QFutureWatcher<ElevationLegList> watcher;
   bool terminateThreadSignal = false;
 
+  /* Elevation points in meter for each leg keyed by a hash of the leg geometry. Only changed legs have to be
+   * sampled again on flight plan changes. Cost is number of points. Accessed by thread and GUI. */
+  mutable QCache<uint, ElevationCacheEntry> elevationCache;
+  mutable QMutex elevationCacheMutex;
+
+  /* Incremented when cache is cleared to avoid adding outdated results from a running thread */
+  int elevationCacheGeneration = 0;
+
   bool databaseLoadStatus = false;
 
   QRubberBand *rubberBand = nullptr;
@@ -24,6 +24,7 @@
 #include "sql/sqldatabase.h"
 #include "fs/common/binarygeometry.h"
 #include "common/maptools.h"
+#include "common/paintprofiler.h"
 #include "settings/settings.h"
 #include "db/databasemanager.h"
 
@@ -110,8 +111,8 @@ const QList<map::MapAirspace> *AirspaceQuery::getAirspaces(const GeoDataLatLonBo
                                                            map::MapAirspaceFilter filter, float flightPlanAltitude,
                                                            bool lazy, bool& overflow)
 {
-  airspaceCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bool rebuilt = airspaceCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                           [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersAirspace(newLayer);
   });
@@ -121,6 +122,7 @@ const QList<map::MapAirspace> *AirspaceQuery::getAirspaces(const GeoDataLatLonBo
   {
     // Need a few more parameters to clear the cache which is different to other map features
     airspaceCache.list.clear();
+    rebuilt = true;
     lastAirspaceFilter = filter;
     lastFlightplanAltitude = flightPlanAltitude;
   }
@@ -230,6 +232,7 @@ const QList<map::MapAirspace> *AirspaceQuery::getAirspaces(const GeoDataLatLonBo
     }
   }
   overflow = airspaceCache.validate(queryMaxRows);
+  PaintProfiler::query("Airspaces", !rebuilt, airspaceCache.list.size());
   return &airspaceCache.list;
 }
 
@@ -418,7 +421,8 @@ void AirspaceQuery::initQueries()
 
   // Get all that are crossing the anti meridian too and filter them out from the query result
   QString airspaceRect =
-    " (not (max_lonx < :leftx or min_lonx > :rightx or "
+    " " + query::whereRectIndex(db, table, id) +
+    "(not (max_lonx < :leftx or min_lonx > :rightx or "
     "min_laty > :topy or max_laty < :bottomy) or max_lonx < min_lonx) and ";
 
   airspaceByRectQuery = new SqlQuery(db);
@@ -439,7 +443,7 @@ void AirspaceQuery::initQueries()
   airspaceByRectAtAltQuery = new SqlQuery(db);
   airspaceByRectAtAltQuery->prepare(
     "select " + airspaceQueryBase + "from " + table +
-    " where "
+    " where " + query::whereRectIndex(db, table, id) +
     "not (max_lonx < :leftx or min_lonx > :rightx or "
     "min_laty > :topy or max_laty < :bottomy) and "
     "type like :type and "
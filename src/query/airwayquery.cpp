@@ -19,31 +19,25 @@
 
 #include "common/constants.h"
 #include "common/maptypesfactory.h"
+#include "common/paintprofiler.h"
 #include "common/proctypes.h"
 #include "mapgui/maplayer.h"
-#include "settings/settings.h"
+#include "query/mapqueryprefetcher.h"
 #include "sql/sqldatabase.h"
 
 using namespace Marble;
 using namespace atools::sql;
 using namespace atools::geo;
 
-static double queryRectInflationFactor = 0.2;
-static double queryRectInflationIncrement = 0.1;
-int AirwayQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
-
-AirwayQuery::AirwayQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam)
+AirwayQuery::AirwayQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam, const query::QuerySettings& settings)
   : dbNav(sqlDbNav), trackDatabase(trackDatabaseParam)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
-
-  queryRectInflationFactor = settings.getAndStoreValue(
-    lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.3).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(
-    lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
-  queryMaxRows =
-    settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "AirwayQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+
+  queryRectInflationFactor = settings.rectInflationFactor;
+  queryRectInflationIncrement = settings.rectInflationIncrement;
+  queryMaxRows = settings.airwayQueryMaxRows;
+  airwayCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
 }
 
 AirwayQuery::~AirwayQuery()
@@ -226,36 +220,59 @@ void AirwayQuery::getAirwaysByNameAndWaypoint(QList<map::MapAirway>& airways, co
 
 const QList<map::MapAirway> *AirwayQuery::getAirways(const GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy)
 {
-  airwayCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                          [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  // Tracks are not available in the prefetch thread
+  query::TiledRectCache<map::MapAirway>::TileLoadFunc loadFunc;
+  if(trackDatabase || !MapQueryPrefetcher::isLoadingInBackground())
+    loadFunc = [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapAirway>& tileList)
+               {
+                 airwayTile(tileList, tileRect);
+               };
+
+  bool rebuilt = airwayCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                         [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersAirwayTrack(newLayer);
-  });
+  }, loadFunc);
 
-  if(airwayCache.list.isEmpty() && !lazy)
-  {
-    QSet<int> ids;
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, airwayByRectQuery);
-      airwayByRectQuery->exec();
-      while(airwayByRectQuery->next())
-      {
-        if(ids.contains(airwayByRectQuery->valueInt(airwayIdCol)))
-          continue;
-
-        map::MapAirway airway;
-        mapTypesFactory->fillAirwayOrTrack(airwayByRectQuery->record(), airway, trackDatabase);
-        airwayCache.list.append(airway);
-        ids.insert(airway.id);
-      }
-    }
-  }
   airwayCache.validate(queryMaxRows);
+  PaintProfiler::query("Airways", !rebuilt, airwayCache.list.size());
   return &airwayCache.list;
 }
 
+void AirwayQuery::airwayTile(QList<map::MapAirway>& tileList, const GeoDataLatLonBox& tileRect)
+{
+  query::bindRect(tileRect, airwayByRectQuery);
+  airwayByRectQuery->exec();
+  while(airwayByRectQuery->next())
+  {
+    map::MapAirway airway;
+    mapTypesFactory->fillAirwayOrTrack(airwayByRectQuery->record(), airway, trackDatabase);
+    tileList.append(airway);
+  }
+}
+
+void AirwayQuery::getMissingTiles(query::PrefetchTiles& tiles, const GeoDataLatLonBox& rect) const
+{
+  if(tiles.mapLayer->isAirway() && (tiles.types.testFlag(map::AIRWAYV) || tiles.types.testFlag(map::AIRWAYJ)))
+    tiles.airwayKeys = airwayCache.missingTiles(rect, tiles.mapLayer, queryRectInflationFactor,
+                                                queryRectInflationIncrement);
+}
+
+void AirwayQuery::loadTiles(query::PrefetchTiles& tiles)
+{
+  for(const query::TileKey& key : tiles.airwayKeys)
+    airwayTile(tiles.airways[key], query::tileRect(key));
+}
+
+void AirwayQuery::insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped)
+{
+  for(auto it = tiles.airways.constBegin(); it != tiles.airways.constEnd(); ++it)
+  {
+    if(!airwayCache.insertTile(it.key(), it.value(), tiles.mapLayer))
+      dropped.airwayKeys.append(it.key());
+  }
+}
+
 void AirwayQuery::initQueries()
 {
   airwayTable = trackDatabase ? "track" : "airway";
@@ -302,8 +319,9 @@ void AirwayQuery::initQueries()
   airwayByRectQuery = new SqlQuery(dbNav);
   airwayByRectQuery->prepare(
     "select " + queryBase + ", right_lonx, left_lonx, bottom_laty, top_laty from " + airwayTable + " where " +
-    "not (right_lonx < :leftx or left_lonx > :rightx or bottom_laty > :topy or top_laty < :bottomy) "
-    "or right_lonx < left_lonx");
+    query::whereRectIndex(dbNav, airwayTable, airwayIdCol) +
+    "(not (right_lonx < :leftx or left_lonx > :rightx or bottom_laty > :topy or top_laty < :bottomy) "
+    "or right_lonx < left_lonx)");
 
   airwayByWaypointIdQuery = new SqlQuery(dbNav);
   airwayByWaypointIdQuery->prepare(
@@ -54,8 +54,9 @@ class AirwayQuery
 public:
   /*
    * @param sqlDbNav for updated navaids
+   * @param settings read in the GUI thread
    */
-  AirwayQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackDatabaseParam);
+  AirwayQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackDatabaseParam, const query::QuerySettings& settings);
   ~AirwayQuery();
 
   AirwayQuery(const AirwayQuery& other) = delete;
@@ -94,6 +95,16 @@ public:
    * if they have to be kept between event loop calls. */
   const QList<map::MapAirway> *getAirways(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
 
+  /* Get keys of airway tiles covering rect which are not cached yet. Uses layer and types in tiles which
+   * are set by MapQuery::getMissingTiles() before. */
+  void getMissingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect) const;
+
+  /* Load airways for all keys in tiles in the prefetch thread */
+  void loadTiles(query::PrefetchTiles& tiles);
+
+  /* Add tiles loaded by the prefetch thread to the cache. Keys of tiles not kept are added to dropped. */
+  void insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped);
+
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
 
@@ -105,11 +116,14 @@ public:
 private:
   map::MapWaypoint waypointById(int id);
 
+  /* Load airways overlapping one tile not touching the caches */
+  void airwayTile(QList<map::MapAirway>& tileList, const Marble::GeoDataLatLonBox& tileRect);
+
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbNav;
 
-  /* Simple bounding rectangle caches */
-  query::SimpleRectCache<map::MapAirway> airwayCache;
+  /* Tiled bounding rectangle cache. Airways overlapping more than one tile are merged by id. */
+  query::TiledRectCache<map::MapAirway> airwayCache;
 
   /* ID/object caches */
   QCache<query::NearestCacheKeyNavaid, map::MapResultIndex> nearestNavaidCache;
@@ -120,7 +134,9 @@ private:
   /* true if this uses the track database (PACOTS, NAT, etc.) */
   bool trackDatabase;
 
-  static int queryMaxRows;
+  /* Not static since instances are also used in the prefetch thread */
+  double queryRectInflationFactor = 0.3, queryRectInflationIncrement = 0.1;
+  int queryMaxRows = map::MAX_MAP_OBJECTS;
 
   /* Database queries */
   atools::sql::SqlQuery *airwayByRectQuery = nullptr;
@@ -153,6 +153,16 @@ void AirwayTrackQuery::getTracks(QList<map::MapAirway>& airways, const GeoDataLa
   }
 }
 
+void AirwayTrackQuery::getMissingTiles(query::PrefetchTiles& tiles, const GeoDataLatLonBox& rect) const
+{
+  airwayQuery->getMissingTiles(tiles, rect);
+}
+
+void AirwayTrackQuery::insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped)
+{
+  airwayQuery->insertTiles(tiles, dropped);
+}
+
 void AirwayTrackQuery::initQueries()
 {
   trackQuery->initQueries();
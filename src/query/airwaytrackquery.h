@@ -103,6 +103,10 @@ public:
   void getTracks(QList<map::MapAirway>& airways, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                  bool lazy);
 
+  /* Prefetching covers only the navigation database. See AirwayQuery::getMissingTiles(). */
+  void getMissingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect) const;
+  void insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped);
+
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
 
@@ -20,6 +20,7 @@
 #include "common/constants.h"
 #include "common/maptypesfactory.h"
 #include "common/maptools.h"
+#include "common/paintprofiler.h"
 #include "common/proctypes.h"
 #include "mapgui/maplayer.h"
 #include "online/onlinedatacontroller.h"
@@ -28,10 +29,10 @@
 #include "userdata/userdatacontroller.h"
 #include "query/airportquery.h"
 #include "query/airwaytrackquery.h"
+#include "query/mapqueryprefetcher.h"
 #include "query/waypointtrackquery.h"
 #include "sql/sqldatabase.h"
 #include "navapp.h"
-#include "settings/settings.h"
 #include "db/databasemanager.h"
 #include "fs/util/fsutil.h"
 #include "sql/sqlutil.h"
@@ -49,10 +50,6 @@ using map::MapParking;
 using map::MapHelipad;
 using map::MapUserpoint;
 
-static double queryRectInflationFactor = 0.2;
-static double queryRectInflationIncrement = 0.1;
-int MapQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
-
 // Queries only used for export ================================================
 // Get assigned airport for navaid by name, region and coordinate closest to position
 static QLatin1String AIRPORTIDENT_FROM_WAYPOINT("select a.ident, w.lonx, w.laty "
@@ -71,19 +68,24 @@ static QLatin1String AIRPORTIDENT_FROM_NDB("select a.ident, n.lonx, n.laty "
                                            "order by (abs(n.lonx - :lonx) + abs(n.laty - :laty)) limit 1");
 static float MAX_AIRPORT_IDENT_DISTANCE_M = atools::geo::nmToMeter(5.f);
 
-MapQuery::MapQuery(atools::sql::SqlDatabase *sqlDb, SqlDatabase *sqlDbNav, SqlDatabase *sqlDbUser)
+MapQuery::MapQuery(atools::sql::SqlDatabase *sqlDb, SqlDatabase *sqlDbNav, SqlDatabase *sqlDbUser,
+                   const query::QuerySettings& settings)
   : dbSim(sqlDb), dbNav(sqlDbNav), dbUser(sqlDbUser)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
-
-  runwayOverwiewCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "RunwayOverwiewCache",
-                                                           1000).toInt());
-  queryRectInflationFactor = settings.getAndStoreValue(
-    lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.3).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(
-    lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
-  queryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "MapQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+
+  runwayOverwiewCache.setMaxCost(settings.runwayOverviewCacheSize);
+  queryRectInflationFactor = settings.rectInflationFactor;
+  queryRectInflationIncrement = settings.rectInflationIncrement;
+  queryMaxRows = settings.mapQueryMaxRows;
+
+  // Approximate memory limit for each of the tiled caches
+  airportCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
+  vorCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
+  ndbCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
+  markerCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
+  holdingCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
+  ilsCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
 }
 
 MapQuery::~MapQuery()
@@ -559,139 +561,15 @@ QVector<map::MapIls> MapQuery::ilsByAirportAndRunway(const QString& airportIdent
   return ilsList;
 }
 
-void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const MapLayer *mapLayer,
-                                       bool airportDiagram, map::MapTypes types,
-                                       int xs, int ys, int screenDistance, map::MapResult& result)
+void MapQuery::getCachedObjects(map::MapResult& result) const
 {
-  using maptools::insertSortedByDistance;
-  using maptools::insertSortedByTowerDistance;
-
-  int x, y;
-  if(mapLayer->isAirport() && types.testFlag(map::AIRPORT))
-  {
-    for(int i = airportCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapAirport& airport = airportCache.list.at(i);
-
-      if(airport.isVisible(types))
-      {
-        if(conv.wToS(airport.position, x, y))
-          if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-            insertSortedByDistance(conv, result.airports, &result.airportIds, xs, ys, airport);
-
-        if(airportDiagram)
-        {
-          // Include tower for airport diagrams
-          if(conv.wToS(airport.towerCoords, x, y) &&
-             atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-            insertSortedByTowerDistance(conv, result.towers, xs, ys, airport);
-        }
-      }
-    }
-  }
-
-  if(mapLayer->isVor() && types.testFlag(map::VOR))
-  {
-    for(int i = vorCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapVor& vor = vorCache.list.at(i);
-      if(conv.wToS(vor.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.vors, &result.vorIds, xs, ys, vor);
-    }
-  }
-
-  if(mapLayer->isNdb() && types.testFlag(map::NDB))
-  {
-    for(int i = ndbCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapNdb& ndb = ndbCache.list.at(i);
-      if(conv.wToS(ndb.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.ndbs, &result.ndbIds, xs, ys, ndb);
-    }
-  }
-
-  if(mapLayer->isHolding() && types.testFlag(map::HOLDING))
-  {
-    for(int i = holdingCache.list.size() - 1; i >= 0; i--)
-    {
-      const map::MapHolding& holding = holdingCache.list.at(i);
-      if(conv.wToS(holding.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.holdings, &result.holdingIds, xs, ys, holding);
-    }
-  }
-
-  // No flag since visibility is defined by type
-  if(mapLayer->isUserpoint())
-  {
-    for(int i = userpointCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapUserpoint& wp = userpointCache.list.at(i);
-      if(conv.wToS(wp.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.userpoints, &result.userpointIds, xs, ys, wp);
-    }
-  }
-
-  // Add waypoints that displayed together with airways =================================
-  if((mapLayer->isAirwayWaypoint() && (types.testFlag(map::AIRWAYV) || types.testFlag(map::AIRWAYJ))) ||
-     (mapLayer->isTrackWaypoint() && types.testFlag(map::TRACK)) ||
-     (mapLayer->isWaypoint() && types.testFlag(map::WAYPOINT)))
-    NavApp::getWaypointTrackQuery()->getNearestScreenObjects(conv, mapLayer, types, xs, ys, screenDistance, result);
-
-  if(mapLayer->isMarker() && types.testFlag(map::MARKER))
-  {
-    for(int i = markerCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapMarker& wp = markerCache.list.at(i);
-      if(conv.wToS(wp.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.markers, nullptr, xs, ys, wp);
-    }
-  }
-
-  if(mapLayer->isIls() && types.testFlag(map::ILS))
-  {
-    for(int i = ilsCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapIls& wp = ilsCache.list.at(i);
-      if(conv.wToS(wp.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.ils, nullptr, xs, ys, wp);
-    }
-  }
-
-  // Get objects from airport diagram =====================================================
-  if(mapLayer->isAirport() && types.testFlag(map::AIRPORT))
-  {
-    if(airportDiagram)
-    {
-      QHash<int, QList<map::MapParking> > parkingCache = NavApp::getAirportQuerySim()->getParkingCache();
-
-      // Also check parking and helipads in airport diagrams
-      for(const QList<MapParking>& parkings : parkingCache)
-      {
-        for(const MapParking& p : parkings)
-        {
-          if(conv.wToS(p.position, x, y) && atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-            insertSortedByDistance(conv, result.parkings, nullptr, xs, ys, p);
-        }
-      }
-
-      QHash<int, QList<map::MapHelipad> > helipadCache = NavApp::getAirportQuerySim()->getHelipadCache();
-
-      for(const QList<MapHelipad>& helipads : helipadCache)
-      {
-        for(const MapHelipad& p : helipads)
-        {
-          if(conv.wToS(p.position, x, y) && atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-            insertSortedByDistance(conv, result.helipads, nullptr, xs, ys, p);
-        }
-      }
-    }
-  }
+  result.airports = airportCache.list;
+  result.vors = vorCache.list;
+  result.ndbs = ndbCache.list;
+  result.holdings = holdingCache.list;
+  result.userpoints = userpointCache.list;
+  result.markers = markerCache.list;
+  result.ils = ilsCache.list;
 }
 
 const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonBox& rect,
@@ -702,89 +580,166 @@ const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonB
   bool addon = types.testFlag(map::AIRPORT_ADDON);
   bool normal = types & (map::AIRPORT_HARD | map::AIRPORT_SOFT | map::AIRPORT_EMPTY);
 
-  airportCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                           [ = ](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bool navdata = NavApp::getDatabaseManager()->getNavDatabaseStatus() == dm::NAVDATABASE_ALL;
+  bool xplane = NavApp::isAirportDatabaseXPlane(navdata);
+
+  query::TiledRectCache<map::MapAirport>::TileLoadFunc loadFunc;
+  if(!MapQueryPrefetcher::isLoadingInBackground())
+    loadFunc = [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapAirport>& tileList)
+               {
+                 airportTile(tileList, tileRect, mapLayer, addon, normal, navdata, xplane);
+               };
+
+  bool rebuilt = airportCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                          [ = ](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersAirport(newLayer) &&
     // Invalidate cache if settings differ
     airportCacheAddonFlag == addon && airportCacheNormalFlag == normal;
-  });
+  }, loadFunc);
 
   airportCacheAddonFlag = addon;
   airportCacheNormalFlag = normal;
 
-  switch(mapLayer->getDataSource())
-  {
-    case layer::ALL:
-      airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-      return fetchAirports(rect, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
-
-    case layer::MEDIUM:
-      // Airports > 4000 ft
-      return fetchAirports(rect, airportMediumByRectQuery, lazy, true /* overview */, addon, normal, overflow);
-
-    case layer::LARGE:
-      // Airports > 8000 ft
-      return fetchAirports(rect, airportLargeByRectQuery, lazy, true /* overview */, addon, normal, overflow);
-
-  }
-  return nullptr;
+  overflow = airportCache.validate(queryMaxRows);
+  PaintProfiler::query("Airports", !rebuilt, airportCache.list.size());
+  return &airportCache.list;
 }
 
 const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                             bool lazy, bool& overflow)
 {
-  vorCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                       [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  query::TiledRectCache<map::MapVor>::TileLoadFunc loadFunc;
+  if(!MapQueryPrefetcher::isLoadingInBackground())
+    loadFunc = [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapVor>& tileList)
+               {
+                 vorTile(tileList, tileRect);
+               };
+
+  bool rebuilt = vorCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                      [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersVor(newLayer);
-  });
+  }, loadFunc);
 
-  if(vorCache.list.isEmpty() && !lazy)
-  {
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, vorsByRectQuery);
-      vorsByRectQuery->exec();
-      while(vorsByRectQuery->next())
-      {
-        map::MapVor vor;
-        mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
-        vorCache.list.append(vor);
-      }
-    }
-  }
   overflow = vorCache.validate(queryMaxRows);
+  PaintProfiler::query("VOR", !rebuilt, vorCache.list.size());
   return &vorCache.list;
 }
 
 const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                             bool lazy, bool& overflow)
 {
-  ndbCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                       [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  query::TiledRectCache<map::MapNdb>::TileLoadFunc loadFunc;
+  if(!MapQueryPrefetcher::isLoadingInBackground())
+    loadFunc = [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapNdb>& tileList)
+               {
+                 ndbTile(tileList, tileRect);
+               };
+
+  bool rebuilt = ndbCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                      [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersNdb(newLayer);
-  });
+  }, loadFunc);
+
+  overflow = ndbCache.validate(queryMaxRows);
+  PaintProfiler::query("NDB", !rebuilt, ndbCache.list.size());
+  return &ndbCache.list;
+}
+
+void MapQuery::getMissingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect,
+                               const MapLayer *mapLayer, map::MapTypes types) const
+{
+  tiles.mapLayer = mapLayer;
+  tiles.types = types;
+
+  // Database manager cannot be accessed in the prefetch thread
+  tiles.navdata = NavApp::getDatabaseManager()->getNavDatabaseStatus() == dm::NAVDATABASE_ALL;
+  tiles.airportDatabaseXPlane = NavApp::isAirportDatabaseXPlane(tiles.navdata);
+
+  bool addon = types.testFlag(map::AIRPORT_ADDON);
+  bool normal = types & (map::AIRPORT_HARD | map::AIRPORT_SOFT | map::AIRPORT_EMPTY);
+
+  // Only for the same flags since the cache is dropped on change anyway
+  if(types.testFlag(map::AIRPORT) && mapLayer->isAirport() &&
+     airportCacheAddonFlag == addon && airportCacheNormalFlag == normal)
+    tiles.airportKeys = airportCache.missingTiles(rect, mapLayer, queryRectInflationFactor,
+                                                  queryRectInflationIncrement);
 
-  if(ndbCache.list.isEmpty() && !lazy)
+  if(types.testFlag(map::VOR) && mapLayer->isVor())
+    tiles.vorKeys = vorCache.missingTiles(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement);
+
+  if(types.testFlag(map::NDB) && mapLayer->isNdb())
+    tiles.ndbKeys = ndbCache.missingTiles(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement);
+}
+
+void MapQuery::loadTiles(query::PrefetchTiles& tiles)
+{
+  bool addon = tiles.types.testFlag(map::AIRPORT_ADDON);
+  bool normal = tiles.types & (map::AIRPORT_HARD | map::AIRPORT_SOFT | map::AIRPORT_EMPTY);
+
+  for(const query::TileKey& key : tiles.airportKeys)
+    airportTile(tiles.airports[key], query::tileRect(key), tiles.mapLayer, addon, normal, tiles.navdata,
+                tiles.airportDatabaseXPlane);
+
+  for(const query::TileKey& key : tiles.vorKeys)
+    vorTile(tiles.vors[key], query::tileRect(key));
+
+  for(const query::TileKey& key : tiles.ndbKeys)
+    ndbTile(tiles.ndbs[key], query::tileRect(key));
+}
+
+void MapQuery::insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped)
+{
+  bool addon = tiles.types.testFlag(map::AIRPORT_ADDON);
+  bool normal = tiles.types & (map::AIRPORT_HARD | map::AIRPORT_SOFT | map::AIRPORT_EMPTY);
+
+  // Airport settings might have changed in the meantime
+  if(airportCacheAddonFlag == addon && airportCacheNormalFlag == normal)
   {
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    for(auto it = tiles.airports.constBegin(); it != tiles.airports.constEnd(); ++it)
     {
-      query::bindRect(r, ndbsByRectQuery);
-      ndbsByRectQuery->exec();
-      while(ndbsByRectQuery->next())
-      {
-        map::MapNdb ndb;
-        mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
-        ndbCache.list.append(ndb);
-      }
+      if(!airportCache.insertTile(it.key(), it.value(), tiles.mapLayer))
+        dropped.airportKeys.append(it.key());
     }
   }
-  overflow = ndbCache.validate(queryMaxRows);
-  return &ndbCache.list;
+
+  for(auto it = tiles.vors.constBegin(); it != tiles.vors.constEnd(); ++it)
+  {
+    if(!vorCache.insertTile(it.key(), it.value(), tiles.mapLayer))
+      dropped.vorKeys.append(it.key());
+  }
+
+  for(auto it = tiles.ndbs.constBegin(); it != tiles.ndbs.constEnd(); ++it)
+  {
+    if(!ndbCache.insertTile(it.key(), it.value(), tiles.mapLayer))
+      dropped.ndbKeys.append(it.key());
+  }
+}
+
+void MapQuery::vorTile(QList<map::MapVor>& tileList, const Marble::GeoDataLatLonBox& tileRect)
+{
+  query::bindRect(tileRect, vorsByRectQuery);
+  vorsByRectQuery->exec();
+  while(vorsByRectQuery->next())
+  {
+    map::MapVor vor;
+    mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
+    tileList.append(vor);
+  }
+}
+
+void MapQuery::ndbTile(QList<map::MapNdb>& tileList, const Marble::GeoDataLatLonBox& tileRect)
+{
+  query::bindRect(tileRect, ndbsByRectQuery);
+  ndbsByRectQuery->exec();
+  while(ndbsByRectQuery->next())
+  {
+    map::MapNdb ndb;
+    mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
+    tileList.append(ndb);
+  }
 }
 
 const QList<map::MapUserpoint> MapQuery::getUserdataPoints(const GeoDataLatLonBox& rect, const QStringList& types,
@@ -796,7 +751,7 @@ const QList<map::MapUserpoint> MapQuery::getUserdataPoints(const GeoDataLatLonBo
   userpointCache.clear();
 
   // Display either unknown or any type
-  if(unknownType || !types.isEmpty())
+  if(userdataPointByRectQuery != nullptr && (unknownType || !types.isEmpty()))
   {
     bool allTypesSelected = types == typesAll;
 
@@ -891,28 +846,25 @@ QString MapQuery::airportIdentFromQuery(const QString& queryStr, const QString&
 const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                                   bool lazy, bool& overflow)
 {
-  markerCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                          [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bool rebuilt = markerCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                         [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersMarker(newLayer);
-  });
-
-  if(markerCache.list.isEmpty() && !lazy)
+  },
+                                         [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapMarker>& tileList)
   {
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(tileRect, markersByRectQuery);
+    markersByRectQuery->exec();
+    while(markersByRectQuery->next())
     {
-      query::bindRect(r, markersByRectQuery);
-      markersByRectQuery->exec();
-      while(markersByRectQuery->next())
-      {
-        map::MapMarker marker;
-        mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
-        markerCache.list.append(marker);
-      }
+      map::MapMarker marker;
+      mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
+      tileList.append(marker);
     }
-  }
+  });
+
   overflow = markerCache.validate(queryMaxRows);
+  PaintProfiler::query("Markers", !rebuilt, markerCache.list.size());
   return &markerCache.list;
 }
 
@@ -921,29 +873,25 @@ const QList<map::MapHolding> *MapQuery::getHoldings(const Marble::GeoDataLatLonB
 {
   if(holdingByRectQuery != nullptr)
   {
-
-    holdingCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                             [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+    bool rebuilt = holdingCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
     {
       return curLayer->hasSameQueryParametersMarker(newLayer);
-    });
-
-    if(holdingCache.list.isEmpty() && !lazy)
+    },
+                                            [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapHolding>& tileList)
     {
-      for(const GeoDataLatLonBox& r :
-          query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+      query::bindRect(tileRect, holdingByRectQuery);
+      holdingByRectQuery->exec();
+      while(holdingByRectQuery->next())
       {
-        query::bindRect(r, holdingByRectQuery);
-        holdingByRectQuery->exec();
-        while(holdingByRectQuery->next())
-        {
-          map::MapHolding holding;
-          mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
-          holdingCache.list.append(holding);
-        }
+        map::MapHolding holding;
+        mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
+        tileList.append(holding);
       }
-    }
+    });
+
     overflow = holdingCache.validate(queryMaxRows);
+    PaintProfiler::query("Holdings", !rebuilt, holdingCache.list.size());
     return &holdingCache.list;
   }
   return nullptr;
@@ -951,103 +899,105 @@ const QList<map::MapHolding> *MapQuery::getHoldings(const Marble::GeoDataLatLonB
 
 const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer *mapLayer, bool lazy, bool& overflow)
 {
-  ilsCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                       [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bool rebuilt = ilsCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                      [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersIls(newLayer);
-  });
-
-  if(ilsCache.list.isEmpty() && !lazy)
+  },
+                                      [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapIls>& tileList)
   {
-    // ILS length is 9 NM * 1' per degree
-    double increase = atools::geo::toRadians(9. / 60.);
+    // Increase bounding rect since ILS has no bounding to query - ILS length is 9 NM * 1' per degree
+    GeoDataLatLonBox r(tileRect);
+    query::inflateQueryRect(r, 0., 9. / 60.);
 
-    // Increase bounding rect since ILS has no bounding to query
-    rect.setBoundaries(rect.north() + increase, rect.south() - increase,
-                       rect.east() + increase, rect.west() - increase);
-
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(r, ilsByRectQuery);
+    ilsByRectQuery->exec();
+    while(ilsByRectQuery->next())
     {
-      query::bindRect(r, ilsByRectQuery);
-
-      ilsByRectQuery->exec();
-      while(ilsByRectQuery->next())
-      {
-        map::MapIls ils;
-        mapTypesFactory->fillIls(ilsByRectQuery->record(), ils);
-        ilsCache.list.append(ils);
-      }
+      map::MapIls ils;
+      mapTypesFactory->fillIls(ilsByRectQuery->record(), ils);
+      tileList.append(ils);
     }
-  }
+  });
+
   overflow = ilsCache.validate(queryMaxRows);
+  PaintProfiler::query("ILS", !rebuilt, ilsCache.list.size());
   return &ilsCache.list;
 }
 
 /*
- * Get airport cache
- * @param reverse reverse order of airports to have unimportant small ones below in painting order
- * @param lazy do not update cache - instead return incomplete resut
- * @param overview fetch only incomplete data for overview airports
- * @return pointer to the airport cache
+ * Load airports for one tile
+ * @param addon load add-on airports
+ * @param normal load airports matching the layer
+ * @param navdata and xplane database state which has to be passed in from the GUI thread
  */
-const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect,
-                                                      atools::sql::SqlQuery *query,
-                                                      bool lazy, bool overview, bool addon, bool normal, bool& overflow)
+void MapQuery::airportTile(QList<map::MapAirport>& tileList, const Marble::GeoDataLatLonBox& tileRect,
+                           const MapLayer *mapLayer, bool addon, bool normal, bool navdata, bool xplane)
 {
-  if(airportCache.list.isEmpty() && !lazy)
+  atools::sql::SqlQuery *query = nullptr;
+  bool overview = false;
+  switch(mapLayer->getDataSource())
   {
-    bool navdata = NavApp::getDatabaseManager()->getNavDatabaseStatus() == dm::NAVDATABASE_ALL;
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    case layer::ALL:
+      airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
+      query = airportByRectQuery;
+      break;
+
+    case layer::MEDIUM:
+      // Airports > 4000 ft
+      query = airportMediumByRectQuery;
+      overview = true;
+      break;
+
+    case layer::LARGE:
+      // Airports > 8000 ft
+      query = airportLargeByRectQuery;
+      overview = true;
+      break;
+  }
+
+  if(query == nullptr)
+    return;
+
+  // Avoid duplicates between both queries
+  QSet<int> ids;
+
+  // Get normal airports ==========
+  if(normal)
+  {
+    query::bindRect(tileRect, query);
+    query->exec();
+    while(query->next())
     {
-      // Avoid duplicates between both queries
-      QSet<int> ids;
+      map::MapAirport ap;
+      if(overview)
+        // Fill only a part of the object
+        mapTypesFactory->fillAirportForOverview(query->record(), ap, navdata, xplane);
+      else
+        mapTypesFactory->fillAirport(query->record(), ap, true /* complete */, navdata, xplane);
 
-      // Get normal airports ==========
-      if(normal)
-      {
-        query::bindRect(r, query);
-        query->exec();
-        while(query->next())
-        {
-          map::MapAirport ap;
-          if(overview)
-            // Fill only a part of the object
-            mapTypesFactory->fillAirportForOverview(query->record(), ap, navdata,
-                                                    NavApp::isAirportDatabaseXPlane(navdata));
-          else
-            mapTypesFactory->fillAirport(query->record(), ap, true /* complete */, navdata,
-                                         NavApp::isAirportDatabaseXPlane(navdata));
-
-          ids.insert(ap.id);
-          airportCache.list.append(ap);
-        }
-      }
+      ids.insert(ap.id);
+      tileList.append(ap);
+    }
+  }
 
-      // Get add-on airports ==========
-      if(addon)
-      {
-        query::bindRect(r, airportAddonByRectQuery);
-        airportAddonByRectQuery->exec();
-        while(airportAddonByRectQuery->next())
-        {
-          map::MapAirport ap;
-          if(overview)
-            // Fill only a part of the object
-            mapTypesFactory->fillAirportForOverview(airportAddonByRectQuery->record(), ap, navdata,
-                                                    NavApp::isAirportDatabaseXPlane(navdata));
-          else
-            mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), ap, true /* complete */, navdata,
-                                         NavApp::isAirportDatabaseXPlane(navdata));
-          if(!ids.contains(ap.id))
-            airportCache.list.append(ap);
-        }
-      }
+  // Get add-on airports ==========
+  if(addon)
+  {
+    query::bindRect(tileRect, airportAddonByRectQuery);
+    airportAddonByRectQuery->exec();
+    while(airportAddonByRectQuery->next())
+    {
+      map::MapAirport ap;
+      if(overview)
+        // Fill only a part of the object
+        mapTypesFactory->fillAirportForOverview(airportAddonByRectQuery->record(), ap, navdata, xplane);
+      else
+        mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), ap, true /* complete */, navdata, xplane);
+      if(!ids.contains(ap.id))
+        tileList.append(ap);
     }
   }
-  overflow = airportCache.validate(queryMaxRows);
-  return &airportCache.list;
 }
 
 const QList<map::MapRunway> *MapQuery::getRunwaysForOverview(int airportId)
@@ -1134,7 +1084,8 @@ void MapQuery::initQueries()
   // Common where clauses
   static const QString whereRect("lonx between :leftx and :rightx and laty between :bottomy and :topy");
   static const QString whereIdentRegion("ident = :ident and region like :region");
-  static const QString whereLimit("limit " + QString::number(queryMaxRows));
+  // Only for queries not loading tiles - row limit for tiles is applied after merging them
+  const QString whereLimit("limit " + QString::number(queryMaxRows));
 
   // Common select statements
   QStringList const airportQueryBase = AirportQuery::airportColumns(dbSim);
@@ -1223,21 +1174,23 @@ void MapQuery::initQueries()
 
   airportByRectQuery = new SqlQuery(dbSim);
   airportByRectQuery->prepare(
-    "select " + airportQueryBase.join(", ") + " from airport where " + whereRect +
-    " and longest_runway_length >= :minlength "
-    + whereLimit);
+    "select " + airportQueryBase.join(", ") + " from airport where " +
+    query::whereRectPoint(dbSim, "airport", "airport_id") + " and longest_runway_length >= :minlength");
 
   airportAddonByRectQuery = new SqlQuery(dbSim);
   airportAddonByRectQuery->prepare(
-    "select " + airportQueryBase.join(", ") + " from airport where " + whereRect + " and is_addon = 1 " + whereLimit);
+    "select " + airportQueryBase.join(", ") + " from airport where " +
+    query::whereRectPoint(dbSim, "airport", "airport_id") + " and is_addon = 1");
 
   airportMediumByRectQuery = new SqlQuery(dbSim);
   airportMediumByRectQuery->prepare(
-    "select " + airportQueryBaseOverview.join(", ") + " from airport_medium where " + whereRect + " " + whereLimit);
+    "select " + airportQueryBaseOverview.join(", ") + " from airport_medium where " +
+    query::whereRectPoint(dbSim, "airport_medium", "airport_id"));
 
   airportLargeByRectQuery = new SqlQuery(dbSim);
   airportLargeByRectQuery->prepare(
-    "select " + airportQueryBaseOverview.join(", ") + " from airport_large where " + whereRect + " " + whereLimit);
+    "select " + airportQueryBaseOverview.join(", ") + " from airport_large where " +
+    query::whereRectPoint(dbSim, "airport_large", "airport_id"));
 
   // Runways > 4000 feet for simplyfied runway overview
   runwayOverviewQuery = new SqlQuery(dbSim);
@@ -1246,29 +1199,36 @@ void MapQuery::initQueries()
     "from runway where airport_id = :airportId and length > 4000 " + whereLimit);
 
   vorsByRectQuery = new SqlQuery(dbNav);
-  vorsByRectQuery->prepare("select " + vorQueryBase + " from vor where " + whereRect + " " + whereLimit);
+  vorsByRectQuery->prepare("select " + vorQueryBase + " from vor where " +
+                           query::whereRectPoint(dbNav, "vor", "vor_id"));
 
   ndbsByRectQuery = new SqlQuery(dbNav);
-  ndbsByRectQuery->prepare("select " + ndbQueryBase + " from ndb where " + whereRect + " " + whereLimit);
+  ndbsByRectQuery->prepare("select " + ndbQueryBase + " from ndb where " +
+                           query::whereRectPoint(dbNav, "ndb", "ndb_id"));
 
-  userdataPointByRectQuery = new SqlQuery(dbUser);
-  userdataPointByRectQuery->prepare("select * from userdata "
-                                    "where " + whereRect + " and visible_from > :dist and type like :type " +
-                                    whereLimit);
+  if(dbUser != nullptr)
+  {
+    userdataPointByRectQuery = new SqlQuery(dbUser);
+    userdataPointByRectQuery->prepare("select * from userdata "
+                                      "where " + whereRect + " and visible_from > :dist and type like :type " +
+                                      whereLimit);
+  }
 
   markersByRectQuery = new SqlQuery(dbSim);
   markersByRectQuery->prepare(
     "select marker_id, type, ident, heading, lonx, laty "
     "from marker "
-    "where " + whereRect + " " + whereLimit);
+    "where " + query::whereRectPoint(dbSim, "marker", "marker_id"));
 
   ilsByRectQuery = new SqlQuery(dbSim);
-  ilsByRectQuery->prepare("select " + ilsQueryBase + " from ils where " + whereRect + " " + whereLimit);
+  ilsByRectQuery->prepare("select " + ilsQueryBase + " from ils where " +
+                          query::whereRectPoint(dbSim, "ils", "ils_id"));
 
   if(holdingDb != nullptr)
   {
     holdingByRectQuery = new SqlQuery(holdingDb);
-    holdingByRectQuery->prepare("select " + holdingQueryBase + " from holding where " + whereRect + " " + whereLimit);
+    holdingByRectQuery->prepare("select " + holdingQueryBase + " from holding where " +
+                                query::whereRectPoint(holdingDb, "holding", "holding_id"));
   }
 
   // Check for GLS ground station or GBAS threshold
@@ -52,9 +52,11 @@ public:
   /*
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
+   * @param sqlDbUser for userpoints. Can be null if userpoints are not needed.
+   * @param settings read in the GUI thread
    */
   MapQuery(atools::sql::SqlDatabase *sqlDb, atools::sql::SqlDatabase *sqlDbNav,
-           atools::sql::SqlDatabase *sqlDbUser);
+           atools::sql::SqlDatabase *sqlDbUser, const query::QuerySettings& settings);
   ~MapQuery();
 
   MapQuery(const MapQuery& other) = delete;
@@ -137,20 +139,11 @@ public:
                         bool airportFromNavDatabase);
 
   /*
-   * Get objects near a screen coordinate from the cache which will cover all visible objects.
-   * No objects are loaded from the database.
-   *
-   * @param conv Converter to calcualte screen coordinates
-   * @param mapLayer current map layer
-   * @param airportDiagram get nearest parking and helipads too
-   * @param types map objects to fetch AIRPORT, VOR, NDB, WAYPOINT, AIRWAY, etc.
-   * @param xs/ys Screen coordinates
-   * @param screenDistance maximum distance to coordinates
-   * @param result will receive objects based on type
+   * Get all airports, VOR, NDB, holdings, userpoints, markers and ILS from the caches which will cover all
+   * visible objects. No objects are loaded from the database.
+   * Lists are implicitly shared and are used to build the screen index for the nearest object search.
    */
-  void getNearestScreenObjects(const CoordinateConverter& conv, const MapLayer *mapLayer, bool airportDiagram,
-                               map::MapTypes types, int xs, int ys, int screenDistance,
-                               map::MapResult& result);
+  void getCachedObjects(map::MapResult& result) const;
 
   /* Only VOR, NDB, ILS and waypoints
    * All sorted by distance to pos with a maximum distance distanceNm
@@ -193,6 +186,18 @@ public:
   /* Similar to getAirports */
   const QList<map::MapIls> *getIls(Marble::GeoDataLatLonBox rect, const MapLayer *mapLayer, bool lazy, bool& overflow);
 
+  /* Get keys of airport, VOR and NDB tiles covering rect which are not cached yet. Used to prepare prefetching. */
+  void getMissingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect,
+                       const MapLayer *mapLayer, map::MapTypes types) const;
+
+  /* Load objects for all keys in tiles without using or changing the caches. Called in the prefetch thread
+   * on an instance having its own database connections. */
+  void loadTiles(query::PrefetchTiles& tiles);
+
+  /* Add tiles loaded by the prefetch thread to the caches. Tiles for other layers or settings are ignored.
+   * Keys of tiles which could not be kept due to the memory limit are added to dropped. */
+  void insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped);
+
   /* Get a partially filled runway list for the overview */
   const QList<map::MapRunway> *getRunwaysForOverview(int airportId);
 
@@ -228,9 +233,11 @@ private:
                                 const atools::geo::Pos& sortByDistancePos,
                                 float maxDistanceMeter, bool airportFromNavDatabase);
 
-  const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect,
-                                              atools::sql::SqlQuery *query,
-                                              bool lazy, bool overview, bool addon, bool normal, bool& overflow);
+  /* Load objects for one tile not touching the caches */
+  void airportTile(QList<map::MapAirport>& tileList, const Marble::GeoDataLatLonBox& tileRect,
+                   const MapLayer *mapLayer, bool addon, bool normal, bool navdata, bool xplane);
+  void vorTile(QList<map::MapVor>& tileList, const Marble::GeoDataLatLonBox& tileRect);
+  void ndbTile(QList<map::MapNdb>& tileList, const Marble::GeoDataLatLonBox& tileRect);
   QVector<map::MapIls> ilsByAirportAndRunway(const QString& airportIdent, const QString& runway);
 
   void runwayEndByNameFuzzy(QList<map::MapRunwayEnd>& runwayEnds, const QString& name, const map::MapAirport& airport,
@@ -241,16 +248,18 @@ private:
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbSim, *dbNav, *dbUser;
 
-  /* Simple bounding rectangle caches */
+  /* Tiled bounding rectangle caches */
   bool airportCacheAddonFlag = false; // Keep addon status flag for comparing
   bool airportCacheNormalFlag = false; // Keep normal (non add-on) status flag for comparing
-  query::SimpleRectCache<map::MapAirport> airportCache;
+  query::TiledRectCache<map::MapAirport> airportCache;
+  query::TiledRectCache<map::MapVor> vorCache;
+  query::TiledRectCache<map::MapNdb> ndbCache;
+  query::TiledRectCache<map::MapMarker> markerCache;
+  query::TiledRectCache<map::MapHolding> holdingCache;
+  query::TiledRectCache<map::MapIls> ilsCache;
+
+  /* Simple bounding rectangle cache - user points can change */
   query::SimpleRectCache<map::MapUserpoint> userpointCache;
-  query::SimpleRectCache<map::MapVor> vorCache;
-  query::SimpleRectCache<map::MapNdb> ndbCache;
-  query::SimpleRectCache<map::MapMarker> markerCache;
-  query::SimpleRectCache<map::MapHolding> holdingCache;
-  query::SimpleRectCache<map::MapIls> ilsCache;
 
   bool gls = false;
 
@@ -258,7 +267,9 @@ private:
   QCache<int, QList<map::MapRunway> > runwayOverwiewCache;
   QCache<query::NearestCacheKeyNavaid, map::MapResultIndex> nearestNavaidCache;
 
-  static int queryMaxRows;
+  /* Not static since instances are also used in the prefetch thread */
+  double queryRectInflationFactor = 0.3, queryRectInflationIncrement = 0.1;
+  int queryMaxRows = map::MAX_MAP_OBJECTS;
 
   /* Database queries */
   atools::sql::SqlQuery *runwayOverviewQuery = nullptr,
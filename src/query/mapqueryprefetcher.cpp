@@ -0,0 +1,357 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "query/mapqueryprefetcher.h"
+
+#include "common/constants.h"
+#include "query/airwayquery.h"
+#include "query/airwaytrackquery.h"
+#include "query/mapquery.h"
+#include "query/waypointquery.h"
+#include "query/waypointtrackquery.h"
+#include "navapp.h"
+#include "settings/settings.h"
+#include "sql/sqldatabase.h"
+#include "exception.h"
+
+#include <QDebug>
+
+#include <cmath>
+
+using atools::sql::SqlDatabase;
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+
+/* Connection names for the prefetch thread */
+static const QString DATABASE_NAME_PREFETCH_SIM("LNMDBPREFETCHSIM");
+static const QString DATABASE_NAME_PREFETCH_NAV("LNMDBPREFETCHNAV");
+static const QString DATABASE_TYPE("QSQLITE");
+
+/* Ignore map movements older than this */
+static const qint64 MAX_MOVEMENT_INTERVAL_MS = 2000L;
+
+/* Prefetch area is the current one moved this number of last movements ahead */
+static const double PREFETCH_STEPS = 2.;
+
+/* Zoom changes above this ratio are not considered as movement */
+static const double MAX_ZOOM_RATIO = 1.1;
+
+static double normalizeLonDeg(double lon)
+{
+  while(lon > 180.)
+    lon -= 360.;
+  while(lon < -180.)
+    lon += 360.;
+  return lon;
+}
+
+MapQueryPrefetchWorker::MapQueryPrefetchWorker(const query::QuerySettings& settings)
+  : querySettings(settings)
+{
+
+}
+
+MapQueryPrefetchWorker::~MapQueryPrefetchWorker()
+{
+  deInitDatabases();
+}
+
+void MapQueryPrefetchWorker::initDatabases(const QString& simDbFile, const QString& navDbFile)
+{
+  deInitDatabases();
+
+  try
+  {
+    SqlDatabase::addDatabase(DATABASE_TYPE, DATABASE_NAME_PREFETCH_SIM);
+    SqlDatabase::addDatabase(DATABASE_TYPE, DATABASE_NAME_PREFETCH_NAV);
+
+    // Only read access - main connections are not blocked
+    dbSim = new SqlDatabase(DATABASE_NAME_PREFETCH_SIM);
+    dbSim->setDatabaseName(simDbFile);
+    dbSim->setReadonly();
+    dbSim->open({"PRAGMA cache_size=-10000"});
+
+    dbNav = new SqlDatabase(DATABASE_NAME_PREFETCH_NAV);
+    dbNav->setDatabaseName(navDbFile);
+    dbNav->setReadonly();
+    dbNav->open({"PRAGMA cache_size=-10000"});
+
+    // Spatial index files are created by the DatabaseManager before this is called
+    query::attachSpatialIndex(dbSim);
+    query::attachSpatialIndex(dbNav);
+
+    // No userpoints needed
+    mapQuery = new MapQuery(dbSim, dbNav, nullptr, querySettings);
+    mapQuery->initQueries();
+
+    // Tracks are not prefetched
+    waypointQuery = new WaypointQuery(dbNav, false, querySettings);
+    waypointQuery->initQueries();
+
+    airwayQuery = new AirwayQuery(dbNav, false, querySettings);
+    airwayQuery->initQueries();
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open prefetch databases" << e.what();
+    deInitDatabases();
+  }
+}
+
+void MapQueryPrefetchWorker::deInitDatabases()
+{
+  delete mapQuery;
+  mapQuery = nullptr;
+
+  delete waypointQuery;
+  waypointQuery = nullptr;
+
+  delete airwayQuery;
+  airwayQuery = nullptr;
+
+  if(dbSim != nullptr || dbNav != nullptr)
+  {
+    if(dbSim != nullptr && dbSim->isOpen())
+      dbSim->close();
+    delete dbSim;
+    dbSim = nullptr;
+
+    if(dbNav != nullptr && dbNav->isOpen())
+      dbNav->close();
+    delete dbNav;
+    dbNav = nullptr;
+
+    SqlDatabase::removeDatabase(DATABASE_NAME_PREFETCH_SIM);
+    SqlDatabase::removeDatabase(DATABASE_NAME_PREFETCH_NAV);
+  }
+}
+
+void MapQueryPrefetchWorker::prefetch(query::PrefetchTiles tiles)
+{
+  if(mapQuery != nullptr)
+  {
+    try
+    {
+      mapQuery->loadTiles(tiles);
+      waypointQuery->loadTiles(tiles);
+      airwayQuery->loadTiles(tiles);
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Prefetch failed" << e.what();
+      tiles.clearObjects();
+      tiles.failed = true;
+    }
+  }
+
+  // Send back always to reset the request state
+  emit prefetchFinished(tiles);
+}
+
+// ===============================================================================================
+
+MapQueryPrefetcher::MapQueryPrefetcher(QObject *parent)
+  : QObject(parent)
+{
+  enabled = atools::settings::Settings::instance().getAndStoreValue(lnm::SETTINGS_MAPQUERY + "Prefetch",
+                                                                     true).toBool();
+
+  qRegisterMetaType<query::PrefetchTiles>();
+
+  // Settings are not accessible from the thread
+  worker = new MapQueryPrefetchWorker(query::QuerySettings::read());
+  worker->moveToThread(&thread);
+
+  connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+  connect(this, &MapQueryPrefetcher::prefetchRequested, worker, &MapQueryPrefetchWorker::prefetch,
+          Qt::QueuedConnection);
+  connect(this, &MapQueryPrefetcher::initDatabasesRequested, worker, &MapQueryPrefetchWorker::initDatabases,
+          Qt::BlockingQueuedConnection);
+  connect(this, &MapQueryPrefetcher::deInitDatabasesRequested, worker, &MapQueryPrefetchWorker::deInitDatabases,
+          Qt::BlockingQueuedConnection);
+  connect(worker, &MapQueryPrefetchWorker::prefetchFinished, this, &MapQueryPrefetcher::prefetchFinished,
+          Qt::QueuedConnection);
+
+  thread.setObjectName("MapQueryPrefetch");
+  thread.start(QThread::LowPriority);
+}
+
+MapQueryPrefetcher::~MapQueryPrefetcher()
+{
+  preDatabaseLoad();
+
+  // Worker is deleted in thread when finished
+  thread.quit();
+  thread.wait();
+}
+
+void MapQueryPrefetcher::preDatabaseLoad()
+{
+  // Results of running requests belong to the old database
+  requestId++;
+  requestPending = viewPending = loadDirect = false;
+  lastRect.clear();
+  droppedTiles = query::PrefetchTiles();
+  lastMapLayer = nullptr;
+
+  if(databasesOpen)
+  {
+    // Waits for a running prefetch
+    emit deInitDatabasesRequested();
+    databasesOpen = false;
+  }
+}
+
+void MapQueryPrefetcher::postDatabaseLoad()
+{
+  if(enabled && !databasesOpen)
+  {
+    emit initDatabasesRequested(NavApp::getDatabaseSim()->databaseName(),
+                                NavApp::getDatabaseNav()->databaseName());
+
+    // Worker is idle after the blocking call - fall back to loading in the GUI thread on error
+    databasesOpen = worker->isInitialized();
+  }
+}
+
+bool MapQueryPrefetcher::isLoadingInBackground()
+{
+  const MapQueryPrefetcher *prefetcher = NavApp::getMapQueryPrefetcher();
+  return prefetcher != nullptr && prefetcher->databasesOpen && prefetcher->paintingVisibleMap &&
+         !prefetcher->loadDirect;
+}
+
+void MapQueryPrefetcher::viewChanged(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                     map::MapTypes types)
+{
+  qint64 elapsed = lastRectTimer.isValid() ? lastRectTimer.restart() : MAX_MOVEMENT_INTERVAL_MS;
+  if(!lastRectTimer.isValid())
+    lastRectTimer.start();
+
+  // Frame was drawn with tiles loaded in the GUI thread
+  loadDirect = false;
+
+  if(mapLayer != lastMapLayer)
+  {
+    // Other tiles for the new layer
+    droppedTiles = query::PrefetchTiles();
+    lastMapLayer = mapLayer;
+  }
+
+  if(requestPending)
+    // Check visible area again once the running request is done
+    viewPending = true;
+  else if(databasesOpen && mapLayer != nullptr)
+  {
+    // Tiles left out while painting the visible area first ==================
+    query::PrefetchTiles tiles;
+    missingTiles(tiles, rect, mapLayer, types);
+    tiles.visible = !tiles.isEmpty();
+
+    if(tiles.isEmpty() && !lastRect.isEmpty() && elapsed < MAX_MOVEMENT_INTERVAL_MS)
+    {
+      // Tiles ahead of the map movement ==================
+      double widthRatio = rect.width() / lastRect.width();
+
+      if(widthRatio < MAX_ZOOM_RATIO && widthRatio > 1. / MAX_ZOOM_RATIO)
+      {
+        // Movement without zoom - estimate next position from last step
+        GeoDataCoordinates center = rect.center(), lastCenter = lastRect.center();
+        double dLon = normalizeLonDeg(center.longitude(GeoDataCoordinates::Degree) -
+                                      lastCenter.longitude(GeoDataCoordinates::Degree)) * PREFETCH_STEPS;
+        double dLat = (center.latitude(GeoDataCoordinates::Degree) -
+                       lastCenter.latitude(GeoDataCoordinates::Degree)) * PREFETCH_STEPS;
+
+        if(std::abs(dLon) > 0. || std::abs(dLat) > 0.)
+        {
+          GeoDataLatLonBox nextRect(std::min(rect.north(GeoDataCoordinates::Degree) + dLat, 90.),
+                                    std::max(rect.south(GeoDataCoordinates::Degree) + dLat, -90.),
+                                    normalizeLonDeg(rect.east(GeoDataCoordinates::Degree) + dLon),
+                                    normalizeLonDeg(rect.west(GeoDataCoordinates::Degree) + dLon),
+                                    GeoDataCoordinates::Degree);
+          missingTiles(tiles, nextRect, mapLayer, types);
+
+          // Would be dropped again
+          tiles.removeKeys(droppedTiles);
+        }
+      }
+    }
+
+    if(!tiles.isEmpty())
+    {
+#ifdef DEBUG_INFORMATION
+      qDebug() << Q_FUNC_INFO << "visible" << tiles.visible << "airports" << tiles.airportKeys.size()
+               << "vors" << tiles.vorKeys.size() << "ndbs" << tiles.ndbKeys.size()
+               << "waypoints" << tiles.waypointKeys.size() << "airways" << tiles.airwayKeys.size();
+#endif
+      tiles.requestId = requestId;
+      requestPending = true;
+      emit prefetchRequested(tiles);
+    }
+  }
+
+  lastRect = rect;
+}
+
+void MapQueryPrefetcher::missingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect,
+                                      const MapLayer *mapLayer, map::MapTypes types) const
+{
+  // Sets layer and types which are used by the other queries
+  NavApp::getMapQuery()->getMissingTiles(tiles, rect, mapLayer, types);
+  NavApp::getWaypointTrackQuery()->getMissingTiles(tiles, rect);
+  NavApp::getAirwayTrackQuery()->getMissingTiles(tiles, rect);
+}
+
+void MapQueryPrefetcher::prefetchFinished(const query::PrefetchTiles& tiles)
+{
+  if(tiles.requestId == requestId)
+  {
+    requestPending = false;
+
+    if(tiles.failed)
+    {
+      // Load all tiles in the GUI thread from now on
+      preDatabaseLoad();
+      emit tilesLoaded();
+      return;
+    }
+
+    // Caches drop tiles exceeding the memory limit if these are not visible
+    query::PrefetchTiles dropped;
+    NavApp::getMapQuery()->insertTiles(tiles, dropped);
+    NavApp::getWaypointTrackQuery()->insertTiles(tiles, dropped);
+    NavApp::getAirwayTrackQuery()->insertTiles(tiles, dropped);
+
+    if(!dropped.isEmpty())
+    {
+      qDebug() << Q_FUNC_INFO << "Tiles dropped by cache: airports" << dropped.airportKeys.size()
+               << "vors" << dropped.vorKeys.size() << "ndbs" << dropped.ndbKeys.size()
+               << "waypoints" << dropped.waypointKeys.size() << "airways" << dropped.airwayKeys.size();
+
+      if(tiles.visible)
+        // View changed in the meantime - avoid an endless request loop and query directly for the next frame
+        loadDirect = true;
+      else
+        droppedTiles.appendKeys(dropped);
+    }
+
+    if(tiles.visible || viewPending)
+      // Draw the parts which were left out - this calls viewChanged() again which requests remaining tiles
+      emit tilesLoaded();
+    viewPending = false;
+  }
+}
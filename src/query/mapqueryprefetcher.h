@@ -0,0 +1,168 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPQUERYPREFETCHER_H
+#define LITTLENAVMAP_MAPQUERYPREFETCHER_H
+
+#include "query/querytypes.h"
+
+#include <QObject>
+#include <QThread>
+#include <QElapsedTimer>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+class MapQuery;
+class MapLayer;
+class WaypointQuery;
+class AirwayQuery;
+
+/*
+ * Lives in the prefetch thread and owns read only connections to the simulator and navigation databases
+ * as well as map, waypoint and airway query instances using these. Caches of these instances are not used.
+ */
+class MapQueryPrefetchWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  /* Settings have to be read in the GUI thread before moving this to the worker thread */
+  explicit MapQueryPrefetchWorker(const query::QuerySettings& settings);
+  virtual ~MapQueryPrefetchWorker() override;
+
+  /* Open databases and prepare queries. Has to be called in the worker thread. */
+  void initDatabases(const QString& simDbFile, const QString& navDbFile);
+
+  /* Close databases and delete queries. Has to be called in the worker thread. */
+  void deInitDatabases();
+
+  /* True if databases and queries were set up successfully */
+  bool isInitialized() const
+  {
+    return mapQuery != nullptr;
+  }
+
+  /* Load all requested tiles and send them back with prefetchFinished */
+  void prefetch(query::PrefetchTiles tiles);
+
+signals:
+  void prefetchFinished(const query::PrefetchTiles& tiles);
+
+private:
+  query::QuerySettings querySettings;
+  atools::sql::SqlDatabase *dbSim = nullptr, *dbNav = nullptr;
+  MapQuery *mapQuery = nullptr;
+  WaypointQuery *waypointQuery = nullptr;
+  AirwayQuery *airwayQuery = nullptr;
+};
+
+/*
+ * Loads airports, VOR, NDB, waypoints and airways into the tile caches of the main query instances.
+ *
+ * Tiles which are missing while painting the visible map are left out by the queries (see
+ * isLoadingInBackground()) and requested first. The map is redrawn once these arrive.
+ * Tiles ahead of the movement of the map are requested afterwards. Movement is estimated from the last changes
+ * of the visible area which also covers the map following the user aircraft.
+ *
+ * Loading is done in a separate thread using own database connections. Tiles are added to the caches in the
+ * GUI thread once loaded. Web and print rendering still load missing tiles synchronously.
+ */
+class MapQueryPrefetcher :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MapQueryPrefetcher(QObject *parent);
+  virtual ~MapQueryPrefetcher() override;
+
+  /* Close database connections in thread */
+  void preDatabaseLoad();
+
+  /* Open database connections in thread using the files of the main databases */
+  void postDatabaseLoad();
+
+  /* Call after each paint of the visible map */
+  void viewChanged(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, map::MapTypes types);
+
+  /* Call before painting a map. Tiles are loaded in background only for the visible map and not for printing. */
+  void setPaintingVisibleMap(bool value)
+  {
+    paintingVisibleMap = value;
+  }
+
+  /* True if map queries should leave out missing tiles for the map currently painted since these are loaded
+   * in background. Only for the GUI thread. */
+  static bool isLoadingInBackground();
+
+signals:
+  /* Tiles for the visible map were added to the caches. Map has to be redrawn. */
+  void tilesLoaded();
+
+  /* Internal signals for the worker */
+  void prefetchRequested(query::PrefetchTiles tiles);
+  void initDatabasesRequested(const QString& simDbFile, const QString& navDbFile);
+  void deInitDatabasesRequested();
+
+private:
+  void prefetchFinished(const query::PrefetchTiles& tiles);
+
+  /* Collect keys of missing tiles from all query classes */
+  void missingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                    map::MapTypes types) const;
+
+  QThread thread;
+  MapQueryPrefetchWorker *worker = nullptr;
+
+  /* Disabled by settings */
+  bool enabled = true;
+
+  /* True if databases are open in thread */
+  bool databasesOpen = false;
+
+  /* Set before painting */
+  bool paintingVisibleMap = false;
+
+  /* Changed on database switch to ignore outdated results */
+  int requestId = 0;
+
+  /* Only one request at a time to avoid queuing requests which are outdated anyway */
+  bool requestPending = false;
+
+  /* View changed while a request was running */
+  bool viewPending = false;
+
+  /* Visible tiles could not be kept in the caches. Load missing tiles in the GUI thread for the next frame
+   * instead of requesting them again. */
+  bool loadDirect = false;
+
+  /* Keys of tiles ahead of the movement which were dropped by the caches due to the memory limit.
+   * Not requested again until the layer or database changes. */
+  query::PrefetchTiles droppedTiles;
+  const MapLayer *lastMapLayer = nullptr;
+
+  /* Last visible rectangle and time for movement estimation */
+  Marble::GeoDataLatLonBox lastRect;
+  QElapsedTimer lastRectTimer;
+};
+
+#endif // LITTLENAVMAP_MAPQUERYPREFETCHER_H
@@ -17,13 +17,182 @@
 
 #include "query/querytypes.h"
 
+#include "common/constants.h"
+#include "settings/settings.h"
 #include "sql/sqlquery.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqltransaction.h"
+#include "geo/calculations.h"
 #include "geo/rect.h"
+#include "exception.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSqlDriver>
+
+#include <cmath>
 
 using namespace Marble;
 
 namespace query {
 
+/* Highest level is about 5 NM tile size */
+static const int TILE_MAX_LEVEL = 10;
+
+/* Minimum number of tiles covering the largest side of a rectangle */
+static const double TILES_PER_RECT = 3.;
+
+/* Heap memory of a string. Empty strings share a static null object. */
+static int strMem(const QString& str)
+{
+  return str.isNull() ? 0 : static_cast<int>(sizeof(QArrayData)) + (str.capacity() + 1) * 2;
+}
+
+int objectMemory(const map::MapAirport& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.ident) + strMem(obj.icao) + strMem(obj.iata) +
+         strMem(obj.faa) + strMem(obj.local) + strMem(obj.name) + strMem(obj.region);
+}
+
+int objectMemory(const map::MapVor& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.ident) + strMem(obj.region) + strMem(obj.type) +
+         strMem(obj.name) + strMem(obj.channel);
+}
+
+int objectMemory(const map::MapNdb& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.ident) + strMem(obj.region) + strMem(obj.type) +
+         strMem(obj.name);
+}
+
+int objectMemory(const map::MapWaypoint& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.ident) + strMem(obj.region) + strMem(obj.type) +
+         strMem(obj.arincType);
+}
+
+int objectMemory(const map::MapMarker& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.type) + strMem(obj.ident);
+}
+
+int objectMemory(const map::MapHolding& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.navIdent) + strMem(obj.name) + strMem(obj.vorType) +
+         strMem(obj.airportIdent);
+}
+
+int objectMemory(const map::MapIls& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.ident) + strMem(obj.name) + strMem(obj.region) +
+         strMem(obj.airportIdent) + strMem(obj.runwayName) + strMem(obj.perfIndicator) + strMem(obj.provider);
+}
+
+int objectImportance(const map::MapAirport& obj)
+{
+  // Add-on airports first and then by longest runway
+  return (obj.addon() ? 1000000 : 0) + obj.longestRunwayLength;
+}
+
+int objectImportance(const map::MapVor& obj)
+{
+  return obj.range;
+}
+
+int objectImportance(const map::MapNdb& obj)
+{
+  return obj.range;
+}
+
+int objectImportance(const map::MapWaypoint& obj)
+{
+  // Waypoints on airways first
+  return (obj.hasJetAirways ? 2 : 0) + (obj.hasVictorAirways ? 1 : 0);
+}
+
+int objectMemory(const map::MapAirway& obj)
+{
+  return static_cast<int>(sizeof(obj)) + strMem(obj.name) +
+         (obj.altitudeLevelsEast.capacity() + obj.altitudeLevelsWest.capacity()) * static_cast<int>(sizeof(quint16));
+}
+
+QuerySettings QuerySettings::read()
+{
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  QuerySettings s;
+  s.rectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor",
+                                                    s.rectInflationFactor).toDouble();
+  s.rectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement",
+                                                       s.rectInflationIncrement).toDouble();
+  s.mapQueryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "MapQueryRowLimit",
+                                                s.mapQueryMaxRows).toInt();
+  s.waypointQueryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "WaypointQueryRowLimit",
+                                                     s.waypointQueryMaxRows).toInt();
+  s.airwayQueryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "AirwayQueryRowLimit",
+                                                   s.airwayQueryMaxRows).toInt();
+  s.tileCacheMemoryKb = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TileCacheMemoryKb",
+                                                  s.tileCacheMemoryKb).toInt();
+  s.runwayOverviewCacheSize = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "RunwayOverwiewCache",
+                                                        s.runwayOverviewCacheSize).toInt();
+  s.waypointInfoCacheSize = settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "WaypointCache",
+                                                      s.waypointInfoCacheSize).toInt();
+  return s;
+}
+
+double tileSizeDeg(int level)
+{
+  return 90. / static_cast<double>(1 << level);
+}
+
+int tileLevelForRect(const Marble::GeoDataLatLonBox& rect)
+{
+  double extent = std::max(rect.width(GeoDataCoordinates::Degree), rect.height(GeoDataCoordinates::Degree));
+
+  int level = 0;
+  while(level < TILE_MAX_LEVEL && tileSizeDeg(level + 1) >= extent / TILES_PER_RECT)
+    level++;
+  return level;
+}
+
+QVector<TileKey> tileKeysForRect(const Marble::GeoDataLatLonBox& rect, int level)
+{
+  double size = tileSizeDeg(level);
+  int columns = static_cast<int>(360. / size), rows = static_cast<int>(180. / size);
+
+  QVector<TileKey> keys;
+  for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
+  {
+    int x1 = std::max(static_cast<int>(std::floor((r.west(GeoDataCoordinates::Degree) + 180.) / size)), 0);
+    int x2 = std::min(static_cast<int>(std::floor((r.east(GeoDataCoordinates::Degree) + 180.) / size)), columns - 1);
+    int y1 = std::max(static_cast<int>(std::floor((r.south(GeoDataCoordinates::Degree) + 90.) / size)), 0);
+    int y2 = std::min(static_cast<int>(std::floor((r.north(GeoDataCoordinates::Degree) + 90.) / size)), rows - 1);
+
+    for(int y = y1; y <= y2; y++)
+    {
+      for(int x = x1; x <= x2; x++)
+      {
+        TileKey key = {level, x, y};
+        if(!keys.contains(key))
+          keys.append(key);
+      }
+    }
+  }
+  return keys;
+}
+
+Marble::GeoDataLatLonBox tileRect(const TileKey& key)
+{
+  double size = tileSizeDeg(key.level);
+  double west = key.x * size - 180., south = key.y * size - 90.;
+  return GeoDataLatLonBox(std::min(south + size, 90.), south, std::min(west + size, 180.), west,
+                          GeoDataCoordinates::Degree);
+}
+
 void inflateQueryRect(Marble::GeoDataLatLonBox& rect, double factor, double increment)
 {
   rect.scale(1. + factor, 1. + factor);
@@ -66,6 +235,434 @@ void bindRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query,
   query->bindValue(":" + prefix + "topy", rect.getNorth());
 }
 
+QString spatialIndexTable(const QString& table)
+{
+  return "rtree_" + table;
+}
+
+/* Schema name of the attached spatial index file */
+static const QString SPATIAL_SCHEMA("spatial");
+
+/* Dynamic property of the connection's driver keeping the table names of the attached spatial index file.
+ * Avoids pragma and schema queries each time a query is prepared. */
+static const char *SPATIAL_TABLES_PROPERTY = "lnmSpatialTables";
+
+/* Folder for index files - uses settings folder if empty */
+static QString spatialIndexDirectory;
+
+/* Increase to force creation of new index files */
+static const int SPATIAL_INDEX_VERSION = 2;
+
+/* Tables and columns which get an R*Tree spatial index. Point tables use the same column for min and max. */
+struct SpatialIndexTable
+{
+  QString table, idColumn, minX, maxX, minY, maxY;
+};
+
+static const QVector<SpatialIndexTable> SPATIAL_INDEX_TABLES(
+{
+  {"airport", "airport_id", "lonx", "lonx", "laty", "laty"},
+  {"airport_medium", "airport_id", "lonx", "lonx", "laty", "laty"},
+  {"airport_large", "airport_id", "lonx", "lonx", "laty", "laty"},
+  {"vor", "vor_id", "lonx", "lonx", "laty", "laty"},
+  {"ndb", "ndb_id", "lonx", "lonx", "laty", "laty"},
+  {"waypoint", "waypoint_id", "lonx", "lonx", "laty", "laty"},
+  {"marker", "marker_id", "lonx", "lonx", "laty", "laty"},
+  {"ils", "ils_id", "lonx", "lonx", "laty", "laty"},
+  {"holding", "holding_id", "lonx", "lonx", "laty", "laty"},
+  {"airway", "airway_id", "left_lonx", "right_lonx", "bottom_laty", "top_laty"},
+  {"boundary", "boundary_id", "min_lonx", "max_lonx", "min_laty", "max_laty"}
+});
+
+/* Tables and id columns which get unit vectors for the distance search */
+static const QVector<std::pair<QString, QString> > UNIT_VECTOR_TABLES(
+{
+  {"airport", "airport_id"}, {"nav_search", "nav_search_id"}
+});
+
+/* True if the table exists in the attached source database and is not empty */
+static bool hasSourceTableAndRows(atools::sql::SqlDatabase *db, const QString& table)
+{
+  atools::sql::SqlQuery query(db);
+  query.prepare("select count(1) from src.sqlite_master where type = 'table' and name = :name");
+  query.bindValue(":name", table);
+  query.exec();
+  if(!query.next() || query.valueInt(0) == 0)
+    return false;
+
+  query.exec("select 1 from src." + table + " limit 1");
+  return query.next();
+}
+
+/* Fill unit vectors for all rows of the source table in schema srcSchema into a new table in targetSchema */
+static void createUnitVectors(atools::sql::SqlDatabase *db, const QString& srcSchema, const QString& targetSchema,
+                              const QString& table, const QString& idColumn)
+{
+  QString vectorTable = targetSchema + ".unitvec_" + table;
+  atools::sql::SqlQuery query(db);
+  query.exec("create table " + vectorTable + "(id integer primary key, x double, y double, z double)");
+
+  atools::sql::SqlQuery insertQuery(db);
+  insertQuery.prepare("insert into " + vectorTable + " (id, x, y, z) values(:id, :x, :y, :z)");
+
+  // Coordinates are converted here since SQLite is usually compiled without math functions
+  query.exec("select " + idColumn + " as id, lonx, laty from " + srcSchema + "." + table +
+             " where lonx is not null and laty is not null");
+  while(query.next())
+  {
+    double lonRad = atools::geo::toRadians(query.valueFloat("lonx"));
+    double latRad = atools::geo::toRadians(query.valueFloat("laty"));
+    insertQuery.bindValue(":id", query.valueInt("id"));
+    insertQuery.bindValue(":x", std::cos(latRad) * std::cos(lonRad));
+    insertQuery.bindValue(":y", std::cos(latRad) * std::sin(lonRad));
+    insertQuery.bindValue(":z", std::sin(latRad));
+    insertQuery.exec();
+  }
+}
+
+void setSpatialIndexDirectory(const QString& dir)
+{
+  spatialIndexDirectory = dir;
+}
+
+QString spatialIndexFile(const QString& dbFile)
+{
+  QString dir = spatialIndexDirectory.isEmpty() ?
+                atools::settings::Settings::getPath() + QDir::separator() + "spatial" : spatialIndexDirectory;
+
+  // Add hash of the path to separate equally named files in different folders
+  QFileInfo fileinfo(dbFile);
+  QString path = fileinfo.canonicalFilePath().isEmpty() ? fileinfo.absoluteFilePath() : fileinfo.canonicalFilePath();
+  QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+  return dir + QDir::separator() + fileinfo.fileName() + "-" + QString::fromLatin1(hash) + "-spatial";
+}
+
+/* True if the meta table in schema matches size and modification time of the database file */
+static bool isSpatialIndexCurrent(atools::sql::SqlDatabase *db, const QString& schema, const QString& dbFile)
+{
+  QFileInfo fileinfo(dbFile);
+  atools::sql::SqlQuery query(db);
+  query.exec("select version, source_size, source_modified from " + schema + ".spatial_meta");
+  return query.next() && query.valueInt("version") == SPATIAL_INDEX_VERSION &&
+         query.value("source_size").toLongLong() == fileinfo.size() &&
+         query.value("source_modified").toLongLong() == fileinfo.lastModified().toMSecsSinceEpoch();
+}
+
+bool isSpatialIndexFileOutdated(const QString& dbFile)
+{
+  QString indexFile = spatialIndexFile(dbFile);
+  if(!QFile::exists(indexFile))
+    return true;
+
+  const QString name("LNMDBSPATIALCHECK");
+  bool outdated = true;
+  {
+    atools::sql::SqlDatabase::addDatabase("QSQLITE", name);
+    atools::sql::SqlDatabase db(name);
+    try
+    {
+      db.setDatabaseName(indexFile);
+      db.setReadonly();
+      db.open();
+      outdated = !isSpatialIndexCurrent(&db, "main", dbFile);
+      db.close();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << indexFile << e.what();
+    }
+  }
+  atools::sql::SqlDatabase::removeDatabase(name);
+  return outdated;
+}
+
+bool createSpatialIndexFile(const QString& dbFile, std::function<void(int done, int total)> progress)
+{
+  if(!isSpatialIndexFileOutdated(dbFile))
+    return true;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Fill a new file and replace the old one when done to avoid attaching incomplete files
+  QString indexFile = spatialIndexFile(dbFile), tempFile = indexFile + "-temp";
+  QDir().mkpath(QFileInfo(indexFile).absolutePath());
+  QFile::remove(tempFile);
+
+  const QString name("LNMDBSPATIALCREATE");
+  bool ok = false;
+  {
+    atools::sql::SqlDatabase::addDatabase("QSQLITE", name);
+    atools::sql::SqlDatabase db(name);
+    try
+    {
+      db.setDatabaseName(tempFile);
+      db.open({"PRAGMA journal_mode=OFF", "PRAGMA synchronous=OFF"});
+
+      // Size and time of the file before attaching
+      QFileInfo fileinfo(dbFile);
+      atools::sql::SqlQuery query(&db);
+      query.prepare("attach database :file as src");
+      query.bindValue(":file", dbFile);
+      query.exec();
+
+      atools::sql::SqlTransaction transaction(&db);
+      bool rtree = true;
+      int done = 0, total = SPATIAL_INDEX_TABLES.size() + UNIT_VECTOR_TABLES.size();
+      for(const SpatialIndexTable& t : SPATIAL_INDEX_TABLES)
+      {
+        if(progress)
+          progress(done++, total);
+
+        if(!rtree || !hasSourceTableAndRows(&db, t.table))
+          continue;
+
+        QString indexTable = spatialIndexTable(t.table);
+        try
+        {
+          query.exec("create virtual table " + indexTable + " using rtree(id, min_x, max_x, min_y, max_y)");
+        }
+        catch(atools::Exception& e)
+        {
+          // R*Tree module not available - rect queries use the coordinate columns
+          qWarning() << Q_FUNC_INFO << "Cannot create R*Tree" << e.what();
+          rtree = false;
+          continue;
+        }
+
+        // Objects crossing the anti-meridian cover the whole longitude range like in the plain queries
+        query.exec("insert into " + indexTable + " select " + t.idColumn + ", "
+                   "case when " + t.maxX + " < " + t.minX + " then -180. else " + t.minX + " end, "
+                   "case when " + t.maxX + " < " + t.minX + " then 180. else " + t.maxX + " end, "
+                   "min(" + t.minY + ", " + t.maxY + "), max(" + t.minY + ", " + t.maxY + ") "
+                   "from src." + t.table + " where " + t.minX + " is not null and " + t.minY + " is not null");
+      }
+
+      for(const std::pair<QString, QString>& t : UNIT_VECTOR_TABLES)
+      {
+        if(progress)
+          progress(done++, total);
+
+        if(hasSourceTableAndRows(&db, t.first))
+          createUnitVectors(&db, "src", "main", t.first, t.second);
+      }
+
+      query.exec("create table spatial_meta (version integer, source_size bigint, source_modified bigint)");
+      query.prepare("insert into spatial_meta (version, source_size, source_modified) "
+                    "values(:version, :size, :modified)");
+      query.bindValue(":version", SPATIAL_INDEX_VERSION);
+      query.bindValue(":size", fileinfo.size());
+      query.bindValue(":modified", fileinfo.lastModified().toMSecsSinceEpoch());
+      query.exec();
+      transaction.commit();
+
+      query.exec("detach database src");
+      db.close();
+      ok = true;
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot create spatial index for" << dbFile << e.what();
+    }
+  }
+  atools::sql::SqlDatabase::removeDatabase(name);
+
+  if(ok)
+  {
+    QFile::remove(indexFile);
+    ok = QFile::rename(tempFile, indexFile);
+  }
+  else
+    QFile::remove(tempFile);
+
+  qDebug() << Q_FUNC_INFO << indexFile << "ok" << ok << "took" << timer.elapsed() << "ms";
+  return ok;
+}
+
+/* True if the spatial index file is attached to the connection */
+static bool isSpatialIndexAttached(atools::sql::SqlDatabase *db)
+{
+  atools::sql::SqlQuery query(db);
+  query.exec("pragma database_list");
+  while(query.next())
+  {
+    if(query.valueStr("name") == SPATIAL_SCHEMA)
+      return true;
+  }
+  return false;
+}
+
+/* Remember the tables of the attached file or clear if tables is empty */
+static void setSpatialTables(atools::sql::SqlDatabase *db, const QStringList& tables)
+{
+  db->getQSqlDatabase().driver()->setProperty(SPATIAL_TABLES_PROPERTY, tables);
+}
+
+bool attachSpatialIndex(atools::sql::SqlDatabase *db)
+{
+  setSpatialTables(db, QStringList());
+
+  QString dbFile = db->databaseName();
+  QString indexFile = spatialIndexFile(dbFile);
+  if(!QFile::exists(indexFile))
+    return false;
+
+  try
+  {
+    atools::sql::SqlQuery query(db);
+    if(!isSpatialIndexAttached(db))
+    {
+      query.prepare("attach database :file as " + SPATIAL_SCHEMA);
+      query.bindValue(":file", indexFile);
+      query.exec();
+
+      if(!isSpatialIndexCurrent(db, SPATIAL_SCHEMA, dbFile))
+      {
+        // Database was replaced after creating the index
+        qWarning() << Q_FUNC_INFO << "Outdated spatial index" << indexFile;
+        query.exec("detach database " + SPATIAL_SCHEMA);
+        return false;
+      }
+    }
+
+    // Read tables once instead of checking for each query
+    QStringList tables;
+    query.exec("select name from " + SPATIAL_SCHEMA + ".sqlite_master where type = 'table'");
+    while(query.next())
+      tables.append(query.valueStr(0));
+    query.finish();
+    setSpatialTables(db, tables);
+    return true;
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot attach spatial index" << indexFile << e.what();
+  }
+  return false;
+}
+
+/* True if table exists in the attached spatial index file */
+static bool hasSpatialTable(atools::sql::SqlDatabase *db, const QString& name)
+{
+  return db->getQSqlDatabase().driver()->property(SPATIAL_TABLES_PROPERTY).toStringList().contains(name);
+}
+
+bool hasSpatialIndex(atools::sql::SqlDatabase *db, const QString& table)
+{
+  return hasSpatialTable(db, spatialIndexTable(table));
+}
+
+QString unitVectorTable(const QString& table)
+{
+  // Not qualified - SQLite looks in the temporary tables first and in attached databases last
+  return "unitvec_" + table;
+}
+
+/* True if the temporary fallback table exists. Checked each time since temporary tables are lost on close. */
+static bool hasUnitVectorTempTable(atools::sql::SqlDatabase *db, const QString& table)
+{
+  atools::sql::SqlQuery query(db);
+  query.prepare("select count(1) from sqlite_temp_master where type = 'table' and name = :name");
+  query.bindValue(":name", unitVectorTable(table));
+  query.exec();
+  bool found = query.next() && query.valueInt(0) > 0;
+  query.finish();
+  return found;
+}
+
+bool hasUnitVectorTable(atools::sql::SqlDatabase *db, const QString& table)
+{
+  return hasSpatialTable(db, unitVectorTable(table)) || hasUnitVectorTempTable(db, table);
+}
+
+bool createUnitVectorTempTable(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn)
+{
+  if(hasUnitVectorTable(db, table))
+    return true;
+
+  QElapsedTimer timer;
+  timer.start();
+  atools::sql::SqlQuery query(db);
+  try
+  {
+    // Savepoint works inside and outside of transactions and avoids a commit for each row
+    query.exec("savepoint unitvec");
+    createUnitVectors(db, "main", "temp", table, idColumn);
+    query.exec("release unitvec");
+
+    qDebug() << Q_FUNC_INFO << table << "took" << timer.elapsed() << "ms";
+    return true;
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot create unit vectors for" << table << e.what();
+    try
+    {
+      query.exec("rollback to unitvec");
+      query.exec("release unitvec");
+    }
+    catch(atools::Exception& e2)
+    {
+      qWarning() << Q_FUNC_INFO << e2.what();
+    }
+  }
+  return false;
+}
+
+QString unitVectorJoin(const QString& table, const QString& idColumn, const atools::geo::Pos& center)
+{
+  double lonRad = atools::geo::toRadians(static_cast<double>(center.getLonX()));
+  double latRad = atools::geo::toRadians(static_cast<double>(center.getLatY()));
+  double sinLon = std::sin(lonRad), cosLon = std::cos(lonRad), sinLat = std::sin(latRad), cosLat = std::cos(latRad);
+
+  // Center, north and east unit vectors
+  double cx = cosLat * cosLon, cy = cosLat * sinLon, cz = sinLat;
+  double nx = -sinLat * cosLon, ny = -sinLat * sinLon, nz = cosLat;
+  double ex = -sinLon, ey = cosLon;
+
+  auto num = [](double value) -> QString {
+               return QString::number(value, 'g', 17);
+             };
+
+  return " join (select id as dist_id, "
+         "x * " + num(cx) + " + y * " + num(cy) + " + z * " + num(cz) + " as dist_dot, "
+         "x * " + num(nx) + " + y * " + num(ny) + " + z * " + num(nz) + " as dist_north, "
+         "x * " + num(ex) + " + y * " + num(ey) + " as dist_east "
+         "from " + unitVectorTable(table) + ") on dist_id = " + idColumn;
+}
+
+QString unitVectorRadiusWhere(float minDistanceNm, float maxDistanceNm)
+{
+  // Great circle distance in radians using one nautical mile for one arc minute
+  double minRad = atools::geo::toRadians(std::min(static_cast<double>(minDistanceNm) / 60., 180.));
+  double maxRad = atools::geo::toRadians(std::min(static_cast<double>(maxDistanceNm) / 60., 180.));
+
+  QString cond("dist_dot >= " + QString::number(std::cos(maxRad), 'g', 17));
+  if(minDistanceNm > 0.f)
+    // Avoid excluding the center because of rounding errors if minimum is zero
+    cond += " and dist_dot <= " + QString::number(std::cos(minRad), 'g', 17);
+  return cond;
+}
+
+QString whereRectPoint(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn)
+{
+  if(hasSpatialIndex(db, table))
+    // Unary plus avoids use of the coordinate indexes for the exact check
+    return whereRectIndex(db, table, idColumn) +
+           " +lonx between :leftx and :rightx and +laty between :bottomy and :topy";
+  else
+    return "lonx between :leftx and :rightx and laty between :bottomy and :topy";
+}
+
+QString whereRectIndex(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn)
+{
+  if(hasSpatialIndex(db, table))
+    return idColumn + " in (select id from " + SPATIAL_SCHEMA + "." + spatialIndexTable(table) +
+           " where max_x >= :leftx and min_x <= :rightx and max_y >= :bottomy and min_y <= :topy) and ";
+  else
+    return QString();
+}
+
 /* Inflates the rectangle and splits it at the antimeridian (date line) if it overlaps */
 QList<Marble::GeoDataLatLonBox> splitAtAntiMeridian(const Marble::GeoDataLatLonBox& rect, double factor,
                                                     double increment)
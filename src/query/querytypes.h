@@ -23,7 +23,11 @@
 #include "common/maptypes.h"
 
 #include <QList>
+#include <QHash>
+#include <QCache>
+#include <QSet>
 
+#include <algorithm>
 #include <functional>
 
 #include <marble/GeoDataCoordinates.h>
@@ -35,6 +39,7 @@ class Rect;
 }
 namespace sql {
 class SqlQuery;
+class SqlDatabase;
 }
 }
 
@@ -45,6 +50,62 @@ namespace query {
 void bindRect(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query, const QString& prefix = QString());
 void bindRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query, const QString& prefix = QString());
 
+/* Name of the R*Tree spatial index table for table in the attached spatial index file */
+QString spatialIndexTable(const QString& table);
+
+/* Folder for the spatial index files. Default is "spatial" in the settings folder since database files can be
+ * located in read only folders. Has to be set before any connections are opened. */
+void setSpatialIndexDirectory(const QString& dir);
+
+/* Name of the file in the spatial index folder containing the R*Tree spatial indexes for a database file */
+QString spatialIndexFile(const QString& dbFile);
+
+/* Creates the spatial index file for all map object tables of the database file if it is missing or outdated.
+ * Also contains the unit vector tables for the distance search.
+ * Has to be called before connections attach the file. progress is called before each table with the number
+ * of tables done and the total. Returns false on error. R*Tree tables are left out if SQLite has no R*Tree module. */
+bool createSpatialIndexFile(const QString& dbFile, std::function<void(int done, int total)> progress = nullptr);
+
+/* True if the spatial index file is missing or does not match the current database file */
+bool isSpatialIndexFileOutdated(const QString& dbFile);
+
+/* Attaches the spatial index file of the connection's database if it is up to date. Has to be called for each
+ * connection including the ones in worker threads after opening and before preparing queries.
+ * Remembers the available tables for hasSpatialIndex() and hasUnitVectorTable(). Returns true if attached. */
+bool attachSpatialIndex(atools::sql::SqlDatabase *db);
+
+/* True if the R*Tree spatial index for table is attached to the connection. */
+bool hasSpatialIndex(atools::sql::SqlDatabase *db, const QString& table);
+
+/* Name of the table containing unit vectors (x, y, z) on the unit sphere for each row of a point table.
+ * Created with the spatial index file for the airport and navaid search tables.
+ * Allows to calculate great circle distance and bearing based filters and ordering inside SQLite which
+ * has no trigonometric functions. */
+QString unitVectorTable(const QString& table);
+
+/* True if the unit vector table for table is attached to the connection or was created as temporary table */
+bool hasUnitVectorTable(atools::sql::SqlDatabase *db, const QString& table);
+
+/* Fallback if the spatial index file is not available. Creates the unit vectors as temporary table which
+ * exists only for this connection. Works for read only connections too. Can take a second for large tables.
+ * Does nothing if the table is already available. Returns false on error. */
+bool createUnitVectorTempTable(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn);
+
+/* Join with the unit vector table adding the columns dist_dot (cosine of the great circle distance to center),
+ * dist_north and dist_east (direction components at center) */
+QString unitVectorJoin(const QString& table, const QString& idColumn, const atools::geo::Pos& center);
+
+/* Condition for minimum and maximum great circle distance using dist_dot from unitVectorJoin() */
+QString unitVectorRadiusWhere(float minDistanceNm, float maxDistanceNm);
+
+/* Get where clause for point objects having lonx and laty columns for use with bindRect().
+ * Uses the R*Tree spatial index if available and falls back to a range query on the coordinates. */
+QString whereRectPoint(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn);
+
+/* Get where clause prefix ending with "and" which limits the result to objects having an overlapping bounding
+ * rectangle in the R*Tree index. Empty if there is no spatial index for the table. */
+QString whereRectIndex(atools::sql::SqlDatabase *db, const QString& table, const QString& idColumn);
+
 /* Run query for rect potentially splitting at anti-meridian and call callback */
 void fetchObjectsForRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query,
                          std::function<void(atools::sql::SqlQuery *query)> callback);
@@ -55,6 +116,89 @@ QList<Marble::GeoDataLatLonBox> splitAtAntiMeridian(const Marble::GeoDataLatLonB
 /* Inflate rect by width and height in degrees. If it crosses the poles or date line it will be limited */
 void inflateQueryRect(Marble::GeoDataLatLonBox& rect, double factor, double increment);
 
+/* Default for the approximate memory used by the tiles of a TiledRectCache in kB which are not visible.
+ * Visible tiles are always kept in addition. */
+static const int TILE_CACHE_DEFAULT_MEMORY_KB = 4 * 1024;
+
+/* Approximate memory in bytes used by an object including heap allocated strings and containers.
+ * Used as cost by TiledRectCache. Falls back to the object size for types not covered below. */
+template<typename TYPE>
+int objectMemory(const TYPE&)
+{
+  return static_cast<int>(sizeof(TYPE));
+}
+
+int objectMemory(const map::MapAirport& obj);
+int objectMemory(const map::MapVor& obj);
+int objectMemory(const map::MapNdb& obj);
+int objectMemory(const map::MapWaypoint& obj);
+int objectMemory(const map::MapMarker& obj);
+int objectMemory(const map::MapHolding& obj);
+int objectMemory(const map::MapIls& obj);
+int objectMemory(const map::MapAirway& obj);
+
+/* Importance of an object used to keep the most relevant ones if the merged tiles exceed the row limit.
+ * Higher values are more important. All objects are equal for types not covered below. */
+template<typename TYPE>
+int objectImportance(const TYPE&)
+{
+  return 0;
+}
+
+int objectImportance(const map::MapAirport& obj);
+int objectImportance(const map::MapVor& obj);
+int objectImportance(const map::MapNdb& obj);
+int objectImportance(const map::MapWaypoint& obj);
+
+/* Settings for the map query classes. Read once in the GUI thread and passed to the constructors since
+ * the settings cannot be accessed from other threads like the prefetch thread. */
+struct QuerySettings
+{
+  /* Read and store all values from the settings. Call only in the GUI thread. */
+  static QuerySettings read();
+
+  double rectInflationFactor = 0.3, rectInflationIncrement = 0.1;
+  int mapQueryMaxRows = map::MAX_MAP_OBJECTS, waypointQueryMaxRows = map::MAX_MAP_OBJECTS,
+      airwayQueryMaxRows = map::MAX_MAP_OBJECTS;
+  int tileCacheMemoryKb = TILE_CACHE_DEFAULT_MEMORY_KB;
+  int runwayOverviewCacheSize = 1000, waypointInfoCacheSize = 100;
+};
+
+/* Key for a fixed latitude/longitude tile used by TiledRectCache.
+ * Level defines the tile size. x and y are column and row counted from the south-west corner at -180/-90. */
+struct TileKey
+{
+  int level, x, y;
+
+  bool operator==(const query::TileKey& other) const
+  {
+    return level == other.level && x == other.x && y == other.y;
+  }
+
+  bool operator!=(const query::TileKey& other) const
+  {
+    return !operator==(other);
+  }
+
+};
+
+inline uint qHash(const query::TileKey& key)
+{
+  return static_cast<uint>(key.level << 26) ^ static_cast<uint>(key.x << 13) ^ static_cast<uint>(key.y);
+}
+
+/* Tile size in degrees for level. Level 0 is 90 degrees and each further level halves the size. */
+double tileSizeDeg(int level);
+
+/* Get the tile level which covers the rectangle with a few tiles in each direction */
+int tileLevelForRect(const Marble::GeoDataLatLonBox& rect);
+
+/* Get keys for all tiles touching the rectangle. Rectangle can cross the anti-meridian. */
+QVector<query::TileKey> tileKeysForRect(const Marble::GeoDataLatLonBox& rect, int level);
+
+/* Bounding rectangle of a tile. Never crosses the anti-meridian. */
+Marble::GeoDataLatLonBox tileRect(const query::TileKey& key);
+
 template<typename ID>
 const atools::sql::SqlRecord *cachedRecord(QCache<ID, atools::sql::SqlRecord>& cache,
                                            atools::sql::SqlQuery *query, ID id);
@@ -89,6 +233,171 @@ struct SimpleRectCache
 
 };
 
+/*
+ * Spatial cache that keeps objects in fixed latitude/longitude tiles and loads only tiles not cached yet.
+ * Panning the map therefore queries only newly exposed areas. Tiles covering the last requested rectangle are
+ * always kept. All other tiles are evicted by last use once the approximate memory limit is exceeded.
+ * Objects have to provide an id which is used to remove duplicates on tile borders.
+ */
+template<typename TYPE>
+struct TiledRectCache
+{
+  typedef std::function<bool (const MapLayer *curLayer, const MapLayer *mapLayer)> LayerCompareFunc;
+  typedef std::function<void (const Marble::GeoDataLatLonBox& tileRect, QList<TYPE>& tileList)> TileLoadFunc;
+
+  TiledRectCache()
+  {
+    tiles.setMaxCost(TILE_CACHE_DEFAULT_MEMORY_KB);
+  }
+
+  /*
+   * @param rect bounding rectangle - all objects inside this rectangle are returned
+   * @param mapLayer current map layer
+   * @param lazy if true do not fetch new data but return the old potentially incomplete dataset
+   * @param funcSameLayer has to return true if query parameters are equal for both layers. Drops all tiles if not.
+   * @param funcLoadTile called for each missing tile to fetch all objects in the tile rectangle.
+   * If empty missing tiles are skipped and the list contains only cached tiles. The list is rebuilt on the
+   * next call in this case. Used when tiles are loaded in the background by the prefetch thread.
+   * @return true if the list was rebuilt
+   */
+  bool updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor, double increment,
+                   bool lazy, LayerCompareFunc funcSameLayer, TileLoadFunc funcLoadTile);
+  void clear();
+
+  /* Limits the merged list to the queryMaxRows most important objects and returns true if objects were removed
+   * now or by a previous call for the same list. Tiles are loaded without limit and are kept complete. */
+  bool validate(int queryMaxRows);
+
+  /* Limit for the cached tiles in kB which are not visible. Size of a tile is estimated using objectMemory().
+   * Visible tiles are not counted and never evicted, so a dense area cannot push its own tiles out. */
+  void setMaxMemoryKb(int memoryKb)
+  {
+    tiles.setMaxCost(memoryKb);
+  }
+
+  /* Get keys of all tiles covering the rectangle which are not loaded yet.
+   * Returns nothing if the layer differs from the one used for the cached tiles. */
+  QVector<query::TileKey> missingTiles(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor,
+                                       double increment) const;
+
+  /* Add a tile which was loaded elsewhere, e.g. in the prefetch thread.
+   * Ignored if the layer differs or the tile is already present. Does not change the list.
+   * Returns true if the tile is in the cache afterwards. Tiles which are not visible and exceed the memory
+   * limit are dropped. */
+  bool insertTile(const query::TileKey& key, const QList<TYPE>& tileList, const MapLayer *mapLayer);
+
+  /* True if the tile is loaded */
+  bool containsTile(const query::TileKey& key) const
+  {
+    return visibleTiles.contains(key) || tiles.contains(key);
+  }
+
+  const MapLayer *curMapLayer = nullptr;
+
+  /* All objects from tiles covering the last rectangle */
+  QList<TYPE> list;
+
+private:
+  /* Approximate size of the tile in kB used as cost. QList keeps a pointer to each large object. */
+  static int tileCost(const QList<TYPE> *tileList)
+  {
+    qint64 bytes = sizeof(QList<TYPE>);
+    for(const TYPE& obj : *tileList)
+      bytes += objectMemory(obj) + static_cast<int>(sizeof(void *));
+    return static_cast<int>(bytes / 1024) + 1;
+  }
+
+  /* Move tiles not covered by keys to the evictable cache and the ones covered from the cache to visibleTiles */
+  void updateVisibleTiles(const QVector<query::TileKey>& keys);
+
+  /* Keys of the complete list. Empty if tiles were missing. */
+  QVector<query::TileKey> curKeys;
+
+  /* Keys of the tiles covering the last requested rectangle */
+  QVector<query::TileKey> visibleKeys;
+
+  /* Tiles of visibleKeys which are not subject to the memory limit */
+  QHash<query::TileKey, QList<TYPE> > visibleTiles;
+
+  /* All other tiles evicted by last use */
+  QCache<query::TileKey, QList<TYPE> > tiles;
+
+  /* List was truncated by validate() */
+  bool overflow = false;
+};
+
+/* Tile keys to load and the loaded objects exchanged with the prefetch thread. See MapQueryPrefetcher. */
+struct PrefetchTiles
+{
+  /* Used to ignore results of outdated requests */
+  int requestId = 0;
+
+  /* Tiles were left out while painting the visible area and not requested for the estimated next area */
+  bool visible = false;
+
+  /* Set by the prefetch thread on database errors */
+  bool failed = false;
+
+  const MapLayer *mapLayer = nullptr;
+  map::MapTypes types;
+
+  /* Database state from the GUI thread needed to fill airports */
+  bool navdata = false, airportDatabaseXPlane = false;
+
+  QVector<query::TileKey> airportKeys, vorKeys, ndbKeys, waypointKeys, airwayKeys;
+
+  QHash<query::TileKey, QList<map::MapAirport> > airports;
+  QHash<query::TileKey, QList<map::MapVor> > vors;
+  QHash<query::TileKey, QList<map::MapNdb> > ndbs;
+  QHash<query::TileKey, QList<map::MapWaypoint> > waypoints;
+  QHash<query::TileKey, QList<map::MapAirway> > airways;
+
+  bool isEmpty() const
+  {
+    return airportKeys.isEmpty() && vorKeys.isEmpty() && ndbKeys.isEmpty() && waypointKeys.isEmpty() &&
+           airwayKeys.isEmpty();
+  }
+
+  /* Remove loaded objects but keep the keys */
+  void clearObjects()
+  {
+    airports.clear();
+    vors.clear();
+    ndbs.clear();
+    waypoints.clear();
+    airways.clear();
+  }
+
+  /* Add keys of other to the keys of this */
+  void appendKeys(const PrefetchTiles& other)
+  {
+    airportKeys.append(other.airportKeys);
+    vorKeys.append(other.vorKeys);
+    ndbKeys.append(other.ndbKeys);
+    waypointKeys.append(other.waypointKeys);
+    airwayKeys.append(other.airwayKeys);
+  }
+
+  /* Remove all keys which are also contained in other */
+  void removeKeys(const PrefetchTiles& other)
+  {
+    removeKeys(airportKeys, other.airportKeys);
+    removeKeys(vorKeys, other.vorKeys);
+    removeKeys(ndbKeys, other.ndbKeys);
+    removeKeys(waypointKeys, other.waypointKeys);
+    removeKeys(airwayKeys, other.airwayKeys);
+  }
+
+private:
+  static void removeKeys(QVector<query::TileKey>& keys, const QVector<query::TileKey>& otherKeys)
+  {
+    keys.erase(std::remove_if(keys.begin(), keys.end(), [&otherKeys](const query::TileKey& key) -> bool {
+            return otherKeys.contains(key);
+          }), keys.end());
+  }
+
+};
+
 // ---------------------------------------------------------------------------------
 
 template<typename TYPE>
@@ -144,6 +453,175 @@ void SimpleRectCache<TYPE>::clear()
   curMapLayer = nullptr;
 }
 
+// ---------------------------------------------------------------------------------
+
+template<typename TYPE>
+bool TiledRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor,
+                                       double increment, bool lazy, LayerCompareFunc funcSameLayer,
+                                       TileLoadFunc funcLoadTile)
+{
+  if(lazy)
+    // Nothing changed
+    return false;
+
+#ifndef DEBUG_DISABLE_RECT_CACHE
+  if(curMapLayer == nullptr || !funcSameLayer(curMapLayer, mapLayer))
+#else
+  Q_UNUSED(funcSameLayer)
+#endif
+  {
+    // Query parameters changed - no tile can be reused
+    tiles.clear();
+    visibleTiles.clear();
+    curKeys.clear();
+    visibleKeys.clear();
+  }
+  curMapLayer = mapLayer;
+
+  Marble::GeoDataLatLonBox inflatedRect(rect);
+  query::inflateQueryRect(inflatedRect, factor, increment);
+  QVector<query::TileKey> keys = query::tileKeysForRect(inflatedRect, query::tileLevelForRect(inflatedRect));
+
+  if(keys == curKeys)
+    // Same tiles as before - list is still valid
+    return false;
+
+  updateVisibleTiles(keys);
+
+  list.clear();
+  overflow = false;
+  QSet<int> ids;
+  bool complete = true;
+  for(const query::TileKey& key : keys)
+  {
+    auto it = visibleTiles.find(key);
+    if(it == visibleTiles.end())
+    {
+      if(!funcLoadTile)
+      {
+        // Loaded in background - leave out for now
+        complete = false;
+        continue;
+      }
+
+      // Not cached yet or evicted
+      it = visibleTiles.insert(key, QList<TYPE>());
+      funcLoadTile(query::tileRect(key), it.value());
+    }
+
+    // Objects on tile borders are returned for both neighbors
+    for(const TYPE& obj : it.value())
+    {
+      if(!ids.contains(obj.id))
+      {
+        ids.insert(obj.id);
+        list.append(obj);
+      }
+    }
+  }
+
+  // Force rebuild on next call if tiles are missing
+  curKeys = complete ? keys : QVector<query::TileKey>();
+  return true;
+}
+
+template<typename TYPE>
+bool TiledRectCache<TYPE>::validate(int queryMaxRows)
+{
+  if(list.size() > queryMaxRows)
+  {
+    // Limit merged result to the same number of objects as a single query would return
+    // Keep the most important ones - order of equal objects is kept
+    std::stable_sort(list.begin(), list.end(), [](const TYPE& obj1, const TYPE& obj2) -> bool {
+            return objectImportance(obj1) > objectImportance(obj2);
+          });
+    list.erase(list.begin() + queryMaxRows, list.end());
+    overflow = true;
+  }
+  return overflow;
+}
+
+template<typename TYPE>
+QVector<query::TileKey> TiledRectCache<TYPE>::missingTiles(const Marble::GeoDataLatLonBox& rect,
+                                                           const MapLayer *mapLayer, double factor,
+                                                           double increment) const
+{
+  QVector<query::TileKey> keys;
+  if(curMapLayer != nullptr && curMapLayer == mapLayer)
+  {
+    Marble::GeoDataLatLonBox inflatedRect(rect);
+    query::inflateQueryRect(inflatedRect, factor, increment);
+
+    for(const query::TileKey& key : query::tileKeysForRect(inflatedRect, query::tileLevelForRect(inflatedRect)))
+    {
+      if(!containsTile(key))
+        keys.append(key);
+    }
+  }
+  return keys;
+}
+
+template<typename TYPE>
+bool TiledRectCache<TYPE>::insertTile(const query::TileKey& key, const QList<TYPE>& tileList,
+                                      const MapLayer *mapLayer)
+{
+  if(curMapLayer == nullptr || curMapLayer != mapLayer)
+    return false;
+
+  if(!containsTile(key))
+  {
+    if(visibleKeys.contains(key))
+      visibleTiles.insert(key, tileList);
+    else
+    {
+      QList<TYPE> *newTile = new QList<TYPE>(tileList);
+      tiles.insert(key, newTile, tileCost(newTile));
+    }
+  }
+  return containsTile(key);
+}
+
+template<typename TYPE>
+void TiledRectCache<TYPE>::updateVisibleTiles(const QVector<query::TileKey>& keys)
+{
+  // Protect tiles which became visible again - before releasing others which might evict them
+  for(const query::TileKey& key : keys)
+  {
+    QList<TYPE> *tileList = tiles.take(key);
+    if(tileList != nullptr)
+    {
+      visibleTiles.insert(key, *tileList);
+      delete tileList;
+    }
+  }
+
+  // Tiles which are not visible anymore can be evicted now
+  for(auto it = visibleTiles.begin(); it != visibleTiles.end();)
+  {
+    if(!keys.contains(it.key()))
+    {
+      QList<TYPE> *tileList = new QList<TYPE>(it.value());
+      tiles.insert(it.key(), tileList, tileCost(tileList));
+      it = visibleTiles.erase(it);
+    }
+    else
+      ++it;
+  }
+  visibleKeys = keys;
+}
+
+template<typename TYPE>
+void TiledRectCache<TYPE>::clear()
+{
+  list.clear();
+  overflow = false;
+  tiles.clear();
+  visibleTiles.clear();
+  curKeys.clear();
+  visibleKeys.clear();
+  curMapLayer = nullptr;
+}
+
 /* Get a record from the cache or get it from a database query */
 template<typename ID>
 const atools::sql::SqlRecord *cachedRecord(QCache<ID, atools::sql::SqlRecord>& cache, atools::sql::SqlQuery *query,
@@ -239,4 +717,6 @@ inline uint qHash(const query::NearestCacheKeyNavaid& key)
 
 } // namespace query
 
+Q_DECLARE_METATYPE(query::PrefetchTiles);
+
 #endif // LNM_QUERYTYPES_H
@@ -21,8 +21,9 @@
 #include "common/maptypesfactory.h"
 #include "common/mapresult.h"
 #include "common/maptools.h"
+#include "common/paintprofiler.h"
 #include "mapgui/maplayer.h"
-#include "settings/settings.h"
+#include "query/mapqueryprefetcher.h"
 #include "sql/sqlutil.h"
 
 using namespace Marble;
@@ -30,24 +31,17 @@ using namespace atools::sql;
 using namespace atools::geo;
 using map::MapWaypoint;
 
-static double queryRectInflationFactor = 0.2;
-static double queryRectInflationIncrement = 0.1;
-int WaypointQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
-
-WaypointQuery::WaypointQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam)
+WaypointQuery::WaypointQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam, const query::QuerySettings& settings)
   : dbNav(sqlDbNav), trackDatabase(trackDatabaseParam)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
 
-  queryRectInflationFactor = settings.getAndStoreValue(
-    lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.3).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(
-    lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
-  queryMaxRows =
-    settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "WaypointQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+  queryRectInflationFactor = settings.rectInflationFactor;
+  queryRectInflationIncrement = settings.rectInflationIncrement;
+  queryMaxRows = settings.waypointQueryMaxRows;
 
-  waypointInfoCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "WaypointCache", 100).toInt());
+  waypointInfoCache.setMaxCost(settings.waypointInfoCacheSize);
+  waypointCache.setMaxMemoryKb(settings.tileCacheMemoryKb);
 }
 
 WaypointQuery::~WaypointQuery()
@@ -119,31 +113,60 @@ void WaypointQuery::getWaypointRectNearest(map::MapWaypoint& waypoint, const Pos
 const QList<map::MapWaypoint> *WaypointQuery::getWaypoints(const GeoDataLatLonBox& rect,
                                                            const MapLayer *mapLayer, bool lazy, bool& overflow)
 {
-  waypointCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  // Tracks are not available in the prefetch thread
+  query::TiledRectCache<map::MapWaypoint>::TileLoadFunc loadFunc;
+  if(trackDatabase || !MapQueryPrefetcher::isLoadingInBackground())
+    loadFunc = [ = ](const GeoDataLatLonBox& tileRect, QList<map::MapWaypoint>& tileList)
+               {
+                 waypointTile(tileList, tileRect);
+               };
+
+  bool rebuilt = waypointCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                           [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersWaypoint(newLayer);
-  });
+  }, loadFunc);
 
-  if(waypointCache.list.isEmpty() && !lazy)
-  {
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, waypointsByRectQuery);
-      waypointsByRectQuery->exec();
-      while(waypointsByRectQuery->next())
-      {
-        map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp, trackDatabase);
-        waypointCache.list.append(wp);
-      }
-    }
-  }
   overflow = waypointCache.validate(queryMaxRows);
+  PaintProfiler::query("Waypoints", !rebuilt, waypointCache.list.size());
   return &waypointCache.list;
 }
 
+void WaypointQuery::waypointTile(QList<map::MapWaypoint>& tileList, const GeoDataLatLonBox& tileRect)
+{
+  query::bindRect(tileRect, waypointsByRectQuery);
+  waypointsByRectQuery->exec();
+  while(waypointsByRectQuery->next())
+  {
+    map::MapWaypoint wp;
+    mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp, trackDatabase);
+    tileList.append(wp);
+  }
+}
+
+void WaypointQuery::getMissingTiles(query::PrefetchTiles& tiles, const GeoDataLatLonBox& rect) const
+{
+  // Waypoints are also needed to draw airways
+  if(tiles.mapLayer->isAirwayWaypoint() && tiles.types & (map::WAYPOINT | map::AIRWAYV | map::AIRWAYJ))
+    tiles.waypointKeys = waypointCache.missingTiles(rect, tiles.mapLayer, queryRectInflationFactor,
+                                                    queryRectInflationIncrement);
+}
+
+void WaypointQuery::loadTiles(query::PrefetchTiles& tiles)
+{
+  for(const query::TileKey& key : tiles.waypointKeys)
+    waypointTile(tiles.waypoints[key], query::tileRect(key));
+}
+
+void WaypointQuery::insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped)
+{
+  for(auto it = tiles.waypoints.constBegin(); it != tiles.waypoints.constEnd(); ++it)
+  {
+    if(!waypointCache.insertTile(it.key(), it.value(), tiles.mapLayer))
+      dropped.waypointKeys.append(it.key());
+  }
+}
+
 void WaypointQuery::getNearestScreenObjects(const CoordinateConverter& conv, const MapLayer *mapLayer,
                                             map::MapTypes types, int xs, int ys,
                                             int screenDistance, map::MapResult& result)
@@ -190,9 +213,9 @@ void WaypointQuery::initQueries()
   QString id = trackDatabase ? "trackpoint_id" : "waypoint_id";
 
   // Common where clauses
-  static const QString whereRect("lonx between :leftx and :rightx and laty between :bottomy and :topy");
   static const QString whereIdentRegion("ident = :ident and region like :region");
-  static const QString whereLimit("limit " + QString::number(queryMaxRows));
+  // Only for queries not loading tiles - row limit for tiles is applied after merging them
+  const QString whereLimit("limit " + QString::number(queryMaxRows));
 
   // Common select statements
   QString waypointQueryBase(id + ", ident, region, type, num_victor_airway, num_jet_airway, mag_var, lonx, laty ");
@@ -218,12 +241,12 @@ void WaypointQuery::initQueries()
 
   // Get Waypoint in rect
   waypointRectQuery = new SqlQuery(dbNav);
-  waypointRectQuery->prepare("select " + waypointQueryBase + " from " + table + " where " + whereRect + " " +
-                             whereLimit);
+  waypointRectQuery->prepare("select " + waypointQueryBase + " from " + table + " where " +
+                             query::whereRectPoint(dbNav, table, id) + " " + whereLimit);
 
   waypointsByRectQuery = new SqlQuery(dbNav);
   waypointsByRectQuery->prepare(
-    "select " + waypointQueryBase + " from " + table + " where " + whereRect + " " + whereLimit);
+    "select " + waypointQueryBase + " from " + table + " where " + query::whereRectPoint(dbNav, table, id));
 
   waypointInfoQuery = new SqlQuery(dbNav);
 
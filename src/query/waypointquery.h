@@ -40,8 +40,9 @@ public:
   /*
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
+   * @param settings read in the GUI thread
    */
-  WaypointQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackDatabaseParam);
+  WaypointQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackDatabaseParam, const query::QuerySettings& settings);
   ~WaypointQuery();
 
   WaypointQuery(const WaypointQuery& other) = delete;
@@ -70,6 +71,16 @@ public:
   const QList<map::MapWaypoint> *getWaypoints(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                               bool lazy, bool& overflow);
 
+  /* Get keys of waypoint tiles covering rect which are not cached yet. Uses layer and types in tiles which
+   * are set by MapQuery::getMissingTiles() before. */
+  void getMissingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect) const;
+
+  /* Load waypoints for all keys in tiles in the prefetch thread */
+  void loadTiles(query::PrefetchTiles& tiles);
+
+  /* Add tiles loaded by the prefetch thread to the cache. Keys of tiles not kept are added to dropped. */
+  void insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped);
+
   /* Get record for joined tables waypoint, bgl_file and scenery_area */
   const atools::sql::SqlRecord *getWaypointInformation(int waypointId);
 
@@ -87,14 +98,19 @@ public:
   void clearCache();
 
 private:
+  /* Load waypoints for one tile not touching the caches */
+  void waypointTile(QList<map::MapWaypoint>& tileList, const Marble::GeoDataLatLonBox& tileRect);
+
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbNav;
 
-  /* Simple bounding rectangle caches */
-  query::SimpleRectCache<map::MapWaypoint> waypointCache;
+  /* Tiled bounding rectangle cache */
+  query::TiledRectCache<map::MapWaypoint> waypointCache;
   QCache<int, atools::sql::SqlRecord> waypointInfoCache;
 
-  static int queryMaxRows;
+  /* Not static since instances are also used in the prefetch thread */
+  double queryRectInflationFactor = 0.3, queryRectInflationIncrement = 0.1;
+  int queryMaxRows = map::MAX_MAP_OBJECTS;
 
   bool trackDatabase;
 
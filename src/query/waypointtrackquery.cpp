@@ -117,6 +117,16 @@ void WaypointTrackQuery::getWaypoints(QList<map::MapWaypoint>& waypoints, const
   }
 }
 
+void WaypointTrackQuery::getMissingTiles(query::PrefetchTiles& tiles, const GeoDataLatLonBox& rect) const
+{
+  waypointQuery->getMissingTiles(tiles, rect);
+}
+
+void WaypointTrackQuery::insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped)
+{
+  waypointQuery->insertTiles(tiles, dropped);
+}
+
 const SqlRecord *WaypointTrackQuery::getWaypointInformation(int waypointId)
 {
   const SqlRecord *rec = waypointQuery->getWaypointInformation(waypointId);
@@ -83,6 +83,10 @@ public:
   void getWaypoints(QList<map::MapWaypoint>& waypoints, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                     bool lazy, bool& overflow);
 
+  /* Prefetching covers only the navigation database. See WaypointQuery::getMissingTiles(). */
+  void getMissingTiles(query::PrefetchTiles& tiles, const Marble::GeoDataLatLonBox& rect) const;
+  void insertTiles(const query::PrefetchTiles& tiles, query::PrefetchTiles& dropped);
+
   /* Get record for joined tables waypoint, bgl_file and scenery_area */
   const atools::sql::SqlRecord *getWaypointInformation(int waypointId);
 
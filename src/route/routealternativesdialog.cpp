@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routealternativesdialog.h"
+#include "ui_routealternativesdialog.h"
+
+#include "common/unit.h"
+#include "common/formatter.h"
+#include "gui/itemviewzoomhandler.h"
+
+#include <QPushButton>
+#include <QTableWidget>
+
+RouteAlternativesDialog::RouteAlternativesDialog(QWidget *parent, const QVector<RouteAlternative>& alternativesParam)
+  : QDialog(parent), ui(new Ui::RouteAlternativesDialog), alternatives(alternativesParam)
+{
+  ui->setupUi(this);
+  setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  setWindowModality(Qt::ApplicationModal);
+
+  // Resize widget to get rid of the too large default margins
+  zoomHandler = new atools::gui::ItemViewZoomHandler(ui->tableWidgetRouteAlternatives);
+
+  connect(ui->buttonBox, &QDialogButtonBox::clicked, this, &RouteAlternativesDialog::buttonBoxClicked);
+  connect(ui->tableWidgetRouteAlternatives, &QTableWidget::itemSelectionChanged,
+          this, &RouteAlternativesDialog::updateButtons);
+  connect(ui->tableWidgetRouteAlternatives, &QTableWidget::doubleClicked, this, &QDialog::accept);
+
+  fillTable();
+  updateButtons();
+}
+
+RouteAlternativesDialog::~RouteAlternativesDialog()
+{
+  delete zoomHandler;
+  delete ui;
+}
+
+void RouteAlternativesDialog::buttonBoxClicked(QAbstractButton *button)
+{
+  QDialogButtonBox::StandardButton buttonType = ui->buttonBox->standardButton(button);
+
+  if(buttonType == QDialogButtonBox::Ok)
+    accept();
+  else if(buttonType == QDialogButtonBox::Cancel)
+    reject();
+}
+
+void RouteAlternativesDialog::updateButtons()
+{
+  ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(getSelectedCandidateIndex() != -1);
+}
+
+int RouteAlternativesDialog::getSelectedCandidateIndex() const
+{
+  QItemSelectionModel *selection = ui->tableWidgetRouteAlternatives->selectionModel();
+  if(selection != nullptr)
+  {
+    QModelIndexList rows = selection->selectedRows();
+    if(!rows.isEmpty())
+    {
+      QTableWidgetItem *item = ui->tableWidgetRouteAlternatives->item(rows.first().row(), 0);
+      if(item != nullptr)
+        return item->data(Qt::UserRole).toInt();
+    }
+  }
+  return -1;
+}
+
+void RouteAlternativesDialog::fillTable()
+{
+  QTableWidget *table = ui->tableWidgetRouteAlternatives;
+  table->clear();
+  table->setColumnCount(5);
+  table->setRowCount(alternatives.size());
+  table->setHorizontalHeaderLabels({tr("Calculation"), tr("Distance\n%1").arg(Unit::getUnitDistStr()),
+                                    tr("Legs"), tr("Airways"), tr("Travel Time\nhh:mm")});
+
+  int row = 0;
+  for(const RouteAlternative& alt : alternatives)
+  {
+    int col = 0;
+    QTableWidgetItem *item = new QTableWidgetItem(alt.name);
+    item->setData(Qt::UserRole, alt.candidateIndex);
+    table->setItem(row, col++, item);
+
+    item = new QTableWidgetItem(Unit::distNm(alt.distanceNm, false));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    table->setItem(row, col++, item);
+
+    item = new QTableWidgetItem(QLocale().toString(alt.numLegs));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    table->setItem(row, col++, item);
+
+    item = new QTableWidgetItem(QLocale().toString(alt.numAirways));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    table->setItem(row, col++, item);
+
+    item = new QTableWidgetItem(alt.travelTimeHours < 0.f ? QString() :
+                                formatter::formatMinutesHours(alt.travelTimeHours));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    table->setItem(row, col++, item);
+    row++;
+  }
+
+  table->resizeColumnsToContents();
+
+  // Select first row which is the best ranked
+  QItemSelectionModel *selection = table->selectionModel();
+  if(selection != nullptr && !alternatives.isEmpty())
+    selection->select(table->model()->index(0, 0), QItemSelectionModel::Select | QItemSelectionModel::Rows);
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ROUTEALTERNATIVESDIALOG_H
+#define LNM_ROUTEALTERNATIVESDIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class RouteAlternativesDialog;
+}
+
+namespace atools {
+namespace gui {
+class ItemViewZoomHandler;
+}
+}
+
+class QAbstractButton;
+
+/* Summary of a calculated flight plan alternative as shown in the dialog */
+struct RouteAlternative
+{
+  /* Index into RouteCalcResult::candidates */
+  int candidateIndex = -1;
+
+  QString name;
+  float distanceNm = 0.f;
+  int numLegs = 0, numAirways = 0;
+
+  /* Travel time at cruise speed corrected by winds at cruise altitude. -1 if not available. */
+  float travelTimeHours = -1.f;
+};
+
+/*
+ * Shows a list of calculated flight plan alternatives and allows the user to select one.
+ */
+class RouteAlternativesDialog :
+  public QDialog
+{
+  Q_OBJECT
+
+public:
+  /* List should be sorted by rank. First entry is selected. */
+  RouteAlternativesDialog(QWidget *parent, const QVector<RouteAlternative>& alternativesParam);
+  virtual ~RouteAlternativesDialog() override;
+
+  RouteAlternativesDialog(const RouteAlternativesDialog& other) = delete;
+  RouteAlternativesDialog& operator=(const RouteAlternativesDialog& other) = delete;
+
+  /* Candidate index of selected alternative or -1 if none */
+  int getSelectedCandidateIndex() const;
+
+private:
+  void fillTable();
+  void buttonBoxClicked(QAbstractButton *button);
+  void updateButtons();
+
+  Ui::RouteAlternativesDialog *ui;
+  QVector<RouteAlternative> alternatives;
+  atools::gui::ItemViewZoomHandler *zoomHandler = nullptr;
+};
+
+#endif // LNM_ROUTEALTERNATIVESDIALOG_H
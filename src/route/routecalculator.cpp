@@ -0,0 +1,466 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routecalculator.h"
+
+#include "navapp.h"
+#include "atools.h"
+#include "common/constants.h"
+#include "settings/settings.h"
+#include "routing/routefinder.h"
+#include "routing/routenetwork.h"
+#include "routing/routenetworkloader.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+#include "exception.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDateTime>
+
+using atools::sql::SqlDatabase;
+using atools::routing::RouteNetwork;
+
+/* Connection names for the calculation thread */
+static const QString DATABASE_NAME_ROUTECALC_NAV("LNMDBROUTECALCNAV");
+static const QString DATABASE_NAME_ROUTECALC_TRACK("LNMDBROUTECALCTRACK");
+static const QString DATABASE_TYPE("QSQLITE");
+
+/* Minimum time between progress signals */
+static const qint64 PROGRESS_INTERVAL_MS = 100L;
+
+RouteCalcWorker::RouteCalcWorker()
+{
+
+}
+
+RouteCalcWorker::~RouteCalcWorker()
+{
+  deInitDatabases();
+  deleteNetworks();
+}
+
+void RouteCalcWorker::initDatabases(const QString& navDbFile, const QString& trackDbFile,
+                                    const QString& networkKey)
+{
+  deInitDatabases();
+
+  if(networkKey != currentNetworkKey)
+  {
+    // Different navdata - networks have to be loaded again
+    qDebug() << Q_FUNC_INFO << "Network key changed from" << currentNetworkKey << "to" << networkKey;
+    deleteNetworks();
+    currentNetworkKey = networkKey;
+  }
+  else
+    qDebug() << Q_FUNC_INFO << "Keeping networks for" << networkKey;
+
+  try
+  {
+    SqlDatabase::addDatabase(DATABASE_TYPE, DATABASE_NAME_ROUTECALC_NAV);
+    SqlDatabase::addDatabase(DATABASE_TYPE, DATABASE_NAME_ROUTECALC_TRACK);
+
+    // Map the navigation database file into memory which avoids copying all pages through the
+    // SQLite page cache when loading the networks
+    int mmapMb = atools::settings::Settings::instance().
+                 getAndStoreValue(lnm::SETTINGS_DATABASE + "RouteNetworkMmapMb", 512).toInt();
+
+    // Only read access - main connections are not blocked
+    dbNav = new SqlDatabase(DATABASE_NAME_ROUTECALC_NAV);
+    dbNav->setDatabaseName(navDbFile);
+    dbNav->setReadonly();
+    dbNav->open({"PRAGMA cache_size=-10000", QString("PRAGMA mmap_size=%1").arg(mmapMb * 1024LL * 1024LL)});
+
+    dbTrack = new SqlDatabase(DATABASE_NAME_ROUTECALC_TRACK);
+    dbTrack->setDatabaseName(trackDbFile);
+    dbTrack->setReadonly();
+    dbTrack->open({"PRAGMA cache_size=-1000"});
+
+    if(networkRadio == nullptr)
+      networkRadio = new RouteNetwork(atools::routing::SOURCE_RADIO);
+    if(networkAirway == nullptr)
+      networkAirway = new RouteNetwork(atools::routing::SOURCE_AIRWAY);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open route calculation databases" << e.what();
+    deInitDatabases();
+    deleteNetworks();
+    currentNetworkKey.clear();
+  }
+}
+
+void RouteCalcWorker::deleteNetworks()
+{
+  delete networkRadio;
+  networkRadio = nullptr;
+  delete networkAirway;
+  networkAirway = nullptr;
+}
+
+void RouteCalcWorker::loadNetwork(RouteNetwork *network)
+{
+  QElapsedTimer timer;
+  timer.start();
+  if(network == networkAirway)
+    currentTrackKey = trackKey();
+
+  atools::routing::RouteNetworkLoader loader(dbNav, dbTrack);
+  loader.load(network);
+  qDebug() << Q_FUNC_INFO << (network == networkAirway ? "Airway" : "Radio")
+           << "network loaded in" << timer.elapsed() << "ms";
+}
+
+void RouteCalcWorker::preloadNetworks(int preloadId)
+{
+  if(dbNav == nullptr || networkAirway == nullptr || networkRadio == nullptr)
+    return;
+
+  try
+  {
+    // Airway network is used more often - load first
+    // Loading a network cannot be interrupted - check cancellation before each one
+    for(RouteNetwork *network : {networkAirway, networkRadio})
+    {
+      if(canceledPreloadId.load() == preloadId)
+      {
+        qDebug() << Q_FUNC_INFO << "Preload" << preloadId << "canceled";
+        break;
+      }
+
+      if(!network->isLoaded())
+        loadNetwork(network);
+    }
+  }
+  catch(atools::Exception& e)
+  {
+    // Not critical - try again on calculation
+    qWarning() << Q_FUNC_INFO << "Preloading networks failed" << e.what();
+    networkAirway->clear();
+    networkRadio->clear();
+  }
+}
+
+void RouteCalcWorker::deInitDatabases()
+{
+  if(dbNav != nullptr || dbTrack != nullptr)
+  {
+    if(dbNav != nullptr && dbNav->isOpen())
+      dbNav->close();
+    delete dbNav;
+    dbNav = nullptr;
+
+    if(dbTrack != nullptr && dbTrack->isOpen())
+      dbTrack->close();
+    delete dbTrack;
+    dbTrack = nullptr;
+
+    SqlDatabase::removeDatabase(DATABASE_NAME_ROUTECALC_NAV);
+    SqlDatabase::removeDatabase(DATABASE_NAME_ROUTECALC_TRACK);
+  }
+}
+
+QString RouteCalcWorker::trackKey()
+{
+  QString key;
+  if(dbTrack != nullptr && atools::sql::SqlUtil(dbTrack).hasTableAndRows("track"))
+  {
+    // Ids of waypoints and airways change with the navdata - names and types with the downloaded tracks
+    atools::sql::SqlQuery query(dbTrack);
+    query.exec("select count(1), sum(from_waypoint_id), sum(to_waypoint_id), sum(airway_id), "
+               "group_concat(track_type || track_name || sequence_no, ',') from track");
+    if(query.next())
+      key = QString("%1|%2|%3|%4|%5").arg(query.valueInt(0)).arg(query.value(1).toLongLong()).
+            arg(query.value(2).toLongLong()).arg(query.value(3).toLongLong()).arg(qHash(query.valueStr(4)));
+  }
+  return key;
+}
+
+void RouteCalcWorker::tracksChanged()
+{
+  if(networkAirway != nullptr && networkAirway->isLoaded())
+  {
+    try
+    {
+      QString key = trackKey();
+      if(key != currentTrackKey)
+      {
+        qDebug() << Q_FUNC_INFO << "Tracks changed - clearing airway network";
+        networkAirway->clear();
+      }
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << e.what();
+      networkAirway->clear();
+    }
+  }
+}
+
+void RouteCalcWorker::calculate(RouteCalcRequest request)
+{
+  qDebug() << Q_FUNC_INFO << "request" << request.requestId;
+
+  RouteCalcResult result;
+  result.request = request;
+
+  if(canceledRequestId.load() == request.requestId)
+  {
+    // Canceled before being started
+    result.canceled = true;
+    emit calculationFinished(result);
+    return;
+  }
+
+  RouteNetwork *net = request.airwayNetwork ? networkAirway : networkRadio;
+
+  if(net == nullptr || dbNav == nullptr)
+  {
+    result.errorMessage = tr("Databases for flight plan calculation not available.");
+    emit calculationFinished(result);
+    return;
+  }
+
+  try
+  {
+    if(!net->isLoaded())
+    {
+      // Load network from database if not already done
+      emit calculationProgress(request.requestId, 0, 0);
+      loadNetwork(net);
+    }
+
+    if(request.variants.isEmpty())
+    {
+      // Single calculation using request parameters
+      RouteCalcVariant variant;
+      variant.mode = request.mode;
+      variant.costFactorForceAirways = request.costFactorForceAirways;
+
+      RouteCalcCandidate candidate;
+      result.canceled = !calculateVariant(request, variant, candidate, 0, 1);
+      result.found = candidate.found;
+      result.entries = candidate.entries;
+      result.distanceMeter = candidate.distanceMeter;
+    }
+    else
+    {
+      // Calculate alternatives one after the other since the route finder modifies the network
+      // Progress is scaled to the number of variants
+      int num = request.variants.size();
+      for(int i = 0; i < num && !result.canceled; i++)
+      {
+        RouteCalcCandidate candidate;
+        result.canceled = !calculateVariant(request, request.variants.at(i), candidate, i, num);
+        result.found |= candidate.found;
+        result.candidates.append(candidate);
+      }
+    }
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Route calculation failed" << e.what();
+    result.found = false;
+    result.errorMessage = e.what();
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Route calculation failed";
+    result.found = false;
+    result.errorMessage = tr("Unknown error.");
+  }
+
+  qDebug() << Q_FUNC_INFO << "found" << result.found << "canceled" << result.canceled
+           << "size" << result.entries.size() << "candidates" << result.candidates.size();
+
+  emit calculationFinished(result);
+}
+
+bool RouteCalcWorker::calculateVariant(const RouteCalcRequest& request, const RouteCalcVariant& variant,
+                                       RouteCalcCandidate& candidate, int progressOffset, int progressScale)
+{
+  candidate.variant = variant;
+
+  atools::routing::RouteFinder routeFinder(request.airwayNetwork ? networkAirway : networkRadio);
+  routeFinder.setCostFactorForceAirways(variant.costFactorForceAirways);
+
+  QElapsedTimer progressTimer;
+  progressTimer.start();
+  int id = request.requestId;
+
+  // Called from the route finder in this thread - return false to stop
+  routeFinder.setProgressCallback([this, id, progressOffset, progressScale, &progressTimer]
+                                    (int distToDest, int currentDistToDest) -> bool
+  {
+    if(progressTimer.hasExpired(PROGRESS_INTERVAL_MS) && distToDest > 0)
+    {
+      // Report in per mille of the whole task
+      int value = (progressOffset * 1000 + (distToDest - currentDistToDest) * 1000 / distToDest) / progressScale;
+      emit calculationProgress(id, 1000, value);
+      progressTimer.restart();
+    }
+    return canceledRequestId.load() != id;
+  });
+
+  // Calculate the route - calls above lambda ================================================
+  candidate.found = routeFinder.calculateRoute(request.departurePos, request.destinationPos,
+                                               atools::roundToInt(request.altitudeFt), variant.mode);
+
+  if(canceledRequestId.load() == id)
+  {
+    candidate.found = false;
+    return false;
+  }
+
+  if(candidate.found)
+  {
+    // Fetch waypoints
+    RouteExtractor extractor(&routeFinder);
+    extractor.extractRoute(candidate.entries, candidate.distanceMeter);
+    candidate.found = candidate.entries.size() > 0;
+  }
+
+  qDebug() << Q_FUNC_INFO << variant.name << "found" << candidate.found << "size" << candidate.entries.size()
+           << "distance" << candidate.distanceMeter;
+  return true;
+}
+
+// ===============================================================================================
+
+RouteCalculator::RouteCalculator(QObject *parent)
+  : QObject(parent)
+{
+  preload = atools::settings::Settings::instance().getAndStoreValue(lnm::SETTINGS_DATABASE + "RouteNetworkPreload",
+                                                                     true).toBool();
+
+  qRegisterMetaType<RouteCalcRequest>();
+  qRegisterMetaType<RouteCalcResult>();
+
+  worker = new RouteCalcWorker;
+  worker->moveToThread(&thread);
+
+  connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+  connect(this, &RouteCalculator::calculateRequested, worker, &RouteCalcWorker::calculate,
+          Qt::QueuedConnection);
+  connect(this, &RouteCalculator::tracksChangedRequested, worker, &RouteCalcWorker::tracksChanged,
+          Qt::QueuedConnection);
+  connect(this, &RouteCalculator::preloadNetworksRequested, worker, &RouteCalcWorker::preloadNetworks,
+          Qt::QueuedConnection);
+  connect(this, &RouteCalculator::initDatabasesRequested, worker, &RouteCalcWorker::initDatabases,
+          Qt::BlockingQueuedConnection);
+  connect(this, &RouteCalculator::deInitDatabasesRequested, worker, &RouteCalcWorker::deInitDatabases,
+          Qt::BlockingQueuedConnection);
+  connect(worker, &RouteCalcWorker::calculationProgress, this, &RouteCalculator::workerProgress,
+          Qt::QueuedConnection);
+  connect(worker, &RouteCalcWorker::calculationFinished, this, &RouteCalculator::workerFinished,
+          Qt::QueuedConnection);
+
+  thread.setObjectName("RouteCalculator");
+  thread.start();
+
+  postDatabaseLoad();
+}
+
+RouteCalculator::~RouteCalculator()
+{
+  preDatabaseLoad();
+
+  // Worker is deleted in thread when finished
+  thread.quit();
+  thread.wait();
+}
+
+void RouteCalculator::preDatabaseLoad()
+{
+  // Stop a running calculation or preload and ignore the result
+  cancel();
+  requestId++;
+  calculating = false;
+
+  if(databasesOpen)
+  {
+    // Waits until the canceled calculation or the currently loading network returns
+    emit deInitDatabasesRequested();
+    databasesOpen = false;
+  }
+}
+
+void RouteCalculator::postDatabaseLoad()
+{
+  if(!databasesOpen)
+  {
+    // Networks depend only on the navigation database - keep them if file and cycle did not change
+    QString navDbFile = NavApp::getDatabaseNav()->databaseName();
+    QFileInfo navDbFileInfo(navDbFile);
+    QString networkKey = QString("%1|%2|%3|%4").
+                         arg(navDbFileInfo.canonicalFilePath()).
+                         arg(navDbFileInfo.size()).
+                         arg(navDbFileInfo.lastModified().toMSecsSinceEpoch()).
+                         arg(NavApp::getDatabaseAiracCycleNav());
+
+    emit initDatabasesRequested(navDbFile, NavApp::getDatabaseTrack()->databaseName(), networkKey);
+    databasesOpen = true;
+
+    if(preload)
+      emit preloadNetworksRequested(++preloadId);
+  }
+}
+
+void RouteCalculator::tracksChanged()
+{
+  // Executed in order after a running calculation
+  emit tracksChangedRequested();
+
+  if(preload)
+    emit preloadNetworksRequested(++preloadId);
+}
+
+int RouteCalculator::calculate(RouteCalcRequest request)
+{
+  cancel();
+
+  request.requestId = ++requestId;
+  calculating = true;
+  emit calculateRequested(request);
+  return requestId;
+}
+
+void RouteCalculator::cancel()
+{
+  // Stop preload too - a calculation would wait in the queue until all networks are loaded
+  worker->cancelPreload(preloadId);
+
+  if(calculating)
+    worker->cancel(requestId);
+}
+
+void RouteCalculator::workerProgress(int id, int maximum, int value)
+{
+  if(id == requestId && calculating)
+    emit calculationProgress(maximum, value);
+}
+
+void RouteCalculator::workerFinished(const RouteCalcResult& result)
+{
+  if(result.request.requestId == requestId && calculating)
+  {
+    calculating = false;
+    emit calculationFinished(result);
+  }
+}
@@ -0,0 +1,241 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ROUTECALCULATOR_H
+#define LNM_ROUTECALCULATOR_H
+
+#include "route/routeextractor.h"
+#include "routing/routenetworktypes.h"
+#include "geo/pos.h"
+
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+namespace routing {
+class RouteNetwork;
+}
+}
+
+/* One configuration of the route finder when calculating alternatives */
+struct RouteCalcVariant
+{
+  /* Description shown to the user */
+  QString name;
+  atools::routing::Modes mode = atools::routing::MODE_NONE;
+  float costFactorForceAirways = 1.f;
+};
+
+/* Result for one configuration when calculating alternatives */
+struct RouteCalcCandidate
+{
+  RouteCalcVariant variant;
+  bool found = false;
+
+  /* Route points excluding departure and destination */
+  QVector<RouteEntry> entries;
+  float distanceMeter = 0.f;
+};
+
+/* Parameters for a flight plan calculation. Positions are already resolved by the caller. */
+struct RouteCalcRequest
+{
+  int requestId = -1;
+
+  /* Use airway network if true and radio navaid network otherwise */
+  bool airwayNetwork = true;
+
+  atools::geo::Pos departurePos, destinationPos;
+  float altitudeFt = 0.f;
+  atools::routing::Modes mode = atools::routing::MODE_NONE;
+  float costFactorForceAirways = 1.f;
+
+  /* Calculate a candidate for each configuration and ignore mode and costFactorForceAirways if not empty.
+   * Result is returned in RouteCalcResult::candidates. */
+  QVector<RouteCalcVariant> variants;
+
+  /* Used only by the caller when applying the result. Not evaluated in the worker. */
+  QString commandName;
+  bool fetchAirways = false;
+  int fromIndex = -1, toIndex = -1, routeSize = 0;
+};
+
+/* Calculation result as sent back from the worker thread. Contains a copy of the request. */
+struct RouteCalcResult
+{
+  RouteCalcRequest request;
+
+  bool found = false, canceled = false;
+
+  /* Not empty if an exception was caught in the worker */
+  QString errorMessage;
+
+  /* Route points excluding departure and destination */
+  QVector<RouteEntry> entries;
+  float distanceMeter = 0.f;
+
+  /* One entry per variant in request if calculating alternatives */
+  QVector<RouteCalcCandidate> candidates;
+};
+
+Q_DECLARE_METATYPE(RouteCalcRequest);
+Q_DECLARE_METATYPE(RouteCalcResult);
+
+/*
+ * Lives in the calculation thread. Owns the airway and radio navaid networks and read only connections to the
+ * navigation and track databases which are used to load the networks on demand.
+ *
+ * Networks are kept across database switches as long as the key built from navigation database file and AIRAC
+ * cycle does not change.
+ */
+class RouteCalcWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  RouteCalcWorker();
+  virtual ~RouteCalcWorker() override;
+
+  /* Open databases. Networks are dropped if networkKey differs from the last call.
+   * Has to be called in the worker thread. */
+  void initDatabases(const QString& navDbFile, const QString& trackDbFile, const QString& networkKey);
+
+  /* Close databases but keep networks. Has to be called in the worker thread. */
+  void deInitDatabases();
+
+  /* Clear airway network to force a reload on next calculation if the tracks in the database differ
+   * from the ones loaded into the network */
+  void tracksChanged();
+
+  /* Load all networks which are not loaded yet. Called in background after opening the databases
+   * to avoid the delay on first calculation. Stops before the next network if canceled. */
+  void preloadNetworks(int preloadId);
+
+  /* Load network if needed, calculate and send result with calculationFinished */
+  void calculate(RouteCalcRequest request);
+
+  /* Thread safe. Cancellation token for the given request which is checked periodically by the route finder. */
+  void cancel(int requestId)
+  {
+    canceledRequestId.store(requestId);
+  }
+
+  /* Thread safe. Stops the preload with the given id after the network currently loading. */
+  void cancelPreload(int preloadId)
+  {
+    canceledPreloadId.store(preloadId);
+  }
+
+signals:
+  /* Sent periodically while calculating. Maximum is 0 while the network is loaded. */
+  void calculationProgress(int requestId, int maximum, int value);
+  void calculationFinished(const RouteCalcResult& result);
+
+private:
+  void deleteNetworks();
+  void loadNetwork(atools::routing::RouteNetwork *network);
+
+  /* Key built from all track segments in the track database. Empty if there are no tracks. */
+  QString trackKey();
+
+  /* Run route finder and extractor for one configuration. Returns false if canceled. */
+  bool calculateVariant(const RouteCalcRequest& request, const RouteCalcVariant& variant,
+                        RouteCalcCandidate& candidate, int progressOffset, int progressScale);
+
+  atools::sql::SqlDatabase *dbNav = nullptr, *dbTrack = nullptr;
+  atools::routing::RouteNetwork *networkRadio = nullptr, *networkAirway = nullptr;
+
+  /* Navigation database file, file time and AIRAC cycle the networks were loaded for */
+  QString currentNetworkKey;
+
+  /* Tracks which were loaded into the airway network */
+  QString currentTrackKey;
+
+  QAtomicInt canceledRequestId = -1, canceledPreloadId = -1;
+};
+
+/*
+ * Runs flight plan calculations in a separate thread using own database connections. Result is delivered by the
+ * signal calculationFinished in the GUI thread. Only one calculation can run at a time.
+ */
+class RouteCalculator :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit RouteCalculator(QObject *parent);
+  virtual ~RouteCalculator() override;
+
+  /* Cancel running calculation and close database connections in thread */
+  void preDatabaseLoad();
+
+  /* Open database connections in thread using the files of the main databases */
+  void postDatabaseLoad();
+
+  /* Airway network will be reloaded in background or with the next calculation if tracks changed */
+  void tracksChanged();
+
+  /* Start calculation and return the request id. Request id in the parameter is ignored.
+   * A running calculation is canceled. */
+  int calculate(RouteCalcRequest request);
+
+  /* Cancel the running calculation and a running network preload. Result is still sent with flag canceled. */
+  void cancel();
+
+  /* true if a calculation was started and the result is not delivered yet */
+  bool isCalculating() const
+  {
+    return calculating;
+  }
+
+signals:
+  void calculationProgress(int maximum, int value);
+  void calculationFinished(const RouteCalcResult& result);
+
+  /* Internal signals for the worker */
+  void calculateRequested(RouteCalcRequest request);
+  void initDatabasesRequested(const QString& navDbFile, const QString& trackDbFile, const QString& networkKey);
+  void deInitDatabasesRequested();
+  void tracksChangedRequested();
+  void preloadNetworksRequested(int preloadId);
+
+private:
+  void workerProgress(int id, int maximum, int value);
+  void workerFinished(const RouteCalcResult& result);
+
+  QThread thread;
+  RouteCalcWorker *worker = nullptr;
+
+  bool databasesOpen = false, calculating = false;
+
+  /* Load networks in background after opening databases. Disabled by settings. */
+  bool preload = true;
+
+  /* Id of the last request. Results of other requests are ignored. */
+  int requestId = 0;
+
+  /* Id of the last preload request */
+  int preloadId = 0;
+};
+
+#endif // LNM_ROUTECALCULATOR_H
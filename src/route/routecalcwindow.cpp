@@ -57,7 +57,8 @@ RouteCalcWindow::RouteCalcWindow(QWidget *parent) :
              ui->checkBoxRouteCalcAirwayNoRnav, ui->checkBoxRouteCalcAirwayTrack, ui->radioButtonRouteCalcRadio,
              ui->radioButtonRouteCalcAirwayVictor, ui->radioButtonRouteCalcAirway, ui->checkBoxRouteCalcRadioNdb};
 
-  connect(ui->pushButtonRouteCalc, &QPushButton::clicked, this, &RouteCalcWindow::calculateClicked);
+  connect(ui->pushButtonRouteCalc, &QPushButton::clicked, this, &RouteCalcWindow::calculateButtonClicked);
+  connect(ui->pushButtonRouteCalcCompare, &QPushButton::clicked, this, &RouteCalcWindow::calculateAlternativesClicked);
   connect(ui->pushButtonRouteCalcDirect, &QPushButton::clicked, this, &RouteCalcWindow::calculateDirectClicked);
   connect(ui->pushButtonRouteCalcReverse, &QPushButton::clicked, this, &RouteCalcWindow::calculateReverseClicked);
   connect(ui->pushButtonRouteCalcTrackDownload, &QPushButton::clicked, this, &RouteCalcWindow::downloadTrackClicked);
@@ -70,6 +71,8 @@ RouteCalcWindow::RouteCalcWindow(QWidget *parent) :
   connect(ui->horizontalSliderRouteCalcAirwayPreference, &QSlider::valueChanged,
           this, &RouteCalcWindow::updatePreferenceLabel);
 
+  calculateButtonText = ui->pushButtonRouteCalc->text();
+
   units = new UnitStringTool();
   units->init({ui->spinBoxRouteCalcCruiseAltitude});
 
@@ -134,6 +137,21 @@ void RouteCalcWindow::helpClicked()
                                            lnm::helpLanguageOnline());
 }
 
+void RouteCalcWindow::calculateButtonClicked()
+{
+  if(calculating)
+    emit cancelCalculateClicked();
+  else
+    emit calculateClicked();
+}
+
+void RouteCalcWindow::setCalculating(bool value)
+{
+  calculating = value;
+  NavApp::getMainUi()->pushButtonRouteCalc->setText(calculating ? tr("&Cancel Calculation") : calculateButtonText);
+  updateWidgets();
+}
+
 void RouteCalcWindow::updateWidgets()
 {
   Ui::MainWindow *ui = NavApp::getMainUi();
@@ -153,7 +171,10 @@ void RouteCalcWindow::updateWidgets()
 
   bool canCalcRoute = NavApp::getRouteConst().canCalcRoute();
   ui->pushButtonRouteCalcAdjustAltitude->setEnabled(canCalcRoute);
-  ui->pushButtonRouteCalc->setEnabled(isCalculateSelection() ? canCalculateSelection : canCalcRoute);
+  // Cancel is always possible
+  ui->pushButtonRouteCalc->setEnabled(calculating || (isCalculateSelection() ? canCalculateSelection : canCalcRoute));
+  ui->pushButtonRouteCalcCompare->setEnabled(!calculating &&
+                                             (isCalculateSelection() ? canCalculateSelection : canCalcRoute));
 
   ui->pushButtonRouteCalcDirect->setEnabled(canCalcRoute && NavApp::getRouteConst().hasEntries());
   ui->pushButtonRouteCalcReverse->setEnabled(canCalcRoute);
@@ -315,7 +336,21 @@ bool RouteCalcWindow::isCalculateSelection() const
 
 float RouteCalcWindow::getAirwayPreferenceCostFactor() const
 {
-  return DIRECT_COST_FACTORS[NavApp::getMainUi()->horizontalSliderRouteCalcAirwayPreference->value()];
+  return getAirwayPreferenceCostFactor(NavApp::getMainUi()->horizontalSliderRouteCalcAirwayPreference->value());
+}
+
+float RouteCalcWindow::getAirwayPreferenceCostFactor(int airwayWaypointPreference)
+{
+  if(airwayWaypointPreference < AIRWAY_WAYPOINT_PREF_MIN || airwayWaypointPreference > AIRWAY_WAYPOINT_PREF_MAX)
+    return 1.f;
+
+  return DIRECT_COST_FACTORS[airwayWaypointPreference];
+}
+
+QString RouteCalcWindow::getAirwayWaypointPreferenceText(int airwayWaypointPreference) const
+{
+  // Use first line of the label text
+  return preferenceTexts.value(airwayWaypointPreference).section('\n', 0, 0);
 }
 
 void RouteCalcWindow::adjustAltitudePressed()
@@ -121,6 +121,15 @@ public:
 
   float getAirwayPreferenceCostFactor() const;
 
+  /* Cost factor for given airway/waypoint preference 0 = airways only, 10 = waypoints only */
+  static float getAirwayPreferenceCostFactor(int airwayWaypointPreference);
+
+  /* Short description for given airway/waypoint preference */
+  QString getAirwayWaypointPreferenceText(int airwayWaypointPreference) const;
+
+  /* Turns the calculate button into a cancel button while a calculation is running in background */
+  void setCalculating(bool value);
+
   static constexpr int AIRWAY_WAYPOINT_PREF_MIN = 0;
   static constexpr int AIRWAY_WAYPOINT_PREF_MAX = 10;
 
@@ -128,6 +137,8 @@ signals:
   /* Use clicked calculate flight plan button */
   void downloadTrackClicked();
   void calculateClicked();
+  void calculateAlternativesClicked();
+  void cancelCalculateClicked();
   void calculateDirectClicked();
   void calculateReverseClicked();
 
@@ -141,9 +152,13 @@ private:
 
   void helpClicked();
 
+  /* Sends calculateClicked or cancelCalculateClicked depending on state */
+  void calculateButtonClicked();
+
   /* Range/selection */
   int fromIndex = -1, toIndex = -1;
-  bool canCalculateSelection = false;
+  bool canCalculateSelection = false, calculating = false;
+  QString calculateButtonText;
   UnitStringTool *units = nullptr;
 
   QList<QObject *> widgets;
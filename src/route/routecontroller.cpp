@@ -45,7 +45,6 @@
 #include "query/airportquery.h"
 #include "mapgui/mapwidget.h"
 #include "parkingdialog.h"
-#include "routing/routefinder.h"
 #include "routing/routenetwork.h"
 #include "route/customproceduredialog.h"
 #include "settings/settings.h"
@@ -64,6 +63,10 @@
 #include "common/mapcolors.h"
 #include "common/unit.h"
 #include "route/routecalcwindow.h"
+#include "route/routecalculator.h"
+#include "route/routealternativesdialog.h"
+#include "weather/windreporter.h"
+#include "grib/windquery.h"
 #include "common/unitstringtool.h"
 #include "perf/aircraftperfcontroller.h"
 #include "fs/sc/simconnectdata.h"
@@ -80,7 +83,6 @@
 #include <QFileInfo>
 #include <QTextTable>
 #include <QPlainTextEdit>
-#include <QProgressDialog>
 #include <QScrollBar>
 
 namespace rcol {
@@ -223,9 +225,8 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
 
   view->setContextMenuPolicy(Qt::CustomContextMenu);
 
-  // Create flight plan calculation caches
-  routeNetworkRadio = new atools::routing::RouteNetwork(atools::routing::SOURCE_RADIO);
-  routeNetworkAirway = new atools::routing::RouteNetwork(atools::routing::SOURCE_AIRWAY);
+  // Create flight plan calculation thread which keeps the network caches
+  routeCalculator = new RouteCalculator(this);
 
   routeWindow = new RouteCalcWindow(mainWindow);
 
@@ -341,6 +342,11 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
 
   connect(this, &RouteController::routeChanged, routeWindow, &RouteCalcWindow::routeChanged);
   connect(routeWindow, &RouteCalcWindow::calculateClicked, this, &RouteController::calculateRoute);
+  connect(routeWindow, &RouteCalcWindow::calculateAlternativesClicked,
+          this, &RouteController::calculateRouteAlternatives);
+  connect(routeWindow, &RouteCalcWindow::cancelCalculateClicked, this, &RouteController::cancelCalculateRoute);
+  connect(routeCalculator, &RouteCalculator::calculationProgress, this, &RouteController::routeCalculationProgress);
+  connect(routeCalculator, &RouteCalculator::calculationFinished, this, &RouteController::routeCalculationFinished);
   connect(routeWindow, &RouteCalcWindow::calculateDirectClicked, this, &RouteController::calculateDirect);
   connect(routeWindow, &RouteCalcWindow::calculateReverseClicked, this, &RouteController::reverseRoute);
   connect(routeWindow, &RouteCalcWindow::downloadTrackClicked,
@@ -365,8 +371,7 @@ RouteController::~RouteController()
   delete entryBuilder;
   delete model;
   delete undoStack;
-  delete routeNetworkRadio;
-  delete routeNetworkAirway;
+  delete routeCalculator;
   delete zoomHandler;
   delete symbolPainter;
   delete flightplanIO;
@@ -1612,75 +1617,81 @@ void RouteController::calculateRouteWindowFull()
   NavApp::showRouteCalc();
 }
 
-void RouteController::calculateRoute()
+atools::routing::Modes RouteController::routeCalcAirwayMode(int airwayWaypointPreference, bool noRnav) const
 {
-  qDebug() << Q_FUNC_INFO;
+  atools::routing::Modes mode = atools::routing::MODE_NONE;
+
+  // Airway preference =======================================
+  switch(routeWindow->getAirwayRoutingType())
+  {
+    case rd::BOTH:
+      mode = atools::routing::MODE_AIRWAY_WAYPOINT;
+      break;
+
+    case rd::VICTOR:
+      mode = atools::routing::MODE_VICTOR_WAYPOINT;
+      break;
+
+    case rd::JET:
+      mode = atools::routing::MODE_JET_WAYPOINT;
+      break;
+  }
 
-  atools::routing::RouteNetwork *net = nullptr;
-  QString command;
+  // Airway/waypoint preference =======================================
+  if(airwayWaypointPreference == RouteCalcWindow::AIRWAY_WAYPOINT_PREF_MIN)
+    mode &= ~atools::routing::MODE_WAYPOINT;
+  else if(airwayWaypointPreference == RouteCalcWindow::AIRWAY_WAYPOINT_PREF_MAX)
+    mode &= ~atools::routing::MODE_AIRWAY;
+
+  // RNAV setting
+  if(noRnav)
+    mode |= atools::routing::MODE_NO_RNAV;
+
+  // Use tracks like NAT or PACOTS
+  if(routeWindow->isUseTracks())
+    mode |= atools::routing::MODE_TRACK;
+
+  return mode;
+}
+
+void RouteController::buildRouteCalcRequest(RouteCalcRequest& request)
+{
   atools::routing::Modes mode = atools::routing::MODE_NONE;
-  bool fetchAirways = false;
 
   // Build configuration for route finder =======================================
   if(routeWindow->getRoutingType() == rd::AIRWAY)
   {
-    net = routeNetworkAirway;
-    fetchAirways = true;
+    request.airwayNetwork = true;
+    request.fetchAirways = true;
 
-    // Airway preference =======================================
     switch(routeWindow->getAirwayRoutingType())
     {
       case rd::BOTH:
-        command = tr("Airway Flight Plan Calculation");
-        mode = atools::routing::MODE_AIRWAY_WAYPOINT;
+        request.commandName = tr("Airway Flight Plan Calculation");
         break;
 
       case rd::VICTOR:
-        command = tr("Low altitude airway Flight Plan Calculation");
-        mode = atools::routing::MODE_VICTOR_WAYPOINT;
+        request.commandName = tr("Low altitude airway Flight Plan Calculation");
         break;
 
       case rd::JET:
-        command = tr("High altitude airway Flight Plan Calculation");
-        mode = atools::routing::MODE_JET_WAYPOINT;
+        request.commandName = tr("High altitude airway Flight Plan Calculation");
         break;
     }
 
-    // Airway/waypoint preference =======================================
-    int pref = routeWindow->getAirwayWaypointPreference();
-    if(pref == RouteCalcWindow::AIRWAY_WAYPOINT_PREF_MIN)
-      mode &= ~atools::routing::MODE_WAYPOINT;
-    else if(pref == RouteCalcWindow::AIRWAY_WAYPOINT_PREF_MAX)
-      mode &= ~atools::routing::MODE_AIRWAY;
-
-    // RNAV setting
-    if(routeWindow->isAirwayNoRnav())
-      mode |= atools::routing::MODE_NO_RNAV;
-
-    // Use tracks like NAT or PACOTS
-    if(routeWindow->isUseTracks())
-      mode |= atools::routing::MODE_TRACK;
+    mode = routeCalcAirwayMode(routeWindow->getAirwayWaypointPreference(), routeWindow->isAirwayNoRnav());
   }
   else if(routeWindow->getRoutingType() == rd::RADIONNAV)
   {
     // Radionav settings ========================================
-    command = tr("Radionnav Flight Plan Calculation");
-    fetchAirways = false;
-    net = routeNetworkRadio;
+    request.commandName = tr("Radionnav Flight Plan Calculation");
+    request.fetchAirways = false;
+    request.airwayNetwork = false;
     mode = atools::routing::MODE_RADIONAV_VOR;
     if(routeWindow->isRadionavNdb())
       mode |= atools::routing::MODE_RADIONAV_NDB;
   }
 
-  if(!net->isLoaded())
-  {
-    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    loader.load(net);
-  }
-
-  atools::routing::RouteFinder routeFinder(net);
-  routeFinder.setCostFactorForceAirways(routeWindow->getAirwayPreferenceCostFactor());
-
   int fromIdx = -1, toIdx = -1;
   if(routeWindow->isCalculateSelection())
   {
@@ -1695,214 +1706,419 @@ void RouteController::calculateRoute()
     // Disable certain optimizations in route finder - use nearest underlying point as start for departure position
     mode |= atools::routing::MODE_POINT_TO_POINT;
 
-  if(calculateRouteInternal(&routeFinder, command, fetchAirways, routeWindow->getCruisingAltitudeFt(),
-                            fromIdx, toIdx, mode))
-    NavApp::setStatusMessage(tr("Calculated flight plan."));
-  else
-    NavApp::setStatusMessage(tr("No route found."));
+  request.mode = mode;
+  request.altitudeFt = routeWindow->getCruisingAltitudeFt();
+  request.costFactorForceAirways = routeWindow->getAirwayPreferenceCostFactor();
+  request.routeSize = route.size();
 
-  routeWindow->updateWidgets();
-}
+  if(fromIdx != -1 && toIdx != -1)
+  {
+    request.fromIndex = std::max(route.getLastIndexOfDepartureProcedure(), fromIdx);
+    request.toIndex = std::min(route.getDestinationIndexBeforeProcedure(), toIdx);
 
-void RouteController::clearAirwayNetworkCache()
-{
-  routeNetworkAirway->clear();
+    request.departurePos = route.value(request.fromIndex).getPosition();
+    request.destinationPos = route.value(request.toIndex).getPosition();
+  }
+  else
+  {
+    request.departurePos = route.getLastLegOfDepartureProcedure().getPosition();
+    request.destinationPos = route.getDestinationBeforeProcedure().getPosition();
+  }
 }
 
-/* Calculate a flight plan to all types */
-bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *routeFinder, const QString& commandName,
-                                             bool fetchAirways, float altitudeFt, int fromIndex, int toIndex,
-                                             atools::routing::Modes mode)
+void RouteController::calculateRoute()
 {
   qDebug() << Q_FUNC_INFO;
-  bool calcRange = fromIndex != -1 && toIndex != -1;
-  int oldRouteSize = route.size();
+
+  RouteCalcRequest request;
+  buildRouteCalcRequest(request);
 
   // Stop any background tasks
   beforeRouteCalc();
 
-  Flightplan& flightplan = route.getFlightplan();
+  // Calculation and network loading is done in background - result is sent to routeCalculationFinished()
+  routeCalculator->calculate(request);
 
-  // Load network from database if not already done
-  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+  NavApp::setStatusMessage(tr("Calculating flight plan ..."));
+  routeWindow->setCalculating(true);
+}
+
+void RouteController::calculateRouteAlternatives()
+{
+  qDebug() << Q_FUNC_INFO;
 
-  Pos departurePos, destinationPos;
+  RouteCalcRequest request;
+  buildRouteCalcRequest(request);
 
-  if(calcRange)
+  // Flags which are not touched by the variants
+  atools::routing::Modes keepMode = request.mode & atools::routing::MODE_POINT_TO_POINT;
+
+  // Current settings are always the first
+  RouteCalcVariant current;
+  current.name = tr("Current settings");
+  current.mode = request.mode;
+  current.costFactorForceAirways = request.costFactorForceAirways;
+  request.variants.append(current);
+
+  QVector<RouteCalcVariant> variants;
+  if(request.airwayNetwork)
   {
-    fromIndex = std::max(route.getLastIndexOfDepartureProcedure(), fromIndex);
-    toIndex = std::min(route.getDestinationIndexBeforeProcedure(), toIndex);
+    // Range of airway/waypoint preferences and RNAV setting
+    bool noRnav = routeWindow->isAirwayNoRnav();
+    for(int pref : {RouteCalcWindow::AIRWAY_WAYPOINT_PREF_MIN, 3, 6, 8, RouteCalcWindow::AIRWAY_WAYPOINT_PREF_MAX})
+    {
+      RouteCalcVariant variant;
+      variant.name = routeWindow->getAirwayWaypointPreferenceText(pref);
+      variant.mode = routeCalcAirwayMode(pref, noRnav) | keepMode;
+      variant.costFactorForceAirways = RouteCalcWindow::getAirwayPreferenceCostFactor(pref);
+      variants.append(variant);
+    }
 
-    departurePos = route.value(fromIndex).getPosition();
-    destinationPos = route.value(toIndex).getPosition();
+    RouteCalcVariant rnav = current;
+    rnav.name = noRnav ? tr("Current settings and RNAV airways") : tr("Current settings and no RNAV airways");
+    if(noRnav)
+      rnav.mode &= ~atools::routing::MODE_NO_RNAV;
+    else
+      rnav.mode |= atools::routing::MODE_NO_RNAV;
+    variants.append(rnav);
   }
   else
   {
-    departurePos = route.getLastLegOfDepartureProcedure().getPosition();
-    destinationPos = route.getDestinationBeforeProcedure().getPosition();
+    RouteCalcVariant vor;
+    vor.name = tr("VOR only");
+    vor.mode = keepMode | atools::routing::MODE_RADIONAV_VOR;
+    vor.costFactorForceAirways = request.costFactorForceAirways;
+    variants.append(vor);
+
+    RouteCalcVariant vorNdb;
+    vorNdb.name = tr("VOR and NDB");
+    vorNdb.mode = keepMode | atools::routing::MODE_RADIONAV_VOR | atools::routing::MODE_RADIONAV_NDB;
+    vorNdb.costFactorForceAirways = request.costFactorForceAirways;
+    variants.append(vorNdb);
   }
 
-  // ===================================================================
-  // Set up a progress dialog which shows for all calculations taking more than half a second
-  QProgressDialog progress(tr("Calculating Flight Plan ..."), tr("Cancel"), 0, 0, mainWindow);
-  progress.setWindowTitle(tr("Little Navmap - Calculating Flight Plan"));
-  progress.setWindowFlags(progress.windowFlags() & ~Qt::WindowContextHelpButtonHint);
-  progress.setWindowModality(Qt::ApplicationModal);
-  progress.setMinimumDuration(500);
-
-  bool dialogShown = false, canceled = false;
-  routeFinder->setProgressCallback([&progress, &canceled, &dialogShown](int distToDest, int currentDistToDest) -> bool
+  // Add only configurations which differ from the already added ones
+  for(const RouteCalcVariant& variant : variants)
   {
-    QApplication::processEvents();
-    progress.setMaximum(distToDest);
-    progress.setValue(distToDest - currentDistToDest);
-    canceled = progress.wasCanceled();
-
-    if(!dialogShown && progress.isVisible())
+    bool found = false;
+    for(const RouteCalcVariant& v : request.variants)
     {
-      // Dialog is shown - remove wait cursor
-      dialogShown = true;
-      QGuiApplication::restoreOverrideCursor();
+      if(v.mode == variant.mode &&
+         atools::almostEqual(v.costFactorForceAirways, variant.costFactorForceAirways, 0.001f))
+      {
+        found = true;
+        break;
+      }
     }
 
-    return !canceled;
-  });
+    if(!found)
+      request.variants.append(variant);
+  }
 
-  // Calculate the route - calls above lambda ================================================
-  bool found = routeFinder->calculateRoute(departurePos, destinationPos, atools::roundToInt(altitudeFt), mode);
+  // Stop any background tasks
+  beforeRouteCalc();
 
-  if(!dialogShown)
-    QGuiApplication::restoreOverrideCursor();
+  routeCalculator->calculate(request);
 
-  qDebug() << Q_FUNC_INFO << "found" << found << "canceled" << canceled;
+  NavApp::setStatusMessage(tr("Calculating %1 flight plan alternatives ...").arg(request.variants.size()));
+  routeWindow->setCalculating(true);
+}
 
-  // Hide dialog
-  progress.reset();
+void RouteController::cancelCalculateRoute()
+{
+  qDebug() << Q_FUNC_INFO;
 
-  // Create wait cursor if calculation takes too long
-  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+  // Result is still sent but with canceled flag
+  routeCalculator->cancel();
+}
 
-  float distance = 0.f;
-  QVector<RouteEntry> calculatedRoute;
+void RouteController::routeCalculationProgress(int maximum, int value)
+{
+  if(maximum == 0)
+    NavApp::setStatusMessage(tr("Loading flight plan calculation network ..."));
+  else
+    NavApp::setStatusMessage(tr("Calculating flight plan ... %1 percent done.").
+                             arg(std::min(100, std::max(0, value * 100 / maximum))));
+}
 
-  if(found && !canceled)
-  {
-    // A route was found
+void RouteController::routeCalculationFinished(const RouteCalcResult& result)
+{
+  qDebug() << Q_FUNC_INFO << "found" << result.found << "canceled" << result.canceled;
 
-    // Fetch waypoints
-    RouteExtractor extractor(routeFinder);
-    extractor.extractRoute(calculatedRoute, distance);
-    qDebug() << Q_FUNC_INFO << "Extracted size" << calculatedRoute.size();
+  routeWindow->setCalculating(false);
 
-    found = calculatedRoute.size() > 0;
+  const RouteCalcRequest& request = result.request;
+  if(result.canceled)
+    NavApp::setStatusMessage(tr("Flight plan calculation canceled."));
+  else if(!result.errorMessage.isEmpty())
+  {
+    NavApp::setStatusMessage(tr("No route found."));
+    atools::gui::Dialog::warning(mainWindow, tr("Error calculating flight plan:\n%1").arg(result.errorMessage));
   }
-
-  if(found && !canceled)
+  else
   {
-    // Compare to direct connection and check if route is too long
-    float directDistance = departurePos.distanceMeterTo(destinationPos);
-    float ratio = distance / directDistance;
-    qDebug() << "route distance" << QString::number(distance, 'f', 0)
-             << "direct distance" << QString::number(directDistance, 'f', 0) << "ratio" << ratio;
-
-    if(ratio < MAX_DISTANCE_DIRECT_RATIO)
+    // Check if the flight plan was modified while calculating in background
+    bool calcRange = request.fromIndex != -1 && request.toIndex != -1;
+    bool unchanged = route.size() == request.routeSize;
+    if(unchanged && calcRange)
+      unchanged = request.toIndex < route.size() &&
+                  route.value(request.fromIndex).getPosition().almostEqual(request.departurePos) &&
+                  route.value(request.toIndex).getPosition().almostEqual(request.destinationPos);
+    else if(unchanged)
+      unchanged = route.getLastLegOfDepartureProcedure().getPosition().almostEqual(request.departurePos) &&
+                  route.getDestinationBeforeProcedure().getPosition().almostEqual(request.destinationPos);
+
+    if(!unchanged)
+      NavApp::setStatusMessage(tr("Flight plan changed while calculating. Result discarded."));
+    else if(!request.variants.isEmpty() && result.found)
     {
-      // Start undo
-      RouteCommand *undoCommand = preChange(commandName);
-      int numAlternateLegs = route.getNumAlternateLegs();
+      // Let user select one of the alternatives
+      RouteCalcResult selected = result;
+      int index = selectRouteAlternative(result);
+      if(index >= 0)
+      {
+        selected.entries = result.candidates.at(index).entries;
+        selected.distanceMeter = result.candidates.at(index).distanceMeter;
 
-      QList<FlightplanEntry>& entries = flightplan.getEntries();
+        if(applyCalculatedRoute(selected))
+          NavApp::setStatusMessage(tr("Calculated flight plan using \"%1\".").
+                                   arg(result.candidates.at(index).variant.name));
+      }
+      else
+        NavApp::setStatusMessage(tr("No flight plan alternative selected."));
+    }
+    else
+    {
+      bool found = result.found && applyCalculatedRoute(result);
 
-      if(calcRange)
+      if(found)
+        NavApp::setStatusMessage(tr("Calculated flight plan."));
+      else
       {
-        entries[toIndex].setAirway(QString());
-        entries[toIndex].setFlag(atools::fs::pln::entry::TRACK, false);
-        entries.erase(flightplan.getEntries().begin() + fromIndex + 1, flightplan.getEntries().begin() + toIndex);
+        NavApp::setStatusMessage(tr("No route found."));
+        atools::gui::Dialog(mainWindow).showInfoMsgBox(lnm::ACTIONS_SHOWROUTE_ERROR,
+                                                       tr("Cannot calculate flight plan.\n\n"
+                                                          "Try another calculation type,\n"
+                                                          "change the cruise altitude or\n"
+                                                          "create the flight plan manually."),
+                                                       tr("Do not &show this dialog again."));
       }
-      else
-        // Erase all but start and destination
-        entries.erase(flightplan.getEntries().begin() + 1, entries.end() - numAlternateLegs - 1);
+    }
+  }
 
-      int idx = 1;
-      // Create flight plan entries - will be copied later to the route map objects
-      for(const RouteEntry& routeEntry : calculatedRoute)
+  routeWindow->updateWidgets();
+}
+
+int RouteController::selectRouteAlternative(const RouteCalcResult& result)
+{
+  const RouteCalcRequest& request = result.request;
+  float directDistance = request.departurePos.distanceMeterTo(request.destinationPos);
+  float cruiseSpeedKts = NavApp::getAircraftPerformance().getCruiseSpeed();
+  WindReporter *windReporter = NavApp::getWindReporter();
+
+  QVector<RouteAlternative> alternatives;
+  QVector<QVector<RouteEntry> > entryLists;
+  for(int i = 0; i < result.candidates.size(); i++)
+  {
+    const RouteCalcCandidate& candidate = result.candidates.at(i);
+
+    // Skip not found, too long ones and duplicates
+    if(!candidate.found)
+      continue;
+
+    if(directDistance > MIN_DISTANCE_DIRECT_METER &&
+       candidate.distanceMeter / directDistance >= MAX_DISTANCE_DIRECT_RATIO)
+      continue;
+
+    bool duplicate = false;
+    for(const QVector<RouteEntry>& entries : entryLists)
+    {
+      duplicate = entries.size() == candidate.entries.size() &&
+                  std::equal(entries.begin(), entries.end(), candidate.entries.begin(),
+                             [](const RouteEntry& e1, const RouteEntry& e2) -> bool {
+            return e1.ref.id == e2.ref.id && e1.ref.objType == e2.ref.objType && e1.airwayId == e2.airwayId;
+          });
+      if(duplicate)
+        break;
+    }
+    if(duplicate)
+      continue;
+    entryLists.append(candidate.entries);
+
+    RouteAlternative alt;
+    alt.candidateIndex = i;
+    alt.name = candidate.variant.name;
+    alt.distanceNm = atools::geo::meterToNm(candidate.distanceMeter);
+    alt.numLegs = candidate.entries.size() + 1;
+
+    // Build list of positions including departure and destination
+    QVector<Pos> positions({request.departurePos});
+    QSet<int> airwayIds;
+    for(const RouteEntry& entry : candidate.entries)
+    {
+      FlightplanEntry flightplanEntry;
+      entryBuilder->buildFlightplanEntry(entry.ref.id, atools::geo::EMPTY_POS, entry.ref.objType,
+                                         flightplanEntry, false /* resolve airways */);
+      positions.append(flightplanEntry.getPosition());
+      if(entry.airwayId != -1)
+        airwayIds.insert(entry.airwayId);
+    }
+    positions.append(request.destinationPos);
+    alt.numAirways = airwayIds.size();
+
+    if(cruiseSpeedKts > 0.f && cruiseSpeedKts < map::INVALID_SPEED_VALUE)
+    {
+      // Sum up time for all legs using winds at cruise altitude
+      float hours = 0.f;
+      for(int j = 1; j < positions.size() && hours >= 0.f; j++)
       {
-        FlightplanEntry flightplanEntry;
-        entryBuilder->buildFlightplanEntry(routeEntry.ref.id, atools::geo::EMPTY_POS, routeEntry.ref.objType,
-                                           flightplanEntry, fetchAirways);
-        if(fetchAirways && routeEntry.airwayId != -1)
-          // Get airway by id - needed to fetch the name first
-          updateFlightplanEntryAirway(routeEntry.airwayId, flightplanEntry);
-
-        if(calcRange)
-          entries.insert(flightplan.getEntries().begin() + fromIndex + idx, flightplanEntry);
+        Pos pos1 = positions.at(j - 1).alt(request.altitudeFt), pos2 = positions.at(j).alt(request.altitudeFt);
+        atools::grib::Wind wind = windReporter->getWindForLineRoute(pos1, pos2);
+        float groundSpeed = atools::geo::windCorrectedGroundSpeed(wind.speed, wind.dir,
+                                                                   pos1.angleDegTo(pos2), cruiseSpeedKts);
+        if(groundSpeed < 1.f)
+          // Too much wind
+          hours = -1.f;
         else
-          entries.insert(entries.end() - numAlternateLegs - 1, flightplanEntry);
-        idx++;
+          hours += atools::geo::meterToNm(pos1.distanceMeterTo(pos2)) / groundSpeed;
       }
+      alt.travelTimeHours = hours;
+    }
 
-      // Remove procedure points from flight plan
-      flightplan.removeNoSaveEntries();
+    alternatives.append(alt);
+  }
 
-      // Copy flight plan to route object
-      route.createRouteLegsFromFlightplan();
+  if(alternatives.isEmpty())
+    return -1;
 
-      // Reload procedures from properties
-      loadProceduresFromFlightplan(true /* clear old procedure properties */);
-      loadAlternateFromFlightplan();
-      QGuiApplication::restoreOverrideCursor();
+  // Rank by travel time if all are valid - otherwise by distance
+  bool allTimes = std::all_of(alternatives.begin(), alternatives.end(), [](const RouteAlternative& alt) -> bool {
+          return alt.travelTimeHours >= 0.f;
+        });
 
-      // Remove duplicates in flight plan and route
-      route.updateAll();
+  std::stable_sort(alternatives.begin(), alternatives.end(),
+                   [allTimes](const RouteAlternative& alt1, const RouteAlternative& alt2) -> bool {
+          return allTimes ? alt1.travelTimeHours < alt2.travelTimeHours : alt1.distanceNm < alt2.distanceNm;
+        });
 
-      // Set altitude in local units
-      flightplan.setCruisingAltitude(atools::roundToInt(Unit::altFeetF(altitudeFt)));
+  RouteAlternativesDialog dialog(mainWindow, alternatives);
+  if(dialog.exec() == QDialog::Accepted)
+    return dialog.getSelectedCandidateIndex();
+  else
+    return -1;
+}
 
-      route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
+/* Replace flight plan or range with calculated route */
+bool RouteController::applyCalculatedRoute(const RouteCalcResult& result)
+{
+  qDebug() << Q_FUNC_INFO;
+  const RouteCalcRequest& request = result.request;
+  const QVector<RouteEntry>& calculatedRoute = result.entries;
+  bool fetchAirways = request.fetchAirways;
+  int fromIndex = request.fromIndex, toIndex = request.toIndex;
+  bool calcRange = fromIndex != -1 && toIndex != -1;
+  int oldRouteSize = route.size();
 
-      updateActiveLeg();
+  // Compare to direct connection and check if route is too long
+  // Ratio is not usable if departure and destination are at the same position - accept route then
+  float directDistance = request.departurePos.distanceMeterTo(request.destinationPos);
+  float ratio = directDistance > MIN_DISTANCE_DIRECT_METER ? result.distanceMeter / directDistance : 0.f;
+  qDebug() << "route distance" << QString::number(result.distanceMeter, 'f', 0)
+           << "direct distance" << QString::number(directDistance, 'f', 0) << "ratio" << ratio;
 
-      route.updateLegAltitudes();
+  if(ratio >= MAX_DISTANCE_DIRECT_RATIO)
+    // Too long
+    return false;
 
-      updateTableModel();
-      updateMoveAndDeleteActions();
+  Flightplan& flightplan = route.getFlightplan();
 
-      postChange(undoCommand);
-      NavApp::updateWindowTitle();
+  // Create wait cursor if updating takes too long
+  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
-#ifdef DEBUG_INFORMATION
-      qDebug() << flightplan;
-#endif
+  // Start undo
+  RouteCommand *undoCommand = preChange(request.commandName);
+  int numAlternateLegs = route.getNumAlternateLegs();
 
-      NavApp::updateErrorLabels();
+  QList<FlightplanEntry>& entries = flightplan.getEntries();
 
-      if(calcRange)
-      {
-        // will also update route window
-        int newToIndex = toIndex - (oldRouteSize - route.size());
-        selectRange(fromIndex, newToIndex);
-      }
+  if(calcRange)
+  {
+    entries[toIndex].setAirway(QString());
+    entries[toIndex].setFlag(atools::fs::pln::entry::TRACK, false);
+    entries.erase(flightplan.getEntries().begin() + fromIndex + 1, flightplan.getEntries().begin() + toIndex);
+  }
+  else
+    // Erase all but start and destination
+    entries.erase(flightplan.getEntries().begin() + 1, entries.end() - numAlternateLegs - 1);
 
-      emit routeChanged(true);
-    }
+  int idx = 1;
+  // Create flight plan entries - will be copied later to the route map objects
+  for(const RouteEntry& routeEntry : calculatedRoute)
+  {
+    FlightplanEntry flightplanEntry;
+    entryBuilder->buildFlightplanEntry(routeEntry.ref.id, atools::geo::EMPTY_POS, routeEntry.ref.objType,
+                                       flightplanEntry, fetchAirways);
+    if(fetchAirways && routeEntry.airwayId != -1)
+      // Get airway by id - needed to fetch the name first
+      updateFlightplanEntryAirway(routeEntry.airwayId, flightplanEntry);
+
+    if(calcRange)
+      entries.insert(flightplan.getEntries().begin() + fromIndex + idx, flightplanEntry);
     else
-      // Too long
-      found = false;
+      entries.insert(entries.end() - numAlternateLegs - 1, flightplanEntry);
+    idx++;
+  }
+
+  // Remove procedure points from flight plan
+  flightplan.removeNoSaveEntries();
+
+  // Copy flight plan to route object
+  route.createRouteLegsFromFlightplan();
+
+  // Reload procedures from properties
+  loadProceduresFromFlightplan(true /* clear old procedure properties */);
+  loadAlternateFromFlightplan();
+
+  // Remove duplicates in flight plan and route
+  route.updateAll();
+
+  // Set altitude in local units
+  flightplan.setCruisingAltitude(atools::roundToInt(Unit::altFeetF(request.altitudeFt)));
+
+  route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
+
+  updateActiveLeg();
+
+  route.updateLegAltitudes();
+
+  updateTableModel();
+  updateMoveAndDeleteActions();
+
+  postChange(undoCommand);
+  NavApp::updateWindowTitle();
+
+#ifdef DEBUG_INFORMATION
+  qDebug() << flightplan;
+#endif
+
+  NavApp::updateErrorLabels();
+
+  if(calcRange)
+  {
+    // will also update route window
+    int newToIndex = toIndex - (oldRouteSize - route.size());
+    selectRange(fromIndex, newToIndex);
   }
 
+  emit routeChanged(true);
+
   QGuiApplication::restoreOverrideCursor();
-  if(!found && !canceled)
-    atools::gui::Dialog(mainWindow).showInfoMsgBox(lnm::ACTIONS_SHOWROUTE_ERROR,
-                                                   tr("Cannot calculate flight plan.\n\n"
-                                                      "Try another calculation type,\n"
-                                                      "change the cruise altitude or\n"
-                                                      "create the flight plan manually."),
-                                                   tr("Do not &show this dialog again."));
+
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << route;
 #endif
 
-  return found;
+  return true;
 }
 
 void RouteController::adjustFlightplanAltitude()
@@ -1998,13 +2214,17 @@ void RouteController::preDatabaseLoad()
   route.resetActive();
   highlightNextWaypoint(route.getActiveLegIndex());
 
+  // Stop calculation and close connections of the calculation thread
+  routeCalculator->preDatabaseLoad();
+  routeWindow->setCalculating(false);
+
   routeWindow->preDatabaseLoad();
 }
 
 void RouteController::postDatabaseLoad()
 {
-  routeNetworkRadio->clear();
-  routeNetworkAirway->clear();
+  // Reopen connections after database switch - networks are kept if the navdata did not change
+  routeCalculator->postDatabaseLoad();
 
   // Remove the legs but keep the properties
   route.clearProcedures(proc::PROCEDURE_ALL);
@@ -2913,6 +3133,8 @@ void RouteController::optionsChanged()
 
 void RouteController::tracksChanged()
 {
+  // Airway network is reloaded only if the tracks differ from the ones loaded into it
+  routeCalculator->tracksChanged();
   postDatabaseLoad();
 }
 
@@ -5121,20 +5343,21 @@ void RouteController::debugNetworkClick(const atools::geo::Pos& pos)
   {
     qDebug() << Q_FUNC_INFO << pos;
 
+    // Networks of the calculation thread cannot be used here - load temporary copies
+    atools::routing::RouteNetwork routeNetworkAirway(atools::routing::SOURCE_AIRWAY),
+    routeNetworkRadio(atools::routing::SOURCE_RADIO);
     atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    if(!routeNetworkAirway->isLoaded())
-      loader.load(routeNetworkAirway);
-    if(!routeNetworkRadio->isLoaded())
-      loader.load(routeNetworkRadio);
+    loader.load(&routeNetworkAirway);
+    loader.load(&routeNetworkRadio);
 
-    atools::routing::Node node = routeNetworkAirway->getNearestNode(pos);
+    atools::routing::Node node = routeNetworkAirway.getNearestNode(pos);
     if(node.isValid())
     {
       qDebug() << "Airway node" << node;
       qDebug() << "Airway edges" << node.edges;
     }
 
-    node = routeNetworkRadio->getNearestNode(pos);
+    node = routeNetworkRadio.getNearestNode(pos);
     if(node.isValid())
     {
       qDebug() << "Radio node" << node;
@@ -26,10 +26,6 @@
 #include <QTimer>
 
 namespace atools {
-namespace routing {
-class RouteFinder;
-class RouteNetwork;
-}
 namespace gui {
 class ItemViewZoomHandler;
 class TabWidgetHandler;
@@ -61,6 +57,9 @@ class AirwayTrackQuery;
 class UnitStringTool;
 class QTextCursor;
 class RouteCalcWindow;
+class RouteCalculator;
+struct RouteCalcResult;
+struct RouteCalcRequest;
 
 /*
  * All flight plan related tasks like saving, loading, modification, calculation and table
@@ -272,9 +271,6 @@ public:
     return tabHandlerRoute;
   }
 
-  /* Clear network, so it will be reloaded before next flight plan calculation. */
-  void clearAirwayNetworkCache();
-
 #ifdef DEBUG_NETWORK_INFORMATION
   void debugNetworkClick(const atools::geo::Pos& pos);
 
@@ -382,12 +378,30 @@ private:
 
   void clearRoute();
 
-  /* Calculate flight plan pressed in dock window */
+  /* Calculate flight plan pressed in dock window. Starts the calculation in background. */
   void calculateRoute();
-  bool calculateRouteInternal(atools::routing::RouteFinder *routeFinder,
-                              const QString& commandName,
-                              bool fetchAirways, float altitudeFt, int fromIndex, int toIndex,
-                              atools::routing::Modes mode);
+
+  /* Compare pressed in dock window. Calculates several configurations in background. */
+  void calculateRouteAlternatives();
+
+  /* Fill calculation request from dock window settings and current flight plan */
+  void buildRouteCalcRequest(RouteCalcRequest& request);
+
+  /* Get route finder mode for airway calculation based on window settings and given preference */
+  atools::routing::Modes routeCalcAirwayMode(int airwayWaypointPreference, bool noRnav) const;
+
+  /* Rank alternatives and let the user select one in a dialog. Returns candidate index or -1 if none selected. */
+  int selectRouteAlternative(const RouteCalcResult& result);
+
+  /* Cancel pressed in dock window while calculating */
+  void cancelCalculateRoute();
+
+  /* Called by route calculator in GUI thread */
+  void routeCalculationProgress(int maximum, int value);
+  void routeCalculationFinished(const RouteCalcResult& result);
+
+  /* Replace flight plan or selected range with calculation result. Returns false if route was too long. */
+  bool applyCalculatedRoute(const RouteCalcResult& result);
 
   void updateModelTimeFuelWind();
 
@@ -491,6 +505,9 @@ private:
   /* If route distance / direct distance if bigger than this value fail routing */
   static Q_DECL_CONSTEXPR float MAX_DISTANCE_DIRECT_RATIO = 2.0f;
 
+  /* Ratio check above is skipped if direct distance is below this value like for departure equal to destination */
+  static Q_DECL_CONSTEXPR float MIN_DISTANCE_DIRECT_METER = 1.0f;
+
   static Q_DECL_CONSTEXPR int ROUTE_UNDO_LIMIT = 50;
 
   atools::gui::ItemViewZoomHandler *zoomHandler = nullptr;
@@ -500,8 +517,8 @@ private:
   /* Clean index of the undo stack or -1 if not clean state exists */
   int undoIndexClean = 0;
 
-  /* Network cache for flight plan calculation */
-  atools::routing::RouteNetwork *routeNetworkRadio = nullptr, *routeNetworkAirway = nullptr;
+  /* Runs flight plan calculation in background and keeps the network caches */
+  RouteCalculator *routeCalculator = nullptr;
 
   /* Flightplan and route objects */
   Route route; /* real route containing all segments */
@@ -20,7 +20,6 @@
 #include "common/maptypes.h"
 #include "options/optiondata.h"
 #include "search/sqlmodel.h"
-#include "search/sqlproxymodel.h"
 #include "common/symbolpainter.h"
 #include "sql/sqlrecord.h"
 #include "common/maptypesfactory.h"
@@ -44,21 +43,12 @@ AirportIconDelegate::~AirportIconDelegate()
 void AirportIconDelegate::paint(QPainter *painter, const QStyleOptionViewItem& option,
                                 const QModelIndex& index) const
 {
-  QModelIndex idx(index);
   const SqlModel *sqlModel = dynamic_cast<const SqlModel *>(index.model());
-  if(sqlModel == nullptr)
-  {
-    // Convert index to source if distance search proxy is used
-    const SqlProxyModel *sqlProxyModel = dynamic_cast<const SqlProxyModel *>(index.model());
-    Q_ASSERT(sqlProxyModel != nullptr);
-    sqlModel = dynamic_cast<const SqlModel *>(sqlProxyModel->sourceModel());
-    idx = sqlProxyModel->mapToSource(index);
-  }
   Q_ASSERT(sqlModel != nullptr);
 
   // Get airport from the SQL model
   map::MapAirport ap;
-  mapTypesFactory->fillAirport(sqlModel->getSqlRecord(idx.row()), ap, true /* complete */, false /* nav */,
+  mapTypesFactory->fillAirport(sqlModel->getSqlRecord(index.row()), ap, true /* complete */, false /* nav */,
                                NavApp::isAirportDatabaseXPlane(false /* navdata */));
 
   // Create a style copy
@@ -18,7 +18,6 @@
 #include "search/navicondelegate.h"
 
 #include "search/sqlmodel.h"
-#include "search/sqlproxymodel.h"
 #include "common/symbolpainter.h"
 #include "sql/sqlrecord.h"
 #include "common/maptypes.h"
@@ -39,16 +38,7 @@ NavIconDelegate::~NavIconDelegate()
 void NavIconDelegate::paint(QPainter *painter, const QStyleOptionViewItem& option,
                             const QModelIndex& index) const
 {
-  QModelIndex idx(index);
   const SqlModel *sqlModel = dynamic_cast<const SqlModel *>(index.model());
-  if(sqlModel == nullptr)
-  {
-    // Convert index to source if distance search proxy is used
-    const SqlProxyModel *sqlProxyModel = dynamic_cast<const SqlProxyModel *>(index.model());
-    Q_ASSERT(sqlProxyModel != nullptr);
-    sqlModel = dynamic_cast<const SqlModel *>(sqlProxyModel->sourceModel());
-    idx = sqlProxyModel->mapToSource(index);
-  }
   Q_ASSERT(sqlModel != nullptr);
 
   // Create a style copy
@@ -63,7 +53,7 @@ void NavIconDelegate::paint(QPainter *painter, const QStyleOptionViewItem& optio
   QStyledItemDelegate::paint(painter, opt, index);
 
   // Get nav type from SQL model
-  QString navtype = sqlModel->getSqlRecord(idx.row()).valueStr("nav_type");
+  QString navtype = sqlModel->getSqlRecord(index.row()).valueStr("nav_type");
   map::MapTypes type = map::navTypeToMapObjectType(navtype);
 
   int symbolSize = option.rect.height() - 4;
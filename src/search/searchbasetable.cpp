@@ -329,11 +329,11 @@ void SearchBaseTable::updateDistanceSearch()
     QComboBox *distanceDirWidget = columns->getDistanceDirectionWidget();
 
     controller->filterByDistance(NavApp::getMapWidget()->getSearchMarkPos(),
-                                 static_cast<sqlproxymodel::SearchDirection>(distanceDirWidget->currentIndex()),
+                                 static_cast<sqlmodel::SearchDirection>(distanceDirWidget->currentIndex()),
                                  Unit::rev(minDistanceWidget->value(), Unit::distNmF),
                                  Unit::rev(maxDistanceWidget->value(), Unit::distNmF));
 
-    controller->loadAllRowsForDistanceSearch();
+    controller->queryDistanceSearch();
   }
 }
 
@@ -459,7 +459,7 @@ void SearchBaseTable::connectSearchWidgets()
     connect(minDistanceWidget, QOverload<int>::of(&QSpinBox::valueChanged), this, [ = ](int value)
     {
       controller->filterByDistanceUpdate(
-        static_cast<sqlproxymodel::SearchDirection>(distanceDirWidget->currentIndex()),
+        static_cast<sqlmodel::SearchDirection>(distanceDirWidget->currentIndex()),
         Unit::rev(value, Unit::distNmF),
         Unit::rev(maxDistanceWidget->value(), Unit::distNmF));
 
@@ -471,7 +471,7 @@ void SearchBaseTable::connectSearchWidgets()
     connect(maxDistanceWidget, QOverload<int>::of(&QSpinBox::valueChanged), this, [ = ](int value)
     {
       controller->filterByDistanceUpdate(
-        static_cast<sqlproxymodel::SearchDirection>(distanceDirWidget->currentIndex()),
+        static_cast<sqlmodel::SearchDirection>(distanceDirWidget->currentIndex()),
         Unit::rev(minDistanceWidget->value(), Unit::distNmF),
         Unit::rev(value, Unit::distNmF));
       minDistanceWidget->setMaximum(value);
@@ -481,7 +481,7 @@ void SearchBaseTable::connectSearchWidgets()
 
     connect(distanceDirWidget, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [ = ](int index)
     {
-      controller->filterByDistanceUpdate(static_cast<sqlproxymodel::SearchDirection>(index),
+      controller->filterByDistanceUpdate(static_cast<sqlmodel::SearchDirection>(index),
                                          Unit::rev(minDistanceWidget->value(), Unit::distNmF),
                                          Unit::rev(maxDistanceWidget->value(), Unit::distNmF));
       updateButtonMenu();
@@ -557,7 +557,7 @@ void SearchBaseTable::distanceSearchChanged(bool checked, bool changeViewState)
 
   controller->filterByDistance(
     checked ? NavApp::getMapWidget()->getSearchMarkPos() : atools::geo::Pos(),
-    static_cast<sqlproxymodel::SearchDirection>(distanceDirWidget->currentIndex()),
+    static_cast<sqlmodel::SearchDirection>(distanceDirWidget->currentIndex()),
     Unit::rev(minDistanceWidget->value(), Unit::distNmF),
     Unit::rev(maxDistanceWidget->value(), Unit::distNmF));
 
@@ -565,7 +565,7 @@ void SearchBaseTable::distanceSearchChanged(bool checked, bool changeViewState)
   maxDistanceWidget->setEnabled(checked);
   distanceDirWidget->setEnabled(checked);
   if(checked)
-    controller->loadAllRowsForDistanceSearch();
+    controller->queryDistanceSearch();
   restoreViewState(checked);
   updateButtonMenu();
 }
@@ -590,7 +590,7 @@ void SearchBaseTable::editStartTimer()
 void SearchBaseTable::editTimeout()
 {
   qDebug() << "editTimeout";
-  controller->loadAllRowsForDistanceSearch();
+  controller->queryDistanceSearch();
 }
 
 void SearchBaseTable::connectSearchSlots()
@@ -40,11 +40,6 @@ SqlController::~SqlController()
 {
   viewSetModel(nullptr);
 
-  if(proxyModel != nullptr)
-    proxyModel->clear();
-  delete proxyModel;
-  proxyModel = nullptr;
-
   if(model != nullptr)
     model->clear();
   delete model;
@@ -56,15 +51,16 @@ void SqlController::preDatabaseLoad()
   viewSetModel(nullptr);
 
   if(model != nullptr)
+  {
     model->clear();
+    model->preDatabaseLoad();
+  }
 }
 
 void SqlController::postDatabaseLoad()
 {
-  if(proxyModel != nullptr)
-    viewSetModel(proxyModel);
-  else
-    viewSetModel(model);
+  viewSetModel(model);
+  model->postDatabaseLoad();
   model->updateSqlQuery();
   model->resetSqlQuery();
   model->fillHeaderData();
@@ -91,10 +87,7 @@ void SqlController::refreshData(bool loadAll, bool keepSelection)
   model->refreshData();
 
   if(loadAll)
-  {
-    while(model->canFetchMore())
-      model->fetchMore(QModelIndex());
-  }
+    model->fetchRowsBlocking(-1);
 
   // Selection changes when updating model
   sm = view->selectionModel();
@@ -105,11 +98,8 @@ void SqlController::refreshData(bool loadAll, bool keepSelection)
 
     // Check if selected rows have to be loaded
     if(maxRow >= visibleRowCount)
-    {
       // Load until done or highest selected row is covered
-      while(model->canFetchMore() && getVisibleRowCount() < maxRow)
-        model->fetchMore(QModelIndex());
-    }
+      model->fetchRowsBlocking(maxRow + 1);
 
     // Update selection in new data result set
     int totalRowCount = getTotalRowCount();
@@ -154,14 +144,14 @@ void SqlController::filterByBuilder()
 void SqlController::filterIncluding(const QModelIndex& index)
 {
   view->clearSelection();
-  model->filterIncluding(toSource(index));
+  model->filterIncluding(index);
   searchParamsChanged = true;
 }
 
 void SqlController::filterExcluding(const QModelIndex& index)
 {
   view->clearSelection();
-  model->filterExcluding(toSource(index));
+  model->filterExcluding(index);
   searchParamsChanged = true;
 }
 
@@ -255,39 +245,21 @@ void SqlController::filterByComboBox(const Column *col, int value, bool noFilter
   searchParamsChanged = true;
 }
 
-void SqlController::filterByDistance(const atools::geo::Pos& center, sqlproxymodel::SearchDirection dir,
+void SqlController::filterByDistance(const atools::geo::Pos& center, sqlmodel::SearchDirection dir,
                                      float minDistance, float maxDistance)
 {
-  if(center.isValid())
-  {
-    // Start or update distance search
-    view->clearSelection();
-
-    currentDistanceCenter = center;
-    atools::geo::Rect rect(center, atools::geo::nmToMeter(maxDistance));
-
-    bool proxyWasNull = false;
-    if(proxyModel == nullptr)
-    {
-      // No proxy - create a new one and assign it to the model
-      proxyWasNull = true;
-      // Controller takes ownership
-      proxyModel = new SqlProxyModel(nullptr, model);
-      proxyModel->setDynamicSortFilter(true);
-      proxyModel->setSourceModel(model);
-
-      viewSetModel(proxyModel);
-    }
-
-    // Update distances in proxy to get precise radius filtering (second filter stage)
-    proxyModel->setDistanceFilter(center, dir, minDistance, maxDistance);
+  view->clearSelection();
+  bool wasDistanceSearch = isDistanceSearch();
+  currentDistanceCenter = center;
 
-    // Update rectangle filter in query model (first coarse filter stage)
-    model->filterByBoundingRect(rect);
+  // Start, update or end distance search - radius and direction are filtered by the query
+  model->filterByDistance(center, dir, minDistance, maxDistance);
 
-    if(proxyWasNull)
+  if(center.isValid())
+  {
+    if(!wasDistanceSearch)
     {
-      // New proxy created so set ordering and more
+      // Distance search started so set ordering and more
       model->fillHeaderData();
       view->reset();
       processViewColumns();
@@ -295,40 +267,20 @@ void SqlController::filterByDistance(const atools::geo::Pos& center, sqlproxymod
   }
   else
   {
-    // End distance search
-    view->clearSelection();
-    currentDistanceCenter = atools::geo::Pos();
-
-    // Set sql model back into view
-    viewSetModel(model);
-
-    if(proxyModel != nullptr)
-    {
-      proxyModel->clear();
-      delete proxyModel;
-      proxyModel = nullptr;
-    }
-
-    model->filterByBoundingRect(atools::geo::Rect());
+    // End distance search - query is run by the model
     model->fillHeaderData();
     processViewColumns();
   }
   searchParamsChanged = true;
 }
 
-void SqlController::filterByDistanceUpdate(sqlproxymodel::SearchDirection dir, float minDistance,
+void SqlController::filterByDistanceUpdate(sqlmodel::SearchDirection dir, float minDistance,
                                            float maxDistance)
 {
-  if(proxyModel != nullptr)
+  if(isDistanceSearch())
   {
     view->clearSelection();
-    // Create new bounding rectangle for first stage search
-    atools::geo::Rect rect(currentDistanceCenter, atools::geo::nmToMeter(maxDistance));
-
-    // Update proxy second stage filter
-    proxyModel->setDistanceFilter(currentDistanceCenter, dir, minDistance, maxDistance);
-    // Update SQL model coarse first stage filter
-    model->filterByBoundingRect(rect);
+    model->filterByDistance(currentDistanceCenter, dir, minDistance, maxDistance);
     searchParamsChanged = true;
   }
 }
@@ -363,10 +315,7 @@ const QItemSelection SqlController::getSelection() const
 
 int SqlController::getVisibleRowCount() const
 {
-  if(proxyModel != nullptr)
-    // Proxy fine second stage filter knows precise count
-    return proxyModel->rowCount();
-  else if(model != nullptr)
+  if(model != nullptr)
     return model->rowCount();
 
   return 0;
@@ -374,10 +323,7 @@ int SqlController::getVisibleRowCount() const
 
 int SqlController::getTotalRowCount() const
 {
-  if(proxyModel != nullptr)
-    // Proxy fine second stage filter knows precise count
-    return proxyModel->rowCount();
-  else if(model != nullptr)
+  if(model != nullptr)
     return model->getTotalRowCount();
   else
     return 0;
@@ -411,12 +357,12 @@ void SqlController::resetView()
   for(int i = 0; i < header->count(); i++)
     header->moveSection(header->visualIndex(i), i);
 
-  if(proxyModel != nullptr)
+  if(isDistanceSearch())
   {
-    // For distance search switch back to distance column sort - tell proxy ...
-    proxyModel->sort(0, Qt::DescendingOrder);
-    // ... and adjust query
-    model->setSort("distance", Qt::DescendingOrder);
+    // For distance search switch back to distance column sort with nearest first
+    model->setSort("distance", Qt::AscendingOrder);
+    model->updateSqlQuery();
+    model->resetSqlQuery();
   }
   else
     model->resetSort();
@@ -429,7 +375,7 @@ void SqlController::resetView()
 void SqlController::resetSearch()
 {
   if(columns != nullptr)
-    // Will also delete proxy by check box message
+    // Will also end distance search by check box message
     columns->resetWidgets();
 
   if(model != nullptr)
@@ -448,29 +394,13 @@ QModelIndex SqlController::getModelIndexAt(const QPoint& pos) const
 
 QString SqlController::getFieldDataAt(const QModelIndex& index) const
 {
-  return model->getFormattedFieldData(toSource(index)).toString();
-}
-
-QModelIndex SqlController::toSource(const QModelIndex& index) const
-{
-  if(proxyModel != nullptr)
-    return proxyModel->mapToSource(index);
-  else
-    return index;
-}
-
-QModelIndex SqlController::fromSource(const QModelIndex& index) const
-{
-  if(proxyModel != nullptr)
-    return proxyModel->mapFromSource(index);
-  else
-    return index;
+  return model->getFormattedFieldData(index).toString();
 }
 
 int SqlController::getIdForRow(const QModelIndex& index)
 {
   if(index.isValid())
-    return model->getRawData(toSource(index).row(), columns->getIdColumnName()).toInt();
+    return model->getRawData(index.row(), columns->getIdColumnName()).toInt();
   else
     return -1;
 }
@@ -546,23 +476,12 @@ void SqlController::prepareModel()
   processViewColumns();
 }
 
-void SqlController::loadAllRowsForDistanceSearch()
+void SqlController::queryDistanceSearch()
 {
-  if(searchParamsChanged && proxyModel != nullptr)
+  if(searchParamsChanged && isDistanceSearch())
   {
-    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
-
-    // Run query again
+    // Run query again - only the first page is fetched
     model->resetSqlQuery();
-
-    // Let proxy know that filter parameters have changed
-    proxyModel->invalidate();
-
-    while(model->canFetchMore())
-      // Fetch as long as we can
-      model->fetchMore(QModelIndex());
-
-    QGuiApplication::restoreOverrideCursor();
     searchParamsChanged = false;
   }
 }
@@ -577,17 +496,14 @@ void SqlController::loadAllRows()
 {
   QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
-  if(proxyModel != nullptr)
+  if(isDistanceSearch() && searchParamsChanged)
   {
-    // Run query again
+    // Run delayed query
     model->resetSqlQuery();
-
-    // Let proxy know that filter parameters have changed
-    proxyModel->invalidate();
+    searchParamsChanged = false;
   }
 
-  while(model->canFetchMore())
-    model->fetchMore(QModelIndex());
+  model->fetchRowsBlocking(-1);
 
   QGuiApplication::restoreOverrideCursor();
 }
@@ -611,21 +527,13 @@ void SqlController::initRecord(atools::sql::SqlRecord& rec)
 
 bool SqlController::hasRow(int row) const
 {
-  int srow = row;
-  if(proxyModel != nullptr)
-    srow = toSource(proxyModel->index(row, 0)).row();
-
-  return model->hasIndex(srow, 0);
+  return model->hasIndex(row, 0);
 }
 
 void SqlController::fillRecord(int row, atools::sql::SqlRecord& rec)
 {
-  int srow = row;
-  if(proxyModel != nullptr)
-    srow = toSource(proxyModel->index(row, 0)).row();
-
   for(int i = 0; i < rec.count(); i++)
-    rec.setValue(i, model->getRawData(srow, i));
+    rec.setValue(i, model->getRawData(row, i));
 }
 
 QVariant SqlController::getRawData(int row, const QString& colname) const
@@ -635,10 +543,7 @@ QVariant SqlController::getRawData(int row, const QString& colname) const
 
 QVariant SqlController::getRawData(int row, int col) const
 {
-  int srow = row;
-  if(proxyModel != nullptr)
-    srow = toSource(proxyModel->index(row, 0)).row();
-  return model->getRawData(srow, col);
+  return model->getRawData(row, col);
 }
 
 QVariant SqlController::getRawDataLocal(int row, const QString& colname) const
@@ -19,7 +19,6 @@
 #define LITTLENAVMAP_CONTROLLER_H
 
 #include "search/sqlmodel.h"
-#include "search/sqlproxymodel.h"
 
 namespace atools {
 namespace geo {
@@ -141,19 +140,20 @@ public:
   void filterByRecord(const atools::sql::SqlRecord& record);
 
   /* Start or end distance search depending if center is valid or not */
-  void filterByDistance(const atools::geo::Pos& center, sqlproxymodel::SearchDirection dir,
+  void filterByDistance(const atools::geo::Pos& center, sqlmodel::SearchDirection dir,
                         float minDistance, float maxDistance);
 
   /* Update distance search for changed values from spin box widgets */
-  void filterByDistanceUpdate(sqlproxymodel::SearchDirection dir, float minDistance, float maxDistance);
+  void filterByDistanceUpdate(sqlmodel::SearchDirection dir, float minDistance, float maxDistance);
 
-  /* Load all rows if a distance search is active. */
-  void loadAllRowsForDistanceSearch();
+  /* Run the query if a distance search is active and parameters have changed.
+   * Rows are fetched on demand like for all other searches. */
+  void queryDistanceSearch();
 
   /* True if distance search is active */
   bool isDistanceSearch()
   {
-    return proxyModel != nullptr;
+    return model != nullptr && model->isDistanceSearch();
   }
 
   /* Set the callback that will handle data rows and values, i.e. format values to strings.
@@ -204,17 +204,6 @@ private:
   /* Adapt columns to query change */
   void processViewColumns();
 
-  /* Convert indexes if proxy model for distance search is used */
-  QModelIndex toSource(const QModelIndex& index) const;
-  QModelIndex fromSource(const QModelIndex& index) const;
-
-  /* Proxy model used to distance search. null if distance search is not active.
-   * While the normal SQL model acts as a primary (rectangle based) filter the proxy
-   * model will do proper min/max radius filtering at a secondary stage.
-   * To get correct results all rows have to be loaded from the SQL model and have to be piped through the
-   * proxy model. */
-  SqlProxyModel *proxyModel = nullptr;
-
   SqlModel *model = nullptr;
   QWidget *parentWidget = nullptr;
   atools::sql::SqlDatabase *db = nullptr;
@@ -17,6 +17,9 @@
 
 #include "search/sqlmodel.h"
 
+#include "common/mapflags.h"
+#include "common/unit.h"
+#include "geo/calculations.h"
 #include "gui/application.h"
 #include "gui/errorhandler.h"
 #include "sql/sqldatabase.h"
@@ -25,29 +28,147 @@
 #include "search/column.h"
 #include "search/columnlist.h"
 #include "sql/sqlrecord.h"
+#include "query/querytypes.h"
 
+#include <QApplication>
 #include <QLineEdit>
 #include <QCheckBox>
+#include <QMessageBox>
 #include <QSqlError>
+#include <QSqlQuery>
 #include <QRegularExpression>
 #include <QComboBox>
 
+#include <algorithm>
+#include <cmath>
+
 using atools::sql::SqlQuery;
 using atools::sql::SqlDatabase;
 using atools::gui::ErrorHandler;
 using atools::sql::SqlRecord;
 
+/* Direction filter ranges are decreased by this value on each side */
+const static double DIR_RANGE_DEG = 22.5;
+
+/* Number of rows loaded for each fetchMore() call */
+const static int FETCH_PAGE_SIZE = 256;
+
 SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *columnList)
-  : QSqlQueryModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
+  : QAbstractTableModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
 {
+  qRegisterMetaType<sqlmodel::PageRequest>();
+  qRegisterMetaType<sqlmodel::PageResult>();
+
+  // Connection name has to be unique for each search table
+  worker = new SqlModelWorker("LNMDBSEARCH" + columns->getTablename().toUpper());
+  worker->moveToThread(&thread);
+
+  connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+  connect(this, &SqlModel::pageRequested, worker, &SqlModelWorker::fetchPage, Qt::QueuedConnection);
+  connect(this, &SqlModel::countRequested, worker, &SqlModelWorker::countRows, Qt::QueuedConnection);
+  connect(this, &SqlModel::unitVectorsRequested, worker, &SqlModelWorker::createUnitVectors, Qt::QueuedConnection);
+  connect(this, &SqlModel::initDatabaseRequested, worker, &SqlModelWorker::initDatabase,
+          Qt::BlockingQueuedConnection);
+  connect(this, &SqlModel::deInitDatabaseRequested, worker, &SqlModelWorker::deInitDatabase,
+          Qt::BlockingQueuedConnection);
+  connect(worker, &SqlModelWorker::pageFinished, this, &SqlModel::pageFinished, Qt::QueuedConnection);
+  connect(worker, &SqlModelWorker::countFinished, this, &SqlModel::countFinished, Qt::QueuedConnection);
+
+  thread.setObjectName("SqlModel " + columns->getTablename());
+  thread.start();
+
   // Set default handler
   setDataCallback(nullptr, QSet<Qt::ItemDataRole>());
 
+  postDatabaseLoad();
   buildQuery();
 }
 
 SqlModel::~SqlModel()
 {
+  preDatabaseLoad();
+
+  // Worker is deleted in thread when finished
+  thread.quit();
+  thread.wait();
+}
+
+void SqlModel::preDatabaseLoad()
+{
+  newRequest();
+
+  if(workerDatabaseOpen)
+  {
+    // Waits for a running query
+    emit deInitDatabaseRequested();
+    workerDatabaseOpen = false;
+  }
+}
+
+void SqlModel::postDatabaseLoad()
+{
+  if(!workerDatabaseOpen && db->isOpen())
+  {
+    emit initDatabaseRequested(db->databaseName());
+
+    // Queries are run in the GUI thread if the connection cannot be opened
+    workerDatabaseOpen = worker->isDatabaseOpen();
+  }
+}
+
+void SqlModel::newRequest()
+{
+  requestId++;
+  worker->currentRequestId.store(requestId);
+  pagePending = false;
+}
+
+void SqlModel::clear()
+{
+  newRequest();
+
+  beginResetModel();
+  rows.clear();
+  sqlRecord.clear();
+  sqlRecordQuery.clear();
+  headers.clear();
+  atEnd = true;
+  rowsOutdated = false;
+  totalRowCount = 0;
+  endResetModel();
+}
+
+int SqlModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : rows.size();
+}
+
+int SqlModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : sqlRecord.count();
+}
+
+QVariant SqlModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if(orientation == Qt::Horizontal && (role == Qt::DisplayRole || role == Qt::EditRole))
+  {
+    // Use field name if no caption is set
+    QVariant value = headers.value(section);
+    if(!value.isValid() && section >= 0 && section < sqlRecord.count())
+      value = sqlRecord.fieldName(section);
+    return value;
+  }
+  return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool SqlModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant& value, int role)
+{
+  if(orientation != Qt::Horizontal || section < 0 || (role != Qt::DisplayRole && role != Qt::EditRole))
+    return false;
+
+  headers.insert(section, value);
+  emit headerDataChanged(orientation, section, section);
+  return true;
 }
 
 void SqlModel::filterByBuilder()
@@ -68,9 +189,19 @@ void SqlModel::filterExcluding(QModelIndex index)
   buildQuery();
 }
 
-void SqlModel::filterByBoundingRect(const atools::geo::Rect& boundingRectangle)
+void SqlModel::filterByDistance(const atools::geo::Pos& center, sqlmodel::SearchDirection dir,
+                                float minDistance, float maxDistance)
 {
-  boundingRect = boundingRectangle;
+  distanceCenter = center;
+  distanceDirection = dir;
+  minDistanceNm = minDistance;
+  maxDistanceNm = maxDistance;
+
+  if(center.isValid())
+    boundingRect = atools::geo::Rect(center, atools::geo::nmToMeter(maxDistance));
+  else
+    boundingRect = atools::geo::Rect();
+
   buildQuery();
 }
 
@@ -84,7 +215,7 @@ void SqlModel::filterByRecord(const atools::sql::SqlRecord& record)
 void SqlModel::filterBy(QModelIndex index, bool exclude)
 {
   QString whereCol = getSqlRecord().fieldName(index.column());
-  filterBy(exclude, whereCol, QSqlQueryModel::data(index));
+  filterBy(exclude, whereCol, getRawData(index.row(), index.column()));
 }
 
 /* Simple include/exclude filter. Updates the attached search widgets */
@@ -333,6 +464,7 @@ void SqlModel::clearWhereConditions()
 {
   whereConditionMap.clear();
   boundingRect = atools::geo::Rect();
+  distanceCenter = atools::geo::Pos();
 }
 
 /* Set header captions */
@@ -343,7 +475,7 @@ void SqlModel::fillHeaderData()
   for(int i = 0; i < cnt; i++)
   {
     const Column *cd = columns->getColumn(sqlRecord.fieldName(i));
-    if(!cd->isHidden() && !(!boundingRect.isValid() && cd->isDistance()))
+    if(!cd->isHidden() && !(!isDistanceSearch() && cd->isDistance()))
       setHeaderData(i, Qt::Horizontal, cd->getDisplayName());
   }
 }
@@ -384,15 +516,29 @@ void SqlModel::sort(int column, Qt::SortOrder order)
   orderByOrder = sortOrderToSql(order);
 
   buildQuery();
+
+  if(isDistanceSearch())
+    // Query is not run automatically for distance search
+    resetSqlQuery();
 }
 
 /* Build full list of columns to query */
-QString SqlModel::buildColumnList(const atools::sql::SqlRecord& tableCols)
+QString SqlModel::buildColumnList(const atools::sql::SqlRecord& tableCols, bool distanceColumns)
 {
   QVector<QString> colNames;
   for(const Column *col : columns->getColumns())
   {
-    if(col->isDistance() || !tableCols.contains(col->getColumnName()))
+    if(distanceColumns && col->getColumnName() == "distance")
+      // Order key which increases with great circle distance - displayed value is calculated in data()
+      colNames.append("1. - dist_dot as distance");
+    else if(distanceColumns && col->getColumnName() == "heading")
+      // Pseudo angle from 0 to 4 which increases with the true course from the center - "diamond angle"
+      colNames.append("case when dist_east >= 0 then "
+                      "(case when dist_north >= 0 then dist_east / (dist_east + dist_north) "
+                      "else 1. - dist_north / (dist_east - dist_north) end) "
+                      "else (case when dist_north <= 0 then 2. - dist_east / (-dist_east - dist_north) "
+                      "else 3. + dist_north / (dist_north - dist_east) end) end as heading");
+    else if(col->isDistance() || !tableCols.contains(col->getColumnName()))
       // Add null for special distance columns
       // Null for columns which do not exist in the database
       colNames.append("null as " + col->getColumnName());
@@ -420,19 +566,24 @@ void SqlModel::buildQuery()
   QString tablename = columns->getTablename();
 
   atools::sql::SqlRecord tableCols = db->record(tablename);
-  QString queryCols = buildColumnList(tableCols);
+  QString distanceJoin = buildDistanceJoin();
+  QString queryCols = buildColumnList(tableCols, hasDistanceVectors);
 
   QVector<const Column *> overrideColumns;
   QString queryWhere = buildWhere(tableCols, overrideColumns);
 
-  QString queryOrder;
+  // Sort key is an expression on the result columns which is used for keyset paging
+  QString orderKey;
   const Column *col = columns->getColumn(orderByCol);
-  // Distance columns are no search criteria
-  if(!orderByCol.isEmpty() && !orderByOrder.isEmpty() && !col->isDistance())
+  // Distance columns are only sort criteria when distance search is active
+  if(!orderByCol.isEmpty() && !orderByOrder.isEmpty() && !(col->isDistance() && !hasDistanceVectors))
   {
     Q_ASSERT(col != nullptr);
 
-    if(!tableCols.contains(orderByCol))
+    if(col->isDistance())
+      // Use alias of calculated column
+      orderKey = orderByCol;
+    else if(!tableCols.contains(orderByCol))
     {
       // Skip not existing columns for backwards compatibility
       qWarning() << Q_FUNC_INFO << tablename + "." + col->getColumnName() << "does not exist";
@@ -441,40 +592,41 @@ void SqlModel::buildQuery()
     {
       // Use sort functions to have null values at end of the list - will avoid indexes
       if(orderByOrder == "asc")
-        queryOrder += "order by " + col->getSortFuncAsc().arg(orderByCol) + " " + orderByOrder;
+        orderKey = col->getSortFuncAsc().arg(orderByCol);
       else if(orderByOrder == "desc")
-        queryOrder += "order by " + col->getSortFuncDesc().arg(orderByCol) + " " + orderByOrder;
+        orderKey = col->getSortFuncDesc().arg(orderByCol);
       else
         Q_ASSERT(orderByOrder != "asc" && orderByOrder != "desc");
     }
     else
-      queryOrder += "order by " + orderByCol + " " + orderByOrder;
+      orderKey = orderByCol;
   }
+  currentOrderKey = orderKey;
+  currentOrderDesc = orderByOrder == "desc";
 
-  currentSqlQuery = "select " + queryCols + " from " + tablename +
-                    " " + queryWhere + " " + queryOrder;
+  // Id as tie breaker gives a unique order
+  QString idCol = columns->getIdColumnName();
+  currentSqlPageQuery = "select " + queryCols + ", " + idCol + " as page_id from " + tablename + distanceJoin +
+                        " " + queryWhere;
+  currentSqlQuery = "select " + queryCols + " from " + tablename + distanceJoin + " " + queryWhere + " order by " +
+                    (orderKey.isEmpty() ? QString() : orderKey + " " + orderByOrder + ", ") + idCol + " " +
+                    (currentOrderDesc ? "desc" : "asc");
 
   // Build a query to find the total row count of the result ==================
-  totalRowCount = 0;
-  currentSqlCountQuery = "select count(1) from " + tablename + " " + queryWhere;
+  // Rows are counted by stepping through the result which allows to interrupt the count
+  currentSqlCountQuery = "select 1 from " + tablename + distanceJoin + " " + queryWhere;
 
   // Build a query to fetch the whole result set in getFullResultSet() ==================
-  if(!boundingRect.isValid())
-  {
-    QStringList colList(columns->getIdColumnName());
-
-    // Add coordinates if available
-    if(columns->hasColumn("lonx") && columns->hasColumn("laty"))
-    {
-      colList.append("lonx");
-      colList.append("laty");
-    }
+  QStringList colList(columns->getIdColumnName());
 
-    currentSqlFetchQuery = "select " + colList.join(", ") + " from " + tablename + " " + queryWhere;
+  // Add coordinates if available
+  if(columns->hasColumn("lonx") && columns->hasColumn("laty"))
+  {
+    colList.append("lonx");
+    colList.append("laty");
   }
-  else
-    // No result set for distance searches since the result is not filtered by precise distance
-    currentSqlFetchQuery.clear();
+
+  currentSqlFetchQuery = "select " + colList.join(", ") + " from " + tablename + distanceJoin + " " + queryWhere;
 
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << currentSqlQuery;
@@ -491,11 +643,10 @@ void SqlModel::buildQuery()
 
   try
   {
-    // Count total rows
-    updateTotalCount();
+    updateRecord("select " + queryCols + " from " + tablename + distanceJoin);
 
-    if(!boundingRect.isValid())
-      // Delay query for bounding rectangle query with proxy model
+    if(!isDistanceSearch())
+      // Delay query for distance search which is run by the controller after editing
       resetSqlQuery();
   }
   catch(atools::Exception& e)
@@ -510,16 +661,14 @@ void SqlModel::buildQuery()
 
 void SqlModel::updateTotalCount()
 {
-  if(!currentSqlCountQuery.isEmpty())
-  {
-    SqlQuery countStmt(db);
-    countStmt.exec(currentSqlCountQuery);
-    if(countStmt.next())
-      totalRowCount = countStmt.value(0).toInt();
-    else
-      totalRowCount = 0;
-  }
-  else
+  if(atEnd)
+    // All rows loaded - no need to count
+    totalRowCount = rows.size();
+  else if(workerDatabaseOpen)
+    // Count in background - result arrives with countFinished
+    emit countRequested(requestId, activeSqlCountQuery);
+  else if(activeSqlCountQuery.isEmpty() ||
+          !sqlmodel::countRows(db->getQSqlDatabase(), activeSqlCountQuery, totalRowCount))
     totalRowCount = 0;
 }
 
@@ -615,6 +764,11 @@ QString SqlModel::buildWhere(const atools::sql::SqlRecord& tableCols, QVector<co
     if(!queryWhere.isEmpty())
       queryWhere += WHERE_OPERATOR;
     queryWhere += rectCond;
+
+    // Precise radius and direction filter
+    QString distanceCond = buildDistanceWhere();
+    if(!distanceCond.isEmpty())
+      queryWhere += WHERE_OPERATOR + distanceCond;
   }
 
   if(!queryWhere.isEmpty())
@@ -623,6 +777,74 @@ QString SqlModel::buildWhere(const atools::sql::SqlRecord& tableCols, QVector<co
   return queryWhere;
 }
 
+/* Joins the table with a subquery on the unit vectors giving the dot product with the center (cosine of the
+ * angular distance) and the components in north and east direction at the center for each row */
+QString SqlModel::buildDistanceJoin()
+{
+  hasDistanceVectors = false;
+  if(!isDistanceSearch())
+    return QString();
+
+  // Unit vectors are usually created with the spatial index file - fall back to a temporary table in memory
+  QString tablename = columns->getTablename(), idColumn = columns->getIdColumnName();
+  if(!query::createUnitVectorTempTable(db, tablename, idColumn))
+  {
+    // Only rectangle search possible - do not hide that results are not filtered by distance
+    if(!distanceWarningShown)
+    {
+      distanceWarningShown = true;
+      QMessageBox::warning(parentWidget, QApplication::applicationName(),
+                           tr("Cannot prepare the distance search.\n"
+                              "Results are not filtered by distance and direction and cannot be sorted by distance."));
+    }
+    return QString();
+  }
+
+  // Worker connection needs the same temporary table - queued before the page requests
+  if(workerDatabaseOpen)
+    emit unitVectorsRequested(tablename, idColumn);
+
+  hasDistanceVectors = true;
+  return query::unitVectorJoin(tablename, idColumn, distanceCenter);
+}
+
+/* Where clause for minimum and maximum radius and direction using the values from the distance join */
+QString SqlModel::buildDistanceWhere() const
+{
+  if(!hasDistanceVectors)
+    return QString();
+
+  QStringList cond(query::unitVectorRadiusWhere(minDistanceNm, maxDistanceNm));
+
+  // Direction as angle between north and east components: e.g. north is cos(course) >= sin(22.5)
+  // and is compared squared to avoid square roots
+  QString sinSq = QString::number(std::pow(std::sin(atools::geo::toRadians(DIR_RANGE_DEG)), 2.), 'g', 17);
+  QString lenSq = "(dist_north * dist_north + dist_east * dist_east)";
+  switch(distanceDirection)
+  {
+    case sqlmodel::ALL:
+      break;
+
+    case sqlmodel::NORTH:
+      cond.append("dist_north >= 0 and dist_north * dist_north >= " + sinSq + " * " + lenSq);
+      break;
+
+    case sqlmodel::EAST:
+      cond.append("dist_east >= 0 and dist_east * dist_east >= " + sinSq + " * " + lenSq);
+      break;
+
+    case sqlmodel::SOUTH:
+      cond.append("dist_north <= 0 and dist_north * dist_north >= " + sinSq + " * " + lenSq);
+      break;
+
+    case sqlmodel::WEST:
+      cond.append("dist_east <= 0 and dist_east * dist_east >= " + sinSq + " * " + lenSq);
+      break;
+  }
+
+  return "(" + cond.join(WHERE_OPERATOR) + ")";
+}
+
 /* Convert a value to string for the where clause */
 QString SqlModel::buildWhereValue(const WhereCondition& cond)
 {
@@ -640,16 +862,179 @@ QString SqlModel::buildWhereValue(const WhereCondition& cond)
 
 void SqlModel::refreshData()
 {
-  resetSqlQuery();
-  updateTotalCount();
+  startQuery();
+  fetchRowsBlocking(FETCH_PAGE_SIZE);
+}
+
+void SqlModel::startQuery()
+{
+  newRequest();
+  rowsOutdated = true;
+  totalRowCount = -1;
+
+  // Query might be changed by filters before all pages are loaded
+  activeSqlQuery = currentSqlPageQuery;
+  activeSqlCountQuery = currentSqlCountQuery;
+  activeOrderKey = currentOrderKey;
+  activeOrderDesc = currentOrderDesc;
 }
 
 void SqlModel::resetSqlQuery()
 {
-  QSqlQueryModel::setQuery(currentSqlQuery, db->getQSqlDatabase());
+  startQuery();
+
+  if(workerDatabaseOpen)
+  {
+    // Old rows stay visible until the first page arrives
+    pagePending = true;
+    emit pageRequested(pageRequest(0));
+  }
+  else
+    fetchRowsBlocking(FETCH_PAGE_SIZE);
+}
+
+void SqlModel::updateRecord(const QString& recordQuery)
+{
+  if(recordQuery == sqlRecordQuery && !sqlRecord.isEmpty())
+    return;
+
+  // Limit 0 only prepares the statement and returns the columns without running the query
+  QSqlQuery query(db->getQSqlDatabase());
+  if(!query.exec(recordQuery + " limit 0"))
+  {
+    atools::gui::ErrorHandler(parentWidget).handleSqlError(query.lastError());
+    return;
+  }
+
+  QSqlRecord rec = query.record();
+  query.finish();
+  sqlRecordQuery = recordQuery;
+
+  if(rec.count() != sqlRecord.count())
+  {
+    // Columns changed - drop rows
+    beginResetModel();
+    sqlRecord = rec;
+    rows.clear();
+    atEnd = true;
+    endResetModel();
+  }
+  else
+    sqlRecord = rec;
+}
+
+sqlmodel::PageRequest SqlModel::pageRequest(int offset) const
+{
+  sqlmodel::PageRequest request;
+  request.requestId = requestId;
+  request.query = activeSqlQuery;
+  request.orderKey = activeOrderKey;
+  request.descending = activeOrderDesc;
+  request.offset = offset;
+  request.limit = FETCH_PAGE_SIZE;
+
+  if(offset > 0)
+  {
+    // Continue after last loaded row
+    request.afterKey = lastKey;
+    request.afterId = lastId;
+  }
+  return request;
+}
+
+void SqlModel::applyPage(const sqlmodel::PageResult& result)
+{
+  if(result.offset == 0)
+  {
+    // First page of a new query
+    beginResetModel();
+    rows = result.rows;
+    atEnd = result.atEnd;
+    rowsOutdated = false;
+    lastKey = result.lastKey;
+    lastId = result.lastId;
+    endResetModel();
+  }
+  else if(result.offset == rows.size() && !rowsOutdated)
+  {
+    if(!result.rows.isEmpty())
+    {
+      beginInsertRows(QModelIndex(), rows.size(), rows.size() + result.rows.size() - 1);
+      rows.append(result.rows);
+      lastKey = result.lastKey;
+      lastId = result.lastId;
+      endInsertRows();
+    }
+    atEnd = result.atEnd;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Page at offset" << result.offset << "does not match rows" << rows.size();
+
+  if(atEnd)
+    // Count is known now
+    totalRowCount = rows.size();
+}
+
+void SqlModel::pageFinished(const sqlmodel::PageResult& result)
+{
+  if(result.requestId != requestId)
+    // Outdated
+    return;
+
+  pagePending = false;
+
+  if(result.error.isValid())
+  {
+    atEnd = true;
+    atools::gui::ErrorHandler(parentWidget).handleSqlError(result.error);
+    return;
+  }
+
+  applyPage(result);
+
+  if(result.offset == 0 && totalRowCount < 0)
+    // Count only if the result has more than one page
+    updateTotalCount();
+
+  emit fetchedMore();
+}
+
+void SqlModel::countFinished(int id, int count)
+{
+  if(id == requestId && totalRowCount < 0)
+  {
+    totalRowCount = count;
+    emit fetchedMore();
+  }
+}
+
+void SqlModel::fetchRowsBlocking(int minRows)
+{
+  if(!rowsOutdated && (atEnd || (minRows >= 0 && rows.size() >= minRows)))
+    return;
+
+  // Cancel pending pages and count which would not match the rows loaded here
+  newRequest();
+
+  sqlmodel::PageRequest request = pageRequest(rowsOutdated ? 0 : rows.size());
+  request.limit = minRows < 0 ? -1 : std::max(minRows - request.offset, FETCH_PAGE_SIZE);
+
+  sqlmodel::PageResult result;
+  sqlmodel::readPage(db->getQSqlDatabase(), request, result);
+
+  if(result.error.isValid())
+  {
+    atEnd = true;
+    atools::gui::ErrorHandler(parentWidget).handleSqlError(result.error);
+    return;
+  }
+
+  applyPage(result);
 
-  if(lastError().isValid())
-    atools::gui::ErrorHandler(parentWidget).handleSqlError(lastError());
+  if(totalRowCount < 0)
+    updateTotalCount();
+
+  emit fetchedMore();
 }
 
 Qt::SortOrder SqlModel::getSortOrder() const
@@ -674,34 +1059,72 @@ QVariant SqlModel::data(const QModelIndex& index, int role) const
 
   Qt::ItemDataRole dataRole = static_cast<Qt::ItemDataRole>(role);
 
-  // Get the default value for this role. Can be a font, color, etc.
-  QVariant roleValue = QSqlQueryModel::data(index, role);
+  if(isDistanceSearch() && (role == Qt::DisplayRole || role == Qt::TextAlignmentRole))
+  {
+    // Distance and heading columns contain only order keys - calculate precise values for display
+    const Column *column = getColumnModel(index.column());
+    if(column->isDistance())
+      return distanceData(index.row(), column, role);
+  }
+
+  // Get the default value for this role. Only display and edit roles have values.
+  QVariant roleValue;
+  if(role == Qt::DisplayRole || role == Qt::EditRole)
+    roleValue = getRawData(index.row(), index.column());
 
   if(handlerRoles.contains(dataRole))
   {
     // Callback wants to be called for this role
 
     // Get data to display
-    QVariant dataValue = QSqlQueryModel::data(index, Qt::DisplayRole);
+    QVariant dataValue = getRawData(index.row(), index.column());
     QString col = getSqlRecord().fieldName(index.column());
     const Column *column = columns->getColumn(col);
 
-    int row = -1;
-    if(!boundingRect.isValid())
-      // no reliable row information with proxy
-      row = index.row();
-
-    QVariant retval = dataFunction(index.column(), row, column, roleValue, dataValue, dataRole);
+    QVariant retval = dataFunction(index.column(), index.row(), column, roleValue, dataValue, dataRole);
     if(retval.isValid())
       return retval;
   }
   return roleValue;
 }
 
+QVariant SqlModel::distanceData(int row, const Column *col, int role) const
+{
+  if(role == Qt::TextAlignmentRole)
+    return Qt::AlignRight;
+  else if(role == Qt::DisplayRole)
+  {
+    atools::geo::Pos pos(getRawData(row, "lonx").toFloat(), getRawData(row, "laty").toFloat());
+
+    if(col->getColumnName() == "distance")
+      return Unit::distMeter(pos.distanceMeterTo(distanceCenter), false);
+    else if(col->getColumnName() == "heading")
+    {
+      float heading = atools::geo::normalizeCourse(distanceCenter.angleDegTo(pos));
+      if(heading < map::INVALID_COURSE_VALUE)
+        return QLocale().toString(heading, 'f', 0);
+    }
+  }
+  return QVariant();
+}
+
+bool SqlModel::canFetchMore(const QModelIndex& parent) const
+{
+  return !parent.isValid() && !atEnd && !rowsOutdated && !pagePending;
+}
+
 void SqlModel::fetchMore(const QModelIndex& parent)
 {
-  QSqlQueryModel::fetchMore(parent);
-  emit fetchedMore();
+  if(!canFetchMore(parent))
+    return;
+
+  if(workerDatabaseOpen)
+  {
+    pagePending = true;
+    emit pageRequested(pageRequest(rows.size()));
+  }
+  else
+    fetchRowsBlocking(rows.size() + FETCH_PAGE_SIZE);
 }
 
 QVariant SqlModel::getRawData(int row, const QString& colname) const
@@ -716,7 +1139,18 @@ void SqlModel::updateSqlQuery()
 
 QVariant SqlModel::getRawData(int row, int col) const
 {
-  return QSqlQueryModel::data(createIndex(row, col));
+  if(row >= 0 && row < rows.size() && col >= 0 && col < rows.at(row).size())
+    return rows.at(row).at(col);
+  else
+    return QVariant();
+}
+
+QSqlRecord SqlModel::record(int row) const
+{
+  QSqlRecord rec(sqlRecord);
+  for(int i = 0; i < rec.count(); i++)
+    rec.setValue(i, getRawData(row, i));
+  return rec;
 }
 
 QString SqlModel::getColumnName(int col) const
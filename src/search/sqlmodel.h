@@ -18,11 +18,15 @@
 #ifndef LITTLENAVMAP_SQLMODEL_H
 #define LITTLENAVMAP_SQLMODEL_H
 
+#include "geo/pos.h"
 #include "geo/rect.h"
 
 #include "search/querybuilder.h"
+#include "search/sqlmodelworker.h"
 
-#include <QSqlQueryModel>
+#include <QAbstractTableModel>
+#include <QSqlRecord>
+#include <QThread>
 
 namespace atools {
 namespace sql {
@@ -35,11 +39,32 @@ class SqlRecord;
 class Column;
 class ColumnList;
 
+namespace sqlmodel {
+
+/* Search direction. This is not the precise direction but an approximation where the ranges overlap.
+ * E.g. EAST is 22.5f <= heading && heading <= 157.5f */
+enum SearchDirection
+{
+  /* Numbers have to match index in the combo box */
+  ALL = 0,
+  NORTH = 1,
+  EAST = 2,
+  SOUTH = 3,
+  WEST = 4
+};
+
+}
+
 /*
- * Extends the QSqlQueryModel and adds query building based on filters and ordering.
+ * Table model for the search result which adds query building based on filters and ordering.
+ *
+ * Queries are run in a worker thread using an own database connection. Rows are loaded in pages on demand
+ * and replace the old result when the first page arrives. A new query cancels all pending pages of older
+ * queries. The total row count is queried after the first page if the result has more rows.
+ * Operations which need the rows immediately like loading all rows use a blocking fallback in the GUI thread.
  */
 class SqlModel :
-  public QSqlQueryModel
+  public QAbstractTableModel
 {
   Q_OBJECT
 
@@ -85,8 +110,7 @@ public:
   /* Get field data formatted for display as seen in the table view */
   QVariant getFormattedFieldData(const QModelIndex& index) const;
 
-  /* Query the full result set into a vector of pairs with id and optional coordinates.
-   * This does not work when using distance search. */
+  /* Query the full result set into a vector of pairs with id and optional coordinates. */
   void getFullResultSet(QVector<std::pair<int, atools::geo::Pos> >& result);
 
   Qt::SortOrder getSortOrder() const;
@@ -101,9 +125,10 @@ public:
     return orderByColIndex;
   }
 
+  /* Number of rows of the whole result. Number of loaded rows until the count query returns. */
   int getTotalRowCount() const
   {
-    return totalRowCount;
+    return totalRowCount >= 0 ? totalRowCount : rows.size();
   }
 
   QString getCurrentSqlQuery() const
@@ -111,8 +136,27 @@ public:
     return currentSqlQuery;
   }
 
-  /* Fetch more data and emit signal fetchedMore */
+  /* Request the next page from the worker. Signal fetchedMore is emitted when it arrives. */
   virtual void fetchMore(const QModelIndex& parent) override;
+  virtual bool canFetchMore(const QModelIndex& parent = QModelIndex()) const override;
+
+  /* Load rows in the GUI thread until at least minRows are loaded or the result is complete.
+   * Loads all rows if minRows is -1. Cancels pending requests. */
+  void fetchRowsBlocking(int minRows);
+
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+  virtual QVariant headerData(int section, Qt::Orientation orientation,
+                              int role = Qt::DisplayRole) const override;
+  virtual bool setHeaderData(int section, Qt::Orientation orientation, const QVariant& value,
+                             int role = Qt::EditRole) override;
+
+  /* Remove all rows and columns and cancel pending requests */
+  void clear();
+
+  /* Close and open worker database connection */
+  void preDatabaseLoad();
+  void postDatabaseLoad();
 
   /* Get unformatted data from the model */
   QVariant getRawData(int row, int col) const;
@@ -120,10 +164,26 @@ public:
 
   /* Sets the SQL query into the model. This will start the query and fetch data from the database. */
   void updateSqlQuery();
+
+  /* Run the current query in the worker thread. Rows are replaced once the first page is loaded. */
   void resetSqlQuery();
 
-  /* Set a filter for objects within the given bounding rectangle */
-  void filterByBoundingRect(const atools::geo::Rect& boundingRectangle);
+  /*
+   * Sets new distance search parameters or stops distance search if center is not valid.
+   * Radius and direction are filtered and ordered precisely inside the SQL query using the unit vector table.
+   * The query is not executed. Call resetSqlQuery() to run it.
+   * @param center center point for filter
+   * @param dir direction
+   * @param minDistance minimum distance to center point in nautical miles
+   * @param maxDistance maximum distance to center point in nautical miles
+   */
+  void filterByDistance(const atools::geo::Pos& center, sqlmodel::SearchDirection dir,
+                        float minDistance, float maxDistance);
+
+  bool isDistanceSearch() const
+  {
+    return distanceCenter.isValid();
+  }
 
   QString getColumnName(int col) const;
 
@@ -167,7 +227,7 @@ public:
     return overrideModeActive;
   }
 
-  /* Update model after data change */
+  /* Update model after data change. Reloads the first page and count blocking in the GUI thread. */
   void refreshData();
 
   void setQueryBuilder(const QueryBuilder& builder)
@@ -176,15 +236,28 @@ public:
   }
 
 signals:
-  /* Emitted when more data was fetched */
+  /* Emitted when more data was fetched or the total row count is known */
   void fetchedMore();
 
   /* One or more columns overrides all other search options */
   void overrideMode(const QStringList& overrideColumnTitles);
 
+  /* Internal signals for the worker */
+  void pageRequested(sqlmodel::PageRequest request);
+  void countRequested(int requestId, QString countQuery);
+  void unitVectorsRequested(QString table, QString idColumn);
+  void initDatabaseRequested(const QString& dbFile);
+  void deInitDatabaseRequested();
+
 private:
-  // Hide the record method
-  using QSqlQueryModel::record;
+  /* Field information without values */
+  const QSqlRecord& record() const
+  {
+    return sqlRecord;
+  }
+
+  /* Field information and values for row */
+  QSqlRecord record(int row) const;
 
   struct WhereCondition
   {
@@ -197,7 +270,7 @@ private:
   virtual void sort(int column, Qt::SortOrder order) override;
 
   void filterBy(bool exclude, QString whereCol, QVariant whereValue);
-  QString buildColumnList(const atools::sql::SqlRecord& tableCols);
+  QString buildColumnList(const atools::sql::SqlRecord& tableCols, bool distanceColumns);
   QString buildWhere(const atools::sql::SqlRecord& tableCols, QVector<const Column *>& overridingColumns);
   QString buildWhereValue(const WhereCondition& cond);
   void buildQuery();
@@ -206,10 +279,39 @@ private:
   QString  sortOrderToSql(Qt::SortOrder order);
   QVariant defaultDataHandler(int, int, const Column *, const QVariant&,
                               const QVariant& displayRoleValue, Qt::ItemDataRole role) const;
+
+  /* Set total row count if all rows are loaded or count in worker thread. Counts in the GUI thread only
+   * if the worker connection is not available. */
   void updateTotalCount();
+
+  /* Get field information by preparing the query with limit 0 in the GUI thread if columns changed */
+  void updateRecord(const QString& recordQuery);
+
+  /* Build page request for the current query */
+  sqlmodel::PageRequest pageRequest(int offset) const;
+
+  /* Replace or append rows. Resets model for the first page. */
+  void applyPage(const sqlmodel::PageResult& result);
+
+  /* Results from worker */
+  void pageFinished(const sqlmodel::PageResult& result);
+  void countFinished(int requestId, int count);
+
+  /* Increase request id and cancel all pending requests */
+  void newRequest();
+
+  /* Use current query for all following pages and mark rows as outdated */
+  void startQuery();
   void buildSqlWhereValue(QVariant& whereValue) const;
   void buildSqlWhereValue(QString& whereValue) const;
 
+  /* Join with unit vectors for distance search or empty if no distance search is active */
+  QString buildDistanceJoin();
+  QString buildDistanceWhere() const;
+
+  /* Formatted distance and heading from the search center for row */
+  QVariant distanceData(int row, const Column *col, int role) const;
+
   /* Default - all conditions are combined using "and" */
   const QString WHERE_OPERATOR = " and ";
 
@@ -218,12 +320,32 @@ private:
 
   QString currentSqlQuery, currentSqlCountQuery, currentSqlFetchQuery;
 
+  /* Query without order for pages, sort expression and order for keyset paging */
+  QString currentSqlPageQuery, currentOrderKey;
+  bool currentOrderDesc = false;
+
+  /* Page query, count query and order for the loaded rows and following pages */
+  QString activeSqlQuery, activeSqlCountQuery, activeOrderKey;
+  bool activeOrderDesc = false;
+
   /* Data callback */
   DataFunctionType dataFunction = nullptr;
   /* Roles for the data callback */
   QSet<Qt::ItemDataRole> handlerRoles;
 
-  /* A bounding rectangle query is used if this is valid */
+  /* Distance search is active if this is valid */
+  atools::geo::Pos distanceCenter;
+  sqlmodel::SearchDirection distanceDirection = sqlmodel::ALL;
+  float minDistanceNm = 0.f, maxDistanceNm = 0.f;
+
+  /* Set by buildDistanceJoin. Distance columns are calculated and radius is filtered in SQL */
+  bool hasDistanceVectors = false;
+
+  /* Warning about missing distance filters is shown only once */
+  bool distanceWarningShown = false;
+
+  /* A bounding rectangle query is used if this is valid. Coarse filter for distance search allowing to use
+   * the coordinate indexes. */
   atools::geo::Rect boundingRect;
 
   QueryBuilder queryBuilder;
@@ -237,8 +359,35 @@ private:
   const ColumnList *columns;
 
   QWidget *parentWidget;
+
+  /* -1 if not known yet */
   int totalRowCount = 0;
 
+  /* Loaded rows and field information */
+  QVector<QVector<QVariant> > rows;
+  QSqlRecord sqlRecord;
+  QString sqlRecordQuery;
+  QHash<int, QVariant> headers;
+
+  /* No more rows to fetch for current query */
+  bool atEnd = true;
+
+  /* Rows belong to a previous query and are replaced by the first page of the current one */
+  bool rowsOutdated = false;
+
+  /* Sort key and id of the last loaded row where the next page continues */
+  QVariant lastKey, lastId;
+
+  /* A page request or a new query is running in the worker */
+  bool pagePending = false;
+
+  /* Increased with each new query or blocking fetch to drop outdated pages */
+  int requestId = 0;
+
+  QThread thread;
+  SqlModelWorker *worker = nullptr;
+  bool workerDatabaseOpen = false;
+
   /* Set by buildWhere. Will ignore all other filter options */
   bool overrideModeActive = false;
 
@@ -0,0 +1,232 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "search/sqlmodelworker.h"
+
+#include "db/databasemanager.h"
+#include "query/querytypes.h"
+#include "sql/sqldatabase.h"
+#include "exception.h"
+
+#include <QDebug>
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+using atools::sql::SqlDatabase;
+
+static const QString DATABASE_TYPE("QSQLITE");
+
+namespace sqlmodel {
+
+/* Condition to continue after the given key and id. Null values are ordered first in SQLite.
+ * Placeholders are used only once since not all drivers support repeated names. */
+static QString keysetWhere(const PageRequest& request)
+{
+  QString key = request.orderKey, cmp = request.descending ? " < " : " > ";
+  QString idCond = "page_id" + cmp + ":page_id";
+
+  if(key.isEmpty())
+    return idCond;
+  else if(request.afterKey.isNull())
+  {
+    if(request.descending)
+      // Only nulls left at the end
+      return "(" + key + " is null and " + idCond + ")";
+    else
+      return "((" + key + " is null and " + idCond + ") or " + key + " is not null)";
+  }
+  else
+    return "(" + key + cmp + ":page_key1 or (" + key + " = :page_key2 and " + idCond + ")" +
+           (request.descending ? " or " + key + " is null)" : ")");
+}
+
+bool readPage(const QSqlDatabase& database, const PageRequest& request, PageResult& result,
+              const InterruptFunc& interrupted)
+{
+  result.requestId = request.requestId;
+  result.offset = request.offset;
+  result.rows.clear();
+  result.lastKey = result.lastId = QVariant();
+  result.atEnd = true;
+  result.error = QSqlError();
+
+  // Sort key is added as last column
+  QString dir = request.descending ? " desc" : " asc";
+  QString sql = "select *, " + (request.orderKey.isEmpty() ? "null" : request.orderKey) + " as page_key from (" +
+                request.query + ")";
+  if(request.afterId.isValid())
+    sql += " where " + keysetWhere(request);
+
+  // Fetch one more row to detect the end of the result - limit -1 is no limit in SQLite
+  int limit = request.limit < 0 ? -1 : request.limit + 1;
+  sql += " order by page_key" + dir + ", page_id" + dir + QString(" limit %1").arg(limit);
+
+  QSqlQuery query(database);
+  query.setForwardOnly(true);
+  query.prepare(sql);
+  if(request.afterId.isValid())
+  {
+    query.bindValue(":page_id", request.afterId);
+    if(!request.orderKey.isEmpty() && !request.afterKey.isNull())
+    {
+      query.bindValue(":page_key1", request.afterKey);
+      query.bindValue(":page_key2", request.afterKey);
+    }
+  }
+
+  if(!query.exec())
+  {
+    result.error = query.lastError();
+    return true;
+  }
+
+  // Leave out page_id and page_key
+  int columns = query.record().count() - 2;
+  while(query.next())
+  {
+    if(interrupted && interrupted())
+    {
+      // Superseded by a new query
+      query.finish();
+      return false;
+    }
+
+    if(request.limit >= 0 && result.rows.size() == request.limit)
+    {
+      result.atEnd = false;
+      break;
+    }
+
+    QVector<QVariant> row(columns);
+    for(int i = 0; i < columns; i++)
+      row[i] = query.value(i);
+    result.rows.append(row);
+    result.lastId = query.value(columns);
+    result.lastKey = query.value(columns + 1);
+  }
+  query.finish();
+  return true;
+}
+
+bool countRows(const QSqlDatabase& database, const QString& countQuery, int& count,
+               const InterruptFunc& interrupted)
+{
+  count = 0;
+  QSqlQuery query(database);
+  query.setForwardOnly(true);
+  if(!query.exec(countQuery))
+  {
+    qWarning() << Q_FUNC_INFO << query.lastError().text();
+    return false;
+  }
+
+  while(query.next())
+  {
+    if(interrupted && interrupted())
+    {
+      query.finish();
+      return false;
+    }
+    count++;
+  }
+  query.finish();
+  return true;
+}
+
+}
+
+SqlModelWorker::SqlModelWorker(const QString& connectionName)
+  : name(connectionName)
+{
+
+}
+
+SqlModelWorker::~SqlModelWorker()
+{
+  deInitDatabase();
+}
+
+void SqlModelWorker::initDatabase(const QString& dbFile)
+{
+  deInitDatabase();
+
+  try
+  {
+    SqlDatabase::addDatabase(DATABASE_TYPE, name);
+
+    // Only read access - main connections are not blocked. Waits for writers like the online data worker.
+    db = new SqlDatabase(name);
+    db->setDatabaseName(dbFile);
+    db->setReadonly();
+    db->open(DatabaseManager::databasePragmas(true /* readonly */, false /* exclusive */) << "PRAGMA cache_size=-2000");
+
+    // Spatial index file contains the unit vectors for the distance search
+    query::attachSpatialIndex(db);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open search database" << dbFile << e.what();
+    deInitDatabase();
+  }
+}
+
+void SqlModelWorker::deInitDatabase()
+{
+  if(db != nullptr)
+  {
+    if(db->isOpen())
+      db->close();
+    delete db;
+    db = nullptr;
+
+    SqlDatabase::removeDatabase(name);
+  }
+}
+
+void SqlModelWorker::fetchPage(sqlmodel::PageRequest request)
+{
+  if(db == nullptr || currentRequestId.load() != request.requestId)
+    // Skip outdated request which is still in the queue
+    return;
+
+  sqlmodel::PageResult result;
+  if(sqlmodel::readPage(db->getQSqlDatabase(), request, result, interruptFunc(request.requestId)))
+    emit pageFinished(result);
+}
+
+void SqlModelWorker::countRows(int requestId, QString countQuery)
+{
+  if(db == nullptr || currentRequestId.load() != requestId)
+    return;
+
+  int count = 0;
+  if(sqlmodel::countRows(db->getQSqlDatabase(), countQuery, count, interruptFunc(requestId)))
+    emit countFinished(requestId, count);
+}
+
+sqlmodel::InterruptFunc SqlModelWorker::interruptFunc(int requestId) const
+{
+  return [this, requestId]() -> bool {
+           return currentRequestId.load() != requestId;
+         };
+}
+
+void SqlModelWorker::createUnitVectors(QString table, QString idColumn)
+{
+  if(db != nullptr)
+    query::createUnitVectorTempTable(db, table, idColumn);
+}
@@ -0,0 +1,144 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_SQLMODELWORKER_H
+#define LNM_SQLMODELWORKER_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QSqlError>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+
+class QSqlDatabase;
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+namespace sqlmodel {
+
+/* Request for one page of the search result */
+struct PageRequest
+{
+  /* Changed by the model for each new query. Pages of older requests are dropped. */
+  int requestId = -1;
+
+  /* Query without order and limit having the unique id as last column page_id. Limit -1 fetches all rows. */
+  QString query;
+  int offset = 0, limit = 0;
+
+  /* Sort expression using the columns of query. Empty if ordered by id only. */
+  QString orderKey;
+  bool descending = false;
+
+  /* Sort key and id of the last row of the previous page. Starts with the first row if afterId is not valid. */
+  QVariant afterKey, afterId;
+};
+
+/* Rows of one page as sent back from the worker thread */
+struct PageResult
+{
+  int requestId = -1, offset = 0;
+  QVector<QVector<QVariant> > rows;
+
+  /* Sort key and id of the last row to continue with the next page */
+  QVariant lastKey, lastId;
+
+  /* No more rows available after this page */
+  bool atEnd = true;
+
+  /* Valid if the query failed */
+  QSqlError error;
+};
+
+/* Called for each row while reading. Returns true to stop, e.g. if a newer request was started. */
+typedef std::function<bool ()> InterruptFunc;
+
+/* Read one page for request from database. Returns false if interrupted. Used in the worker and GUI thread. */
+bool readPage(const QSqlDatabase& database, const PageRequest& request, PageResult& result,
+              const InterruptFunc& interrupted = nullptr);
+
+/* Count rows of countQuery by stepping through the result which allows to interrupt the count.
+ * Returns false if interrupted or on error. */
+bool countRows(const QSqlDatabase& database, const QString& countQuery, int& count,
+               const InterruptFunc& interrupted = nullptr);
+
+}
+
+Q_DECLARE_METATYPE(sqlmodel::PageRequest);
+Q_DECLARE_METATYPE(sqlmodel::PageResult);
+
+/*
+ * Lives in the thread of a SqlModel and owns a read only connection to the database of the model.
+ * Runs page and row count queries so typing in the search widgets does not block the GUI.
+ *
+ * Each page continues after the sort key and id of the last row of the previous page (keyset paging) and the
+ * statement is finished afterwards. This avoids keeping read locks which would block writes of the GUI thread to
+ * the userpoint, logbook and online databases and does not skip or repeat rows like offsets would do.
+ */
+class SqlModelWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit SqlModelWorker(const QString& connectionName);
+  virtual ~SqlModelWorker() override;
+
+  /* Open database. Has to be called in the worker thread. */
+  void initDatabase(const QString& dbFile);
+
+  /* Close database. Has to be called in the worker thread. */
+  void deInitDatabase();
+
+  /* Only valid after initDatabase returned from a blocking call */
+  bool isDatabaseOpen() const
+  {
+    return db != nullptr;
+  }
+
+  /* Fetch page and send it back with pageFinished if the request is still current */
+  void fetchPage(sqlmodel::PageRequest request);
+
+  /* Count rows and send them back with countFinished if the request is still current.
+   * Counting stops as soon as a new request is started. */
+  void countRows(int requestId, QString countQuery);
+
+  /* Create unit vectors for the distance search in memory if not available from the spatial index file */
+  void createUnitVectors(QString table, QString idColumn);
+
+  /* Set by the model in the GUI thread. Requests with other ids are canceled or skipped. */
+  QAtomicInt currentRequestId = -1;
+
+signals:
+  void pageFinished(const sqlmodel::PageResult& result);
+  void countFinished(int requestId, int count);
+
+private:
+  /* Stops reading as soon as the model starts a new request */
+  sqlmodel::InterruptFunc interruptFunc(int requestId) const;
+
+  QString name;
+  atools::sql::SqlDatabase *db = nullptr;
+};
+
+#endif // LNM_SQLMODELWORKER_H
@@ -45,14 +45,16 @@ TrackController::TrackController(TrackManager *trackManagerParam, MainWindow *ma
   verbose = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_TRACK_DEBUG, false).toBool();
   trackManager->setVerbose(verbose);
 
+  query::QuerySettings querySettings = query::QuerySettings::read();
+
   // Set up airway queries =====================
-  airwayTrackQuery = new AirwayTrackQuery(new AirwayQuery(NavApp::getDatabaseNav(), false),
-                                          new AirwayQuery(NavApp::getDatabaseTrack(), true));
+  airwayTrackQuery = new AirwayTrackQuery(new AirwayQuery(NavApp::getDatabaseNav(), false, querySettings),
+                                          new AirwayQuery(NavApp::getDatabaseTrack(), true, querySettings));
   airwayTrackQuery->initQueries();
 
   // Set up waypoint queries =====================
-  waypointTrackQuery = new WaypointTrackQuery(new WaypointQuery(NavApp::getDatabaseNav(), false),
-                                              new WaypointQuery(NavApp::getDatabaseTrack(), true));
+  waypointTrackQuery = new WaypointTrackQuery(new WaypointQuery(NavApp::getDatabaseNav(), false, querySettings),
+                                              new WaypointQuery(NavApp::getDatabaseTrack(), true, querySettings));
   waypointTrackQuery->initQueries();
 
   downloader = new TrackDownloader(this, verbose);
@@ -21,12 +21,14 @@
 #include "settings/settings.h"
 #include "options/optiondata.h"
 #include "common/constants.h"
+#include "common/maptypes.h"
 #include "fs/weather/xpweatherreader.h"
 #include "navapp.h"
 #include "atools.h"
 #include "fs/weather/weathernetdownload.h"
 #include "fs/weather/noaaweatherdownloader.h"
 #include "fs/sc/simconnecttypes.h"
+#include "fs/sc/weatherrequest.h"
 #include "fs/util/fsutil.h"
 #include "query/mapquery.h"
 #include "query/airportquery.h"
@@ -62,8 +64,20 @@ using atools::fs::weather::Metar;
 using atools::util::FileSystemWatcher;
 using atools::settings::Settings;
 
+uint qHash(const WeatherReporter::MetarCacheKey& key)
+{
+  return static_cast<uint>(key.source) ^ qHash(key.station) ^ qHash(key.metar) ^ qHash(key.timestamp) ^
+         key.simFormat;
+}
+
+bool WeatherReporter::MetarCacheKey::operator==(const WeatherReporter::MetarCacheKey& other) const
+{
+  return source == other.source && simFormat == other.simFormat && station == other.station &&
+         timestamp == other.timestamp && metar == other.metar;
+}
+
 WeatherReporter::WeatherReporter(MainWindow *parentWindow, atools::fs::FsPaths::SimulatorType type)
-  : QObject(parentWindow), simType(type), mainWindow(parentWindow)
+  : QObject(parentWindow), metarCache(METAR_CACHE_SIZE), simType(type), mainWindow(parentWindow)
 {
   using namespace std::placeholders;
   onlineWeatherTimeoutSecs = atools::settings::Settings::instance().valueInt(lnm::OPTIONS_WEATHER_UPDATE, 600);
@@ -147,18 +161,21 @@ void WeatherReporter::weatherDownloadProgress(qint64 bytesReceived, qint64 bytes
 
 void WeatherReporter::noaaWeatherUpdated()
 {
+  clearMetarCache(map::WEATHER_SOURCE_NOAA);
   mainWindow->setStatusMessage(tr("NOAA weather downloaded."), true /* addToLog */);
   emit weatherUpdated();
 }
 
 void WeatherReporter::ivaoWeatherUpdated()
 {
+  clearMetarCache(map::WEATHER_SOURCE_IVAO);
   mainWindow->setStatusMessage(tr("IVAO weather downloaded."), true /* addToLog */);
   emit weatherUpdated();
 }
 
 void WeatherReporter::vatsimWeatherUpdated()
 {
+  clearMetarCache(map::WEATHER_SOURCE_VATSIM);
   mainWindow->setStatusMessage(tr("VATSIM weather downloaded."), true /* addToLog */);
   emit weatherUpdated();
 }
@@ -677,7 +694,7 @@ atools::fs::weather::Metar WeatherReporter::getAirportWeather(const QString& air
     case map::WEATHER_SOURCE_SIMULATOR:
       if(NavApp::getCurrentSimulatorDb() == atools::fs::FsPaths::XPLANE11)
         // X-Plane weather file
-        return Metar(getXplaneMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
+        return getParsedMetar(source, getXplaneMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
       else if(NavApp::isConnected() /*&& !NavApp::getConnectClient()->isConnectedNetwork()*/)
       {
         atools::fs::weather::MetarResult res =
@@ -685,25 +702,95 @@ atools::fs::weather::Metar WeatherReporter::getAirportWeather(const QString& air
 
         if(res.isValid() && !res.metarForStation.isEmpty())
           // FSX/P3D - Flight simulator fetched weather or network connection
-          return Metar(res.metarForStation, res.requestIdent, res.timestamp, true);
+          return getParsedMetar(source, res.metarForStation, res.requestIdent, res.timestamp, true);
       }
       return Metar();
 
     case map::WEATHER_SOURCE_ACTIVE_SKY:
-      return Metar(getActiveSkyMetar(airportIcao));
+      return getParsedMetar(source, getActiveSkyMetar(airportIcao));
 
     case map::WEATHER_SOURCE_NOAA:
-      return Metar(getNoaaMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
+      return getParsedMetar(source, getNoaaMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
 
     case map::WEATHER_SOURCE_VATSIM:
-      return Metar(getVatsimMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
+      return getParsedMetar(source, getVatsimMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
 
     case map::WEATHER_SOURCE_IVAO:
-      return Metar(getIvaoMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
+      return getParsedMetar(source, getIvaoMetar(airportIcao, atools::geo::EMPTY_POS).metarForStation);
   }
   return Metar();
 }
 
+QVector<atools::fs::weather::Metar> WeatherReporter::getAirportWeather(const QVector<const map::MapAirport *>& airports,
+                                                                      map::MapWeatherSource source)
+{
+  QVector<Metar> metars;
+  metars.reserve(airports.size());
+
+  if(source == map::WEATHER_SOURCE_SIMULATOR && NavApp::getCurrentSimulatorDb() != atools::fs::FsPaths::XPLANE11)
+  {
+    if(NavApp::isConnected())
+    {
+      // FSX/P3D - collect all stations and send missing ones as one batch
+      QVector<atools::fs::sc::WeatherRequest> requests;
+      requests.reserve(airports.size());
+      for(const map::MapAirport *airport : airports)
+      {
+        atools::fs::sc::WeatherRequest request;
+        request.setStation(airport->ident);
+        request.setPosition(airport->position);
+        requests.append(request);
+      }
+
+      for(const MetarResult& res : NavApp::getConnectClient()->requestWeatherBatch(requests, true))
+      {
+        if(res.isValid() && !res.metarForStation.isEmpty())
+          metars.append(getParsedMetar(source, res.metarForStation, res.requestIdent, res.timestamp, true));
+        else
+          metars.append(Metar());
+      }
+    }
+    else
+      metars.fill(Metar(), airports.size());
+  }
+  else
+  {
+    // Files and downloads - all lookups are local
+    for(const map::MapAirport *airport : airports)
+      metars.append(getAirportWeather(airport->ident, airport->position, source));
+  }
+  return metars;
+}
+
+atools::fs::weather::Metar WeatherReporter::getParsedMetar(map::MapWeatherSource source, const QString& metar,
+                                                           const QString& station, const QDateTime& timestamp,
+                                                           bool simFormat)
+{
+  if(metar.isEmpty())
+    // Nothing to parse - do not fill the cache with empty reports
+    return Metar(metar, station, timestamp, simFormat);
+
+  MetarCacheKey key = {source, station, metar, timestamp, simFormat};
+  Metar *parsed = metarCache.object(key);
+  if(parsed == nullptr)
+  {
+    parsed = new Metar(metar, station, timestamp, simFormat);
+    metarCache.insert(key, parsed);
+  }
+
+  // Copy is cheap compared to parsing
+  return *parsed;
+}
+
+void WeatherReporter::clearMetarCache(map::MapWeatherSource source)
+{
+  for(const MetarCacheKey& key : metarCache.keys())
+  {
+    if(key.source == source)
+      metarCache.remove(key);
+  }
+}
+
 void WeatherReporter::preDatabaseLoad()
 {
 
@@ -715,6 +802,7 @@ void WeatherReporter::postDatabaseLoad(atools::fs::FsPaths::SimulatorType type)
   {
     // Simulator has changed - reload files
     simType = type;
+    metarCache.clear();
     resetErrorState();
     updateTimeouts();
     initActiveSkyNext();
@@ -728,6 +816,7 @@ void WeatherReporter::optionsChanged()
   noaaWeather->setRequestUrl(OptionData::instance().getWeatherNoaaUrl());
   ivaoWeather->setRequestUrl(OptionData::instance().getWeatherIvaoUrl());
 
+  metarCache.clear();
   resetErrorState();
   updateTimeouts();
   initActiveSkyNext();
@@ -779,6 +868,7 @@ void WeatherReporter::activeSkyWeatherFileChanged(const QString& path)
 {
   qDebug() << Q_FUNC_INFO << "file" << path << "changed";
 
+  clearMetarCache(map::WEATHER_SOURCE_ACTIVE_SKY);
   loadActiveSkySnapshot(asPath);
   loadActiveSkyFlightplanSnapshot(asFlightplanPath);
   mainWindow->setStatusMessage(tr("Active Sky weather information updated."), true /* addToLog */);
@@ -788,6 +878,7 @@ void WeatherReporter::activeSkyWeatherFileChanged(const QString& path)
 
 void WeatherReporter::xplaneWeatherFileChanged()
 {
+  clearMetarCache(map::WEATHER_SOURCE_SIMULATOR);
   mainWindow->setStatusMessage(tr("X-Plane weather information updated."), true /* addToLog */);
   emit weatherUpdated();
 }
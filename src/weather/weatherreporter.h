@@ -21,8 +21,11 @@
 #include "fs/fspaths.h"
 #include "common/mapflags.h"
 
+#include <QCache>
+#include <QDateTime>
 #include <QHash>
 #include <QObject>
+#include <QVector>
 
 namespace atools {
 
@@ -33,6 +36,9 @@ namespace geo {
 class Pos;
 }
 namespace fs {
+namespace sc {
+class WeatherRequest;
+}
 namespace weather {
 struct MetarResult;
 
@@ -47,6 +53,9 @@ class NoaaWeatherDownloader;
 }
 
 class MainWindow;
+namespace map {
+struct MapAirport;
+}
 
 /*
  * Provides a source of metar data for airports. Supports ActiveSkyNext, NOAA and VATSIM weather.
@@ -104,6 +113,20 @@ public:
   atools::fs::weather::Metar getAirportWeather(const QString& airportIcao, const atools::geo::Pos& airportPos,
                                                map::MapWeatherSource source);
 
+  /* Resolve weather for all airports in one pass. Result is in the order of airports.
+   * Simulator requests for missing reports are sent as one batch which updates the map once when complete. */
+  QVector<atools::fs::weather::Metar> getAirportWeather(const QVector<const map::MapAirport *>& airports,
+                                                        map::MapWeatherSource source);
+
+  /*
+   * Get a parsed metar object for the raw report from the cache or parse and insert it.
+   * Key is source, station, report timestamp and the report itself. Entries for a source are dropped when
+   * the source is updated. Used by map display, information panel and tooltips.
+   */
+  atools::fs::weather::Metar getParsedMetar(map::MapWeatherSource source, const QString& metar,
+                                            const QString& station = QString(),
+                                            const QDateTime& timestamp = QDateTime(), bool simFormat = false);
+
   /* Does nothing currently */
   void preDatabaseLoad();
 
@@ -202,10 +225,35 @@ private:
   /* Update IVAO and NOAA timeout periods - timeout is disable if weather services are not used */
   void updateTimeouts();
 
+  /* Remove all parsed metars of the given source from the cache */
+  void clearMetarCache(map::MapWeatherSource source);
+
+  /* Cache key used to identify a parsed metar */
+  struct MetarCacheKey
+  {
+    map::MapWeatherSource source;
+    QString station, metar;
+    QDateTime timestamp;
+    bool simFormat;
+
+    bool operator==(const WeatherReporter::MetarCacheKey& other) const;
+    bool operator!=(const WeatherReporter::MetarCacheKey& other) const
+    {
+      return !(*this == other);
+    }
+
+  };
+
+  friend uint qHash(const WeatherReporter::MetarCacheKey& key);
+
   atools::fs::weather::NoaaWeatherDownloader *noaaWeather = nullptr;
   atools::fs::weather::WeatherNetDownload *vatsimWeather = nullptr;
   atools::fs::weather::WeatherNetDownload *ivaoWeather = nullptr;
 
+  /* Parsed metars for all sources. Enough for a whole continent of airports shown on the map. */
+  static const int METAR_CACHE_SIZE = 5000;
+  QCache<MetarCacheKey, atools::fs::weather::Metar> metarCache;
+
   QHash<QString, QString> activeSkyMetars;
   QString activeSkyDepartureMetar, activeSkyDestinationMetar,
           activeSkyDepartureIdent, activeSkyDestinationIdent;
@@ -27,8 +27,10 @@
 #include "route/routecontroller.h"
 #include "web/webmapcontroller.h"
 #include "webapi/webapicontroller.h"
+#include "webapi/webapistream.h"
 #include "web/webtools.h"
 #include "web/webapp.h"
+#include "web/webtilecache.h"
 #include "common/mapcolors.h"
 #include "geo/calculations.h"
 #include "common/htmlinfobuilder.h"
@@ -45,9 +47,15 @@
 
 using namespace stefanfrings;
 
+/* Maximum zoom level for XYZ map tiles */
+const static int MAX_TILE_ZOOM = 20;
+
+/* Send a comment to live stream clients if nothing changed to detect closed connections */
+const static unsigned long STREAM_KEEPALIVE_MS = 15000;
+
 RequestHandler::RequestHandler(QObject *parent, WebMapController *webMapController,WebApiController *webApiController,
                                HtmlInfoBuilder *htmlInfoBuilderParam, bool verboseParam)
-  : HttpRequestHandler(parent), webApiController(webApiController), htmlInfoBuilder(htmlInfoBuilderParam), verbose(verboseParam)
+  : HttpRequestHandler(parent), webMapController(webMapController), webApiController(webApiController), htmlInfoBuilder(htmlInfoBuilderParam), verbose(verboseParam)
 {
   if(verbose)
     qDebug() << Q_FUNC_INFO;
@@ -75,6 +83,10 @@ RequestHandler::RequestHandler(QObject *parent, WebMapController *webMapControll
           Qt::BlockingQueuedConnection);
   connect(this, &RequestHandler::getPixmapRect, webMapController, &WebMapController::getPixmapRect,
           Qt::BlockingQueuedConnection);
+  connect(this, &RequestHandler::getTile, webMapController, &WebMapController::getTile,
+          Qt::BlockingQueuedConnection);
+  connect(this, &RequestHandler::currentTileSettingsKey, webMapController, &WebMapController::currentTileSettingsKey,
+          Qt::BlockingQueuedConnection);
 
   /* Connect WebApiController to serviceWebApi signal */
   connect(this,&RequestHandler::serviceWebApi, webApiController, &WebApiController::service,Qt::BlockingQueuedConnection);
@@ -99,6 +111,14 @@ void RequestHandler::service(HttpRequest& request, HttpResponse& response)
     // ===========================================================================
     // Requests for map images only - either with or without session
     handleMapImage(request, response);
+  else if(path.startsWith(QLatin1String("/tiles/")))
+    // ===========================================================================
+    // Requests for map tiles - always stateless
+    handleMapTile(request, response, path);
+  else if(path == webApiController->webApiStreamPath)
+    // ===========================================================================
+    // Live data stream for web api - runs in this thread until client disconnects
+    handleWebApiStream(request, response);
   else if(path.startsWith(webApiController->webApiPathPrefix))
     // ===========================================================================
     // Requests for web api - either with or without session
@@ -312,12 +332,12 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
     if(format == QLatin1String("jpg"))
     {
       response.setHeader("Content-Type", "image/jpeg");
-      mapPixmap.pixmap.save(&buffer, "JPG", quality);
+      mapPixmap.image.save(&buffer, "JPG", quality);
     }
     else if(format == QLatin1String("png"))
     {
       response.setHeader("Content-Type", "image/png");
-      mapPixmap.pixmap.save(&buffer, "PNG", quality);
+      mapPixmap.image.save(&buffer, "PNG", quality);
     }
     else
       // Should never happen
@@ -330,6 +350,117 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
     showErrorPixmap(response, width, height, 404, QStringLiteral(u"invalid pixmap"));
 }
 
+inline void RequestHandler::handleMapTile(HttpRequest& request, HttpResponse& response, const QString& path)
+{
+  // Path is "/tiles/{z}/{x}/{y}.png" ===========================================
+  QStringList parts = path.split('/');
+  bool okz = false, okx = false, oky = false;
+  int z = -1, x = -1, y = -1;
+  if(parts.size() == 5 && parts.at(4).endsWith(QLatin1String(".png")))
+  {
+    z = parts.at(2).toInt(&okz);
+    x = parts.at(3).toInt(&okx);
+    y = parts.at(4).chopped(4).toInt(&oky);
+  }
+
+  if(!okz || !okx || !oky || z < 0 || z > MAX_TILE_ZOOM || x < 0 || y < 0 || x >= (1 << z) || y >= (1 << z))
+    return showError(request, response, 404, QStringLiteral(u"Invalid tile."));
+
+  // Key contains all settings and database versions - tiles of outdated keys are not used anymore
+  // Cached key is read directly without waiting for the main thread unless changes are pending
+  QString settingsKey = webMapController->getTileSettingsKey();
+  if(settingsKey.isEmpty())
+    settingsKey = emit currentTileSettingsKey();
+  QByteArray etag = '"' + settingsKey.toLatin1() + '"';
+
+  // Clients revalidate each time since the URL does not change with the settings
+  response.setHeader("Cache-Control", "no-cache");
+  response.setHeader("ETag", etag);
+
+  QByteArray ifNoneMatch = request.getHeader("If-None-Match");
+  if(!ifNoneMatch.isEmpty())
+  {
+    for(const QByteArray& tag : ifNoneMatch.split(','))
+    {
+      if(tag.trimmed() == etag)
+      {
+        response.setStatus(304, "Not Modified");
+        response.write(QByteArray(), true);
+        return;
+      }
+    }
+  }
+
+  QString key = QString("%1/%2/%3/%4").arg(z).arg(x).arg(y).arg(settingsKey);
+
+  QByteArray bytes;
+  WebTileCache *tileCache = WebApp::getTileCache();
+  if(tileCache == nullptr || !tileCache->get(key, bytes))
+  {
+    // Not cached - render in main thread and encode here
+    MapTile tile = emit getTile(z, x, y);
+    if(tile.image.isNull())
+      return showError(request, response, 500, QStringLiteral(u"Internal server error. Cannot render tile."));
+
+    if(tile.settingsKey != settingsKey)
+    {
+      // Settings changed in the meantime - use key valid at rendering time
+      key = QString("%1/%2/%3/%4").arg(z).arg(x).arg(y).arg(tile.settingsKey);
+      response.setHeader("ETag", '"' + tile.settingsKey.toLatin1() + '"');
+    }
+
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    tile.image.save(&buffer, "PNG");
+
+    if(tileCache != nullptr)
+      tileCache->insert(key, bytes);
+  }
+  else if(verbose)
+    qDebug() << Q_FUNC_INFO << "Tile from cache" << z << x << y;
+
+  response.setHeader("Content-Type", "image/png");
+  response.write(bytes, true);
+}
+
+inline void RequestHandler::handleWebApiStream(HttpRequest& request, HttpResponse& response)
+{
+  WebApiStream *stream = webApiController->getStream();
+
+  // Resume from last event after reconnect if possible
+  bool ok = false;
+  qint64 lastSequence = request.getHeader("Last-Event-ID").toLongLong(&ok);
+  if(!ok)
+    lastSequence = -1L;
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "Stream for" << request.getPeerAddress() << "last event" << lastSequence;
+
+  response.setHeader("Content-Type", "text/event-stream");
+  response.setHeader("Cache-Control", "no-cache");
+  response.setHeader("Access-Control-Allow-Origin", "*");
+
+  // Sends headers and uses chunked transfer encoding for all following writes
+  response.write("retry: 2000\n\n");
+
+  stream->subscribe();
+  QByteArray events;
+  while(response.isConnected() && !stream->isStopped())
+  {
+    events.clear();
+    if(stream->waitForEvents(lastSequence, events, STREAM_KEEPALIVE_MS))
+      response.write(events);
+    else if(!stream->isStopped())
+      response.write(": keepalive\n\n");
+  }
+  stream->unsubscribe();
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "Stream closed for" << request.getPeerAddress();
+
+  if(response.isConnected())
+    response.write(QByteArray(), true);
+}
 
 inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpResponse& response)
 {
@@ -348,11 +479,37 @@ inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpRespon
   WebApiResponse result = emit serviceWebApi(apiRequest);
 
   // Map API response
-  response.setStatus(result.status);
   QMultiMap<QByteArray, QByteArray>::iterator i;
   for (i = result.headers.begin(); i != result.headers.end(); ++i)
       response.setHeader(i.key(),i.value());
 
+  // Answer with 304 and no body if the client has the same response already
+  QByteArray etag = result.headers.value("ETag");
+  if(result.status == 200 && !etag.isEmpty())
+  {
+    // Clients revalidate each time using the ETag
+    response.setHeader("Cache-Control", "no-cache");
+
+    QByteArray ifNoneMatch = request.getHeader("If-None-Match");
+    if(!ifNoneMatch.isEmpty())
+    {
+      for(const QByteArray& tag : ifNoneMatch.split(','))
+      {
+        if(tag.trimmed() == etag || tag.trimmed() == "*")
+        {
+          if(verbose)
+            qDebug() << Q_FUNC_INFO << "Not modified" << request.getPath() << etag;
+
+          response.setStatus(304, "Not Modified");
+          response.write(QByteArray(), true);
+          return;
+        }
+      }
+    }
+  }
+
+  response.setStatus(result.status);
+
   // Write output
   response.write(result.body, true);
 }
@@ -491,12 +648,12 @@ void RequestHandler::showErrorPixmap(HttpResponse& response, int width, int heig
 {
   qWarning() << Q_FUNC_INFO << "Error" << status << text;
 
-  // Create pixmap
-  QPixmap pixmap(width, height);
-  pixmap.fill(QColor(Qt::white));
+  // Create image - pixmaps cannot be used outside of the main thread
+  QImage image(width, height, QImage::Format_RGB32);
+  image.fill(QColor(Qt::white));
 
   // Prepare painter and font
-  QPainter painter(&pixmap);
+  QPainter painter(&image);
   QFont font = painter.font();
   font.setPixelSize(std::min(height / 10, 20));
   font.setBold(true);
@@ -513,7 +670,8 @@ void RequestHandler::showErrorPixmap(HttpResponse& response, int width, int heig
   QByteArray bytes;
   QBuffer buffer(&bytes);
   buffer.open(QIODevice::WriteOnly);
-  pixmap.save(&buffer, "JPG", 100);
+  painter.end();
+  image.save(&buffer, "JPG", 100);
 
   // Write to response
   response.setHeader("Content-Type", "image/jpeg");
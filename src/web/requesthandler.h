@@ -67,6 +67,8 @@ signals:
   MapPixmap getPixmapObject(int width, int height, web::ObjectType type, const QString& ident, float distanceKm);
   MapPixmap getPixmapPosDistance(int width, int height, atools::geo::Pos pos, float distanceKm, const QString& mapCommand, const QString& errorCase = QLatin1String(""));
   MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase = tr("Invalid rectangle"));
+  MapTile getTile(int z, int x, int y);
+  QString currentTileSettingsKey();
 
   atools::fs::sc::SimConnectUserAircraft getUserAircraft();
   Route getRoute();
@@ -91,6 +93,12 @@ private:
   /* Handle stateful and stateless map image requests. */
   void handleMapImage(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
+  /* Handle XYZ map tile requests like "/tiles/{z}/{x}/{y}.png" using the tile cache. */
+  void handleMapTile(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response, const QString& path);
+
+  /* Handle Server-Sent Events live data stream. Keeps the server thread busy until the client disconnects. */
+  void handleWebApiStream(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
+
   /* Handle stateful and stateless api requests. */
   void handleWebApiRequest(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
@@ -103,6 +111,7 @@ private:
   /* Create and prepare a session and set the cookie or return current session */
   stefanfrings::HttpSession getSession(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
+  WebMapController *webMapController;
   WebApiController *webApiController;
   HtmlInfoBuilder *htmlInfoBuilder;
 
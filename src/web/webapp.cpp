@@ -17,6 +17,10 @@
 
 #include "webapp.h"
 
+#include "web/webtilecache.h"
+#include "settings/settings.h"
+
+#include <QDir>
 #include <QSettings>
 
 #include "httpserver/httpsessionstore.h"
@@ -26,10 +30,13 @@
 stefanfrings::TemplateCache *WebApp::templateCache = nullptr;
 stefanfrings::HttpSessionStore *WebApp::sessionStore = nullptr;
 stefanfrings::StaticFileController *WebApp::staticFileController = nullptr;
+WebTileCache *WebApp::tileCache = nullptr;
 
 atools::io::IniKeyValues WebApp::templateCacheSettings;
 atools::io::IniKeyValues WebApp::sessionSettings;
 atools::io::IniKeyValues WebApp::staticFileControllerSettings;
+atools::io::IniKeyValues WebApp::tileCacheSettings;
+
 
 QString WebApp::documentRoot;
 QString WebApp::htmlExtension = ".html";
@@ -63,9 +70,22 @@ void WebApp::init(QObject *parent, const QString& configFileName, const QString&
     staticFileControllerSettings.insert("path", docrootParam);
   staticFileControllerSettings.insert("filename", configFileName);
   staticFileController = new stefanfrings::StaticFileController(staticFileControllerSettings, parent);
+
+  // Configure map tile cache
+  tileCacheSettings = reader.getKeyValuePairs("tiles");
+  QString tilePath = tileCacheSettings.value("path").toString();
+  if(tilePath.isEmpty())
+    tilePath = atools::settings::Settings::getPath() + QDir::separator() + "webtiles";
+
+  delete tileCache;
+  tileCache = new WebTileCache(tilePath, tileCacheSettings.value("memoryCacheSize", 20000).toInt(),
+                               tileCacheSettings.value("diskCacheSize", 200).toInt());
 }
 
 void WebApp::deinit()
 {
   qDebug() << Q_FUNC_INFO;
+
+  delete tileCache;
+  tileCache = nullptr;
 }
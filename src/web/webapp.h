@@ -28,6 +28,7 @@ class StaticFileController;
 }
 
 class QSettings;
+class WebTileCache;
 class QString;
 class QObject;
 
@@ -59,6 +60,12 @@ public:
     return staticFileController;
   }
 
+  /* Memory and disk cache for map tiles */
+  static WebTileCache *getTileCache()
+  {
+    return tileCache;
+  }
+
   static const QString& getDocroot()
   {
     return documentRoot;
@@ -83,7 +90,11 @@ private:
   /* Controller for static files */
   static stefanfrings::StaticFileController *staticFileController;
 
-  static atools::io::IniKeyValues templateCacheSettings, sessionSettings, staticFileControllerSettings;
+  /* Cache for map tiles */
+  static WebTileCache *tileCache;
+
+  static atools::io::IniKeyValues templateCacheSettings, sessionSettings, staticFileControllerSettings,
+                                  tileCacheSettings;
 
   static QString documentRoot, htmlExtension;
 };
@@ -21,6 +21,7 @@
 #include "web/requesthandler.h"
 #include "web/webmapcontroller.h"
 #include "webapi/webapicontroller.h"
+#include "webapi/webapistream.h"
 #include "web/webapp.h"
 #include "gui/helphandler.h"
 
@@ -108,6 +109,9 @@ void WebController::startServer()
   // Start map
   mapController->init();
 
+  // Start collecting data for live stream subscribers
+  apiController->getStream()->start();
+
   requestHandler = new RequestHandler(this, mapController, apiController, htmlInfoBuilder, verbose);
 
   // Set port - always override configuration file
@@ -202,6 +206,9 @@ void WebController::stopServer()
 
   mapController->deInit();
 
+  // Release live stream subscribers which keep server threads busy
+  apiController->getStream()->stop();
+
   if(listener != nullptr)
     listener->close();
 
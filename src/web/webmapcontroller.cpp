@@ -22,14 +22,45 @@
 #include "mapgui/mappaintwidget.h"
 #include "mapgui/mapwidget.h"
 #include "navapp.h"
-
+#include "common/constants.h"
+#include "settings/settings.h"
+#include "route/route.h"
+#include "geo/calculations.h"
+#include "sql/sqldatabase.h"
+#include "connect/connectclient.h"
+#include "online/onlinedatacontroller.h"
+#include "userdata/userdatacontroller.h"
+#include "weather/weatherreporter.h"
+#include "weather/windreporter.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDebug>
+#include <QFileInfo>
 #include <QPixmap>
+#include <QSettings>
+#include <QUuid>
+
+/* Size of XYZ map tiles in pixel */
+const static int TILE_SIZE = 256;
 
 WebMapController::WebMapController(QWidget *parent, bool verboseParam)
   : QObject(parent), parentWidget(parent), verbose(verboseParam)
 {
   qDebug() << Q_FUNC_INFO;
+
+  // Tile widget is only needed while tiles are requested
+  tileIdleTimer.setSingleShot(true);
+  tileIdleTimer.setInterval(atools::settings::Settings::instance().
+                            getAndStoreValue(lnm::OPTIONS_WEBSERVER_TILE_IDLE_SECONDS, 300).toInt() * 1000);
+  connect(&tileIdleTimer, &QTimer::timeout, this, &WebMapController::deleteTileMapPaintWidget);
+
+  // Merge change signals which arrive in one event loop iteration
+  tileSettingsKeyTimer.setSingleShot(true);
+  tileSettingsKeyTimer.setInterval(0);
+  connect(&tileSettingsKeyTimer, &QTimer::timeout, this, &WebMapController::updateTileSettingsKey);
+
+  tileSessionId = QUuid::createUuid().toString();
 }
 
 WebMapController::~WebMapController()
@@ -49,6 +80,21 @@ void WebMapController::init()
 
   // Activate painting
   mapPaintWidget->setActive();
+
+  // Recalculate the tile key on all changes of the map content =======================
+  tileSettingsKeyConnections = {
+    connect(NavApp::getMapWidget(), &MapPaintWidget::staticLayersInvalidated,
+            this, &WebMapController::invalidateTileSettingsKey),
+    connect(NavApp::getWeatherReporter(), &WeatherReporter::weatherUpdated,
+            this, &WebMapController::tileSessionDataChanged),
+    connect(NavApp::getWindReporter(), &WindReporter::windUpdated, this, &WebMapController::tileSessionDataChanged),
+    connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineClientAndAtcUpdated,
+            this, &WebMapController::tileSessionDataChanged),
+    connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineNetworkChanged,
+            this, &WebMapController::tileSessionDataChanged),
+    connect(NavApp::getConnectClient(), &ConnectClient::dataPacketReceived, this, &WebMapController::tileSimDataChanged)
+  };
+  updateTileSettingsKey();
 }
 
 void WebMapController::deInit()
@@ -57,6 +103,23 @@ void WebMapController::deInit()
 
   delete mapPaintWidget;
   mapPaintWidget = nullptr;
+
+  for(const QMetaObject::Connection& connection : tileSettingsKeyConnections)
+    disconnect(connection);
+  tileSettingsKeyConnections.clear();
+  tileSettingsKeyTimer.stop();
+
+  deleteTileMapPaintWidget();
+}
+
+void WebMapController::deleteTileMapPaintWidget()
+{
+  if(tileMapPaintWidget != nullptr && verbose)
+    qDebug() << Q_FUNC_INFO << "Deleting idle tile map widget";
+
+  tileIdleTimer.stop();
+  delete tileMapPaintWidget;
+  tileMapPaintWidget = nullptr;
 }
 
 MapPixmap WebMapController::getPixmap(int width, int height)
@@ -169,7 +232,8 @@ MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::
       mappixmap.requestedDistanceKm = distanceKm;
 
     // Fill result object
-    mappixmap.pixmap = mapPaintWidget->getPixmap(width, height);
+    // Convert to image which can be used in other threads
+    mappixmap.image = mapPaintWidget->getPixmap(width, height).toImage();
     mappixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
     return mappixmap;
@@ -202,7 +266,7 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
 
       // No distance requested. Therefore requested is equal to actual
       mapPixmap.correctedDistanceKm = mapPixmap.requestedDistanceKm = static_cast<float>(mapPaintWidget->distance());
-      mapPixmap.pixmap = mapPaintWidget->getPixmap(width, height);
+      mapPixmap.image = mapPaintWidget->getPixmap(width, height).toImage();
       mapPixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
       return mapPixmap;
@@ -222,6 +286,160 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
   }
 }
 
+QString WebMapController::getTileSettingsKey() const
+{
+  QMutexLocker locker(&tileSettingsKeyMutex);
+  return tileSettingsKey;
+}
+
+QString WebMapController::currentTileSettingsKey()
+{
+  if(tileSettingsKeyTimer.isActive())
+  {
+    // Do not wait for the timer to avoid tiles rendered with new settings being stored under the old key
+    tileSettingsKeyTimer.stop();
+    updateTileSettingsKey();
+  }
+  return getTileSettingsKey();
+}
+
+void WebMapController::invalidateTileSettingsKey()
+{
+  {
+    QMutexLocker locker(&tileSettingsKeyMutex);
+    tileSettingsKey.clear();
+  }
+  tileSettingsKeyTimer.start();
+}
+
+void WebMapController::tileSessionDataChanged()
+{
+  tileSessionDataVersion++;
+  invalidateTileSettingsKey();
+}
+
+void WebMapController::tileSimDataChanged()
+{
+  // Active leg is highlighted in the flight plan
+  int activeLegIndex = NavApp::getRouteConst().getActiveLegIndex();
+  if(activeLegIndex != tileActiveLegIndex)
+  {
+    tileActiveLegIndex = activeLegIndex;
+    invalidateTileSettingsKey();
+  }
+}
+
+void WebMapController::updateTileSettingsKey()
+{
+  const MapWidget *mapWidget = NavApp::getMapWidget();
+  map::MapTypes types = mapWidget->getShownMapFeatures();
+  map::MapObjectDisplayTypes displayTypes = mapWidget->getShownMapFeaturesDisplay();
+
+  // Map theme and layers ==========================================
+  map::MapAirspaceFilter airspaces = mapWidget->getShownAirspaces();
+  QStringList key({mapWidget->mapThemeId(),
+                   QString::number(types, 16),
+                   QString::number(displayTypes, 16),
+                   QString::number(airspaces.types, 16), QString::number(airspaces.flags, 16),
+                   QString::number(mapWidget->getMapDetailLevel()),
+                   QString::number(mapWidget->showPlaces()), QString::number(mapWidget->showCities()),
+                   QString::number(mapWidget->showGrid()),
+                   QString::number(mapWidget->getMapWeatherSource())});
+
+  // Userpoint type filter ==========================================
+  const UserdataController *userdataController = NavApp::getUserdataController();
+  key << userdataController->getSelectedTypes() << QString::number(userdataController->isSelectedUnknownType());
+
+  // Options like colors, symbol sizes and units as saved by the options dialog and map style file ==============
+  QByteArray options;
+  QDataStream stream(&options, QIODevice::WriteOnly);
+  QSettings *settings = atools::settings::Settings::instance().getQSettings();
+  settings->beginGroup("OptionsDialog");
+  for(const QString& settingsKey : settings->allKeys())
+    stream << settingsKey << settings->value(settingsKey);
+  settings->endGroup();
+  key << QString::fromLatin1(QCryptographicHash::hash(options, QCryptographicHash::Sha1).toHex());
+
+  QFileInfo styleFileInfo(atools::settings::Settings::getConfigFilename("_mapstyle.ini"));
+  key << QString::number(styleFileInfo.lastModified().toMSecsSinceEpoch());
+
+  // Databases - file, modification time and cycle ==========================================
+  for(const atools::sql::SqlDatabase *db : {NavApp::getDatabaseSim(), NavApp::getDatabaseNav(),
+                                            NavApp::getDatabaseUser(), NavApp::getDatabaseLogbook()})
+  {
+    QFileInfo fileInfo(db->databaseName());
+    key << fileInfo.canonicalFilePath() << QString::number(fileInfo.lastModified().toMSecsSinceEpoch());
+  }
+  key << NavApp::getDatabaseAiracCycleSim() << NavApp::getDatabaseAiracCycleNav();
+
+  // Flight plan waypoints and active leg which is highlighted ====================================
+  const Route& route = NavApp::getRouteConst();
+  for(int i = 0; i < route.size(); i++)
+  {
+    const RouteLeg& leg = route.value(i);
+    key << leg.getIdent() << QString::number(leg.getPosition().getLonX(), 'f', 5) <<
+      QString::number(leg.getPosition().getLatY(), 'f', 5);
+  }
+  tileActiveLegIndex = route.getActiveLegIndex();
+  key << QString::number(tileActiveLegIndex);
+
+  // Weather, wind and online centers are only valid for this session ==============================
+  if(displayTypes.testFlag(map::AIRPORT_WEATHER) || displayTypes.testFlag(map::WIND_BARBS) ||
+     displayTypes.testFlag(map::WIND_BARBS_ROUTE) || (NavApp::isOnlineNetworkActive() && types.testFlag(map::AIRSPACE)))
+    key << tileSessionId << QString::number(tileSessionDataVersion);
+
+  QString newKey =
+    QString::fromLatin1(QCryptographicHash::hash(key.join('|').toUtf8(), QCryptographicHash::Sha1).toHex());
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << newKey;
+
+  QMutexLocker locker(&tileSettingsKeyMutex);
+  tileSettingsKey = newKey;
+}
+
+MapTile WebMapController::getTile(int z, int x, int y)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << z << x << y;
+
+  // Key matching the settings copied below
+  MapTile tile;
+  tile.settingsKey = currentTileSettingsKey();
+
+  if(tileMapPaintWidget == nullptr)
+  {
+    // Create on demand to avoid overhead if tiles are not used
+    tileMapPaintWidget = new MapPaintWidget(parentWidget, false /* no real widget - hidden */);
+    tileMapPaintWidget->setActive();
+    tileMapPaintWidget->setStaticLayersOnly(true);
+  }
+  tileIdleTimer.start();
+
+  // Copy all map settings
+  tileMapPaintWidget->copySettings(*NavApp::getMapWidget());
+  tileMapPaintWidget->setKeepWorldRect(false);
+
+  // Tiles are always Web Mercator independent of the visible map projection
+  tileMapPaintWidget->setProjection(Marble::Mercator);
+
+  // Changes with time and would require cache invalidation
+  tileMapPaintWidget->setShowSunShading(false);
+
+  // Marble shows the whole world in Mercator projection with a width of four times the radius
+  tileMapPaintWidget->setRadius((TILE_SIZE / 4) << z);
+
+  // Center of the tile in Web Mercator ======================
+  double numTiles = static_cast<double>(1 << z);
+  double lonX = (x + 0.5) / numTiles * 360. - 180.;
+  double latY = atools::geo::toDegree(std::atan(std::sinh(M_PI * (1. - 2. * (y + 0.5) / numTiles))));
+  tileMapPaintWidget->centerOn(lonX, latY);
+
+  // Convert to image which can be used in other threads
+  tile.image = tileMapPaintWidget->getPixmap(TILE_SIZE, TILE_SIZE).toImage();
+  return tile;
+}
+
 MapPaintWidget* WebMapController::getMapPaintWidget() const{
     return mapPaintWidget;
 }
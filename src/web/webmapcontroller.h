@@ -21,9 +21,10 @@
 #include "web/webflags.h"
 
 #include "geo/rect.h"
-#include <QPixmap>
+#include <QImage>
+#include <QMutex>
+#include <QTimer>
 
-class QPixmap;
 class MapPaintWidget;
 
 /*
@@ -31,7 +32,8 @@ class MapPaintWidget;
  */
 struct MapPixmap
 {
-  QPixmap pixmap;
+  /* Image instead of pixmap since it is encoded in the HTTP server threads */
+  QImage image;
   atools::geo::Pos pos; /* Map center */
   float requestedDistanceKm, /* Requested zoom distance */
         correctedDistanceKm; /* Actual zoom distance which can differ from above due to blur avoidance. */
@@ -51,16 +53,25 @@ struct MapPixmap
 
   bool isValid() const
   {
-    return !pixmap.isNull();
+    return !image.isNull();
   }
 
   bool isInvalid() const
   {
-    return pixmap.isNull();
+    return image.isNull();
   }
 
 };
 
+/*
+ * Map tile and the settings key which was valid when rendering it.
+ */
+struct MapTile
+{
+  QImage image;
+  QString settingsKey;
+};
+
 /*
  * Wraps the MapPaintWidget and provides methods to retreive map images.
  *
@@ -102,10 +113,57 @@ public:
   /* Zoom to rectangel on map. */
   MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase = tr("Invalid rectangle"));
 
+  /* Get a key built from all settings and data which change the content of map tiles like map theme, layers,
+   * options, flight plan, userpoints and database versions. Used to identify tiles in the cache and as ETag.
+   * Returns the cached key and can be called from the HTTP server threads.
+   * Returns an empty string if settings changed and the key is not recalculated yet. Use currentTileSettingsKey()
+   * in this case. */
+  QString getTileSettingsKey() const;
+
+  /* Recalculates the key if changes are pending. Has to be called in the main thread. */
+  QString currentTileSettingsKey();
+
+  /* Get a 256 x 256 pixel tile in Web Mercator projection using the XYZ numbering scheme of OpenStreetMap.
+   * Tiles contain only static layers and no aircraft, tracks, marks or copyright.
+   * Returns the settings key at the time of rendering which has to be used for caching the tile. */
+  MapTile getTile(int z, int x, int y);
+
   /* Get the map paint widget */
   MapPaintWidget* getMapPaintWidget() const;
+
 private:
+  /* Delete tile widget after it was not used for a while */
+  void deleteTileMapPaintWidget();
+
+  /* Calculate the tile settings key in the main thread. Called delayed to merge several change signals. */
+  void updateTileSettingsKey();
+
+  /* Mark key as outdated and start timer for recalculation */
+  void invalidateTileSettingsKey();
+
+  /* Weather, wind or online data which is not saved across sessions has changed */
+  void tileSessionDataChanged();
+
+  /* Check for active leg changes which are not signalled */
+  void tileSimDataChanged();
+
   MapPaintWidget *mapPaintWidget = nullptr;
+
+  /* Separate map widget for tiles which draws only static layers. Created on demand. */
+  MapPaintWidget *tileMapPaintWidget = nullptr;
+  QTimer tileIdleTimer;
+
+  /* Cached key and timer for recalculation on changes. Key is empty while changes are pending. */
+  QString tileSettingsKey;
+  mutable QMutex tileSettingsKeyMutex;
+  QTimer tileSettingsKeyTimer;
+  QVector<QMetaObject::Connection> tileSettingsKeyConnections;
+
+  /* Unique id of this program session and counter for changes of weather, wind and online data. Used to separate
+   * tiles showing this data from the ones of earlier sessions in the disk cache. */
+  QString tileSessionId;
+  int tileSessionDataVersion = 0, tileActiveLegIndex = -1;
+
   QWidget *parentWidget;
   bool verbose = false;
 };
@@ -0,0 +1,194 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webtilecache.h"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QVector>
+
+/* Evict down to this fraction of the maximum size to avoid cleaning up on each insert */
+const static double DISK_CACHE_EVICT_FACTOR = 0.9;
+
+WebTileCache::WebTileCache(const QString& cacheDirectory, int memoryCacheSizeKb, int diskCacheSizeMb)
+  : directory(cacheDirectory)
+{
+  memoryCache.setMaxCost(std::max(memoryCacheSizeKb, 0));
+  diskCacheMaxSize = static_cast<qint64>(std::max(diskCacheSizeMb, 0)) * 1024L * 1024L;
+
+  qDebug() << Q_FUNC_INFO << directory << "memory kB" << memoryCacheSizeKb << "disk MB" << diskCacheSizeMb;
+
+  if(diskCacheMaxSize > 0L)
+  {
+    if(QDir().mkpath(directory))
+      scanDiskCache();
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot create" << directory << "- disabling disk cache";
+      diskCacheMaxSize = 0L;
+    }
+  }
+}
+
+WebTileCache::~WebTileCache()
+{
+  qDebug() << Q_FUNC_INFO;
+}
+
+bool WebTileCache::get(const QString& key, QByteArray& data)
+{
+  QMutexLocker locker(&mutex);
+
+  // Memory first ===================================
+  QByteArray *cached = memoryCache.object(key);
+  if(cached != nullptr)
+  {
+    data = *cached;
+
+    // Update access time for disk LRU too
+    auto it = diskIndex.find(filename(key));
+    if(it != diskIndex.end())
+      it->lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+    return true;
+  }
+
+  // Disk ===================================
+  if(diskCacheMaxSize > 0L)
+  {
+    QString name = filename(key);
+    auto it = diskIndex.find(name);
+    if(it != diskIndex.end())
+    {
+      QFile file(directory + QDir::separator() + name);
+      if(file.open(QIODevice::ReadOnly))
+      {
+        data = file.readAll();
+        file.close();
+
+        it->lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+        memoryCache.insert(key, new QByteArray(data), data.size() / 1024 + 1);
+        return true;
+      }
+      else
+      {
+        // Removed from outside - drop from index
+        qWarning() << Q_FUNC_INFO << "Cannot open" << file.fileName() << file.errorString();
+        diskCacheSize -= it->size;
+        diskIndex.erase(it);
+      }
+    }
+  }
+  return false;
+}
+
+void WebTileCache::insert(const QString& key, const QByteArray& data)
+{
+  QMutexLocker locker(&mutex);
+
+  memoryCache.insert(key, new QByteArray(data), data.size() / 1024 + 1);
+
+  if(diskCacheMaxSize > 0L)
+  {
+    QString name = filename(key);
+    QFile file(directory + QDir::separator() + name);
+    if(file.open(QIODevice::WriteOnly))
+    {
+      file.write(data);
+      file.close();
+
+      DiskEntry& entry = diskIndex[name];
+      diskCacheSize += data.size() - entry.size;
+      entry.size = data.size();
+      entry.lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+
+      if(diskCacheSize > diskCacheMaxSize)
+        evictDiskCache();
+    }
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write" << file.fileName() << file.errorString();
+  }
+}
+
+void WebTileCache::clear()
+{
+  QMutexLocker locker(&mutex);
+
+  qDebug() << Q_FUNC_INFO << "Removing" << diskIndex.size() << "files";
+
+  memoryCache.clear();
+  for(auto it = diskIndex.constBegin(); it != diskIndex.constEnd(); ++it)
+    QFile::remove(directory + QDir::separator() + it.key());
+  diskIndex.clear();
+  diskCacheSize = 0L;
+}
+
+QString WebTileCache::filename(const QString& key)
+{
+  return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".png";
+}
+
+void WebTileCache::scanDiskCache()
+{
+  diskIndex.clear();
+  diskCacheSize = 0L;
+
+  // File modification time is the best guess for last access after restart
+  const QFileInfoList files = QDir(directory).entryInfoList({"*.png"}, QDir::Files);
+  for(const QFileInfo& fileInfo : files)
+  {
+    DiskEntry entry;
+    entry.size = fileInfo.size();
+    entry.lastUsedMs = fileInfo.lastModified().toMSecsSinceEpoch();
+    diskIndex.insert(fileInfo.fileName(), entry);
+    diskCacheSize += entry.size;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Found" << diskIndex.size() << "tiles with" << diskCacheSize / 1024 << "kB";
+
+  if(diskCacheSize > diskCacheMaxSize)
+    evictDiskCache();
+}
+
+void WebTileCache::evictDiskCache()
+{
+  // Sort by access time - oldest first
+  QVector<std::pair<qint64, QString> > entries;
+  entries.reserve(diskIndex.size());
+  for(auto it = diskIndex.constBegin(); it != diskIndex.constEnd(); ++it)
+    entries.append(std::make_pair(it->lastUsedMs, it.key()));
+  std::sort(entries.begin(), entries.end());
+
+  qint64 targetSize = static_cast<qint64>(diskCacheMaxSize * DISK_CACHE_EVICT_FACTOR);
+  int removed = 0;
+  for(const std::pair<qint64, QString>& entry : entries)
+  {
+    if(diskCacheSize <= targetSize)
+      break;
+
+    QFile::remove(directory + QDir::separator() + entry.second);
+    diskCacheSize -= diskIndex.value(entry.second).size;
+    diskIndex.remove(entry.second);
+    removed++;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Removed" << removed << "tiles. Size now" << diskCacheSize / 1024 << "kB";
+}
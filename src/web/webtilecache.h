@@ -0,0 +1,80 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBTILECACHE_H
+#define LNM_WEBTILECACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+
+/*
+ * Thread safe two level cache for encoded map tiles served by the web server.
+ *
+ * First level is a memory cache limited by size. Second level is a folder on disk where each tile is stored in a
+ * file named by the hash of the key. Least recently used files are deleted if the disk cache exceeds its size.
+ *
+ * Keys have to contain all settings that change the tile content like layer settings and database version.
+ * Tiles for outdated keys are never requested again and are removed by the LRU eviction eventually.
+ */
+class WebTileCache
+{
+public:
+  /* Scans the disk cache folder which is created if missing. Disk cache is disabled if diskCacheSizeMb is 0. */
+  WebTileCache(const QString& cacheDirectory, int memoryCacheSizeKb, int diskCacheSizeMb);
+  ~WebTileCache();
+
+  WebTileCache(const WebTileCache& other) = delete;
+  WebTileCache& operator=(const WebTileCache& other) = delete;
+
+  /* Get tile from memory or disk cache. Returns false if not found. Tiles found on disk are added to memory cache. */
+  bool get(const QString& key, QByteArray& data);
+
+  /* Add tile to memory and disk cache and remove the least recently used files if the disk cache is full */
+  void insert(const QString& key, const QByteArray& data);
+
+  /* Remove all tiles from memory and disk */
+  void clear();
+
+private:
+  /* Used to find the least recently used files on disk */
+  struct DiskEntry
+  {
+    qint64 size = 0L, lastUsedMs = 0L;
+  };
+
+  /* Tile filename without path for key */
+  static QString filename(const QString& key);
+
+  /* Build index from files in cache folder */
+  void scanDiskCache();
+
+  /* Delete least recently used files until size is below limit */
+  void evictDiskCache();
+
+  QMutex mutex;
+
+  /* Cost is size in kB */
+  QCache<QString, QByteArray> memoryCache;
+
+  /* Filename to size and last access time */
+  QHash<QString, DiskEntry> diskIndex;
+  qint64 diskCacheSize = 0L, diskCacheMaxSize = 0L;
+  QString directory;
+};
+
+#endif // LNM_WEBTILECACHE_H
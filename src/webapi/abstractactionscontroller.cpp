@@ -21,6 +21,7 @@
 #include "geo/pos.h"
 #include "common/abstractinfobuilder.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
 
 AbstractActionsController::AbstractActionsController(QObject *parent, bool verboseParam, AbstractInfoBuilder* infoBuilder) : QObject(parent), verbose(verboseParam), infoBuilder(infoBuilder)
@@ -60,3 +61,9 @@ WebApiResponse AbstractActionsController::getResponse(){
 
     return response;
 }
+
+void AbstractActionsController::setETag(WebApiResponse& response){
+
+    response.headers.replace("ETag", '"' + QCryptographicHash::hash(response.body, QCryptographicHash::Sha1).toHex() + '"');
+
+}
@@ -48,6 +48,11 @@ protected:
      * @return
      */
     WebApiResponse getResponse();
+    /**
+     * @brief add a strong ETag header built from the body.
+     * RequestHandler answers matching If-None-Match requests with 304.
+     */
+    void setETag(WebApiResponse& response);
     /**
      * @brief verbose
      */
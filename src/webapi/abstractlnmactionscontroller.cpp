@@ -27,6 +27,9 @@
 #include "sql/sqlrecord.h"
 #include "fs/util/morsecode.h"
 #include "fs/sc/simconnectdata.h"
+#include "sql/sqldatabase.h"
+
+#include <QFileInfo>
 
 namespace ageo = atools::geo;
 using atools::fs::util::MorseCode;
@@ -150,3 +153,21 @@ const QString AbstractLnmActionsController::getActiveDateTimeSource(){
 const SimConnectData AbstractLnmActionsController::getSimConnectData(){
     return getNavApp()->getSimConnectData();
 };
+
+QString AbstractLnmActionsController::getDatabaseVersionKey(){
+    QStringList key;
+    for(const atools::sql::SqlDatabase *db : {getNavApp()->getDatabaseSim(), getNavApp()->getDatabaseNav()}){
+        QFileInfo fileInfo(db->databaseName());
+        key << fileInfo.canonicalFilePath() << QString::number(fileInfo.lastModified().toMSecsSinceEpoch());
+    }
+    key << getNavApp()->getDatabaseAiracCycleSim() << getNavApp()->getDatabaseAiracCycleNav();
+    return key.join('|');
+}
+
+QString AbstractLnmActionsController::getWeatherKey(const map::WeatherContext& weatherContext){
+    QStringList key({weatherContext.asMetar, weatherContext.asType});
+    for(const atools::fs::weather::MetarResult *metar : {&weatherContext.fsMetar, &weatherContext.ivaoMetar,
+                                                         &weatherContext.noaaMetar, &weatherContext.vatsimMetar})
+        key << metar->metarForStation << metar->metarForNearest << metar->metarForInterpolated;
+    return key.join('|');
+}
@@ -93,6 +93,16 @@ protected:
     const QDateTime getActiveDateTime();
     const QString getActiveDateTimeSource();
     const SimConnectData getSimConnectData();
+
+    // Keys for response caches
+    /**
+     * @brief changes with simulator and navigation database files and AIRAC cycles
+     */
+    QString getDatabaseVersionKey();
+    /**
+     * @brief changes with any METAR in the weather context
+     */
+    QString getWeatherKey(const map::WeatherContext& weatherContext);
 private:
     MorseCode* morseCode;
     QTime calculateSunriseSunset(const Pos& pos, float zenith);
@@ -3,10 +3,12 @@
 #include "simactionscontroller.h"
 #include "uiactionscontroller.h"
 
-void ActionsControllerIndex::registerQMetaTypes()
+QVector<const QMetaObject *> ActionsControllerIndex::getControllerMetaObjects()
 {
     /* Available action controllers must be registered here */
-    qRegisterMetaType<AirportActionsController*>();
-    qRegisterMetaType<SimActionsController*>();
-    qRegisterMetaType<UiActionsController*>();
+    return {
+        &AirportActionsController::staticMetaObject,
+        &SimActionsController::staticMetaObject,
+        &UiActionsController::staticMetaObject
+    };
 }
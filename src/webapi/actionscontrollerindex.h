@@ -1,16 +1,24 @@
 #ifndef ACTIONSCONTROLLERINDEX_H
 #define ACTIONSCONTROLLERINDEX_H
 
+#include <QVector>
+
+struct QMetaObject;
+
 /**
  * @brief Available action controller classes registry.
- * Class providing static QMetaType registration to keep
+ * Class providing the meta objects of all controllers to keep
  * action controller declarations separated from WebApiController.
- * Available action controllers must be reqistered inside ::registerQMetaTypes
+ * Available action controllers must be reqistered inside ::getControllerMetaObjects
  */
 class ActionsControllerIndex
 {
 public:
-    static void registerQMetaTypes();
+    /**
+     * @brief meta objects used to instantiate controllers and
+     * to build the route table once at startup
+     */
+    static QVector<const QMetaObject *> getControllerMetaObjects();
 };
 
 #endif // ACTIONSCONTROLLERINDEX_H
@@ -22,6 +22,7 @@
 
 using InfoBuilderTypes::AirportInfoData;
 
+#include <QCryptographicHash>
 #include <QDebug>
 
 AirportActionsController::AirportActionsController(QObject *parent, bool verboseParam, AbstractInfoBuilder* infoBuilder) :
@@ -29,6 +30,8 @@ AirportActionsController::AirportActionsController(QObject *parent, bool verbose
 {
     if(verbose)
         qDebug() << Q_FUNC_INFO;
+
+    infoCache.setMaxCost(200);
 }
 
 WebApiResponse AirportActionsController::infoAction(WebApiRequest request){
@@ -43,6 +46,26 @@ WebApiResponse AirportActionsController::infoAction(WebApiRequest request){
 
     if(airport.isValid()){
 
+        // Weather is needed for the cache key
+        map::WeatherContext weatherContext = getWeatherContext(airport);
+
+        // Active time is given with minute resolution to allow caching. Sunrise and sunset depend on the date.
+        QDateTime activeDateTime = getActiveDateTime();
+        activeDateTime.setTime(QTime(activeDateTime.time().hour(), activeDateTime.time().minute()));
+        const QString activeDateTimeSource = getActiveDateTimeSource();
+
+        QByteArray key = QCryptographicHash::hash(
+            QStringList({airport.ident, QString::number(airport.id), getDatabaseVersionKey(),
+                         getWeatherKey(weatherContext), activeDateTime.toString(Qt::ISODate),
+                         activeDateTimeSource}).join('|').toUtf8(), QCryptographicHash::Sha1);
+
+        WebApiResponse *cached = infoCache.object(key);
+        if(cached != nullptr){
+            if(verbose)
+                qDebug() << Q_FUNC_INFO << "cached" << airport.ident;
+            return *cached;
+        }
+
         // Fetch related data
         const SqlRecord* airportInformation = getAirportInformation(airport.id);
         const AirportAdminNames airportAdminNames = getAirportAdminNames(airport);
@@ -50,13 +73,11 @@ WebApiResponse AirportActionsController::infoAction(WebApiRequest request){
 
         const QTime sunrise = getSunrise(*airportInformation);
         const QTime sunset =  getSunset(*airportInformation);
-        const QDateTime activeDateTime = getActiveDateTime();
-        const QString activeDateTimeSource = getActiveDateTimeSource();
 
         // Compose data container
         AirportInfoData data = {
             airport,
-            getWeatherContext(airport),
+            weatherContext,
             nullptr,
             airportInformation,
             &airportAdminNames,
@@ -71,6 +92,10 @@ WebApiResponse AirportActionsController::infoAction(WebApiRequest request){
         response.body = infoBuilder->airport(data);
         response.status = 200;
 
+        // Strong validator for If-None-Match requests
+        setETag(response);
+        infoCache.insert(key, new WebApiResponse(response));
+
     }else{
 
         response.body = "Airport not found";
@@ -20,6 +20,8 @@
 
 #include "webapi/abstractlnmactionscontroller.h"
 
+#include <QCache>
+
 /**
  * @brief Airport actions controller implementation.
  */
@@ -33,6 +35,12 @@ public:
      * @brief get airport info
      */
     Q_INVOKABLE WebApiResponse infoAction(WebApiRequest request);
+private:
+    /**
+     * @brief airport info responses including ETag header keyed by
+     * ident, database versions, weather and active minute
+     */
+    QCache<QByteArray, WebApiResponse> infoCache;
 };
 
 #endif // AIRPORTACTIONSCONTROLLER_H
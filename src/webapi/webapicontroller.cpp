@@ -17,12 +17,16 @@
 
 #include "webapi/webapicontroller.h"
 #include "webapi/actionscontrollerindex.h"
+#include "webapi/webapistream.h"
 
 #include "common/jsoninfobuilder.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QMetaMethod>
 
+/* Maximum number of actions in one batch request */
+const static int MAX_BATCH_SIZE = 64;
 
 WebApiController::WebApiController(QObject *parent, bool verboseParam)
   : QObject(parent), verbose(verboseParam)
@@ -31,12 +35,55 @@ WebApiController::WebApiController(QObject *parent, bool verboseParam)
         qDebug() << Q_FUNC_INFO;
 
     webApiPathPrefix = "/api";
-    registerControllers();
+    webApiStreamPath = webApiPathPrefix + "/stream";
+    stream = new WebApiStream(this, verbose);
+
+    /* Controllers need the info builder */
     registerInfoBuilders();
+    registerControllers();
 }
 
 void WebApiController::registerControllers(){
-    ActionsControllerIndex::registerQMetaTypes();
+
+    for(const QMetaObject *mo : ActionsControllerIndex::getControllerMetaObjects()){
+
+        QObject* controller = mo->newInstance(
+                    Q_ARG(QObject*, parent()),
+                    Q_ARG(bool, verbose),
+                    Q_ARG(AbstractInfoBuilder*, infoBuilder)
+                    );
+
+        if(controller == nullptr){
+            qWarning() << Q_FUNC_INFO << "Cannot instantiate" << mo->className();
+            continue;
+        }
+
+        /* AirportActionsController -> /airport */
+        QByteArray controllerPath(mo->className());
+        controllerPath.chop(static_cast<int>(qstrlen("ActionsController")));
+        controllerPath[0] = static_cast<char>(tolower(controllerPath.at(0)));
+        controllerPath.prepend('/');
+        controllerPaths.insert(controllerPath);
+
+        /* Collect all invokable actions including the inherited ones: infoAction -> /airport/info */
+        for(int i = 0; i < mo->methodCount(); i++){
+            QMetaMethod method = mo->method(i);
+            QByteArray name = method.name();
+
+            if(method.methodType() == QMetaMethod::Method && name.endsWith("Action") &&
+               method.parameterCount() == 1 && qstrcmp(method.typeName(), "WebApiResponse") == 0){
+                name.chop(static_cast<int>(qstrlen("Action")));
+
+                Endpoint endpoint;
+                endpoint.controller = controller;
+                endpoint.methodIndex = i;
+                endpoints.insert(controllerPath + '/' + name, endpoint);
+            }
+        }
+    }
+
+    if(verbose)
+        qDebug() << Q_FUNC_INFO << "Endpoints" << endpoints.keys();
 }
 
 void WebApiController::registerInfoBuilders(){
@@ -55,53 +102,31 @@ WebApiResponse WebApiController::service(WebApiRequest& request)
   // Create response object
   WebApiResponse response;
 
-  // Set default content type
-  response.headers.insert("Content-Type","text/plain");
-
-  // Get controller and action names by string
-  QByteArray controllerName = getControllerNameByPath(request.path);
-  QByteArray actionName = getActionNameByPath(request.path);
-
   if(verbose)
       qDebug() << Q_FUNC_INFO << ":"
                << request.method << ":"
                << request.path << ":"
-               << controllerName << ":"
-               << actionName << ":"
                << request.body;
 
 
   if(request.method == "OPTIONS"){
 
       /* Pass through preflight request */
+      response.headers.insert("Content-Type","text/plain");
       response.status = 200;
 
-  }else{
+  }else if(request.path == "/batch"){
 
-      /* Process REST controller/action request */
+      response = batchAction(request);
 
-      QObject* controller = getControllerInstance(controllerName);
+  }else if(request.path == "/stats"){
 
-      if (controller != nullptr) {
+      response = statsAction();
 
-          // Invoke action on instance
-          bool actionExecuted = QMetaObject::invokeMethod(
-                      controller,
-                      actionName.data(),
-                      Qt::DirectConnection,
-                      Q_RETURN_ARG(WebApiResponse,response), // Note: overwriting response
-                      Q_ARG(WebApiRequest, request)
-                      );
-
-          if(!actionExecuted){
-              response.status = 400; /* Bad request */
-              response.body = "Action not found/failed";
-          }
+  }else{
 
-      }else{
-          response.status = 400; /* Bad request */
-          response.body = "Controller not found";
-      }
+      /* Process REST controller/action request */
+      response = invokeAction(request);
 
   }
 
@@ -111,56 +136,148 @@ WebApiResponse WebApiController::service(WebApiRequest& request)
 
 }
 
-QByteArray WebApiController::getControllerNameByPath(QByteArray path){
-    QByteArray name = "AbstractActionsController"; /* Default fallback */
-    QList<QByteArray> list = path.split('/');
-    if(list.length() > 1 && list[1].length() > 0){
-        name = list[1]+"ActionsController";
-        /* upper case first letter to enable lowercase controller URL's */
-        name[0] = toupper(name[0]);
-        return name;
+WebApiResponse WebApiController::invokeAction(WebApiRequest& request){
+
+    QByteArray key = getEndpointKey(request.path);
+
+    auto it = endpoints.find(key);
+    if(it == endpoints.end() && controllerPaths.contains(key)){
+        /* Controller without action */
+        it = endpoints.find(key + "/notFound");
     }
-    return name;
-};
-QByteArray WebApiController::getActionNameByPath(QByteArray path){
-    QByteArray name = "notFoundAction"; /* Default fallback */
-    QList<QByteArray> list = path.split('/');
-    if(list.length() > 2 && list[2].length() > 0){
-        name = list[2]+"Action";
+
+    WebApiResponse response;
+    if(it != endpoints.end()){
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // Invoke precompiled action directly - note: overwriting response
+        void *args[] = {&response, &request};
+        if(QMetaObject::metacall(it->controller, QMetaObject::InvokeMetaMethod, it->methodIndex, args) >= 0){
+            response.headers.insert("Content-Type","text/plain");
+            response.status = 400; /* Bad request */
+            response.body = "Action not found/failed";
+        }
+
+        qint64 elapsed = timer.nsecsElapsed();
+        it->calls++;
+        it->totalNs += elapsed;
+        it->maxNs = std::max(it->maxNs, elapsed);
+        if(response.status >= 400)
+            it->errors++;
+
+    }else{
+        response.headers.insert("Content-Type","text/plain");
+        response.status = 400; /* Bad request */
+        response.body = controllerPaths.contains(key.left(key.indexOf('/', 1))) ?
+                    "Action not found/failed" : "Controller not found";
     }
-    return name;
-};
+    return response;
+}
 
-void WebApiController::addCommonResponseHeaders(WebApiResponse &response){
+WebApiResponse WebApiController::batchAction(WebApiRequest& request){
 
-    /* CORS: Enable cross-origin requests */
-    response.headers.insert("Access-Control-Allow-Origin","*");
-    response.headers.insert("Access-Control-Allow-Methods","GET, PUT, POST, DELETE");
-    response.headers.insert("Access-Control-Allow-Headers","content-type");
+    WebApiResponse response;
+    response.headers.insert("Content-Type", "application/json");
 
-}
+    // Collect requests from JSON body or path parameters ===========================
+    JSON requests = JSON::array();
+    if(!request.body.isEmpty()){
+        requests = JSON::parse(request.body.constData(), nullptr, false /* no exceptions */);
+    }else{
+        for(const QByteArray& path : request.parameters.values("path"))
+            requests.push_back({{"path", path.toStdString()}});
+    }
 
-QObject* WebApiController::getControllerInstance(QByteArray controllerName){
+    if(!requests.is_array() || requests.size() > MAX_BATCH_SIZE){
+        response.status = 400; /* Bad request */
+        response.body = JSON({{"error", "Invalid batch request"}}).dump().data();
+        return response;
+    }
 
-    // Return stored controller if available
-    if(controllerInstances.contains(controllerName)){
-        return controllerInstances[controllerName];
+    // Execute all actions in order ===========================
+    JSON results = JSON::array();
+    for(const JSON& item : requests){
+
+        WebApiRequest itemRequest;
+        itemRequest.method = "GET";
+        itemRequest.headers = request.headers;
+
+        if(item.is_object()){
+            auto path = item.find("path");
+            if(path != item.end() && path->is_string())
+                itemRequest.path = QByteArray::fromStdString(path->get<std::string>());
+
+            auto parameters = item.find("parameters");
+            if(parameters != item.end() && parameters->is_object()){
+                for(auto it = parameters->begin(); it != parameters->end(); ++it)
+                    itemRequest.parameters.insert(QByteArray::fromStdString(it.key()),
+                                                  QByteArray::fromStdString(it->is_string() ?
+                                                                                it->get<std::string>() : it->dump()));
+            }
+        }
+
+        WebApiResponse itemResponse = invokeAction(itemRequest);
+
+        // Embed JSON bodies as is and all others as string
+        JSON body = JSON::parse(itemResponse.body.constData(), nullptr, false /* no exceptions */);
+        if(body.is_discarded())
+            body = itemResponse.body.toStdString();
+
+        results.push_back({
+            {"path", itemRequest.path.toStdString()},
+            {"status", itemResponse.status},
+            {"body", body}
+        });
     }
-    // Get controller class id
-    int id = QMetaType::type(controllerName+"*");
-    if (id != 0) {
-        // Instantiate
-        const QMetaObject* mo = QMetaType::metaObjectForType(id);
-        QObject* controller = mo->newInstance(
-                    Q_ARG(QObject*, parent()),
-                    Q_ARG(bool, verbose),
-                    Q_ARG(AbstractInfoBuilder*, infoBuilder)
-                    );
 
-        // Store instance
-        controllerInstances.insert(controllerName,controller);
+    response.status = 200;
+    response.body = QByteArray::fromStdString(results.dump());
+    return response;
+}
 
-        return controller;
+WebApiResponse WebApiController::statsAction(){
+
+    JSON stats = JSON::array();
+    for(auto it = endpoints.constBegin(); it != endpoints.constEnd(); ++it){
+        const Endpoint& endpoint = it.value();
+        if(endpoint.calls > 0)
+            stats.push_back({
+                {"path", it.key().toStdString()},
+                {"calls", endpoint.calls},
+                {"errors", endpoint.errors},
+                {"average_ms", endpoint.totalNs / static_cast<double>(endpoint.calls) / 1000000.},
+                {"max_ms", endpoint.maxNs / 1000000.}
+            });
     }
-    return nullptr;
+
+    WebApiResponse response;
+    response.headers.insert("Content-Type", "application/json");
+    response.status = 200;
+    response.body = QByteArray::fromStdString(JSON({{"endpoints", stats}}).dump());
+    return response;
+}
+
+QByteArray WebApiController::getEndpointKey(const QByteArray& path){
+    /* Path is "/controller/action/..." - ignore everything after action */
+    int end = path.indexOf('/', 1);
+    if(end != -1)
+        end = path.indexOf('/', end + 1);
+
+    QByteArray key = end == -1 ? path : path.left(end);
+
+    /* lower case first letter of controller to accept upper case controller URL's too */
+    if(key.size() > 1)
+        key[1] = static_cast<char>(tolower(key.at(1)));
+    return key;
+}
+
+void WebApiController::addCommonResponseHeaders(WebApiResponse &response){
+
+    /* CORS: Enable cross-origin requests */
+    response.headers.insert("Access-Control-Allow-Origin","*");
+    response.headers.insert("Access-Control-Allow-Methods","GET, PUT, POST, DELETE");
+    response.headers.insert("Access-Control-Allow-Headers","content-type");
+
 }
@@ -18,11 +18,15 @@
 #ifndef LNM_WebApiController_H
 #define LNM_WebApiController_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include "webapi/webapirequest.h"
 #include "webapi/webapiresponse.h"
 #include "common/abstractinfobuilder.h"
 
+class WebApiStream;
+
 /**
  * @brief The WebApiController class resolving WebApiRequests to WebApiResponses
  */
@@ -45,33 +49,60 @@ public:
   QString webApiPathPrefix;
 
   /**
-   * @brief Resolves request path to requested controller and action.
-   * Instantiates requested controller dynamically and invokes method/action
-   * to process the response to return.
+   * @brief Resolves request path to requested controller and action
+   * using the route table built at startup and invokes method/action
+   * to process the response to return. Paths /batch and /stats are
+   * handled by this class.
    * @example e.g. /airport/default -> AirportActionsController::defaultAction(...)
    * @param request
    * @return response
    */
   WebApiResponse service(WebApiRequest& request);
 
+  /**
+   * @brief path of the Server-Sent Events live data stream below webApiPathPrefix
+   * @example e.g. "/api/stream"
+   */
+  QString webApiStreamPath;
+
+  /**
+   * @brief live data stream which is served directly by the HTTP server threads
+   */
+  WebApiStream *getStream() const
+  {
+    return stream;
+  }
+
 private:
+  WebApiStream *stream;
+
+  /**
+   * @brief precompiled action of a controller and its statistics
+   */
+  struct Endpoint
+  {
+    QObject *controller = nullptr;
+    int methodIndex = -1;
+
+    /* Statistics for /stats */
+    qint64 calls = 0L, errors = 0L, totalNs = 0L, maxNs = 0L;
+  };
 
   /**
-   * @brief already instanced controllers keyed
-   * by controller name
+   * @brief route table built once at startup keyed by path
+   * @example e.g. "/airport/info"
    */
-  QMap<QString,QObject *> controllerInstances;
+  QHash<QByteArray, Endpoint> endpoints;
 
   /**
-   * @brief return stored action controller instance
-   * or instantiate a new one for the given name
-   * @param controllerName
-   * @return the controller instance
+   * @brief paths of all controllers
+   * @example e.g. "/airport"
    */
-  QObject* getControllerInstance(QByteArray controllerName);
+  QSet<QByteArray> controllerPaths;
 
   /**
-   * @brief register available controllers for dynamic invocation
+   * @brief instantiate all available controllers and fill
+   * the route table with their actions
    */
   void registerControllers();
   /**
@@ -84,18 +115,31 @@ private:
    * @brief requested content-type info builder
    */
   AbstractInfoBuilder* infoBuilder;
+
+  /**
+   * @brief find endpoint for path, invoke action and update statistics
+   * @param request
+   * @return response
+   */
+  WebApiResponse invokeAction(WebApiRequest& request);
+
   /**
-   * @brief create controller name from path string
-   * @param path
-   * @return the controller class name
+   * @brief execute several actions in one request
+   * @example e.g. POST /batch with [{"path":"/sim/info"},{"path":"/airport/info","parameters":{"ident":"EDDF"}}]
+   * or GET /batch?path=/sim/info&path=/ui/info
    */
-  QByteArray getControllerNameByPath(QByteArray path);
+  WebApiResponse batchAction(WebApiRequest& request);
+
+  /**
+   * @brief call counts and latencies of all endpoints as JSON
+   */
+  WebApiResponse statsAction();
+
   /**
-   * @brief create action name from path string
-   * @param path
-   * @return the action method name
+   * @brief get route table key from path by using the first two path elements
+   * @example e.g. "/airport/info/something" -> "/airport/info"
    */
-  QByteArray getActionNameByPath(QByteArray path);
+  static QByteArray getEndpointKey(const QByteArray& path);
 
   /**
    * @brief add headers common to all responses
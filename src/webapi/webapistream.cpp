@@ -0,0 +1,216 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "webapi/webapistream.h"
+
+#include "common/constants.h"
+#include "common/infobuildertypes.h"
+#include "fs/sc/simconnectdata.h"
+#include "mapgui/mapwidget.h"
+#include "navapp.h"
+#include "settings/settings.h"
+#include "web/webcontroller.h"
+#include "web/webmapcontroller.h"
+
+#include <QDebug>
+
+/* Number of delta events kept for subscribers which are behind */
+const static int MAX_DELTA_EVENTS = 32;
+
+WebApiStream::WebApiStream(QObject *parent, bool verboseParam)
+    : QObject(parent), verbose(verboseParam)
+{
+    if(verbose)
+        qDebug() << Q_FUNC_INFO;
+
+    infoBuilder = new JsonInfoBuilder(this);
+
+    int interval = atools::settings::Settings::instance().
+                   getAndStoreValue(lnm::OPTIONS_WEBSERVER_STREAM_INTERVAL, 250).toInt();
+    timer.setInterval(std::max(interval, 50));
+    connect(&timer, &QTimer::timeout, this, &WebApiStream::publish);
+}
+
+WebApiStream::~WebApiStream()
+{
+    stop();
+}
+
+void WebApiStream::start()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopped = false;
+    }
+    timer.start();
+}
+
+void WebApiStream::stop()
+{
+    timer.stop();
+    reset();
+
+    // Release all subscribers waiting in server threads
+    QMutexLocker locker(&mutex);
+    stopped = true;
+    eventsAvailable.wakeAll();
+}
+
+void WebApiStream::subscribe()
+{
+    int num = subscribers.fetchAndAddOrdered(1) + 1;
+    if(verbose)
+        qDebug() << Q_FUNC_INFO << "subscribers" << num;
+}
+
+void WebApiStream::unsubscribe()
+{
+    int num = subscribers.fetchAndAddOrdered(-1) - 1;
+    if(verbose)
+        qDebug() << Q_FUNC_INFO << "subscribers" << num;
+}
+
+bool WebApiStream::isStopped() const
+{
+    QMutexLocker locker(&mutex);
+    return stopped;
+}
+
+bool WebApiStream::waitForEvents(qint64& lastSequence, QByteArray& events, unsigned long timeoutMs)
+{
+    QMutexLocker locker(&mutex);
+
+    if(!stopped && (fullEvent.isEmpty() || lastSequence == sequence))
+        eventsAvailable.wait(&mutex, timeoutMs);
+
+    if(stopped || fullEvent.isEmpty() || lastSequence == sequence)
+        // Timeout or nothing new
+        return false;
+
+    if(lastSequence >= 0 && lastSequence < sequence &&
+       !deltaEvents.isEmpty() && deltaEvents.first().first <= lastSequence + 1)
+    {
+        // All deltas since the last event of the subscriber are available
+        for(const std::pair<qint64, QByteArray>& delta : deltaEvents)
+        {
+            if(delta.first > lastSequence)
+                events.append(delta.second);
+        }
+    }
+    else
+        // New, reconnected or too slow subscriber
+        events = fullEvent;
+
+    lastSequence = sequence;
+    return true;
+}
+
+void WebApiStream::publish()
+{
+    if(subscribers.load() == 0)
+    {
+        // Nobody listening - do not collect state and drop events which would be outdated for new subscribers
+        if(lastStateValid)
+            reset();
+        return;
+    }
+
+    // Collect state once for all subscribers ===================================
+    atools::fs::sc::SimConnectData simConnectData = NavApp::getSimConnectData();
+    SimConnectInfoData simData = {
+        &simConnectData
+    };
+
+    const MapWidget *mapWidget = NavApp::getMapWidget();
+    const MapPaintWidget *webMapWidget = NavApp::getWebController()->getWebMapController()->getMapPaintWidget();
+    UiInfoData uiData = {
+        mapWidget->zoom(),
+        webMapWidget != nullptr ? webMapWidget->zoom() : 0,
+        mapWidget->distance(),
+        webMapWidget != nullptr ? webMapWidget->distance() : 0.
+    };
+
+    JSON state = {
+        {"sim", infoBuilder->siminfoJson(simData)},
+        {"ui", infoBuilder->uiinfoJson(uiData)}
+    };
+
+    if(lastStateValid && state == lastState)
+        // Nothing changed
+        return;
+
+    // Serialize events once ===================================
+    QMutexLocker locker(&mutex);
+    sequence++;
+    fullEvent = eventText(sequence, "full", state);
+
+    if(lastStateValid)
+    {
+        deltaEvents.append(std::make_pair(sequence, eventText(sequence, "delta", mergePatch(lastState, state))));
+        if(deltaEvents.size() > MAX_DELTA_EVENTS)
+            deltaEvents.removeFirst();
+    }
+    else
+        deltaEvents.clear();
+
+    lastState = state;
+    lastStateValid = true;
+
+    eventsAvailable.wakeAll();
+}
+
+void WebApiStream::reset()
+{
+    lastState = JSON();
+    lastStateValid = false;
+
+    QMutexLocker locker(&mutex);
+    fullEvent.clear();
+    deltaEvents.clear();
+}
+
+JSON WebApiStream::mergePatch(const JSON& from, const JSON& to)
+{
+    if(!from.is_object() || !to.is_object())
+        return to;
+
+    JSON patch = JSON::object();
+
+    // Changed and new values
+    for(auto it = to.begin(); it != to.end(); ++it)
+    {
+        auto fromIt = from.find(it.key());
+        if(fromIt == from.end())
+            patch[it.key()] = it.value();
+        else if(*fromIt != it.value())
+            patch[it.key()] = mergePatch(*fromIt, it.value());
+    }
+
+    // Removed values are null
+    for(auto it = from.begin(); it != from.end(); ++it)
+    {
+        if(to.find(it.key()) == to.end())
+            patch[it.key()] = nullptr;
+    }
+    return patch;
+}
+
+QByteArray WebApiStream::eventText(qint64 id, const char *type, const JSON& json)
+{
+    return "id: " + QByteArray::number(id) + "\nevent: " + type + "\ndata: " +
+           QByteArray::fromStdString(json.dump()) + "\n\n";
+}
@@ -0,0 +1,130 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBAPISTREAM_H
+#define LNM_WEBAPISTREAM_H
+
+#include "common/jsoninfobuilder.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+#include <QWaitCondition>
+
+/**
+ * @brief Publishes simulator and ui state as Server-Sent Events to all
+ * subscribers of the live data stream.
+ *
+ * State is collected in the main thread at a fixed interval only while
+ * subscribers are connected. It is serialized once and shared by all
+ * subscribers which wait in the HTTP server threads.
+ *
+ * The first event for a subscriber is "full" containing the whole state.
+ * Following "delta" events contain only changed values as JSON merge patch
+ * (RFC 7386). Event ids are sequence numbers. A subscriber which is too far
+ * behind or reconnects with an unknown Last-Event-ID gets a "full" event again.
+ */
+class WebApiStream :
+        public QObject
+{
+    Q_OBJECT
+public:
+    WebApiStream(QObject *parent, bool verboseParam);
+    virtual ~WebApiStream() override;
+
+    WebApiStream(const WebApiStream& other) = delete;
+    WebApiStream& operator=(const WebApiStream& other) = delete;
+
+    /**
+     * @brief start publishing. Called in main thread when the web server starts.
+     */
+    void start();
+
+    /**
+     * @brief stop publishing and release all waiting subscribers.
+     * Called in main thread before the web server shuts down.
+     */
+    void stop();
+
+    /**
+     * @brief thread safe. Register or unregister a subscriber.
+     * State is only collected if at least one subscriber is registered.
+     */
+    void subscribe();
+    void unsubscribe();
+
+    /**
+     * @brief thread safe. Wait until events newer than lastSequence are
+     * available or timeout is reached.
+     * @param lastSequence id of the last event received by the subscriber
+     * or -1 for none. Updated with the id of the last returned event.
+     * @param events one or more formatted events which can be written as is
+     * @return false if nothing is available, timeout is reached or stream is stopped
+     */
+    bool waitForEvents(qint64& lastSequence, QByteArray& events, unsigned long timeoutMs);
+
+    /**
+     * @brief thread safe. true if subscribers have to disconnect.
+     */
+    bool isStopped() const;
+
+private:
+    /**
+     * @brief collect state, build delta and wake up subscribers. Called by timer.
+     */
+    void publish();
+
+    /**
+     * @brief clear state and events after all subscribers left
+     */
+    void reset();
+
+    /**
+     * @brief JSON merge patch which converts from into to
+     */
+    static JSON mergePatch(const JSON& from, const JSON& to);
+
+    /**
+     * @brief format a Server-Sent Event
+     */
+    static QByteArray eventText(qint64 id, const char *type, const JSON& json);
+
+    bool verbose = false;
+
+    /**
+     * @brief used in main thread only
+     */
+    QTimer timer;
+    JsonInfoBuilder *infoBuilder;
+    JSON lastState;
+    bool lastStateValid = false;
+
+    /**
+     * @brief shared with subscribers and protected by mutex
+     */
+    mutable QMutex mutex;
+    QWaitCondition eventsAvailable;
+    qint64 sequence = 0L;
+    QByteArray fullEvent;
+    QVector<std::pair<qint64, QByteArray> > deltaEvents;
+    bool stopped = true;
+
+    QAtomicInt subscribers = 0;
+};
+
+#endif // LNM_WEBAPISTREAM_H
@@ -0,0 +1,235 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "aircrafttracktest.h"
+
+#include "common/aircrafttrack.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cmath>
+#include <limits>
+
+using atools::geo::LineString;
+using atools::geo::Pos;
+
+namespace {
+
+/* Wavy trail to the east with small deviations */
+Pos wavePos(int i, float startLonX = 0.f)
+{
+  return Pos(startLonX + i * 0.001f, 0.0005f * std::sin(i * 0.3f) + 0.002f * std::sin(i * 0.01f), 5000.f);
+}
+
+/* Levels start at the first position and end at the last simplified one. Chunk offsets point to the
+ * positions at the chunk boundaries. */
+void verifySegment(const at::AircraftTrackSegment& segment)
+{
+  QVERIFY(!segment.line.isEmpty());
+
+  for(const Pos& pos : segment.line)
+    QVERIFY(segment.crossesAntiMeridian || segment.bounding.contains(pos));
+
+  if(segment.levels.isEmpty())
+  {
+    QCOMPARE(segment.simplifiedSize, 0);
+    QVERIFY(segment.chunkEnds.isEmpty());
+    return;
+  }
+
+  QVERIFY(!segment.chunkEnds.isEmpty());
+  QCOMPARE(segment.chunkEnds.last() + 1, segment.simplifiedSize);
+  QVERIFY(segment.simplifiedSize <= segment.line.size());
+  QCOMPARE(segment.chunkStarts.size(), segment.levels.size());
+
+  int lastSize = std::numeric_limits<int>::max();
+  for(int i = 0; i < segment.levels.size(); i++)
+  {
+    const LineString& level = segment.levels.at(i);
+    const QVector<int>& starts = segment.chunkStarts.at(i);
+    QCOMPARE(starts.size(), segment.chunkEnds.size());
+
+    // Higher levels never have more positions
+    QVERIFY(level.size() <= lastSize);
+    lastSize = level.size();
+
+    QVERIFY(level.first().almostEqual(segment.line.first()));
+    QVERIFY(level.last().almostEqual(segment.line.at(segment.simplifiedSize - 1)));
+
+    for(int c = 1; c < starts.size(); c++)
+      QVERIFY(level.at(starts.at(c)).almostEqual(segment.line.at(segment.chunkEnds.at(c - 1))));
+  }
+}
+
+}
+
+void AircraftTrackTest::testDouglasPeucker()
+{
+  LineString line;
+  line.append(Pos(0.f, 0.f));
+  line.append(Pos(1.f, 0.00001f));
+  line.append(Pos(2.f, 0.f));
+  line.append(Pos(3.f, 0.00001f));
+  line.append(Pos(4.f, 1.f));
+  line.append(Pos(5.f, 0.f));
+
+  // Small deviations are removed
+  LineString result;
+  AircraftTrack::douglasPeucker(result, line, 0, 5, 0.001f);
+  QCOMPARE(result.size(), 4);
+  QVERIFY(result.at(0).almostEqual(line.at(0)));
+  QVERIFY(result.at(1).almostEqual(line.at(3)));
+  QVERIFY(result.at(2).almostEqual(line.at(4)));
+  QVERIFY(result.at(3).almostEqual(line.at(5)));
+
+  // All kept with tiny tolerance
+  result.clear();
+  AircraftTrack::douglasPeucker(result, line, 0, 5, 0.000001f);
+  QCOMPARE(result.size(), line.size());
+
+  // Only part of line and appended to existing result
+  AircraftTrack::douglasPeucker(result, line, 1, 3, 0.001f);
+  QCOMPARE(result.size(), line.size() + 2);
+  QVERIFY(result.last().almostEqual(line.at(3)));
+}
+
+void AircraftTrackTest::testLevelOfDetail()
+{
+  QCOMPARE(AircraftTrack::getLevelOfDetail(0.f), -1);
+  QCOMPARE(AircraftTrack::getLevelOfDetail(0.00001f), -1);
+  QCOMPARE(AircraftTrack::getLevelOfDetail(0.00006f), 0);
+  QCOMPARE(AircraftTrack::getLevelOfDetail(0.00021f), 1);
+
+  // Levels increase with tolerance and are limited
+  int last = -1;
+  for(float tolerance = 0.00001f; tolerance < 100.f; tolerance *= 2.f)
+  {
+    int level = AircraftTrack::getLevelOfDetail(tolerance);
+    QVERIFY(level >= last);
+    last = level;
+  }
+  QCOMPARE(AircraftTrack::getLevelOfDetail(1000.f), last);
+}
+
+void AircraftTrackTest::testLevelsCoverChunks()
+{
+  AircraftTrack track;
+  for(int i = 0; i < 1000; i++)
+    track.appendPosition(at::AircraftTrackPos(wavePos(i), static_cast<quint32>(i), false));
+
+  QCOMPARE(track.getSegments().size(), 1);
+  const at::AircraftTrackSegment& segment = track.getSegments().first();
+  QCOMPARE(segment.line.size(), 1000);
+  verifySegment(segment);
+
+  // Chunks are simplified when complete
+  QVERIFY(segment.simplifiedSize > 0);
+  QVERIFY(segment.line.size() - segment.getTailStart() <= 257);
+
+  // Coarse levels remove positions
+  QVERIFY(segment.levels.last().size() < segment.levels.first().size());
+  QVERIFY(segment.levels.first().size() < segment.simplifiedSize);
+
+  // Break starts a new segment
+  track.appendPosition(at::AircraftTrackPos(1000, false));
+  track.appendPosition(at::AircraftTrackPos(wavePos(0, 10.f), 1001, false));
+  QCOMPARE(track.getSegments().size(), 2);
+  QCOMPARE(track.getSegments().last().line.size(), 1);
+}
+
+void AircraftTrackTest::testPruneKeepsGeometry()
+{
+  AircraftTrack track;
+  track.setMaxTrackEntries(700);
+
+  int prunes = 0;
+  for(int i = 0; i < 5000; i++)
+  {
+    bool pruned = false;
+    if(i % 1500 == 1499)
+      // Add a break now and then
+      pruned |= track.appendPosition(at::AircraftTrackPos(static_cast<quint32>(i), false));
+    pruned |= track.appendPosition(at::AircraftTrackPos(wavePos(i), static_cast<quint32>(i), false));
+
+    if(pruned)
+    {
+      prunes++;
+
+      // Geometry matches buffer after prune
+      QVector<LineString> lines = track.getLineStrings();
+      const QVector<at::AircraftTrackSegment>& segments = track.getSegments();
+      QCOMPARE(segments.size(), lines.size());
+
+      for(int j = 0; j < segments.size(); j++)
+      {
+        QCOMPARE(segments.at(j).line.size(), lines.at(j).size());
+        QVERIFY(segments.at(j).line.first().almostEqual(lines.at(j).first()));
+        QVERIFY(segments.at(j).line.last().almostEqual(lines.at(j).last()));
+        verifySegment(segments.at(j));
+        if(QTest::currentTestFailed())
+          return;
+      }
+    }
+  }
+  QVERIFY(prunes > 10);
+}
+
+void AircraftTrackTest::testAntiMeridian()
+{
+  AircraftTrack track;
+  track.appendPosition(at::AircraftTrackPos(Pos(179.5f, 10.f), 0, false));
+  track.appendPosition(at::AircraftTrackPos(Pos(179.9f, 10.f), 1, false));
+  QVERIFY(!track.getSegments().first().crossesAntiMeridian);
+
+  track.appendPosition(at::AircraftTrackPos(Pos(-179.8f, 10.f), 2, false));
+  QVERIFY(track.getSegments().first().crossesAntiMeridian);
+}
+
+void AircraftTrackTest::testNewestRingFile()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString filename = dir.filePath("test.trackring");
+
+  {
+    // Stale file left over if a copy mapped it while reallocating
+    AircraftTrack stale;
+    stale.ringFilename = filename;
+    stale.appendPosition(at::AircraftTrackPos(wavePos(0), 0, false));
+  }
+
+  {
+    AircraftTrack current;
+    current.ringFilename = filename + ".1";
+    for(int i = 0; i < 3; i++)
+      current.appendPosition(at::AircraftTrackPos(wavePos(i), static_cast<quint32>(i), false));
+  }
+
+  AircraftTrack track;
+  track.ringFilename = filename;
+  QCOMPARE(track.ringFiles(), QStringList({filename, filename + ".1"}));
+  QVERIFY(track.attachRing());
+  QCOMPARE(track.size(), 3);
+  QVERIFY(!QFile::exists(filename));
+
+  // Reallocation removes the numbered file and uses the plain name again
+  track.resizeRing(10);
+  QCOMPARE(track.size(), 3);
+  QCOMPARE(track.ringFiles(), QStringList({filename}));
+}
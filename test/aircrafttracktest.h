@@ -0,0 +1,39 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_AIRCRAFTTRACKTEST_H
+#define LNM_AIRCRAFTTRACKTEST_H
+
+#include <QObject>
+
+/* Tests Douglas-Peucker simplification, levels of detail and pruning of the trail geometry in AircraftTrack.
+ * Also tests selection of ring files. */
+class AircraftTrackTest :
+  public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void testDouglasPeucker();
+  void testLevelOfDetail();
+  void testLevelsCoverChunks();
+  void testPruneKeepsGeometry();
+  void testAntiMeridian();
+  void testNewestRingFile();
+};
+
+#endif // LNM_AIRCRAFTTRACKTEST_H
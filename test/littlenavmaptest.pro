@@ -0,0 +1,83 @@
+#*****************************************************************************
+# Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#****************************************************************************
+
+# =============================================================================
+# Unit tests for logic which does not need the main window or the NavApp singletons.
+# Uses the same environment variables as littlenavmap.pro for atools and Marble.
+# Run "qmake && make && ./littlenavmaptest" in a build folder.
+# =============================================================================
+
+QT += core gui sql xml network svg testlib
+
+CONFIG += build_all c++14 console testcase
+CONFIG -= debug_and_release debug_and_release_target app_bundle
+
+TARGET = littlenavmaptest
+TEMPLATE = app
+
+ATOOLS_INC_PATH=$$(ATOOLS_INC_PATH)
+ATOOLS_LIB_PATH=$$(ATOOLS_LIB_PATH)
+MARBLE_INC_PATH=$$(MARBLE_INC_PATH)
+MARBLE_LIB_PATH=$$(MARBLE_LIB_PATH)
+
+CONFIG(debug, debug|release) : CONF_TYPE=debug
+CONFIG(release, debug|release) : CONF_TYPE=release
+
+isEmpty(ATOOLS_INC_PATH) : ATOOLS_INC_PATH=$$PWD/../../atools/src
+isEmpty(ATOOLS_LIB_PATH) : ATOOLS_LIB_PATH=$$PWD/../../build-atools-$$CONF_TYPE
+isEmpty(MARBLE_INC_PATH) : MARBLE_INC_PATH=$$PWD/../../Marble-$$CONF_TYPE/include
+isEmpty(MARBLE_LIB_PATH) : MARBLE_LIB_PATH=$$PWD/../../Marble-$$CONF_TYPE/lib
+
+unix:!macx {
+  QMAKE_RPATHDIR=$$MARBLE_LIB_PATH
+  LIBS += -L$$MARBLE_LIB_PATH -lmarblewidget-qt5 -L$$ATOOLS_LIB_PATH -latools -lz
+}
+
+win32 {
+  DEFINES += _USE_MATH_DEFINES
+  CONFIG(debug, debug|release) : LIBS += -L$$MARBLE_LIB_PATH -llibmarblewidget-qt5d
+  CONFIG(release, debug|release) : LIBS += -L$$MARBLE_LIB_PATH -llibmarblewidget-qt5
+  LIBS += -L$$ATOOLS_LIB_PATH -latools -lz
+}
+
+macx {
+  LIBS += -L$$MARBLE_LIB_PATH -lmarblewidget-qt5 -L$$ATOOLS_LIB_PATH -latools -lz
+}
+
+PRE_TARGETDEPS += $$ATOOLS_LIB_PATH/libatools.a
+DEPENDPATH += $$ATOOLS_INC_PATH $$MARBLE_INC_PATH
+INCLUDEPATH += $$PWD/../src $$PWD $$ATOOLS_INC_PATH $$MARBLE_INC_PATH
+DEFINES += QT_NO_CAST_FROM_BYTEARRAY
+DEFINES += QT_NO_CAST_TO_ASCII
+
+# =====================================================================
+# Files
+
+SOURCES += \
+  $$PWD/../src/common/aircrafttrack.cpp \
+  $$PWD/../src/query/querytypes.cpp \
+  $$PWD/aircrafttracktest.cpp \
+  $$PWD/main.cpp \
+  $$PWD/spatialindextest.cpp \
+  $$PWD/tiledrectcachetest.cpp
+
+HEADERS += \
+  $$PWD/../src/common/aircrafttrack.h \
+  $$PWD/../src/query/querytypes.h \
+  $$PWD/aircrafttracktest.h \
+  $$PWD/spatialindextest.h \
+  $$PWD/tiledrectcachetest.h
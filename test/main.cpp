@@ -0,0 +1,45 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "aircrafttracktest.h"
+#include "spatialindextest.h"
+#include "tiledrectcachetest.h"
+
+#include <QApplication>
+#include <QTest>
+
+/* Runs all test classes and returns the number of failed classes */
+int main(int argc, char *argv[])
+{
+  // Tests do not need a display
+  if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication app(argc, argv);
+  int failed = 0;
+
+  TiledRectCacheTest tiledRectCacheTest;
+  failed += QTest::qExec(&tiledRectCacheTest, argc, argv) != 0;
+
+  SpatialIndexTest spatialIndexTest;
+  failed += QTest::qExec(&spatialIndexTest, argc, argv) != 0;
+
+  AircraftTrackTest aircraftTrackTest;
+  failed += QTest::qExec(&aircraftTrackTest, argc, argv) != 0;
+
+  return failed;
+}
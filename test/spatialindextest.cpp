@@ -0,0 +1,318 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "spatialindextest.h"
+
+#include "query/querytypes.h"
+#include "geo/calculations.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqltransaction.h"
+
+#include <QRandomGenerator>
+#include <QFile>
+#include <QFileInfo>
+#include <QTest>
+
+#include <cmath>
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+
+namespace {
+
+const QString DB_NAME("SPATIALINDEXTEST");
+
+/* Rectangles including one at the poles and ones touching or crossing the anti-meridian */
+const QVector<GeoDataLatLonBox> RECTS(
+{
+  GeoDataLatLonBox(10., 0., 10., 0., GeoDataCoordinates::Degree),
+  GeoDataLatLonBox(55., 45., 15., 5., GeoDataCoordinates::Degree),
+  GeoDataLatLonBox(-30., -32., -60., -62., GeoDataCoordinates::Degree),
+  GeoDataLatLonBox(90., 80., 180., -180., GeoDataCoordinates::Degree),
+  GeoDataLatLonBox(5., -5., 180., 175., GeoDataCoordinates::Degree),
+  GeoDataLatLonBox(5., -5., -175., -180., GeoDataCoordinates::Degree),
+  GeoDataLatLonBox(60., -60., 100., -100., GeoDataCoordinates::Degree)
+});
+
+/* Opens the database read-only in a new connection like the map query connections */
+SqlDatabase *openDb(const QString& file, bool attach)
+{
+  SqlDatabase::addDatabase("QSQLITE", DB_NAME);
+  SqlDatabase *db = new SqlDatabase(DB_NAME);
+  db->setDatabaseName(file);
+  db->setReadonly();
+  db->open();
+  if(attach)
+    query::attachSpatialIndex(db);
+  return db;
+}
+
+/* Great circle distance using one nautical mile for one arc minute like the unit vector queries */
+double angleNm(const atools::geo::Pos& center, double lonx, double laty)
+{
+  double lat1 = atools::geo::toRadians(static_cast<double>(center.getLatY())), lat2 = atools::geo::toRadians(laty);
+  double dLat = lat2 - lat1, dLon = atools::geo::toRadians(lonx - static_cast<double>(center.getLonX()));
+  double a = std::sin(dLat / 2.) * std::sin(dLat / 2.) +
+             std::cos(lat1) * std::cos(lat2) * std::sin(dLon / 2.) * std::sin(dLon / 2.);
+  return atools::geo::toDegree(2. * std::asin(std::min(std::sqrt(a), 1.))) * 60.;
+}
+
+void closeDb(SqlDatabase *db)
+{
+  db->close();
+  delete db;
+  SqlDatabase::removeDatabase(DB_NAME);
+}
+
+/* Returns ids of all rows matching where for the rectangle */
+QSet<int> queryIds(SqlDatabase *db, const QString& table, const QString& idColumn, const QString& where,
+                   const GeoDataLatLonBox& rect)
+{
+  QSet<int> ids;
+  SqlQuery query(db);
+  query.prepare("select " + idColumn + " from " + table + " where " + where);
+  query::bindRect(rect, &query);
+  query.exec();
+  while(query.next())
+    ids.insert(query.valueInt(0));
+  return ids;
+}
+
+}
+
+void SpatialIndexTest::initTestCase()
+{
+  QVERIFY(tempDir.isValid());
+  dbFile = tempDir.filePath("test.sqlite");
+
+  // Keep index files out of the settings folder
+  query::setSpatialIndexDirectory(tempDir.filePath("spatial"));
+
+  // Fill database with random points and airway segments - fixed seed to get reproducible results
+  QRandomGenerator random(4711);
+  {
+    SqlDatabase::addDatabase("QSQLITE", DB_NAME);
+    SqlDatabase db(DB_NAME);
+    db.setDatabaseName(dbFile);
+    db.open();
+
+    SqlQuery query(&db);
+    query.exec("create table vor (vor_id integer primary key, lonx double, laty double)");
+    query.exec("create index idx_vor_lonx on vor(lonx)");
+    query.exec("create index idx_vor_laty on vor(laty)");
+    query.exec("create table airway (airway_id integer primary key, "
+               "left_lonx double, top_laty double, right_lonx double, bottom_laty double)");
+    query.exec("create table nav_search (nav_search_id integer primary key, lonx double, laty double)");
+
+    atools::sql::SqlTransaction transaction(&db);
+    SqlQuery insert(&db);
+    insert.prepare("insert into vor (vor_id, lonx, laty) values(:id, :lonx, :laty)");
+    for(int i = 1; i <= 5000; i++)
+    {
+      insert.bindValue(":id", i);
+      // Every tenth point close to the anti-meridian
+      if(i % 10 == 0)
+        insert.bindValue(":lonx", (i % 20 == 0 ? 180. : -180.) - (i % 20 == 0 ? 1. : -1.) * random.bounded(5.));
+      else
+        insert.bindValue(":lonx", random.bounded(360.) - 180.);
+      insert.bindValue(":laty", random.bounded(180.) - 90.);
+      insert.exec();
+    }
+
+    insert.prepare("insert into airway (airway_id, left_lonx, top_laty, right_lonx, bottom_laty) "
+                   "values(:id, :left, :top, :right, :bottom)");
+    for(int i = 1; i <= 2000; i++)
+    {
+      double lonx = random.bounded(360.) - 180., laty = random.bounded(170.) - 85.;
+      double right = lonx + random.bounded(10.);
+      // Segments crossing the anti-meridian have right < left
+      if(right > 180.)
+        right -= 360.;
+      insert.bindValue(":id", i);
+      insert.bindValue(":left", lonx);
+      insert.bindValue(":top", laty + random.bounded(5.));
+      insert.bindValue(":right", right);
+      insert.bindValue(":bottom", laty);
+      insert.exec();
+    }
+    // Same points for distance search
+    query.exec("insert into nav_search (nav_search_id, lonx, laty) select vor_id, lonx, laty from vor");
+    transaction.commit();
+    db.close();
+  }
+  SqlDatabase::removeDatabase(DB_NAME);
+
+  QVERIFY(query::createSpatialIndexFile(dbFile));
+
+  // Index file is created without R*Tree tables if the module is not available
+  SqlDatabase *db = openDb(dbFile, true /* attach */);
+  rtreeAvailable = query::hasSpatialIndex(db, "vor");
+  closeDb(db);
+}
+
+void SpatialIndexTest::cleanupTestCase()
+{
+  QFile::remove(query::spatialIndexFile(dbFile));
+}
+
+void SpatialIndexTest::testIndexFileCurrent()
+{
+  if(!rtreeAvailable)
+    QSKIP("SQLite without R*Tree module");
+
+  QVERIFY(QFile::exists(query::spatialIndexFile(dbFile)));
+  QCOMPARE(QFileInfo(query::spatialIndexFile(dbFile)).absolutePath(), tempDir.filePath("spatial"));
+  QVERIFY(!query::isSpatialIndexFileOutdated(dbFile));
+
+  // Second call does not recreate the file
+  QVERIFY(query::createSpatialIndexFile(dbFile, [](int, int)
+  {
+    QFAIL("Index created again");
+  }));
+
+  SqlDatabase *db = openDb(dbFile, false /* attach */);
+  QVERIFY(!query::hasSpatialIndex(db, "vor"));
+  QVERIFY(query::attachSpatialIndex(db));
+  QVERIFY(query::hasSpatialIndex(db, "vor"));
+  QVERIFY(query::hasSpatialIndex(db, "airway"));
+  QVERIFY(!query::hasSpatialIndex(db, "ndb"));
+
+  // Attaching twice is ignored
+  QVERIFY(query::attachSpatialIndex(db));
+  closeDb(db);
+}
+
+void SpatialIndexTest::testPointQueryEqualsPlain()
+{
+  if(!rtreeAvailable)
+    QSKIP("SQLite without R*Tree module");
+
+  SqlDatabase *db = openDb(dbFile, true /* attach */);
+  QVERIFY(query::hasSpatialIndex(db, "vor"));
+
+  QString whereIndex = query::whereRectPoint(db, "vor", "vor_id");
+  QString wherePlain = "lonx between :leftx and :rightx and laty between :bottomy and :topy";
+  QVERIFY(whereIndex != wherePlain);
+
+  for(const GeoDataLatLonBox& rect : RECTS)
+  {
+    QSet<int> plain = queryIds(db, "vor", "vor_id", wherePlain, rect);
+    QCOMPARE(queryIds(db, "vor", "vor_id", whereIndex, rect), plain);
+  }
+
+  // Not empty for the large rectangle to make sure the comparison is meaningful
+  QVERIFY(!queryIds(db, "vor", "vor_id", wherePlain, RECTS.last()).isEmpty());
+  closeDb(db);
+}
+
+void SpatialIndexTest::testRectQueryEqualsPlain()
+{
+  if(!rtreeAvailable)
+    QSKIP("SQLite without R*Tree module");
+
+  SqlDatabase *db = openDb(dbFile, true /* attach */);
+
+  // Same condition as used in AirwayQuery
+  QString where = "(not (right_lonx < :leftx or left_lonx > :rightx or bottom_laty > :topy or top_laty < :bottomy) "
+                  "or right_lonx < left_lonx)";
+
+  for(const GeoDataLatLonBox& rect : RECTS)
+  {
+    QSet<int> plain = queryIds(db, "airway", "airway_id", where, rect);
+    QCOMPARE(queryIds(db, "airway", "airway_id", query::whereRectIndex(db, "airway", "airway_id") + where, rect),
+             plain);
+  }
+  closeDb(db);
+}
+
+void SpatialIndexTest::testUnitVectorDistance()
+{
+  SqlDatabase *db = openDb(dbFile, true /* attach */);
+  QVERIFY(query::hasUnitVectorTable(db, "nav_search"));
+  QVERIFY(!query::hasUnitVectorTable(db, "vor"));
+
+  // Centers including one on the anti-meridian and one close to the pole
+  for(const atools::geo::Pos& center : {atools::geo::Pos(8.f, 50.f), atools::geo::Pos(180.f, 0.f),
+                                        atools::geo::Pos(-120.f, 85.f)})
+  {
+    for(const std::pair<float, float>& range : {std::make_pair(0.f, 500.f), std::make_pair(200.f, 1200.f)})
+    {
+      QSet<int> sqlIds;
+      SqlQuery distQuery(db);
+      distQuery.exec("select nav_search_id from nav_search " +
+                     query::unitVectorJoin("nav_search", "nav_search_id", center) +
+                     " where " + query::unitVectorRadiusWhere(range.first, range.second));
+      while(distQuery.next())
+        sqlIds.insert(distQuery.valueInt(0));
+
+      // Compare with great circle distance and leave out points too close to the limits for rounding errors
+      SqlQuery plain(db);
+      plain.exec("select nav_search_id, lonx, laty from nav_search");
+      int inside = 0;
+      while(plain.next())
+      {
+        double distNm = angleNm(center, plain.valueFloat("lonx"), plain.valueFloat("laty"));
+        int id = plain.valueInt(0);
+        if(distNm > range.first + 0.5f && distNm < range.second - 0.5f)
+        {
+          QVERIFY2(sqlIds.contains(id), qPrintable(QString("Missing %1 at %2 NM").arg(id).arg(distNm)));
+          inside++;
+        }
+        else if(distNm < range.first - 0.5f || distNm > range.second + 0.5f)
+          QVERIFY2(!sqlIds.contains(id), qPrintable(QString("Wrong %1 at %2 NM").arg(id).arg(distNm)));
+      }
+      QVERIFY(inside > 0);
+    }
+  }
+  closeDb(db);
+}
+
+void SpatialIndexTest::testOutdatedIndexNotAttached()
+{
+  if(!rtreeAvailable)
+    QSKIP("SQLite without R*Tree module");
+
+  // Change the database file which invalidates size in the index meta data
+  {
+    SqlDatabase::addDatabase("QSQLITE", DB_NAME);
+    SqlDatabase db(DB_NAME);
+    db.setDatabaseName(dbFile);
+    db.open();
+    SqlQuery query(&db);
+    query.exec("create table padding (value text)");
+    query.exec("insert into padding (value) values(randomblob(100000))");
+    db.close();
+  }
+  SqlDatabase::removeDatabase(DB_NAME);
+
+  QVERIFY(query::isSpatialIndexFileOutdated(dbFile));
+
+  // Queries fall back to plain coordinates
+  SqlDatabase *db = openDb(dbFile, true /* attach */);
+  QVERIFY(!query::hasSpatialIndex(db, "vor"));
+  QCOMPARE(query::whereRectIndex(db, "vor", "vor_id"), QString());
+  closeDb(db);
+
+  // Recreated and attached again
+  QVERIFY(query::createSpatialIndexFile(dbFile));
+  db = openDb(dbFile, true /* attach */);
+  QVERIFY(query::hasSpatialIndex(db, "vor"));
+  closeDb(db);
+}
@@ -0,0 +1,47 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_SPATIALINDEXTEST_H
+#define LNM_SPATIALINDEXTEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+/* Tests creation and attaching of the spatial index file, compares rectangle queries using the index
+ * with the plain coordinate queries and distance queries using the unit vectors with great circle distances */
+class SpatialIndexTest :
+  public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void testIndexFileCurrent();
+  void testPointQueryEqualsPlain();
+  void testRectQueryEqualsPlain();
+  void testUnitVectorDistance();
+  void testOutdatedIndexNotAttached();
+
+private:
+  QTemporaryDir tempDir;
+  QString dbFile;
+  bool rtreeAvailable = false;
+};
+
+#endif // LNM_SPATIALINDEXTEST_H
@@ -0,0 +1,347 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "tiledrectcachetest.h"
+
+#include "query/querytypes.h"
+
+#include <QTest>
+
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+
+namespace {
+
+/* Minimal object for the cache which needs an id only */
+struct TestObj
+{
+  int id;
+  double lonx, laty;
+};
+
+/* Objects with higher id are kept if the row limit is exceeded. Found by argument dependent lookup. */
+int objectImportance(const TestObj& obj)
+{
+  return obj.id;
+}
+
+/* Layers are only compared by pointer */
+const MapLayer *LAYER1 = reinterpret_cast<const MapLayer *>(0x1);
+const MapLayer *LAYER2 = reinterpret_cast<const MapLayer *>(0x2);
+
+GeoDataLatLonBox box(double west, double south, double east, double north)
+{
+  return GeoDataLatLonBox(north, south, east, west, GeoDataCoordinates::Degree);
+}
+
+/* Cache plus a fake database counting tile loads */
+struct Fixture
+{
+  query::TiledRectCache<TestObj> cache;
+  QVector<TestObj> objects;
+  int loads = 0;
+
+  bool update(const GeoDataLatLonBox& rect, const MapLayer *layer = LAYER1, bool lazy = false, bool same = true,
+              bool background = false)
+  {
+    query::TiledRectCache<TestObj>::TileLoadFunc loadFunc;
+    if(!background)
+      loadFunc = [this](const GeoDataLatLonBox& tileRect, QList<TestObj>& tileList)
+                 {
+                   loads++;
+                   load(tileRect, tileList);
+                 };
+
+    return cache.updateCache(rect, layer, 0., 0., lazy,
+                             [same](const MapLayer *, const MapLayer *) -> bool
+    {
+      return same;
+    }, loadFunc);
+  }
+
+  /* Inclusive bounds return objects on borders for both neighbor tiles */
+  void load(const GeoDataLatLonBox& tileRect, QList<TestObj>& tileList) const
+  {
+    for(const TestObj& obj : objects)
+    {
+      if(obj.lonx >= tileRect.west(GeoDataCoordinates::Degree) &&
+         obj.lonx <= tileRect.east(GeoDataCoordinates::Degree) &&
+         obj.laty >= tileRect.south(GeoDataCoordinates::Degree) &&
+         obj.laty <= tileRect.north(GeoDataCoordinates::Degree))
+        tileList.append(obj);
+    }
+  }
+
+};
+
+}
+
+void TiledRectCacheTest::testTileKeysAntiMeridian()
+{
+  // Rectangle from 170 E to 170 W crosses the anti-meridian
+  GeoDataLatLonBox rect = box(170., 0., -170., 10.);
+  int level = query::tileLevelForRect(rect);
+  QVector<query::TileKey> keys = query::tileKeysForRect(rect, level);
+
+  QVERIFY(!keys.isEmpty());
+
+  double size = query::tileSizeDeg(level);
+  int columns = static_cast<int>(360. / size);
+  bool east = false, west = false;
+  for(const query::TileKey& key : keys)
+  {
+    QCOMPARE(key.level, level);
+    QVERIFY(key.x >= 0 && key.x < columns);
+    east |= key.x == columns - 1;
+    west |= key.x == 0;
+
+    // Tile rectangles never cross the anti-meridian
+    GeoDataLatLonBox tile = query::tileRect(key);
+    QVERIFY(!tile.crossesDateLine());
+  }
+
+  // Tiles on both sides are covered
+  QVERIFY(east);
+  QVERIFY(west);
+}
+
+void TiledRectCacheTest::testMergeRemovesDuplicates()
+{
+  Fixture f;
+  // Object 2 is exactly on the tile border at 0/0 and is returned by all four tiles
+  f.objects = {{1, 2., 2.}, {2, 0., 0.}, {3, -2., -2.}, {4, 50., 50.}};
+
+  QVERIFY(f.update(box(-3., -3., 3., 3.)));
+  QCOMPARE(f.cache.list.size(), 3);
+
+  QSet<int> ids;
+  for(const TestObj& obj : f.cache.list)
+    ids.insert(obj.id);
+  QCOMPARE(ids, QSet<int>({1, 2, 3}));
+}
+
+void TiledRectCacheTest::testSameRectUsesCache()
+{
+  Fixture f;
+  f.objects = {{1, 2., 2.}};
+
+  QVERIFY(f.update(box(0., 0., 10., 10.)));
+  int loads = f.loads;
+  QVERIFY(loads > 0);
+
+  // Same tiles - nothing loaded and list unchanged
+  QVERIFY(!f.update(box(0., 0., 10., 10.)));
+  QCOMPARE(f.loads, loads);
+  QCOMPARE(f.cache.list.size(), 1);
+}
+
+void TiledRectCacheTest::testPanLoadsOnlyNewTiles()
+{
+  Fixture f;
+  f.objects = {{1, 2., 2.}, {2, 14., 2.}};
+
+  GeoDataLatLonBox rect = box(0., 0., 10., 10.);
+  int level = query::tileLevelForRect(rect);
+  QVERIFY(f.update(rect));
+  QCOMPARE(f.loads, query::tileKeysForRect(rect, level).size());
+
+  // Move by one tile width to the east - only the new column is loaded
+  double size = query::tileSizeDeg(level);
+  GeoDataLatLonBox moved = box(size, 0., 10. + size, 10.);
+  QCOMPARE(query::tileLevelForRect(moved), level);
+
+  QVector<query::TileKey> oldKeys = query::tileKeysForRect(rect, level);
+  int newTiles = 0;
+  for(const query::TileKey& key : query::tileKeysForRect(moved, level))
+    newTiles += !oldKeys.contains(key);
+
+  int loads = f.loads;
+  QVERIFY(f.update(moved));
+  QCOMPARE(f.loads - loads, newTiles);
+  QVERIFY(newTiles < oldKeys.size());
+
+  // Object 2 is visible now
+  bool found = false;
+  for(const TestObj& obj : f.cache.list)
+    found |= obj.id == 2;
+  QVERIFY(found);
+}
+
+void TiledRectCacheTest::testLazyDoesNotLoad()
+{
+  Fixture f;
+  f.objects = {{1, 2., 2.}};
+
+  QVERIFY(f.update(box(0., 0., 10., 10.)));
+  int loads = f.loads;
+
+  // Lazy update keeps the old list even if the rectangle is completely different
+  QVERIFY(!f.update(box(100., 40., 110., 50.), LAYER1, true /* lazy */));
+  QCOMPARE(f.loads, loads);
+  QCOMPARE(f.cache.list.size(), 1);
+}
+
+void TiledRectCacheTest::testLayerChangeDropsTiles()
+{
+  Fixture f;
+  f.objects = {{1, 2., 2.}};
+
+  GeoDataLatLonBox rect = box(0., 0., 10., 10.);
+  QVERIFY(f.update(rect));
+  int loads = f.loads;
+
+  // Different query parameters - all tiles loaded again
+  QVERIFY(f.update(rect, LAYER2, false, false /* same layer */));
+  QCOMPARE(f.loads, loads * 2);
+
+  // Missing tiles are reported only for the current layer
+  QVERIFY(f.cache.missingTiles(rect, LAYER1, 0., 0.).isEmpty());
+  QVERIFY(f.cache.missingTiles(rect, LAYER2, 0., 0.).isEmpty());
+  QVERIFY(!f.cache.missingTiles(box(60., 0., 70., 10.), LAYER2, 0., 0.).isEmpty());
+}
+
+void TiledRectCacheTest::testMergedListLimited()
+{
+  Fixture f;
+  for(int i = 0; i < 10; i++)
+    f.objects.append({i, 1. + i * 0.5, 1. + i * 0.5});
+
+  QVERIFY(f.update(box(0., 0., 10., 10.)));
+  QCOMPARE(f.cache.list.size(), 10);
+
+  // Below limit
+  QVERIFY(!f.cache.validate(100));
+  QCOMPARE(f.cache.list.size(), 10);
+
+  // Merged result is truncated to the most important objects and reported as overflow
+  QVERIFY(f.cache.validate(5));
+  QCOMPARE(f.cache.list.size(), 5);
+  for(int i = 0; i < 5; i++)
+    QCOMPARE(f.cache.list.at(i).id, 9 - i);
+}
+
+void TiledRectCacheTest::testOverflowKeepsTiles()
+{
+  Fixture f;
+  for(int i = 0; i < 10; i++)
+    f.objects.append({i, 1. + i * 0.5, 1. + i * 0.5});
+
+  GeoDataLatLonBox rect = box(0., 0., 10., 10.);
+  QVERIFY(f.update(rect));
+  QVERIFY(f.cache.validate(5));
+  int loads = f.loads;
+
+  // Same view again - still overflow but no new queries
+  QVERIFY(!f.update(rect));
+  QVERIFY(f.cache.validate(5));
+  QCOMPARE(f.cache.list.size(), 5);
+  QCOMPARE(f.loads, loads);
+
+  // Moving the view by one tile loads only the new column and the list is rebuilt from the cached tiles
+  double size = query::tileSizeDeg(query::tileLevelForRect(rect));
+  QVERIFY(f.update(box(size, 0., 10. + size, 10.)));
+  QCOMPARE(f.loads - loads, 2);
+}
+
+void TiledRectCacheTest::testBackgroundLoadLeavesOutTiles()
+{
+  Fixture f;
+  f.objects = {{1, 7., 2.}, {2, 14., 2.}};
+
+  GeoDataLatLonBox rect = box(0., 0., 10., 10.);
+  QVERIFY(f.update(rect));
+  int loads = f.loads;
+
+  // Move by one tile - new column is not loaded but reported as missing
+  double size = query::tileSizeDeg(query::tileLevelForRect(rect));
+  GeoDataLatLonBox moved = box(size, 0., 10. + size, 10.);
+  QVERIFY(f.update(moved, LAYER1, false, true, true /* background */));
+  QCOMPARE(f.loads, loads);
+  QCOMPARE(f.cache.list.size(), 1);
+
+  QVector<query::TileKey> missing = f.cache.missingTiles(moved, LAYER1, 0., 0.);
+  QCOMPARE(missing.size(), 2);
+
+  // Incomplete list is rebuilt on the next call
+  QVERIFY(f.update(moved, LAYER1, false, true, true /* background */));
+
+  // Add tiles like the prefetch thread - nothing is loaded and the list is complete
+  for(const query::TileKey& key : missing)
+  {
+    QList<TestObj> tileList;
+    f.load(query::tileRect(key), tileList);
+    f.cache.insertTile(key, tileList, LAYER1);
+  }
+  QVERIFY(f.update(moved, LAYER1, false, true, true /* background */));
+  QCOMPARE(f.loads, loads);
+  QCOMPARE(f.cache.list.size(), 2);
+  QVERIFY(f.cache.missingTiles(moved, LAYER1, 0., 0.).isEmpty());
+
+  // Complete now
+  QVERIFY(!f.update(moved, LAYER1, false, true, true /* background */));
+
+  // Tiles for other layers are ignored
+  f.cache.insertTile({0, 0, 0}, {{3, -100., -50.}}, LAYER2);
+  QVERIFY(!f.update(moved, LAYER1, false, true, true /* background */));
+}
+
+void TiledRectCacheTest::testOverBudgetTileRetained()
+{
+  // One dense tile which costs more than the whole memory limit
+  Fixture f;
+  f.cache.setMaxMemoryKb(1);
+  for(int i = 0; i < 200; i++)
+    f.objects.append({i, 1. + i * 0.001, 1.});
+
+  GeoDataLatLonBox rect = box(0., 0., 10., 10.);
+  QVERIFY(f.update(rect));
+  QCOMPARE(f.cache.list.size(), 200);
+  QVERIFY(f.cache.missingTiles(rect, LAYER1, 0., 0.).isEmpty());
+  int loads = f.loads;
+
+  // Moving the view by one tile keeps the dense tile and loads only the new column
+  double size = query::tileSizeDeg(query::tileLevelForRect(rect));
+  GeoDataLatLonBox moved = box(size / 2., 0., 10. + size / 2., 10.);
+  f.update(moved);
+  QCOMPARE(f.cache.list.size(), 200);
+  QVERIFY(f.cache.missingTiles(moved, LAYER1, 0., 0.).isEmpty());
+  QCOMPARE(f.loads - loads, 2);
+
+  // Visible tiles added by the prefetch thread are kept too
+  Fixture f2;
+  f2.cache.setMaxMemoryKb(1);
+  f2.objects = f.objects;
+  f2.update(rect, LAYER1, false, true, true /* background */);
+  QVector<query::TileKey> missing = f2.cache.missingTiles(rect, LAYER1, 0., 0.);
+  QCOMPARE(missing.size(), 4);
+  for(const query::TileKey& key : missing)
+  {
+    QList<TestObj> tileList;
+    f2.load(query::tileRect(key), tileList);
+    QVERIFY(f2.cache.insertTile(key, tileList, LAYER1));
+  }
+  QVERIFY(f2.update(rect, LAYER1, false, true, true /* background */));
+  QCOMPARE(f2.cache.list.size(), 200);
+
+  // Dense tile outside of the view exceeds the limit and is dropped
+  QList<TestObj> denseList;
+  for(int i = 0; i < 200; i++)
+    denseList.append({1000 + i, -100., -50.});
+  query::TileKey farKey = {missing.first().level, 0, 0};
+  QVERIFY(!f2.cache.insertTile(farKey, denseList, LAYER1));
+  QVERIFY(!f2.cache.containsTile(farKey));
+}
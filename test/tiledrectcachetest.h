@@ -0,0 +1,42 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_TILEDRECTCACHETEST_H
+#define LNM_TILEDRECTCACHETEST_H
+
+#include <QObject>
+
+/* Tests tile keys, merging, lazy and background updates and the row limit of query::TiledRectCache */
+class TiledRectCacheTest :
+  public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void testTileKeysAntiMeridian();
+  void testMergeRemovesDuplicates();
+  void testSameRectUsesCache();
+  void testPanLoadsOnlyNewTiles();
+  void testLazyDoesNotLoad();
+  void testLayerChangeDropsTiles();
+  void testMergedListLimited();
+  void testOverflowKeepsTiles();
+  void testBackgroundLoadLeavesOutTiles();
+  void testOverBudgetTileRetained();
+};
+
+#endif // LNM_TILEDRECTCACHETEST_H